@@ -0,0 +1,347 @@
+/*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file
+ * Host benchmark for the mac-tempsense coordinator under a synthetic load of sensors, built on the dummy posix
+ * platform.
+ *
+ * The sensors associate, then each one does a data exchange (WAKEUP, C_DATA confirm, D_DATA) every
+ * APP_WAKEUPINTERVALL seconds, spread over the interval, while the simulated time advances and the tasklets run.
+ * Part of the sensors go silent after a few rounds, and must be disconnected by the timeout tasklet, while the
+ * others must never be. The MAC requests are wrapped at link time, so that the coordinator can run without a
+ * CA-821x while its requests, and the synchronous ones in particular, are counted.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cascoda-bm/cascoda_types.h"
+#include "cascoda-util/cascoda_tasklet.h"
+#include "ca821x_api.h"
+#include "cascoda_dummy.h"
+#include "tempsense_app.h"
+
+/** Default load: number of sensors, rounds of data exchanges, and percentage of sensors going silent */
+#define DEFAULT_SENSORS APP_MAX_DEVICES
+#define DEFAULT_ROUNDS 20
+#define DEFAULT_SILENT_PERCENT 10
+/** Round after which the silent sensors stop sending */
+#define SILENT_ROUND 4
+
+/** Counters for the MAC requests of the coordinator */
+struct bench_counters
+{
+	u32_t data_requests;  //!< MCPS_DATA_request, one per WAKEUP of an associated sensor
+	u32_t assoc_response; //!< MLME_ASSOCIATE_response
+	u32_t sync_requests;  //!< Synchronous requests (HWME_GET, MLME_SET, MLME_RESET), each blocking on the SPI
+	u32_t cax_restarts;   //!< EVBME_CAX_Restart, when the last sensor is disconnected
+};
+
+static struct bench_counters sCounters;
+static u8_t                  sLastMsduHandle;
+static struct ca821x_dev     sDevice;
+
+/* Wrapped functions ------------------------------------------------------- */
+
+#if CASCODA_CA_VER >= 8212
+ca_mac_status __wrap_MCPS_DATA_request(uint8_t            SrcAddrMode,
+                                       struct FullAddr    DstAddr,
+                                       uint8_t            HeaderIELength,
+                                       uint8_t            PayloadIELength,
+                                       uint8_t            MsduLength,
+                                       uint8_t           *pMsdu,
+                                       uint8_t            MsduHandle,
+                                       uint8_t           *pTxOptions,
+                                       uint32_t           SchTimestamp,
+                                       uint16_t           SchPeriod,
+                                       uint8_t            TxChannel,
+                                       uint8_t           *pHeaderIEList,
+                                       uint8_t           *pPayloadIEList,
+                                       struct SecSpec    *pSecurity,
+                                       struct ca821x_dev *pDeviceRef)
+#else
+ca_mac_status __wrap_MCPS_DATA_request(uint8_t            SrcAddrMode,
+                                       struct FullAddr    DstAddr,
+                                       uint8_t            MsduLength,
+                                       uint8_t           *pMsdu,
+                                       uint8_t            MsduHandle,
+                                       uint8_t            TxOptions,
+                                       struct SecSpec    *pSecurity,
+                                       struct ca821x_dev *pDeviceRef)
+#endif // CASCODA_CA_VER >= 8212
+{
+	sCounters.data_requests++;
+	sLastMsduHandle = MsduHandle;
+	return MAC_SUCCESS;
+}
+
+ca_mac_status __wrap_MLME_ASSOCIATE_response(uint8_t           *pDeviceAddress,
+                                             uint16_t           AssocShortAddress,
+                                             uint8_t            Status,
+                                             struct SecSpec    *pSecurity,
+                                             struct ca821x_dev *pDeviceRef)
+{
+	sCounters.assoc_response++;
+	return MAC_SUCCESS;
+}
+
+ca_mac_status __wrap_HWME_GET_request_sync(uint8_t            HWAttribute,
+                                           uint8_t           *HWAttributeLength,
+                                           uint8_t           *pHWAttributeValue,
+                                           struct ca821x_dev *pDeviceRef)
+{
+	sCounters.sync_requests++;
+	*HWAttributeLength = 1;
+	*pHWAttributeValue = 0x80;
+	return MAC_SUCCESS;
+}
+
+ca_mac_status __wrap_MLME_SET_request_sync(uint8_t            PIBAttribute,
+                                           uint8_t            PIBAttributeIndex,
+                                           uint8_t            PIBAttributeLength,
+                                           const void        *pPIBAttributeValue,
+                                           struct ca821x_dev *pDeviceRef)
+{
+	sCounters.sync_requests++;
+	return MAC_SUCCESS;
+}
+
+ca_mac_status __wrap_MLME_RESET_request_sync(uint8_t SetDefaultPIB, struct ca821x_dev *pDeviceRef)
+{
+	sCounters.sync_requests++;
+	return MAC_SUCCESS;
+}
+
+ca_mac_status __wrap_MLME_SCAN_request(uint8_t            ScanType,
+                                       uint32_t           ScanChannels,
+                                       uint8_t            ScanDuration,
+                                       struct SecSpec    *pSecurity,
+                                       struct ca821x_dev *pDeviceRef)
+{
+	return MAC_SUCCESS;
+}
+
+void __wrap_EVBME_CAX_Restart(struct ca821x_dev *pDeviceRef)
+{
+	sCounters.cax_restarts++;
+}
+
+/* Simulated sensors ------------------------------------------------------- */
+
+static double nowUs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void associate(u16_t sensor)
+{
+	struct MLME_ASSOCIATE_indication_pset ind = {0};
+
+	memcpy(ind.DeviceAddress, APP_LongAddress, 8);
+	PUTLE32(0x1000u + sensor, ind.DeviceAddress);
+	TEMPSENSE_APP_Coordinator_AssociateResponse(&ind, &sDevice);
+}
+
+// Sensors associate in order on an empty table, so each one gets the short address of its index
+static void indicate(u16_t sensor, const u8_t *msdu, u8_t len)
+{
+	struct MCPS_DATA_indication_pset ind = {0};
+
+	ind.Src.AddressMode = MAC_MODE_SHORT_ADDR;
+	PUTLE16(MAC_SHORTADD + 1 + sensor, ind.Src.Address);
+	PUTLE16(APP_PANId, ind.Src.PANId);
+	ind.MsduLength      = len;
+	ind.MpduLinkQuality = 200;
+#if CASCODA_CA_VER >= 8212
+	memcpy(ind.Data, msdu, len);
+#else
+	memcpy(ind.Msdu, msdu, len);
+#endif // CASCODA_CA_VER >= 8212
+	TEMPSENSE_APP_Coordinator_ProcessDataInd(&ind, &sDevice);
+}
+
+// WAKEUP, confirm of the C_DATA sent in response, and D_DATA, as a sensor does every APP_WAKEUPINTERVALL
+// Returns false if the coordinator didn't respond to the WAKEUP, ie. the sensor was disconnected
+static bool exchange(u16_t sensor, u32_t serial)
+{
+	struct MCPS_DATA_confirm_pset cnf      = {0};
+	u8_t                          wakeup[] = {PT_MSDU_D_WAKEUP, 0, 0, 0, 0};
+	u8_t                          data[]   = {PT_MSDU_D_DATA, 21, 0x00, 0x0C, 180, 90};
+	u32_t                         requests = sCounters.data_requests;
+
+	PUTLE32(serial, wakeup + 1);
+	indicate(sensor, wakeup, sizeof(wakeup));
+	if (sCounters.data_requests == requests)
+		return false;
+
+	cnf.MsduHandle = sLastMsduHandle;
+	cnf.Status     = MAC_SUCCESS;
+	TEMPSENSE_APP_Coordinator_ProcessDataCnf(&cnf, &sDevice);
+	indicate(sensor, data, sizeof(data));
+	return true;
+}
+
+static void printUsage(const char *exec_name)
+{
+	fprintf(stderr, "Usage: %s [-s SENSORS] [-r ROUNDS] [-p PERCENT] [-v]\n", exec_name);
+	fprintf(stderr, "\tRun the mac-tempsense coordinator with a synthetic load of sensors, in simulated time.\n\n");
+	fprintf(stderr, "\t-s SENSORS  Number of sensors (default and maximum %d)\n", APP_MAX_DEVICES);
+	fprintf(stderr, "\t-r ROUNDS   Number of data exchanges of each sensor (default %d)\n", DEFAULT_ROUNDS);
+	fprintf(stderr, "\t-p PERCENT  Percentage of sensors going silent after %d rounds (default %d)\n",
+	        SILENT_ROUND,
+	        DEFAULT_SILENT_PERCENT);
+	fprintf(stderr, "\t-v          Keep the output of the coordinator\n");
+}
+
+int main(int argc, char *argv[])
+{
+	long   sensors = DEFAULT_SENSORS;
+	long   rounds  = DEFAULT_ROUNDS;
+	long   percent = DEFAULT_SILENT_PERCENT;
+	bool   verbose = false;
+	u16_t  silent;
+	u32_t  step_ms;
+	u32_t  exchanges = 0, dropped = 0, kept = 0;
+	u32_t  sync_per_round;
+	double start, elapsed, exchange_us = 0, exchange_max_us = 0, tasklet_us = 0;
+	int    saved_stdout = -1;
+	int    opt;
+
+	while ((opt = getopt(argc, argv, "s:r:p:vh")) != -1)
+	{
+		switch (opt)
+		{
+		case 's':
+			sensors = strtol(optarg, NULL, 0);
+			break;
+		case 'r':
+			rounds = strtol(optarg, NULL, 0);
+			break;
+		case 'p':
+			percent = strtol(optarg, NULL, 0);
+			break;
+		case 'v':
+			verbose = true;
+			break;
+		default:
+			printUsage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	// The silent sensors must have timed out before the last round
+	if (sensors <= 0 || sensors > APP_MAX_DEVICES || percent < 0 || percent > 100 ||
+	    rounds <= SILENT_ROUND + (APP_TIMEOUTINTERVALL / APP_WAKEUPINTERVALL) + 1)
+	{
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	silent  = (u16_t)(sensors * percent / 100);
+	step_ms = (1000 * APP_WAKEUPINTERVALL) / sensors;
+
+	// The coordinator prints a line for every exchange, which is not part of the measurement
+	if (!verbose)
+	{
+		int null_fd = open("/dev/null", O_WRONLY);
+
+		fflush(stdout);
+		saved_stdout = dup(STDOUT_FILENO);
+		dup2(null_fd, STDOUT_FILENO);
+		close(null_fd);
+	}
+
+	APP_STATE = APP_ST_COORDINATOR;
+	TEMPSENSE_APP_Coordinator_Initialise(&sDevice);
+	memset(&sCounters, 0, sizeof(sCounters));
+	for (u16_t i = 0; i < sensors; i++) associate(i);
+
+	// Each round, the sensors exchange data one after the other, spread over the wake-up interval
+	for (u32_t round = 0; round < rounds; round++)
+	{
+		u32_t sync_before = sCounters.sync_requests;
+
+		for (u16_t i = 0; i < sensors; i++)
+		{
+			CHILI_FastForward(step_ms);
+			start = nowUs();
+			TASKLET_Process();
+			tasklet_us += nowUs() - start;
+
+			// The first sensors go silent
+			if (i < silent && round >= SILENT_ROUND)
+				continue;
+
+			start = nowUs();
+			if (!exchange(i, round + 1))
+				dropped++;
+			elapsed = nowUs() - start;
+			exchange_us += elapsed;
+			if (elapsed > exchange_max_us)
+				exchange_max_us = elapsed;
+			exchanges++;
+		}
+		sync_per_round = sCounters.sync_requests - sync_before;
+	}
+
+	// Every silent sensor must have been disconnected
+	for (u16_t i = 0; i < silent; i++)
+	{
+		if (exchange(i, rounds + 1))
+			kept++;
+	}
+
+	if (!verbose)
+	{
+		fflush(stdout);
+		dup2(saved_stdout, STDOUT_FILENO);
+		close(saved_stdout);
+	}
+
+	printf("sensors %ld, silent after round %d: %u, rounds %ld, exchange every %d s\n",
+	       sensors,
+	       SILENT_ROUND,
+	       silent,
+	       rounds,
+	       APP_WAKEUPINTERVALL);
+	printf("exchanges            %10u\n", exchanges);
+	printf("exchange us (mean)   %10.2f\n", exchange_us / exchanges);
+	printf("exchange us (max)    %10.2f\n", exchange_max_us);
+	printf("tasklet us (total)   %10.1f\n", tasklet_us);
+	printf("sync requests/round  %10u\n", sync_per_round);
+	printf("active dropped       %10u\n", dropped);
+	printf("silent kept          %10u\n", kept);
+	printf("CAX restarts         %10u\n", sCounters.cax_restarts);
+
+	return (dropped || kept) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -47,7 +47,9 @@
 //! maximum number of retries for device before disconnection and re-scanning
 #define APP_DEVICE_MAX_RETRIES 1
 //! maximum devices/sensors that can connect to coordinator
-#define APP_MAX_DEVICES 32
+#ifndef APP_MAX_DEVICES
+#define APP_MAX_DEVICES 256
+#endif
 //! default powerdown mode for device/sensor
 #define APP_DEFAULT_PDN_MODE PDM_DPD
 //! use clock from cax8210 xtal oscillator (when 1) or nano120 internal RC oscillator as system clock (when 0)
@@ -62,8 +64,13 @@
 #define APP_REPORT_VBATT 1
 //! report lqi values (both from device and coordinator)
 #define APP_REPORT_LQI 1
-//! report ed values (both from device and coordinator)
+//! report ed values (from device, and from coordinator if APP_REPORT_ED_COORD is set)
 #define APP_REPORT_ED 1
+//! also report the ed value received by the coordinator
+//! this takes a synchronous HWME_GET for every reported packet, so it is off for large networks
+#ifndef APP_REPORT_ED_COORD
+#define APP_REPORT_ED_COORD 0
+#endif
 //! report every nth data package
 #define APP_COORD_REPORTN 1
 //! soft re-initialisation of coordinator
@@ -274,13 +281,11 @@ void TEMPSENSE_APP_Coordinator_ProcessDataCnf(struct MCPS_DATA_confirm_pset *par
  * \brief TEMPSENSE App. Coordinator check and display Data Packet
  *******************************************************************************
  * \param device - device number
- * \param edcoord - ED received locally (Coordinator)
  * \param params - Buffer containing data indication with data to display
  * \param pDeviceRef - Pointer to initialised ca821x_device_ref struct
  *******************************************************************************
  ******************************************************************************/
-void TEMPSENSE_APP_Coordinator_DisplayData(u8_t                              device,
-                                           u8_t                              edcoord,
+void TEMPSENSE_APP_Coordinator_DisplayData(u16_t                             device,
                                            struct MCPS_DATA_indication_pset *params,
                                            struct ca821x_dev                *pDeviceRef);
 
@@ -288,6 +293,9 @@ void TEMPSENSE_APP_Coordinator_DisplayData(u8_t                              dev
 /***************************************************************************/ /**
  * \brief TEMPSENSE App. Coordinator Timeout Check for all Devices
  *******************************************************************************
+ * Disconnects devices that have timed out and schedules the check for the next
+ * device to time out. Called from a tasklet, so does not need to be polled.
+ *******************************************************************************
  ******************************************************************************/
 void TEMPSENSE_APP_Coordinator_CheckTimeouts(struct ca821x_dev *pDeviceRef);
 
@@ -315,7 +323,7 @@ void TEMPSENSE_APP_Coordinator_CheckLQI(u8_t lqi_ts, u8_t lqi_coord);
  * \brief TEMPSENSE App. Checks and displays ED from both Sides
  *******************************************************************************
  * \param ed_ts    - ED received at Temperature Sensor (Device)
- * \param ed_coord - ED received locally (Coordinator)
+ * \param ed_coord - ED received locally (Coordinator), 0 if not read (APP_REPORT_ED_COORD not set)
  *******************************************************************************
  ******************************************************************************/
 void TEMPSENSE_APP_Coordinator_CheckED(u8_t ed_ts, u8_t ed_coord);
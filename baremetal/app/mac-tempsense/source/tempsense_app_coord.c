@@ -39,6 +39,7 @@
 #include "cascoda-bm/cascoda_serial.h"
 #include "cascoda-bm/cascoda_spi.h"
 #include "cascoda-bm/cascoda_types.h"
+#include "cascoda-util/cascoda_tasklet.h"
 #include "cascoda-util/cascoda_time.h"
 
 #include "ca821x_api.h"
@@ -51,20 +52,192 @@
 /******************************************************************************/
 /****** Global Variables                                                 ******/
 /******************************************************************************/
-static u8_t APP_NDEVICES = 0; //!< number of devices connected to coordinator
+#define APP_DEV_NONE 0xFFFF //!< invalid device index, terminates device lists
 
-/* devices associated  with coordinator */
-/* short address assigned will be CA 01 to CA APP_MAX_DEVICES */
-static u8_t  APP_DevState[APP_MAX_DEVICES]        = {APP_CST_DONE}; /* device communications state */
-static u8_t  APP_DevAssociated[APP_MAX_DEVICES]   = {0};            /* device is associated flag */
-static u32_t APP_DevTimeout[APP_MAX_DEVICES]      = {0};            /* device timeout */
-static u32_t APP_DevLongAddrLSBs[APP_MAX_DEVICES] = {0};            /* device lower 4 bytes of long address */
-static u32_t APP_DevHandle[APP_MAX_DEVICES]       = {0xFFFFFFFF};   /* device handle / sequence number */
+/* device entry of a sensor associated with the coordinator */
+/* short address assigned will be MAC_SHORTADD + 1 + device index */
+struct tempsense_dev
+{
+	u64_t longaddr;    //!< IEEE address of device
+	u32_t lastheard;   //!< time of last completed data exchange, timeout is measured from here
+	u32_t handle;      //!< device handle / sequence number
+	u16_t hash_next;   //!< next device in same hash bucket
+	u16_t prev;        //!< previous device in timeout order (heard longer ago)
+	u16_t next;        //!< next device in timeout order (heard more recently), or next free entry
+	u8_t  state;       //!< device communications state
+	u8_t  associated;  //!< device is associated flag
+	u8_t  msdu_handle; //!< msdu handle of pending C_DATA request
+};
+
+static u16_t APP_NDEVICES = 0; //!< number of devices connected to coordinator
+
+static struct tempsense_dev APP_Dev[APP_MAX_DEVICES];     //!< device table
+static u16_t                APP_DevHash[APP_MAX_DEVICES]; //!< hash buckets of device table, keyed by long address
+static u16_t                APP_DevFree;                  //!< first free device entry
+static u16_t                APP_DevOldest;                //!< device heard longest ago, first to time out
+static u16_t                APP_DevNewest;                //!< device heard most recently
+static u16_t                APP_DevByMsduHandle[256];     //!< device with pending C_DATA request for each msdu handle
+static u8_t                 APP_NextMsduHandle;           //!< msdu handle for next C_DATA request
+static ca_tasklet           APP_TimeoutTasklet;           //!< tasklet scheduled for the next device timeout
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Get hash bucket of a long address
+ *******************************************************************************
+ ******************************************************************************/
+static u16_t TEMPSENSE_APP_Coordinator_Hash(u64_t longaddr)
+{
+	/* only the lower 4 bytes vary within the network */
+	return (u16_t)(((u32_t)longaddr * 2654435761u) % APP_MAX_DEVICES);
+}
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Find device entry by long address
+ *******************************************************************************
+ * \return device index, or APP_DEV_NONE if not in table
+ *******************************************************************************
+ ******************************************************************************/
+static u16_t TEMPSENSE_APP_Coordinator_FindDevice(u64_t longaddr)
+{
+	u16_t i = APP_DevHash[TEMPSENSE_APP_Coordinator_Hash(longaddr)];
+
+	while ((i != APP_DEV_NONE) && (APP_Dev[i].longaddr != longaddr)) i = APP_Dev[i].hash_next;
+
+	return i;
+}
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Schedule timeout tasklet for the device heard longest ago
+ *******************************************************************************
+ ******************************************************************************/
+static void TEMPSENSE_APP_Coordinator_ScheduleTimeout(struct ca821x_dev *pDeviceRef)
+{
+	u32_t tnow = TIME_ReadAbsoluteTime();
+	u32_t deadline;
+
+	TASKLET_Cancel(&APP_TimeoutTasklet);
+	if (APP_DevOldest == APP_DEV_NONE)
+		return;
+
+	deadline = APP_Dev[APP_DevOldest].lastheard + (1000 * APP_TIMEOUTINTERVALL) + 1;
+	/* deadline already passed: process on next tasklet run */
+	if ((i32_t)(deadline - tnow) < 0)
+		deadline = tnow;
+	TASKLET_ScheduleAbs(&APP_TimeoutTasklet, tnow, deadline, pDeviceRef);
+}
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Remove device from timeout order list
+ *******************************************************************************
+ ******************************************************************************/
+static void TEMPSENSE_APP_Coordinator_Unlink(u16_t devnum)
+{
+	struct tempsense_dev *dev = &APP_Dev[devnum];
+
+	if (dev->prev != APP_DEV_NONE)
+		APP_Dev[dev->prev].next = dev->next;
+	else
+		APP_DevOldest = dev->next;
+	if (dev->next != APP_DEV_NONE)
+		APP_Dev[dev->next].prev = dev->prev;
+	else
+		APP_DevNewest = dev->prev;
+	dev->prev = dev->next = APP_DEV_NONE;
+}
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Mark device as heard now, moving it to the end of the timeout order
+ *******************************************************************************
+ ******************************************************************************/
+static void TEMPSENSE_APP_Coordinator_Refresh(u16_t devnum, struct ca821x_dev *pDeviceRef)
+{
+	struct tempsense_dev *dev        = &APP_Dev[devnum];
+	u8_t                  was_oldest = (APP_DevOldest == devnum);
+
+	if (dev->associated)
+		TEMPSENSE_APP_Coordinator_Unlink(devnum);
+
+	dev->lastheard = TIME_ReadAbsoluteTime();
+	dev->prev      = APP_DevNewest;
+	dev->next      = APP_DEV_NONE;
+	if (APP_DevNewest != APP_DEV_NONE)
+		APP_Dev[APP_DevNewest].next = devnum;
+	else
+		APP_DevOldest = devnum;
+	APP_DevNewest = devnum;
+
+	/* deadlines of other devices are unchanged, only reschedule if the first one has moved */
+	if (was_oldest || !TASKLET_IsQueued(&APP_TimeoutTasklet))
+		TEMPSENSE_APP_Coordinator_ScheduleTimeout(pDeviceRef);
+}
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Remove device from device table
+ *******************************************************************************
+ ******************************************************************************/
+static void TEMPSENSE_APP_Coordinator_RemoveDevice(u16_t devnum)
+{
+	struct tempsense_dev *dev    = &APP_Dev[devnum];
+	u16_t                *bucket = &APP_DevHash[TEMPSENSE_APP_Coordinator_Hash(dev->longaddr)];
+
+	while (*bucket != devnum) bucket = &APP_Dev[*bucket].hash_next;
+	*bucket = dev->hash_next;
+
+	TEMPSENSE_APP_Coordinator_Unlink(devnum);
+	if (APP_DevByMsduHandle[dev->msdu_handle] == devnum)
+		APP_DevByMsduHandle[dev->msdu_handle] = APP_DEV_NONE;
+
+	dev->state      = APP_CST_DONE;
+	dev->associated = 0;
+	dev->longaddr   = 0;
+	dev->handle     = 0xFFFFFFFF;
+	dev->hash_next  = APP_DEV_NONE;
+	dev->next       = APP_DevFree;
+	APP_DevFree     = devnum;
+	--APP_NDEVICES;
+}
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Timeout tasklet callback
+ *******************************************************************************
+ ******************************************************************************/
+static ca_error TEMPSENSE_APP_Coordinator_TimeoutCallback(void *context)
+{
+	/* the tasklet can still be queued after switching to another mode */
+	if (APP_STATE != APP_ST_COORDINATOR)
+		return CA_ERROR_SUCCESS;
+
+	TEMPSENSE_APP_Coordinator_CheckTimeouts(context);
+	return CA_ERROR_SUCCESS;
+}
 
 void TEMPSENSE_APP_Coordinator_Handler(struct ca821x_dev *pDeviceRef)
 {
-	/* check time-outs */
-	TEMPSENSE_APP_Coordinator_CheckTimeouts(pDeviceRef);
+	u32_t        tnow;
+	static u32_t tlast;
+
+	/* device time-outs are handled by APP_TimeoutTasklet */
+
+	/* coordinator soft reinitialisation if nothing is connected */
+	if (APP_COORD_SREINIT)
+	{
+		tnow = TIME_ReadAbsoluteTime();
+		if (APP_NDEVICES == 0)
+		{
+			if ((((tnow - tlast) > (1000 * APP_WAKEUPINTERVALL)) && (APP_WAKEUPINTERVALL != 0)) ||
+			    (((tnow - tlast) > (100)) && (APP_WAKEUPINTERVALL == 0)))
+			{
+				TEMPSENSE_APP_Coordinator_SoftReinit(pDeviceRef);
+				tlast = tnow;
+			}
+		}
+	}
 
 #if APP_USE_DEBUG
 	APP_Debug_Send(pDeviceRef);
@@ -74,7 +247,7 @@ void TEMPSENSE_APP_Coordinator_Handler(struct ca821x_dev *pDeviceRef)
 
 void TEMPSENSE_APP_Coordinator_Initialise(struct ca821x_dev *pDeviceRef)
 {
-	u8_t i;
+	u16_t i;
 
 	/* initialise PIB */
 	/* IEEE Address: upper 4 bytes are CA 5C 0D A0, lower 4 bytes are 00 00 00 00 */
@@ -82,15 +255,23 @@ void TEMPSENSE_APP_Coordinator_Initialise(struct ca821x_dev *pDeviceRef)
 	APP_ShortAddress = 0xFFFE; /* use long address */
 	memcpy(APP_LongAddress, (u8_t[])MAC_LONGADD, 8);
 
+	TASKLET_Cancel(&APP_TimeoutTasklet);
+	TASKLET_Init(&APP_TimeoutTasklet, &TEMPSENSE_APP_Coordinator_TimeoutCallback);
+	memset(APP_Dev, 0, sizeof(APP_Dev));
 	for (i = 0; i < APP_MAX_DEVICES; ++i)
 	{
-		APP_DevState[i]        = APP_CST_DONE;
-		APP_DevAssociated[i]   = 0;
-		APP_DevTimeout[i]      = 0;
-		APP_DevLongAddrLSBs[i] = 0;
-		APP_DevHandle[i]       = 0xFFFFFFFF;
+		APP_Dev[i].state     = APP_CST_DONE;
+		APP_Dev[i].handle    = 0xFFFFFFFF;
+		APP_Dev[i].hash_next = APP_DEV_NONE;
+		APP_Dev[i].prev      = APP_DEV_NONE;
+		APP_Dev[i].next      = (i + 1 < APP_MAX_DEVICES) ? (i + 1) : APP_DEV_NONE;
+		APP_DevHash[i]       = APP_DEV_NONE;
 	}
-	APP_NDEVICES = 0;
+	for (i = 0; i < 256; ++i) APP_DevByMsduHandle[i] = APP_DEV_NONE;
+	APP_DevFree   = 0;
+	APP_DevOldest = APP_DEV_NONE;
+	APP_DevNewest = APP_DEV_NONE;
+	APP_NDEVICES  = 0;
 
 	/* initialise MAC PIB */
 	TEMPSENSE_APP_InitPIB(pDeviceRef);
@@ -208,17 +389,15 @@ void TEMPSENSE_APP_Coordinator_AssociateResponse(struct MLME_ASSOCIATE_indicatio
 	u8_t  i;
 	u8_t  status;
 	u16_t shortadd;
-	u8_t  associated;
-	u32_t longaddr_lsbs;
-	u8_t  already_in_list;
+	u16_t devnum;
+	u16_t bucket;
+	u64_t longaddr;
 
 #if APP_USE_DEBUG
 	APP_Debug_SetAppState(0xA7);
 #endif /* APP_USE_DEBUG */
 
-	/* get 4 low bytes of ieee address to see if already associated */
-	longaddr_lsbs = (params->DeviceAddress[3] << 24) + (params->DeviceAddress[2] << 16) +
-	                (params->DeviceAddress[1] << 8) + (params->DeviceAddress[0]);
+	longaddr = GETLE64(params->DeviceAddress);
 
 	/* compare upper 4 bytes of long address (CA5C0DA0) */
 	if (memcmp(params->DeviceAddress + 4, APP_LongAddress + 4, 4))
@@ -230,18 +409,8 @@ void TEMPSENSE_APP_Coordinator_AssociateResponse(struct MLME_ASSOCIATE_indicatio
 		return;
 	}
 
-	/* check if device is already in device list by comparing lower 4 bytes of long address */
-	already_in_list = 0;
-	for (i = 0; i < APP_MAX_DEVICES; ++i)
-	{
-		if (longaddr_lsbs == APP_DevLongAddrLSBs[i])
-		{
-			already_in_list = 1;
-			break;
-		}
-	}
-
-	if (already_in_list)
+	/* check if device is already in device list */
+	if (TEMPSENSE_APP_Coordinator_FindDevice(longaddr) != APP_DEV_NONE)
 	{
 /* device already in device list */
 #if APP_USE_DEBUG
@@ -250,23 +419,9 @@ void TEMPSENSE_APP_Coordinator_AssociateResponse(struct MLME_ASSOCIATE_indicatio
 		return;
 	}
 
-	/* look for empty entry in device list and add device */
-	associated = 0;
-	for (i = 0; i < APP_MAX_DEVICES; ++i)
-	{
-		if (APP_DevAssociated[i] == 0)
-		{
-			associated             = 1;
-			APP_DevLongAddrLSBs[i] = longaddr_lsbs;
-			APP_DevAssociated[i]   = 1;
-			APP_DevState[i]        = APP_CST_DONE;
-			APP_DevTimeout[i]      = TIME_ReadAbsoluteTime();
-			shortadd               = MAC_SHORTADD + (i + 1);
-			break;
-		}
-	}
-
-	if (!associated)
+	/* take entry from free list */
+	devnum = APP_DevFree;
+	if (devnum == APP_DEV_NONE)
 	{
 /* no empty entry found in device list */
 #if APP_USE_DEBUG
@@ -276,6 +431,7 @@ void TEMPSENSE_APP_Coordinator_AssociateResponse(struct MLME_ASSOCIATE_indicatio
 		printf("Cannot associate, maximum number of sensors reached\n");
 		return;
 	}
+	shortadd = MAC_SHORTADD + (devnum + 1);
 
 	/* send out associate response */
 	status = MLME_ASSOCIATE_response(params->DeviceAddress, /* *pDeviceAddress */
@@ -294,13 +450,21 @@ void TEMPSENSE_APP_Coordinator_AssociateResponse(struct MLME_ASSOCIATE_indicatio
 		return;
 	}
 
-	/* success */
+	/* success, add device */
+	bucket                    = TEMPSENSE_APP_Coordinator_Hash(longaddr);
+	APP_DevFree               = APP_Dev[devnum].next;
+	APP_Dev[devnum].longaddr  = longaddr;
+	APP_Dev[devnum].state     = APP_CST_DONE;
+	APP_Dev[devnum].hash_next = APP_DevHash[bucket];
+	APP_DevHash[bucket]       = devnum;
+	TEMPSENSE_APP_Coordinator_Refresh(devnum, pDeviceRef);
+	APP_Dev[devnum].associated = 1;
 	++APP_NDEVICES;
 #if APP_USE_DEBUG
 	APP_Debug_SetAppState(0x0A);
 #endif /* APP_USE_DEBUG */
 	TEMPSENSE_APP_PrintSeconds();
-	printf("Detected Sensor %u on Channel %u, Addr=0x", (u8_t)(shortadd & 0x00FF), APP_Channel);
+	printf("Detected Sensor %u on Channel %u, Addr=0x", devnum + 1, APP_Channel);
 	for (i = 3; i < 4; i--)
 	{
 		printf("%02X", params->DeviceAddress[i]);
@@ -311,24 +475,20 @@ void TEMPSENSE_APP_Coordinator_AssociateResponse(struct MLME_ASSOCIATE_indicatio
 
 void TEMPSENSE_APP_Coordinator_ProcessDataInd(struct MCPS_DATA_indication_pset *params, struct ca821x_dev *pDeviceRef)
 {
-	u8_t            devnum;
-	u16_t           shortadd, panid;
-	u8_t            status;
-	u32_t           serialnr;
-	struct FullAddr DeviceFAdd;
-	u8_t            msdu[1];
-	u8_t            edvallp;
-	u8_t            len;
-
-	/* get ed / rssi value for last data packet */
-	HWME_GET_request_sync(HWME_EDVALLP, &len, &edvallp, pDeviceRef);
-
-	/* analyse packet */
+	u16_t                 devnum;
+	u16_t                 shortadd, panid;
+	u8_t                  status;
+	u32_t                 serialnr;
+	struct FullAddr       DeviceFAdd;
+	u8_t                  msdu[1];
+	struct tempsense_dev *dev;
+
+	/* analyse packet, the short address maps directly to the device entry */
 	panid    = (u16_t)(params->Src.PANId[1] << 8) + params->Src.PANId[0];
 	shortadd = (u16_t)(params->Src.Address[1] << 8) + params->Src.Address[0];
-	devnum   = (u8_t)((shortadd & 0xFF) - 1);
+	devnum   = (u16_t)(shortadd - MAC_SHORTADD - 1);
 
-	if ((panid != APP_PANId) || (devnum >= APP_MAX_DEVICES))
+	if ((panid != APP_PANId) || (params->Src.AddressMode != MAC_MODE_SHORT_ADDR) || (devnum >= APP_MAX_DEVICES))
 	{
 /* packet for coordinator not from associated device */
 #if APP_USE_DEBUG
@@ -336,10 +496,11 @@ void TEMPSENSE_APP_Coordinator_ProcessDataInd(struct MCPS_DATA_indication_pset *
 #endif /* APP_USE_DEBUG */
 		return;
 	}
-	if (APP_DevAssociated[devnum] != 1)
+	dev = &APP_Dev[devnum];
+	if (dev->associated != 1)
 	{
 		/* device not associated (anymore) */
-		APP_DevState[devnum] = APP_CST_DONE;
+		dev->state = APP_CST_DONE;
 #if APP_USE_DEBUG
 		APP_Debug_SetAppState(0xC2);
 #endif /* APP_USE_DEBUG */
@@ -354,7 +515,7 @@ void TEMPSENSE_APP_Coordinator_ProcessDataInd(struct MCPS_DATA_indication_pset *
 #endif // CASCODA_CA_VER >= 8212
 	{
 		/* unknown packet type */
-		APP_DevState[devnum] = APP_CST_DONE;
+		dev->state = APP_CST_DONE;
 #if APP_USE_DEBUG
 		APP_Debug_SetAppState(0xC3);
 #endif /* APP_USE_DEBUG */
@@ -368,10 +529,10 @@ void TEMPSENSE_APP_Coordinator_ProcessDataInd(struct MCPS_DATA_indication_pset *
 	if (params->Msdu[0] == PT_MSDU_D_WAKEUP)
 #endif // CASCODA_CA_VER >= 8212
 	{
-		if (APP_DevState[devnum] != APP_CST_DONE)
+		if (dev->state != APP_CST_DONE)
 		{
 			/* out of order */
-			APP_DevState[devnum] = APP_CST_DONE;
+			dev->state = APP_CST_DONE;
 #if APP_USE_DEBUG
 			APP_Debug_SetAppState(0xC4);
 #endif /* APP_USE_DEBUG */
@@ -381,7 +542,7 @@ void TEMPSENSE_APP_Coordinator_ProcessDataInd(struct MCPS_DATA_indication_pset *
 		if (params->MsduLength != 5)
 		{
 			/* wrong msdu length */
-			APP_DevState[devnum] = APP_CST_DONE;
+			dev->state = APP_CST_DONE;
 #if APP_USE_DEBUG
 			APP_Debug_SetAppState(0xC5);
 #endif /* APP_USE_DEBUG */
@@ -397,7 +558,7 @@ void TEMPSENSE_APP_Coordinator_ProcessDataInd(struct MCPS_DATA_indication_pset *
 		    (u32_t)((params->Msdu[4] << 24) + (params->Msdu[3] << 16) + (params->Msdu[2] << 8) + (params->Msdu[1]));
 #endif // CASCODA_CA_VER >= 8212
 
-		if (serialnr == APP_DevHandle[devnum])
+		if (serialnr == dev->handle)
 		{
 /* packet has been re-sent */
 #if APP_USE_DEBUG
@@ -406,8 +567,9 @@ void TEMPSENSE_APP_Coordinator_ProcessDataInd(struct MCPS_DATA_indication_pset *
 			return;
 		}
 
-		APP_DevState[devnum]   = APP_CST_WAKEUP_RECEIVED;
-		APP_DevHandle[devnum]  = serialnr;
+		dev->state             = APP_CST_WAKEUP_RECEIVED;
+		dev->handle            = serialnr;
+		dev->msdu_handle       = APP_NextMsduHandle++;
 		DeviceFAdd.AddressMode = MAC_MODE_SHORT_ADDR;
 		PUTLE16(shortadd, DeviceFAdd.Address);
 		PUTLE16(APP_PANId, DeviceFAdd.PANId);
@@ -423,7 +585,7 @@ void TEMPSENSE_APP_Coordinator_ProcessDataInd(struct MCPS_DATA_indication_pset *
 		                           0,                               /* PayloadIELength */
 		                           1,                               /* MsduLength */
 		                           msdu,                            /* pMsdu */
-		                           LS0_BYTE(APP_DevHandle[devnum]), /* MsduHandle */
+		                           dev->msdu_handle,                /* MsduHandle */
 		                           tx_op,                           /* pTxOptions */
 		                           0,                               /* SchTimestamp */
 		                           0,                               /* SchPeriod */
@@ -437,7 +599,7 @@ void TEMPSENSE_APP_Coordinator_ProcessDataInd(struct MCPS_DATA_indication_pset *
 		                           DeviceFAdd,                      /* DstAddr     */
 		                           1,                               /* MsduLength  */
 		                           msdu,                            /* *pMsdu      */
-		                           LS0_BYTE(APP_DevHandle[devnum]), /* MsduHandle  */
+		                           dev->msdu_handle,                /* MsduHandle  */
 		                           TXOPT_ACKREQ,                    /* TxOptions   */
 		                           NULLP,                           /* *pSecurity  */
 		                           pDeviceRef);
@@ -446,7 +608,7 @@ void TEMPSENSE_APP_Coordinator_ProcessDataInd(struct MCPS_DATA_indication_pset *
 		if (status)
 		{
 			/* data request fail (highly unlikely) */
-			APP_DevState[devnum] = APP_CST_DONE;
+			dev->state = APP_CST_DONE;
 #if APP_USE_DEBUG
 			APP_Debug_SetAppState(0xC7);
 #endif /* APP_USE_DEBUG */
@@ -454,7 +616,8 @@ void TEMPSENSE_APP_Coordinator_ProcessDataInd(struct MCPS_DATA_indication_pset *
 		else
 		{
 			/* success */
-			APP_DevState[devnum] = APP_CST_C_DATA_REQUESTED;
+			dev->state                            = APP_CST_C_DATA_REQUESTED;
+			APP_DevByMsduHandle[dev->msdu_handle] = devnum;
 #if APP_USE_DEBUG
 			APP_Debug_SetAppState(0xC8);
 #endif /* APP_USE_DEBUG */
@@ -469,10 +632,10 @@ void TEMPSENSE_APP_Coordinator_ProcessDataInd(struct MCPS_DATA_indication_pset *
 	if (params->Msdu[0] == PT_MSDU_D_DATA)
 #endif // CASCODA_CA_VER >= 8212
 	{
-		if (APP_DevState[devnum] != APP_CST_C_DATA_CONFIRMED)
+		if (dev->state != APP_CST_C_DATA_CONFIRMED)
 		{
 			/* out of order */
-			APP_DevState[devnum] = APP_CST_DONE;
+			dev->state = APP_CST_DONE;
 #if APP_USE_DEBUG
 			APP_Debug_SetAppState(0xC9);
 #endif /* APP_USE_DEBUG */
@@ -482,7 +645,7 @@ void TEMPSENSE_APP_Coordinator_ProcessDataInd(struct MCPS_DATA_indication_pset *
 		if (params->MsduLength != 6)
 		{
 			/* wrong msdu length */
-			APP_DevState[devnum] = APP_CST_DONE;
+			dev->state = APP_CST_DONE;
 #if APP_USE_DEBUG
 			APP_Debug_SetAppState(0xCA);
 #endif /* APP_USE_DEBUG */
@@ -490,13 +653,13 @@ void TEMPSENSE_APP_Coordinator_ProcessDataInd(struct MCPS_DATA_indication_pset *
 		}
 
 		/* success */
-		APP_DevState[devnum] = APP_CST_DONE;
+		dev->state = APP_CST_DONE;
 #if APP_USE_DEBUG
 		APP_Debug_SetAppState(0x0C);
 #endif /* APP_USE_DEBUG */
-		APP_DevTimeout[devnum] = TIME_ReadAbsoluteTime();
-		if ((APP_DevHandle[devnum] % APP_COORD_REPORTN) == 0)
-			TEMPSENSE_APP_Coordinator_DisplayData(devnum, edvallp, params, pDeviceRef);
+		TEMPSENSE_APP_Coordinator_Refresh(devnum, pDeviceRef);
+		if ((dev->handle % APP_COORD_REPORTN) == 0)
+			TEMPSENSE_APP_Coordinator_DisplayData(devnum, params, pDeviceRef);
 		/* coordinator soft reinitialisation after data exchange */
 		if (APP_COORD_SREINIT)
 			TEMPSENSE_APP_Coordinator_SoftReinit(pDeviceRef);
@@ -507,8 +670,7 @@ void TEMPSENSE_APP_Coordinator_ProcessDataInd(struct MCPS_DATA_indication_pset *
 
 void TEMPSENSE_APP_Coordinator_ProcessDataCnf(struct MCPS_DATA_confirm_pset *params, struct ca821x_dev *pDeviceRef)
 {
-	u8_t i;
-	u8_t found;
+	u16_t devnum;
 
 	if (params->Status != MAC_SUCCESS)
 	{
@@ -520,17 +682,14 @@ void TEMPSENSE_APP_Coordinator_ProcessDataCnf(struct MCPS_DATA_confirm_pset *par
 	}
 
 	/* check if confirm corresponds to C_DATA packet sent */
-	found = 0;
-	for (i = 0; i < APP_MAX_DEVICES; ++i)
+	devnum                                  = APP_DevByMsduHandle[params->MsduHandle];
+	APP_DevByMsduHandle[params->MsduHandle] = APP_DEV_NONE;
+	if ((devnum != APP_DEV_NONE) && (APP_Dev[devnum].state == APP_CST_C_DATA_REQUESTED) &&
+	    (APP_Dev[devnum].msdu_handle == params->MsduHandle))
 	{
-		if ((APP_DevState[i] == APP_CST_C_DATA_REQUESTED) && (LS0_BYTE(APP_DevHandle[i]) == params->MsduHandle))
-		{
-			found           = 1;
-			APP_DevState[i] = APP_CST_C_DATA_CONFIRMED;
-			break;
-		}
+		APP_Dev[devnum].state = APP_CST_C_DATA_CONFIRMED;
 	}
-	if (!found)
+	else
 	{
 /* confirm not matching for any device */
 #if APP_USE_DEBUG
@@ -540,16 +699,23 @@ void TEMPSENSE_APP_Coordinator_ProcessDataCnf(struct MCPS_DATA_confirm_pset *par
 
 } // End of TEMPSENSE_APP_Coordinator_ProcessDataCnf()
 
-void TEMPSENSE_APP_Coordinator_DisplayData(u8_t                              device,
-                                           u8_t                              edcoord,
+void TEMPSENSE_APP_Coordinator_DisplayData(u16_t                             device,
                                            struct MCPS_DATA_indication_pset *params,
                                            struct ca821x_dev                *pDeviceRef)
 {
 	u8_t  temp;
 	u16_t vbat;
+	u8_t  edcoord = 0;
+
+#if APP_REPORT_ED_COORD
+	u8_t len;
+
+	/* get ed / rssi value for last data packet, a synchronous call that is only made when enabled */
+	HWME_GET_request_sync(HWME_EDVALLP, &len, &edcoord, pDeviceRef);
+#endif /* APP_REPORT_ED_COORD */
 
 	TEMPSENSE_APP_PrintSeconds();
-	printf("TS: %u; N: %u", params->Src.Address[0], APP_DevHandle[device]);
+	printf("TS: %u; N: %u", device + 1, APP_Dev[device].handle);
 
 	/* temperature */
 	printf("; T: ");
@@ -596,63 +762,42 @@ void TEMPSENSE_APP_Coordinator_DisplayData(u8_t                              dev
 
 void TEMPSENSE_APP_Coordinator_CheckTimeouts(struct ca821x_dev *pDeviceRef)
 {
-	u8_t         i;
-	u32_t        tnow;
-	static u32_t tlast;
-	i32_t        tdiff;
-	u8_t         restart;
+	u16_t devnum;
+	u32_t tnow;
+	i32_t tdiff;
+	u8_t  restart;
 
 	tnow = TIME_ReadAbsoluteTime();
 
+	/* devices are ordered by the time they were last heard, so only the oldest need checking */
 	restart = 0;
-	for (i = 0; i < APP_MAX_DEVICES; ++i)
+	while ((devnum = APP_DevOldest) != APP_DEV_NONE)
 	{
-		if (APP_DevAssociated[i] == 1)
+		/* avoids cases where tnow < timeout (u32_t) */
+		tdiff = tnow - APP_Dev[devnum].lastheard;
+		if (tdiff <= (1000 * APP_TIMEOUTINTERVALL))
+			break;
+
+		TEMPSENSE_APP_PrintSeconds();
+		printf("Sensor %u (0x%08X) Timeout, disconnected; Devices connected: %u\n",
+		       devnum + 1,
+		       (u32_t)APP_Dev[devnum].longaddr,
+		       (APP_NDEVICES - 1));
+		TEMPSENSE_APP_Coordinator_RemoveDevice(devnum);
+		/* apply restart if last device has been disconnected */
+		if (APP_NDEVICES == 0)
 		{
-			/* avoids cases where tnow < timeout (u32_t) */
-			/* this can happen when this routine gets interrupted by a packet reception */
-			tdiff = tnow - APP_DevTimeout[i];
-			if (tdiff > (1000 * APP_TIMEOUTINTERVALL))
-			{
-				TEMPSENSE_APP_PrintSeconds();
-				printf("Sensor %u (0x%08X) Timeout, disconnected; Devices connected: %u\n",
-				       i + 1,
-				       APP_DevLongAddrLSBs[i],
-				       (APP_NDEVICES - 1));
-				APP_DevState[i]        = APP_CST_DONE;
-				APP_DevAssociated[i]   = 0;
-				APP_DevTimeout[i]      = 0;
-				APP_DevLongAddrLSBs[i] = 0;
-				APP_DevHandle[i]       = 0xFFFFFFFF;
-				--APP_NDEVICES;
-				/* apply restart if last device has been disconnected */
-				if (APP_NDEVICES == 0)
-				{
-					restart = 1;
-				}
-			}
+			restart = 1;
 		}
 	}
 
+	TEMPSENSE_APP_Coordinator_ScheduleTimeout(pDeviceRef);
+
 	if (restart)
 	{
 		EVBME_CAX_Restart(pDeviceRef);
 	}
 
-	/* coordinator soft reinitialisation if nothing is connected */
-	if (APP_COORD_SREINIT)
-	{
-		if (APP_NDEVICES == 0)
-		{
-			if ((((tnow - tlast) > (1000 * APP_WAKEUPINTERVALL)) && (APP_WAKEUPINTERVALL != 0)) ||
-			    (((tnow - tlast) > (100)) && (APP_WAKEUPINTERVALL == 0)))
-			{
-				TEMPSENSE_APP_Coordinator_SoftReinit(pDeviceRef);
-				tlast = tnow;
-			}
-		}
-	}
-
 } // End of TEMPSENSE_APP_Coordinator_CheckTimeouts()
 
 void TEMPSENSE_APP_Coordinator_CheckVbatt(u16_t vbat)
@@ -696,9 +841,11 @@ void TEMPSENSE_APP_Coordinator_CheckED(u8_t ed_ts, u8_t ed_coord)
 			printf("-");
 		else
 			printf("%u", ed_ts);
-		printf("; ED C: %u", ed_coord);
+		if (APP_REPORT_ED_COORD)
+			printf("; ED C: %u", ed_coord);
 	}
-	if (ed_coord < APP_ED_LIMIT)
+	/* without the coordinator value, warn on the sensor's reading */
+	if (ed_coord ? (ed_coord < APP_ED_LIMIT) : (ed_ts && (ed_ts < APP_ED_LIMIT)))
 		printf("; Warning: ED low!");
 } // End of TEMPSENSE_APP_Coordinator_CheckED()
 
@@ -736,7 +883,7 @@ void TEMPSENSE_APP_Coordinator_SoftReinit(struct ca821x_dev *pDeviceRef)
 
 void TEMPSENSE_APP_Coordinator_ReportStatus(void)
 {
-	u8_t i;
+	u16_t i;
 
 	if (APP_STATE != APP_ST_COORDINATOR)
 	{
@@ -746,15 +893,13 @@ void TEMPSENSE_APP_Coordinator_ReportStatus(void)
 
 	printf("Devices connected on Channel %u: %u\n", APP_Channel, APP_NDEVICES);
 
-	for (i = 0; i < APP_MAX_DEVICES; ++i)
+	/* list devices in the order they were heard */
+	for (i = APP_DevOldest; i != APP_DEV_NONE; i = APP_Dev[i].next)
 	{
-		if (APP_DevAssociated[i] == 1)
-		{
-			printf("%u: %08X; Packets received: %u; Last heard: %ums ago.\n",
-			       i + 1,
-			       APP_DevLongAddrLSBs[i],
-			       (APP_DevHandle[i] == 0xFFFFFFFF ? 0 : APP_DevHandle[i]),
-			       (TIME_ReadAbsoluteTime() - APP_DevTimeout[i]));
-		}
+		printf("%u: %08X; Packets received: %u; Last heard: %ums ago.\n",
+		       i + 1,
+		       (u32_t)APP_Dev[i].longaddr,
+		       (APP_Dev[i].handle == 0xFFFFFFFF ? 0 : APP_Dev[i].handle),
+		       (TIME_ReadAbsoluteTime() - APP_Dev[i].lastheard));
 	}
 }
@@ -76,6 +76,7 @@
 #include "lwm2mclient.h"
 #include "object_security.h"
 #include "platform.h"
+#include "pools.h"
 #include "sntp_helper.h"
 #ifdef WITH_MBEDTLS
 #include "mbedtlsconnection.h"
@@ -399,6 +400,33 @@ static void prv_object_list(void *aContext, uint8_t aArgsLength, char *aArgs[])
 	}
 }
 
+static void prv_output_pool(const char *name, const ca_pool *pool)
+{
+	otCliOutputFormat(POOLS_HEAP_FALLBACK ? "%s: %lu allocations from the heap, largest %lu bytes\r\n"
+	                                      : "%s: %lu failures, largest %lu bytes\r\n",
+	                  name,
+	                  (unsigned long)pool->failures,
+	                  (unsigned long)pool->largestFailure);
+	for (uint8_t i = 0; i < pool->numClasses; i++)
+	{
+		const ca_pool_class *poolClass = &pool->classes[i];
+
+		otCliOutputFormat(" - %4u bytes: %u/%u in use, high water %u, spills %lu\r\n",
+		                  poolClass->blockSize,
+		                  poolClass->stats.inUse,
+		                  poolClass->blockCount,
+		                  poolClass->stats.highWater,
+		                  (unsigned long)poolClass->stats.spills);
+	}
+}
+
+static void prv_memory(void *aContext, uint8_t aArgsLength, char *aArgs[])
+{
+	prv_output_pool("lwm2m", pools_get_lwm2m());
+	if (pools_get_mbedtls())
+		prv_output_pool("mbedtls", pools_get_mbedtls());
+}
+
 static void prv_update(void *aContext, uint8_t aArgsLength, char *aArgs[])
 {
 	if (aArgsLength == 0)
@@ -1110,6 +1138,11 @@ int main(int argc, char *argv[])
 
 	PlatformRadioInitWithDev(&dev);
 	OT_INSTANCE = otInstanceInitSingle();
+	pools_init();
+#ifdef WITH_MBEDTLS
+	// After OpenThread, which initialises the settings
+	connection_init(&dev);
+#endif
 
 	otAppCliInit(OT_INSTANCE);
 
@@ -1133,7 +1166,8 @@ int main(int argc, char *argv[])
 	                           {"lwls", prv_object_list},       //List URIs of available objects
 	                           {"lwdisp", prv_display_objects}, //Display objects
 	                           {"lwadd", prv_add},              //Add the test object (added by default)
-	                           {"lwrm", prv_remove}};           //Remove the test object
+	                           {"lwrm", prv_remove},            //Remove the test object
+	                           {"lwmem", prv_memory}};          //Show memory pool statistics
 
 	otCliSetUserCommands(commands, ARRAY_LENGTH(commands), OT_INSTANCE);
 
@@ -0,0 +1,249 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026, Cascoda Ltd.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Distribution License v1.0
+ * which accompanies this distribution.
+ *
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *******************************************************************************/
+
+/*
+ * DTLS session cache for the LwM2M client. A full DTLS handshake takes several flights and a few kilobytes over
+ * the mesh each time a connection is created, eg. after a registration failure or a reboot. The session of each
+ * server is cached in RAM and in the settings, and offered on the next handshake so that the server can resume it
+ * with an abbreviated handshake, from its session ID cache or from a session ticket.
+ *
+ * The DTLS 1.2 Connection ID extension is also requested, so that the server can still match the records of a
+ * connection after the address of the client changed. The client uses an empty Connection ID, as it does not need
+ * one in the records it receives.
+ *
+ * The serialised sessions contain the master secret, and are stored in the settings like the PSK is.
+ */
+
+#include <string.h>
+
+#include "cascoda-util/cascoda_hash.h"
+#include "cascoda-util/cascoda_settings.h"
+#include "ca821x_log.h"
+
+#include "dtls_session.h"
+
+/** A cached session */
+struct dtls_session
+{
+	uint32_t uriHash;                    //!< Hash of the server URI, 0 if the entry is free
+	uint32_t lastUsed;                   //!< Value of sUseCount when the entry was last used
+	uint16_t length;                     //!< Length of the serialised session
+	uint8_t  data[DTLS_SESSION_MAX_LEN]; //!< Session serialised with mbedtls_ssl_session_save()
+};
+
+static struct dtls_session sSessions[DTLS_SESSION_CACHE_SIZE];
+static struct ca821x_dev  *sDeviceRef;
+static uint32_t            sUseCount;
+//! Scratch buffer for a session and its URI hash, as stored in the settings
+static uint8_t sBuffer[sizeof(uint32_t) + DTLS_SESSION_MAX_LEN];
+
+static uint32_t hash_uri(const char *uri)
+{
+	uint32_t hash = HASH_fnv1a_32(uri, strlen(uri));
+
+	// 0 marks the free entries
+	return hash ? hash : 1;
+}
+
+static struct dtls_session *find_session(uint32_t uriHash)
+{
+	for (int i = 0; i < DTLS_SESSION_CACHE_SIZE; i++)
+	{
+		if (sSessions[i].uriHash == uriHash)
+			return &sSessions[i];
+	}
+	return NULL;
+}
+
+/* The entry of the server, else a free entry, else the least recently used one */
+static struct dtls_session *get_session_slot(uint32_t uriHash)
+{
+	struct dtls_session *slot = find_session(uriHash);
+
+	if (slot)
+		return slot;
+
+	slot = &sSessions[0];
+	for (int i = 1; i < DTLS_SESSION_CACHE_SIZE && slot->uriHash; i++)
+	{
+		if (!sSessions[i].uriHash || (int32_t)(sSessions[i].lastUsed - slot->lastUsed) < 0)
+			slot = &sSessions[i];
+	}
+	return slot;
+}
+
+static void persist_sessions(void)
+{
+	ca_error err = CA_ERROR_SUCCESS;
+
+	if (!sDeviceRef)
+		return;
+
+	caUtilSettingsDelete(sDeviceRef, DTLS_SESSION_SETTINGS_KEY, -1);
+	for (int i = 0; i < DTLS_SESSION_CACHE_SIZE && !err; i++)
+	{
+		struct dtls_session *session = &sSessions[i];
+		struct settingBuffer vector[2];
+
+		if (!session->uriHash)
+			continue;
+
+		vector[0].value  = (const uint8_t *)&session->uriHash;
+		vector[0].length = sizeof(session->uriHash);
+		vector[1].value  = session->data;
+		vector[1].length = session->length;
+		err              = caUtilSettingsAddVector(sDeviceRef, DTLS_SESSION_SETTINGS_KEY, vector, 2);
+	}
+
+	if (err)
+		ca_log_warn("Failed to store DTLS sessions, error %s", ca_error_str(err));
+}
+
+void dtls_session_init(struct ca821x_dev *pDeviceRef)
+{
+	int loaded = 0;
+
+	memset(sSessions, 0, sizeof(sSessions));
+	sDeviceRef = pDeviceRef;
+	sUseCount  = 0;
+
+	if (!pDeviceRef)
+		return;
+
+	for (int i = 0; loaded < DTLS_SESSION_CACHE_SIZE; i++)
+	{
+		struct dtls_session *session = &sSessions[loaded];
+		uint16_t             length  = sizeof(sBuffer);
+
+		if (caUtilSettingsGet(pDeviceRef, DTLS_SESSION_SETTINGS_KEY, i, sBuffer, &length))
+			break;
+		if (length <= sizeof(uint32_t) || length > sizeof(sBuffer))
+			continue;
+
+		memcpy(&session->uriHash, sBuffer, sizeof(uint32_t));
+		session->length = length - sizeof(uint32_t);
+		memcpy(session->data, sBuffer + sizeof(uint32_t), session->length);
+		loaded++;
+	}
+
+	if (loaded)
+		ca_log_info("Loaded %d DTLS sessions", loaded);
+}
+
+void dtls_session_configure(mbedtls_ssl_config *conf)
+{
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+	mbedtls_ssl_conf_session_tickets(conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+	mbedtls_ssl_conf_cid(conf, 0, MBEDTLS_SSL_UNEXPECTED_CID_IGNORE);
+#endif
+	(void)conf;
+}
+
+bool dtls_session_setup(mbedtls_ssl_context *ssl, const char *uri)
+{
+	struct dtls_session *cached = find_session(hash_uri(uri));
+	mbedtls_ssl_session  session;
+	int                  rval;
+
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+	mbedtls_ssl_set_cid(ssl, MBEDTLS_SSL_CID_ENABLED, NULL, 0);
+#endif
+
+	if (!cached)
+		return false;
+
+	mbedtls_ssl_session_init(&session);
+	rval = mbedtls_ssl_session_load(&session, cached->data, cached->length);
+	if (!rval)
+		rval = mbedtls_ssl_set_session(ssl, &session);
+	mbedtls_ssl_session_free(&session);
+
+	if (rval)
+	{
+		// Eg. stored by a firmware with a different mbedtls configuration
+		ca_log_warn("Dropping cached DTLS session, error -0x%x", -rval);
+		memset(cached, 0, sizeof(*cached));
+		persist_sessions();
+		return false;
+	}
+
+	cached->lastUsed = ++sUseCount;
+	return true;
+}
+
+void dtls_session_save(mbedtls_ssl_context *ssl, const char *uri)
+{
+	uint32_t             uriHash = hash_uri(uri);
+	struct dtls_session *cached;
+	mbedtls_ssl_session  session;
+	size_t               length = 0;
+	int                  rval;
+
+	mbedtls_ssl_session_init(&session);
+	rval = mbedtls_ssl_get_session(ssl, &session);
+	if (!rval)
+		rval = mbedtls_ssl_session_save(&session, sBuffer, DTLS_SESSION_MAX_LEN, &length);
+	mbedtls_ssl_session_free(&session);
+
+	if (rval == MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL)
+	{
+		// length is the size that the session needs
+		ca_log_warn("DTLS session of %u bytes too large to cache, it will not be resumed", (unsigned)length);
+		dtls_session_forget(uri);
+		return;
+	}
+	if (rval)
+	{
+		ca_log_warn("Cannot cache DTLS session, error -0x%x, it will not be resumed", -rval);
+		dtls_session_forget(uri);
+		return;
+	}
+
+	cached           = get_session_slot(uriHash);
+	cached->lastUsed = ++sUseCount;
+
+	// A resumed session is usually unchanged, so there is nothing to write to flash
+	if (cached->uriHash == uriHash && cached->length == length && !memcmp(cached->data, sBuffer, length))
+		return;
+
+	cached->uriHash = uriHash;
+	cached->length  = (uint16_t)length;
+	memcpy(cached->data, sBuffer, length);
+	persist_sessions();
+}
+
+void dtls_session_forget(const char *uri)
+{
+	struct dtls_session *cached = find_session(hash_uri(uri));
+
+	if (!cached)
+		return;
+
+	memset(cached, 0, sizeof(*cached));
+	persist_sessions();
+}
+
+bool dtls_session_has_cid(mbedtls_ssl_context *ssl)
+{
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+	int enabled = MBEDTLS_SSL_CID_DISABLED;
+
+	if (mbedtls_ssl_get_peer_cid(ssl, &enabled, NULL, NULL))
+		return false;
+	return enabled == MBEDTLS_SSL_CID_ENABLED;
+#else
+	(void)ssl;
+	return false;
+#endif
+}
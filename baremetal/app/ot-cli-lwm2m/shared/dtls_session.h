@@ -0,0 +1,80 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026, Cascoda Ltd.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Distribution License v1.0
+ * which accompanies this distribution.
+ *
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *******************************************************************************/
+
+#ifndef DTLS_SESSION_H_
+#define DTLS_SESSION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mbedtls/ssl.h"
+
+#include "ca821x_api.h"
+
+/* Number of servers whose DTLS session is cached */
+#ifndef DTLS_SESSION_CACHE_SIZE
+#define DTLS_SESSION_CACHE_SIZE 2
+#endif
+
+/* Maximum length of a serialised session. A PSK session takes about 110 bytes, and a certificate based one about
+ * 150 bytes as only a digest of the server certificate is kept (MBEDTLS_SSL_KEEP_PEER_CERTIFICATE is disabled),
+ * plus the session ticket if the server issues one. Sessions that don't fit are not cached. With its URI hash, a
+ * session must fit in one block of the settings (511 bytes).
+ */
+#ifndef DTLS_SESSION_MAX_LEN
+#define DTLS_SESSION_MAX_LEN (511 - sizeof(uint32_t))
+#endif
+
+/* Flash settings key of the cached sessions, next to the keys of cascoda-bm-thread/include/platform.h */
+#define DTLS_SESSION_SETTINGS_KEY 0xCA60
+
+/**
+ * \brief Initialise the session cache, and load the sessions persisted in the settings
+ * \param pDeviceRef - device whose settings store the sessions, or NULL to only cache them in RAM
+ */
+void dtls_session_init(struct ca821x_dev *pDeviceRef);
+
+/**
+ * \brief Enable session tickets and DTLS Connection IDs in an ssl configuration, if mbedtls supports them
+ * \param conf - configuration of the client, before mbedtls_ssl_setup()
+ */
+void dtls_session_configure(mbedtls_ssl_config *conf);
+
+/**
+ * \brief Request a Connection ID, and offer the cached session of a server to resume it
+ * \param ssl - ssl context, after mbedtls_ssl_setup() and before the handshake
+ * \param uri - URI of the server
+ * \return true if a cached session was offered
+ */
+bool dtls_session_setup(mbedtls_ssl_context *ssl, const char *uri);
+
+/**
+ * \brief Cache the session of a completed handshake, and persist it if it changed
+ * \param ssl - ssl context, once the handshake is over
+ * \param uri - URI of the server
+ */
+void dtls_session_save(mbedtls_ssl_context *ssl, const char *uri);
+
+/**
+ * \brief Drop the cached session of a server, eg. because the server refused to resume it
+ * \param uri - URI of the server
+ */
+void dtls_session_forget(const char *uri);
+
+/**
+ * \brief Check whether the Connection ID extension was negotiated for a connection
+ * \param ssl - ssl context, once the handshake is over
+ * \return true if the records carry a Connection ID
+ */
+bool dtls_session_has_cid(mbedtls_ssl_context *ssl);
+
+#endif /* DTLS_SESSION_H_ */
@@ -24,6 +24,7 @@
 #include "openthread/thread.h"
 #include "ca821x_log.h"
 
+#include "dtls_session.h"
 #include "mbedtlsconnection.h"
 #include "object_security.h"
 
@@ -47,13 +48,49 @@ static connection_t *GetFreeCon()
 	return NULL;
 }
 
+/**
+ * Check the progress of the DTLS handshake after mbedtls was run, caching the session once it completes.
+ * @param connection The connection
+ * @param rval       Return value of the last mbedtls_ssl_handshake or mbedtls_ssl_read call
+ */
+static void connection_check_handshake(connection_t *connection, int rval)
+{
+	const char *uri;
+
+	if (connection->isHandshakeOver)
+		return;
+
+	uri = security_get_server_uri(connection->securityObj, connection->securityInstId);
+
+	if (connection->ssl.state == MBEDTLS_SSL_HANDSHAKE_OVER)
+	{
+		connection->isHandshakeOver = true;
+		ca_log_info("DTLS handshake done in %ums, %s session%s",
+		            (unsigned)(TIME_ReadAbsoluteTime() - connection->handshakeStart),
+		            connection->isResuming ? "offered cached" : "new",
+		            dtls_session_has_cid(&connection->ssl) ? ", with connection ID" : "");
+		if (uri)
+			dtls_session_save(&connection->ssl, uri);
+	}
+	else if (rval < 0 && rval != MBEDTLS_ERR_SSL_WANT_READ && rval != MBEDTLS_ERR_SSL_WANT_WRITE)
+	{
+		// The handshake failed, so the next one with this server should start from scratch
+		if (connection->isResuming && uri)
+			dtls_session_forget(uri);
+		connection->isResuming = false;
+	}
+}
+
 static ca_error mbedtls_tasklet_callback(void *context)
 {
 	connection_t *connection = context;
+	int           rval;
 
 	connection->isTimerPassed = true;
 
-	mbedtls_ssl_handshake(&connection->ssl);
+	rval = mbedtls_ssl_handshake(&connection->ssl);
+	connection_check_handshake(connection, rval);
+	return CA_ERROR_SUCCESS;
 }
 
 static connection_t *connection_new_incoming(otInstance *aInstance, lwm2m_context_t *lwm2mH)
@@ -94,6 +131,7 @@ static void connection_udp_receive(void *aContext, otMessage *aMessage, const ot
 			}
 		} while (rval > 0);
 		rxMessage = NULL;
+		connection_check_handshake(connection, rval);
 	}
 	else
 	{
@@ -307,6 +345,7 @@ static void connection_dns_callback(ca_error aError, const otIp6Address *aAddres
 		mbedtls_ssl_conf_rng(&connection->conf, mbedtls_ctr_drbg_random, &ctr_drbg_ctx);
 		mbedtls_ssl_conf_min_version(&connection->conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
 		mbedtls_ssl_conf_max_version(&connection->conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+		dtls_session_configure(&connection->conf);
 
 		secMode = security_get_mode(connection->securityObj, connection->securityInstId);
 		switch (secMode)
@@ -352,6 +391,10 @@ static void connection_dns_callback(ca_error aError, const otIp6Address *aAddres
 
 		//TODO: Can call mbedtls_ssl_set_hostname to verify certificate hostname here if desired.
 
+		connection->isResuming = dtls_session_setup(
+		    &connection->ssl, security_get_server_uri(connection->securityObj, connection->securityInstId));
+		connection->handshakeStart = TIME_ReadAbsoluteTime();
+
 		rval = mbedtls_ssl_handshake(&connection->ssl);
 		if (rval != 0 && rval != MBEDTLS_ERR_SSL_WANT_READ && rval != MBEDTLS_ERR_SSL_WANT_WRITE)
 		{
@@ -416,6 +459,11 @@ exit:
 	return error;
 }
 
+void connection_init(struct ca821x_dev *pDeviceRef)
+{
+	dtls_session_init(pDeviceRef);
+}
+
 connection_t *connection_create(otInstance      *aInstance,
                                 lwm2m_context_t *lwm2mH,
                                 lwm2m_object_t  *securityObj,
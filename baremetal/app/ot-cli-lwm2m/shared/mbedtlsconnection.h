@@ -33,6 +33,7 @@
 #include "openthread/udp.h"
 
 #include "cascoda-util/cascoda_tasklet.h"
+#include "ca821x_api.h"
 #include "ca821x_error.h"
 
 #define LWM2M_STANDARD_PORT_STR "5683"
@@ -64,16 +65,28 @@ typedef struct connection_t
 	int                 cipherSuites[CIPHERSUITE_COUNT + 1]; //!< List of the cipher suites in use
 	int                 securityInstId;                      //!< lwm2m security instance ID
 	uint32_t            intermediateTime; //!< Used with mbedtls_tasklet to implement the intermediate time
+	uint32_t            handshakeStart;   //!< Time the DTLS handshake started, for logging
 	bool                inUse;            //!< Used internally to determine whether this connection structure is in use
 	bool                isTimerPassed;    //!< Used in with mbedtls_tasklet to determine expired or cancelled
 	bool                isSecure;         //!< Used to determine whether this connection is secured with dtls
+	bool                isResuming;       //!< A cached session was offered to the server in the handshake
+	bool                isHandshakeOver;  //!< The DTLS handshake completed, and its session was cached
 } connection_t;
 
+/**
+ * Initialise the connections, and load the DTLS sessions cached in the settings. Must be called once, before
+ * connection_create.
+ *
+ * @param pDeviceRef  Device whose settings store the DTLS sessions
+ */
+void connection_init(struct ca821x_dev *pDeviceRef);
+
 /**
  * Called from example code directly to create a connection when connecting to a server.
  *
  * Note that the connection will not be immediately active, and will require some time to resolve hostname and form
- * DTLS connection with the server.
+ * DTLS connection with the server. If a DTLS session with the server is cached, it is offered for an abbreviated
+ * handshake.
  *
  * @param aInstance  Openthread Instance pointer
  * @param lwm2mH  Wakaama context pointer
@@ -23,22 +23,28 @@
 #include <sys/time.h>
 
 #include "ca821x_log.h"
+#include "pools.h"
 
 #ifndef LWM2M_MEMORY_TRACE
 
 void *lwm2m_malloc(size_t s)
 {
-	return malloc(s);
+	return pools_lwm2m_alloc(s);
 }
 
 void lwm2m_free(void *p)
 {
-	free(p);
+	pools_lwm2m_free(p);
 }
 
 char *lwm2m_strdup(const char *str)
 {
-	return strdup(str);
+	size_t len  = strlen(str) + 1;
+	char  *copy = pools_lwm2m_alloc(len);
+
+	if (copy)
+		memcpy(copy, str, len);
+	return copy;
 }
 
 #endif
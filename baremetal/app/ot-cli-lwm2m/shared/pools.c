@@ -0,0 +1,215 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026, Cascoda Ltd.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Distribution License v1.0
+ * which accompanies this distribution.
+ *
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *******************************************************************************/
+
+/*
+ * Fixed-block memory pools for wakaama and mbedtls. wakaama allocates and frees lists, URIs, observations and
+ * CoAP transactions on every step, and mbedtls allocates its handshake buffers, so allocating them from the
+ * heap fragments it over time. The pools bound the memory used by each, and allocate in constant time.
+ * An allocation that no class has a free block for fails, and is counted as a failure of the pool, unless the
+ * POOLS_HEAP_FALLBACK debug option is enabled.
+ *
+ * The number of blocks of each size can be configured with the LWM2M_POOL_COUNT_x and MBEDTLS_POOL_COUNT_x
+ * definitions, and the high water marks shown by the 'lwmem' command tell how many blocks are needed.
+ */
+
+#include <stdlib.h>
+
+#include "pools.h"
+#include "ca821x_log.h"
+
+#ifdef WITH_MBEDTLS
+#include "mbedtls/platform.h"
+#endif
+
+/* Number of blocks of each size for wakaama. These are the peaks of the pool benchmark over 2000000 steps
+ * (12, 15, 47, 11 and 7 blocks) with some margin, and two of the larger blocks for the CoAP packets and Block1
+ * transfers, which the synthetic trace does not model.
+ */
+#ifndef LWM2M_POOL_COUNT_16
+#define LWM2M_POOL_COUNT_16 16
+#endif
+#ifndef LWM2M_POOL_COUNT_32
+#define LWM2M_POOL_COUNT_32 20
+#endif
+#ifndef LWM2M_POOL_COUNT_64
+#define LWM2M_POOL_COUNT_64 56
+#endif
+#ifndef LWM2M_POOL_COUNT_128
+#define LWM2M_POOL_COUNT_128 16
+#endif
+#ifndef LWM2M_POOL_COUNT_256
+#define LWM2M_POOL_COUNT_256 8
+#endif
+#ifndef LWM2M_POOL_COUNT_512
+#define LWM2M_POOL_COUNT_512 2
+#endif
+#ifndef LWM2M_POOL_COUNT_1024
+#define LWM2M_POOL_COUNT_1024 2
+#endif
+
+static POOL_STORAGE(lwm2m16, 16, LWM2M_POOL_COUNT_16);
+static POOL_STORAGE(lwm2m32, 32, LWM2M_POOL_COUNT_32);
+static POOL_STORAGE(lwm2m64, 64, LWM2M_POOL_COUNT_64);
+static POOL_STORAGE(lwm2m128, 128, LWM2M_POOL_COUNT_128);
+static POOL_STORAGE(lwm2m256, 256, LWM2M_POOL_COUNT_256);
+static POOL_STORAGE(lwm2m512, 512, LWM2M_POOL_COUNT_512);
+static POOL_STORAGE(lwm2m1024, 1024, LWM2M_POOL_COUNT_1024);
+
+static ca_pool_class lwm2mClasses[] = {
+    POOL_CLASS(lwm2m16, 16, LWM2M_POOL_COUNT_16),
+    POOL_CLASS(lwm2m32, 32, LWM2M_POOL_COUNT_32),
+    POOL_CLASS(lwm2m64, 64, LWM2M_POOL_COUNT_64),
+    POOL_CLASS(lwm2m128, 128, LWM2M_POOL_COUNT_128),
+    POOL_CLASS(lwm2m256, 256, LWM2M_POOL_COUNT_256),
+    POOL_CLASS(lwm2m512, 512, LWM2M_POOL_COUNT_512),
+    POOL_CLASS(lwm2m1024, 1024, LWM2M_POOL_COUNT_1024),
+};
+
+static ca_pool lwm2mPool;
+
+#ifdef WITH_MBEDTLS
+/* Number of blocks of each size for mbedtls. The largest blocks hold the DTLS record buffers, which are
+ * MBEDTLS_SSL_MAX_CONTENT_LEN plus the record overhead.
+ */
+#ifndef MBEDTLS_POOL_COUNT_32
+#define MBEDTLS_POOL_COUNT_32 64
+#endif
+#ifndef MBEDTLS_POOL_COUNT_64
+#define MBEDTLS_POOL_COUNT_64 16
+#endif
+#ifndef MBEDTLS_POOL_COUNT_128
+#define MBEDTLS_POOL_COUNT_128 8
+#endif
+#ifndef MBEDTLS_POOL_COUNT_256
+#define MBEDTLS_POOL_COUNT_256 4
+#endif
+#ifndef MBEDTLS_POOL_COUNT_512
+#define MBEDTLS_POOL_COUNT_512 4
+#endif
+#ifndef MBEDTLS_POOL_COUNT_1024
+#define MBEDTLS_POOL_COUNT_1024 2
+#endif
+#ifndef MBEDTLS_POOL_COUNT_1664
+#define MBEDTLS_POOL_COUNT_1664 2
+#endif
+
+static POOL_STORAGE(mbedtls32, 32, MBEDTLS_POOL_COUNT_32);
+static POOL_STORAGE(mbedtls64, 64, MBEDTLS_POOL_COUNT_64);
+static POOL_STORAGE(mbedtls128, 128, MBEDTLS_POOL_COUNT_128);
+static POOL_STORAGE(mbedtls256, 256, MBEDTLS_POOL_COUNT_256);
+static POOL_STORAGE(mbedtls512, 512, MBEDTLS_POOL_COUNT_512);
+static POOL_STORAGE(mbedtls1024, 1024, MBEDTLS_POOL_COUNT_1024);
+static POOL_STORAGE(mbedtls1664, 1664, MBEDTLS_POOL_COUNT_1664);
+
+static ca_pool_class mbedtlsClasses[] = {
+    POOL_CLASS(mbedtls32, 32, MBEDTLS_POOL_COUNT_32),
+    POOL_CLASS(mbedtls64, 64, MBEDTLS_POOL_COUNT_64),
+    POOL_CLASS(mbedtls128, 128, MBEDTLS_POOL_COUNT_128),
+    POOL_CLASS(mbedtls256, 256, MBEDTLS_POOL_COUNT_256),
+    POOL_CLASS(mbedtls512, 512, MBEDTLS_POOL_COUNT_512),
+    POOL_CLASS(mbedtls1024, 1024, MBEDTLS_POOL_COUNT_1024),
+    POOL_CLASS(mbedtls1664, 1664, MBEDTLS_POOL_COUNT_1664),
+};
+
+static ca_pool mbedtlsPool;
+
+static void *mbedtls_pool_calloc(size_t n, size_t size)
+{
+	void *ptr = POOL_Calloc(&mbedtlsPool, n, size);
+
+#if POOLS_HEAP_FALLBACK
+	if (!ptr)
+		ptr = calloc(n, size);
+#endif
+#if POOLS_TRACE
+	ca_log_note("mbedtls: a %p %u", ptr, (unsigned)(n * size));
+#endif
+	if (!ptr)
+		ca_log_warn("mbedtls pool exhausted, %u bytes", (unsigned)(n * size));
+	return ptr;
+}
+
+static void mbedtls_pool_free(void *ptr)
+{
+#if POOLS_TRACE
+	ca_log_note("mbedtls: f %p", ptr);
+#endif
+	if (POOL_Free(&mbedtlsPool, ptr))
+	{
+#if POOLS_HEAP_FALLBACK
+		// Anything that is not a block of the pool was allocated from the heap
+		free(ptr);
+#else
+		ca_log_crit("mbedtls freed %p outside of its pool", ptr);
+#endif
+	}
+}
+#endif //WITH_MBEDTLS
+
+void pools_init(void)
+{
+	POOL_Init(&lwm2mPool, lwm2mClasses, sizeof(lwm2mClasses) / sizeof(lwm2mClasses[0]));
+
+#ifdef WITH_MBEDTLS
+	/* This replaces the allocator that OpenThread registered for mbedtls, so OpenThread must not have anything
+	 * allocated from mbedtls yet.
+	 */
+	POOL_Init(&mbedtlsPool, mbedtlsClasses, sizeof(mbedtlsClasses) / sizeof(mbedtlsClasses[0]));
+	mbedtls_platform_set_calloc_free(mbedtls_pool_calloc, mbedtls_pool_free);
+#endif
+}
+
+void *pools_lwm2m_alloc(size_t size)
+{
+	void *ptr = POOL_Alloc(&lwm2mPool, size);
+
+#if POOLS_HEAP_FALLBACK
+	if (!ptr)
+		ptr = malloc(size);
+#endif
+#if POOLS_TRACE
+	ca_log_note("lwm2m: a %p %u", ptr, (unsigned)size);
+#endif
+	if (!ptr)
+		ca_log_warn("lwm2m pool exhausted, %u bytes", (unsigned)size);
+	return ptr;
+}
+
+void pools_lwm2m_free(void *ptr)
+{
+#if POOLS_TRACE
+	ca_log_note("lwm2m: f %p", ptr);
+#endif
+	if (POOL_Free(&lwm2mPool, ptr))
+	{
+#if POOLS_HEAP_FALLBACK
+		// Anything that is not a block of the pool was allocated from the heap
+		free(ptr);
+#else
+		ca_log_crit("lwm2m freed %p outside of its pool", ptr);
+#endif
+	}
+}
+
+const ca_pool *pools_get_lwm2m(void)
+{
+	return &lwm2mPool;
+}
+
+const ca_pool *pools_get_mbedtls(void)
+{
+#ifdef WITH_MBEDTLS
+	return &mbedtlsPool;
+#else
+	return NULL;
+#endif
+}
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2026, Cascoda Ltd.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Distribution License v1.0
+ * which accompanies this distribution.
+ *
+ * The Eclipse Distribution License is available at
+ *    http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *******************************************************************************/
+
+#ifndef POOLS_H_
+#define POOLS_H_
+
+#include <stddef.h>
+
+#include "cascoda-util/cascoda_pool.h"
+
+/* Log every allocation and free of the pools, as "<pool>: a <pointer> <size>" and "<pool>: f <pointer>" lines.
+ * A log captured from a device can be replayed on the host with the pool benchmark, see cascoda-util/benchmark.
+ */
+#ifndef POOLS_TRACE
+#define POOLS_TRACE 0
+#endif
+
+/* Debug option: take an allocation that no class has a free block for from the heap, instead of failing it, eg. to
+ * find the block counts that a use case needs without it failing. This brings back unbounded heap use and its
+ * fragmentation, and the heap is sized for the allocations that are not from the pools, so it is off by default.
+ */
+#ifndef POOLS_HEAP_FALLBACK
+#define POOLS_HEAP_FALLBACK 0
+#endif
+
+/**
+ * \brief Initialise the memory pools, and route the mbedtls allocations to them
+ * Must be called before anything is allocated from mbedtls, right after the OpenThread instance is initialised.
+ */
+void pools_init(void);
+
+/**
+ * \brief Allocate memory for wakaama
+ * \param size - size of the allocation
+ * \return pointer to the memory, or NULL if the pool has no free block that is large enough
+ */
+void *pools_lwm2m_alloc(size_t size);
+
+/**
+ * \brief Free memory allocated with pools_lwm2m_alloc()
+ * \param ptr - memory to free
+ */
+void pools_lwm2m_free(void *ptr);
+
+/**
+ * \brief Get the pool used by wakaama, eg. for its statistics
+ * \return the pool
+ */
+const ca_pool *pools_get_lwm2m(void);
+
+/**
+ * \brief Get the pool used by mbedtls, eg. for its statistics
+ * \return the pool, or NULL if mbedtls is not used
+ */
+const ca_pool *pools_get_mbedtls(void);
+
+#endif /* POOLS_H_ */
@@ -24,11 +24,13 @@
 #include "openthread/coap.h"
 #include "openthread/instance.h"
 #include "openthread/link.h"
+#include "openthread/platform/settings.h"
 #include "openthread/tasklet.h"
 #include "openthread/thread.h"
 #include "platform.h"
 
 #include "FreeRTOS.h"
+#include "queue.h"
 #include "semphr.h"
 #include "task.h"
 
@@ -63,6 +65,8 @@ const int IMAGE_OK_SLEEP_MS = 8 * 1000;
 const int IMAGE_RANDOM_SLEEP_MS = 4 * 1000;
 // How long to wait between resending image GET requests
 const int IMAGE_FAIL_RETRY_MS = 10 * 1000;
+// How long to wait for the next block of an image before giving up on it
+const int IMAGE_BLOCK_TIMEOUT_MS = 10 * 1000;
 
 const char *uriCascodaDiscover    = "ca/di";
 const char *uriCascodaTemperature = "ca/te";
@@ -85,14 +89,46 @@ static int          deviceID;
 /******************************************************************************/
 TaskHandle_t      CommsTaskHandle;
 SemaphoreHandle_t CommsMutexHandle;
+QueueHandle_t     BlockQueueHandle;
 
-// The size matches the maximum size of a CoAP packet
-static unsigned char message_buffer[1024];
-// length of the message currently in the buffer
-static uint16_t message_length = 0;
-// The resolution of the image is 296x128
-#define IMAGE_SIZE (296 * 128 / 8)
-static unsigned char image_buffer[IMAGE_SIZE];
+/******************************************************************************/
+/****** Image transfer                                                   ******/
+/******************************************************************************/
+// The image is a gzip stream, transferred with CoAP Block2 in blocks of this size
+#define IMAGE_BLOCK_SZX OT_COAP_OPTION_BLOCK_SZX_512
+#define IMAGE_BLOCK_SIZE 512
+// Size of the inflate window. This must match the window the server compresses images with.
+#define IMAGE_DICT_SIZE 1024
+// How many decompressed bytes are written to the display at once
+#define IMAGE_CHUNK_SIZE 256
+// Maximum length of the ETag identifying an image
+#define IMAGE_ETAG_MAX_LENGTH 8
+
+// Received blocks. One is decompressed while the next one is received.
+static uint8_t  block_buffer[2][IMAGE_BLOCK_SIZE];
+static uint16_t block_length[2];
+static bool     block_busy[2];
+// Block being decompressed, or -1
+static int current_block = -1;
+// Number of the next block to request
+static uint32_t next_block;
+// Whether the next block must be requested as soon as a buffer is free
+static bool request_pending;
+// Whether the last block has been received
+static bool transfer_done;
+// Whether the server has confirmed that the displayed image is still valid
+static bool image_unchanged;
+
+// ETag of the image on the display, kept in flash across deep power down
+static uint8_t displayed_etag[IMAGE_ETAG_MAX_LENGTH];
+static uint8_t displayed_etag_length;
+// ETag of the image being received, from the first block
+static uint8_t received_etag[IMAGE_ETAG_MAX_LENGTH];
+static uint8_t received_etag_length;
+
+static struct uzlib_uncomp image_decomp;
+static uint8_t             dict_ring[IMAGE_DICT_SIZE];
+static uint8_t             image_chunk[IMAGE_CHUNK_SIZE];
 
 void initialise_communications();
 
@@ -253,62 +289,40 @@ exit:
 	return error;
 }
 
-void decompress_data()
-{
-	// Decompress the message using uzlib
-
-	// Decompressed length, can be mismatched by one byte
-	unsigned int dlen = IMAGE_SIZE + 1;
-	// How many bytes to decompress in one pass
-	const int OUT_CHUNK_SIZE = 1;
-	int       res;
+static otError sendImageRequest(uint32_t block);
 
-	/* -- decompress data -- */
-
-	struct uzlib_uncomp d;
-	uzlib_uncompress_init(&d, NULL, 0);
-
-	/* all 3 fields below must be initialized by user */
-	d.source         = message_buffer;
-	d.source_limit   = message_buffer + IMAGE_SIZE - 4;
-	d.source_read_cb = NULL;
-
-	res = uzlib_gzip_parse_header(&d);
-	if (res != TINF_OK)
-	{
-		// Could not parse GZIP header
-		configASSERT(0);
-	}
-
-	d.dest_start = d.dest = image_buffer;
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Request the next block of the image, if there is a buffer free for it.
+ * Otherwise, it is requested when the decompression releases a buffer.
+ * Must be called with the comms mutex held.
+ *******************************************************************************
+ ******************************************************************************/
+static void requestNextBlock(void)
+{
+	int failed = -1;
 
-	while (dlen)
+	if (block_busy[next_block % 2])
 	{
-		unsigned int chunk_len = dlen < OUT_CHUNK_SIZE ? dlen : OUT_CHUNK_SIZE;
-		d.dest_limit           = d.dest + chunk_len;
-		res                    = uzlib_uncompress_chksum(&d);
-		dlen -= chunk_len;
-		if (res != TINF_OK)
-		{
-			break;
-		}
+		request_pending = true;
+		return;
 	}
 
-	if (res != TINF_DONE)
-	{
-		// Error during decompression
-		configASSERT(0);
-	}
+	request_pending = false;
+	if (sendImageRequest(next_block) != OT_ERROR_NONE)
+		xQueueSend(BlockQueueHandle, &failed, 0);
 }
 
 static void handleImageResponse(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo, otError aError)
 {
-	//CBOR variables
-	CborError  err;
-	CborParser parser;
-	CborValue  value;
-	CborValue  result;
-	CborValue  id_result;
+	otCoapOptionIterator iterator;
+	const otCoapOption  *etag;
+	uint8_t              etag_value[IMAGE_ETAG_MAX_LENGTH];
+	uint64_t             block2 = 0;
+	uint32_t             num;
+	bool                 more;
+	uint16_t             length;
+	int                  slot = -1;
 
 	if (aError == OT_ERROR_RESPONSE_TIMEOUT && timeoutCount++ > 3)
 		isConnected = false;
@@ -316,62 +330,69 @@ static void handleImageResponse(void *aContext, otMessage *aMessage, const otMes
 		timeoutCount = 0;
 
 	if (aError != OT_ERROR_NONE)
-		return;
+		goto exit;
+
+	// The image on the display is still the one assigned, nothing to transfer
+	if (otCoapMessageGetCode(aMessage) == OT_COAP_CODE_VALID && next_block == 0)
+	{
+		isConnected     = true;
+		image_unchanged = true;
+		goto exit;
+	}
 
 	if (otCoapMessageGetCode(aMessage) != OT_COAP_CODE_CONTENT)
-		return;
+		goto exit;
 
 	isConnected = true;
 
-	// Put the data in the message buffer
-	message_length = otMessageGetLength(aMessage) - otMessageGetOffset(aMessage);
-	otMessageRead(aMessage, otMessageGetOffset(aMessage), &message_buffer, message_length);
+	SuccessOrExit(otCoapOptionIteratorInit(&iterator, aMessage));
+	etag = otCoapOptionIteratorGetFirstOptionMatching(&iterator, OT_COAP_OPTION_E_TAG);
+	if (etag != NULL)
+	{
+		if (etag->mLength > sizeof(etag_value))
+			goto exit;
+		SuccessOrExit(otCoapOptionIteratorGetOptionValue(&iterator, etag_value));
+	}
 
-	//Initialise the CBOR parser
-	SuccessOrExit(err = cbor_parser_init(message_buffer, message_length, 0, &parser, &value));
+	// A response without a Block2 option contains the whole image
+	if (otCoapOptionIteratorGetFirstOptionMatching(&iterator, OT_COAP_OPTION_BLOCK2) != NULL)
+		SuccessOrExit(otCoapOptionIteratorGetOptionUintValue(&iterator, &block2));
 
-	//Extract the values corresponding to the keys from the CBOR map
-	SuccessOrExit(err = cbor_value_map_find_value(&value, "img", &result));
-	SuccessOrExit(err = cbor_value_map_find_value(&value, "devID", &id_result));
+	num    = block2 >> 4;
+	more   = (block2 >> 3) & 0x01;
+	length = otMessageGetLength(aMessage) - otMessageGetOffset(aMessage);
 
-	if (cbor_value_get_type(&result) != CborInvalidType)
+	if (num != next_block || block_busy[num % 2] || length > IMAGE_BLOCK_SIZE)
+		goto exit;
+
+	// All the blocks must come from the same version of the image
+	if (num == 0)
 	{
-		size_t len = sizeof(message_buffer);
-		SuccessOrExit(err = cbor_value_copy_byte_string(&result, message_buffer, &len, NULL));
+		received_etag_length = etag ? etag->mLength : 0;
+		memcpy(received_etag, etag_value, received_etag_length);
 	}
-
-	if (cbor_value_get_type(&id_result) != CborInvalidType)
+	else if ((etag ? etag->mLength : 0) != received_etag_length ||
+	         memcmp(received_etag, etag_value, received_etag_length) != 0)
 	{
-		SuccessOrExit(err = cbor_value_get_int(&id_result, &deviceID));
-		snprintf(uriCascodaImageRequestQuery, sizeof(uriCascodaImageRequestQuery), "id=%d", deviceID);
+		goto exit;
 	}
 
-	// Turn off the radio if you have successfully received an image
-	otInstanceFinalize(OT_INSTANCE);
+	slot = num % 2;
+	otMessageRead(aMessage, otMessageGetOffset(aMessage), block_buffer[slot], length);
+	block_length[slot] = length;
+	block_busy[slot]   = true;
+	transfer_done      = !more;
+	next_block++;
 
-	// Decompress the data and put it in the image buffer
-	decompress_data();
-
-	SIF_IL3820_Initialise(FULL_UPDATE);
-	SIF_IL3820_DisplayImage(image_buffer, WITH_CLEAR);
-
-	// Get a random number, to randomise the sleep time
-	uint16_t random;
-	RAND_GetBytes(sizeof(random), &random);
-
-	// Sleep until you must get a new image
-	int random_delay_ms = random % IMAGE_RANDOM_SLEEP_MS;
-	EVBME_PowerDown(PDM_DPD, IMAGE_OK_SLEEP_MS + random_delay_ms, &sDeviceRef);
+	// Receive the next block while this one is being decompressed
+	if (more)
+		requestNextBlock();
 
 exit:
-	if (err)
-		return;
-	// Should not get here
-	for (;;)
-		;
+	xQueueSend(BlockQueueHandle, &slot, 0);
 }
 
-static otError sendImageRequest(void)
+static otError sendImageRequest(uint32_t block)
 {
 	otError       error   = OT_ERROR_NONE;
 	otMessage    *message = NULL;
@@ -388,11 +409,20 @@ static otError sendImageRequest(void)
 	//Build CoAP header
 	otCoapMessageInit(message, OT_COAP_TYPE_CONFIRMABLE, OT_COAP_CODE_GET);
 	otCoapMessageGenerateToken(message, 2);
+
+	//Let the server check whether the image on the display has changed
+	if (block == 0 && displayed_etag_length)
+		SuccessOrExit(error = otCoapMessageAppendOption(
+		                  message, OT_COAP_OPTION_E_TAG, displayed_etag_length, displayed_etag));
+
 	SuccessOrExit(error = otCoapMessageAppendUriPathOptions(message, uriCascodaImage));
 
 	//Append URI option that identifies the device's ID
 	SuccessOrExit(error = otCoapMessageAppendUriQueryOption(message, uriCascodaImageRequestQuery));
 
+	//Ask for the block of the image
+	SuccessOrExit(error = otCoapMessageAppendBlock2Option(message, block, false, IMAGE_BLOCK_SZX));
+
 	memset(&messageInfo, 0, sizeof(messageInfo));
 	messageInfo.mPeerAddr = serverIp;
 	messageInfo.mPeerPort = OT_DEFAULT_COAP_PORT;
@@ -409,6 +439,149 @@ exit:
 	return error;
 }
 
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief uzlib callback reading the compressed image. Releases the block that
+ * has been decompressed, and waits for the next one to be received.
+ *******************************************************************************
+ ******************************************************************************/
+static int readImageBlock(struct uzlib_uncomp *d)
+{
+	int  slot;
+	bool last;
+
+	xSemaphoreTake(CommsMutexHandle, portMAX_DELAY);
+	if (current_block >= 0)
+		block_busy[current_block] = false;
+	current_block = -1;
+	if (request_pending)
+		requestNextBlock();
+	last = transfer_done;
+	xSemaphoreGive(CommsMutexHandle);
+
+	// Once the last block has been received, there is no need to wait
+	if (xQueueReceive(BlockQueueHandle, &slot, last ? 0 : IMAGE_BLOCK_TIMEOUT_MS / portTICK_PERIOD_MS) != pdTRUE)
+		return -1;
+	if (slot < 0 || block_length[slot] == 0)
+		return -1;
+
+	current_block   = slot;
+	d->source       = block_buffer[slot];
+	d->source_limit = block_buffer[slot] + block_length[slot];
+
+	return *d->source++;
+}
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Download the image from the server, decompressing it and writing it
+ * to the display RAM as the blocks arrive.
+ *******************************************************************************
+ * \return CA_ERROR_SUCCESS if the whole image has been written to the display,
+ * CA_ERROR_ALREADY if the image on the display has not changed, CA_ERROR_FAIL
+ * if the download, the decompression or the write to the display failed
+ *******************************************************************************
+ ******************************************************************************/
+static ca_error receiveImage(void)
+{
+	struct uzlib_uncomp *d               = &image_decomp;
+	bool                 display_started = false;
+	ca_error             error           = CA_ERROR_SUCCESS;
+	int                  res;
+
+	xSemaphoreTake(CommsMutexHandle, portMAX_DELAY);
+	xQueueReset(BlockQueueHandle);
+	block_busy[0] = block_busy[1] = false;
+	current_block                 = -1;
+	next_block                    = 0;
+	transfer_done                 = false;
+	image_unchanged               = false;
+	requestNextBlock();
+	xSemaphoreGive(CommsMutexHandle);
+
+	uzlib_uncompress_init(d, dict_ring, sizeof(dict_ring));
+	d->source         = NULL;
+	d->source_limit   = NULL;
+	d->source_read_cb = readImageBlock;
+
+	res = uzlib_gzip_parse_header(d);
+
+	while (res == TINF_OK && !error)
+	{
+		d->dest_start = d->dest = image_chunk;
+		d->dest_limit           = image_chunk + sizeof(image_chunk);
+
+		res = uzlib_uncompress_chksum(d);
+		if (res != TINF_OK && res != TINF_DONE)
+			break;
+
+		// Only wake the display up once there is something to show
+		if (!display_started)
+		{
+			error = SIF_IL3820_Initialise(FULL_UPDATE);
+			if (!error)
+				SIF_IL3820_StartFrameMemory();
+			display_started = true;
+		}
+		// A frame that was not fully written must not be displayed, nor its ETag kept
+		if (!error)
+			error = SIF_IL3820_WriteFrameMemory(image_chunk, d->dest - image_chunk);
+	}
+
+	xSemaphoreTake(CommsMutexHandle, portMAX_DELAY);
+	if (current_block >= 0)
+		block_busy[current_block] = false;
+	current_block = -1;
+	xSemaphoreGive(CommsMutexHandle);
+
+	if (image_unchanged)
+		return CA_ERROR_ALREADY;
+
+	if (res != TINF_DONE || error)
+	{
+		if (display_started)
+			SIF_IL3820_DeepSleep();
+		return CA_ERROR_FAIL;
+	}
+
+	return CA_ERROR_SUCCESS;
+}
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Turn the radio off, display the received image if there is one and
+ * sleep until a new image must be requested.
+ *******************************************************************************
+ * \param refresh Whether a new image has been received and must be displayed
+ *******************************************************************************
+ ******************************************************************************/
+static void displayImageAndSleep(bool refresh)
+{
+	xSemaphoreTake(CommsMutexHandle, portMAX_DELAY);
+
+	// Remember which image is on the display, so that it is not sent again
+	if (refresh)
+		otPlatSettingsSet(OT_INSTANCE, eink_etag_key, received_etag, received_etag_length);
+
+	// Turn off the radio now that the image has been received
+	otInstanceFinalize(OT_INSTANCE);
+
+	if (refresh)
+		SIF_IL3820_DisplayFrameMemory();
+
+	// Get a random number, to randomise the sleep time
+	uint16_t random;
+	RAND_GetBytes(sizeof(random), &random);
+
+	// Sleep until you must get a new image
+	int random_delay_ms = random % IMAGE_RANDOM_SLEEP_MS;
+	EVBME_PowerDown(PDM_DPD, IMAGE_OK_SLEEP_MS + random_delay_ms, &sDeviceRef);
+
+	// Should not get here
+	for (;;)
+		;
+}
+
 void ImageHandlerTask(void *unused)
 {
 	(void)unused;
@@ -421,11 +594,12 @@ void ImageHandlerTask(void *unused)
 	{
 		if (isConnected)
 		{
-			xSemaphoreTake(CommsMutexHandle, portMAX_DELAY);
-			sendImageRequest();
-			xSemaphoreGive(CommsMutexHandle);
+			ca_error status = receiveImage();
+
+			if (status == CA_ERROR_SUCCESS || status == CA_ERROR_ALREADY)
+				displayImageAndSleep(status == CA_ERROR_SUCCESS);
 
-			// Block after requesting data
+			// Block after failing to get an image
 			const TickType_t delay = IMAGE_FAIL_RETRY_MS / portTICK_PERIOD_MS;
 			vTaskDelay(delay);
 		}
@@ -482,6 +656,12 @@ void initialise_communications()
 	PlatformRadioInitWithDev(&sDeviceRef);
 	OT_INSTANCE = otInstanceInitSingle();
 
+	// Load the ETag of the image that was on the display before going to sleep
+	uint16_t etagLength = sizeof(displayed_etag);
+	if (otPlatSettingsGet(OT_INSTANCE, eink_etag_key, 0, displayed_etag, &etagLength) == OT_ERROR_NONE &&
+	    etagLength <= sizeof(displayed_etag))
+		displayed_etag_length = etagLength;
+
 	SENSORIF_SPI_Config(1);
 
 	if (!otDatasetIsCommissioned(OT_INSTANCE))
@@ -530,6 +710,8 @@ int main(void)
 {
 	// Create the mutex that controls access to the OpenThread API
 	CommsMutexHandle = xSemaphoreCreateMutex();
+	// Create the queue of received image blocks, and room for a failure
+	BlockQueueHandle = xQueueCreate(3, sizeof(int));
 
 	// Create the communications task. It controls the radio and the
 	// Thread network stack.
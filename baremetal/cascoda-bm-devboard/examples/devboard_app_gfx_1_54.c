@@ -95,6 +95,8 @@ static void load_screen(u8_t nr)
 #elif defined EPAPER_MIKROE_1_54_INCH
 		SIF_SSD1608_overlay_qr_code(qr, get_framebuffer(), 2, 2, 2);
 #endif
+		// the QR code is drawn straight into the frame buffer
+		gfx_drv_markDirty(0, 0, LCDWIDTH - 1, LCDHEIGHT - 1);
 		//display_setRotation(1);
 		display_setCursor(1, 65);
 		display_setTextColor(BLACK, WHITE);
@@ -73,6 +73,16 @@ extern u8_t EVBME_UseMAC;
 extern void (*EVBME_Message)(char *message, size_t len);
 extern void (*MAC_Message)(u8_t CommandId, u8_t Count, const u8_t *pBuffer);
 
+/** Counters of the buffered stdout, see EVBME_StdoutGetStats() */
+struct EVBME_StdoutStats
+{
+	u32_t mBytesWritten; //!< Characters printed, including the dropped ones
+	u32_t mBytesDropped; //!< Characters discarded because the buffer was full
+	u32_t mOverflows;    //!< Number of times a character was printed to a full buffer
+	u32_t mFramesSent;   //!< Number of frames sent upstream
+	u16_t mPeakUsage;    //!< Highest number of characters buffered at once
+};
+
 /******************************************************************************/
 /****** EVBME API Functions                                              ******/
 /******************************************************************************/
@@ -120,6 +130,31 @@ ca_error EVBME_NotHandled(const struct MAC_Message *msg, struct ca821x_dev *pDev
  ******************************************************************************/
 void cascoda_io_handler(struct ca821x_dev *pDeviceRef);
 
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Sends the complete lines buffered by printf upstream, in one frame of
+ *        up to SERIAL_MAC_RX_LEN characters. Called by cascoda_io_handler().
+ *******************************************************************************
+ ******************************************************************************/
+void EVBME_StdoutProcess(void);
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Sends everything buffered by printf upstream, including an incomplete
+ *        last line. Call before resetting or powering down the MCU.
+ *******************************************************************************
+ ******************************************************************************/
+void EVBME_StdoutFlush(void);
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Gets the counters of the buffered stdout
+ *******************************************************************************
+ * \param aStats - Filled with the counters since reset
+ *******************************************************************************
+ ******************************************************************************/
+void EVBME_StdoutGetStats(struct EVBME_StdoutStats *aStats);
+
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief re-initialises CA821x / MAC PIB after powerdown. The function pointer
@@ -281,10 +281,15 @@ void BSP_USBSerialRxDequeue(void);
 void BSP_SerialWriteAll(u8_t *pBuffer, u32_t BufferSize);
 
 /**
- * \brief Read Character(s) from Serial
+ * \brief Read received Character(s) from Serial
+ *
+ * Characters are received in the background, eg. by DMA into a circular buffer,
+ * and the BSP calls Serial_ReadInterface() when the line goes idle after
+ * receiving, or before its buffer can overflow. This copies out as many as are
+ * available, without waiting.
  *
  * \param pBuffer - Pointer to Data Buffer
- * \param BufferSize - Max. Characters to Read, 0 to cancel read.
+ * \param BufferSize - Max. Characters to Read
  *
  * \return Number of Characters placed in Buffer
  *
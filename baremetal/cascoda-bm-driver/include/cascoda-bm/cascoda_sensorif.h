@@ -59,8 +59,10 @@ extern "C" {
 #if defined(CASCODA_CHILI2_CONFIG)
 u8_t SENSORIF_SPI_Chip_Select(void);
 void SENSORIF_SECURE_I2C_Config(u32_t portnum);
-void SENSORIF_SECURE_SPI_Config(u32_t portnum);
-void SENSORIF_SECURE_UART_Config(u32_t portnum);
+void     SENSORIF_SECURE_SPI_Config(u32_t portnum);
+void     SENSORIF_SECURE_UART_Config(u32_t portnum);
+ca_error SENSORIF_SECURE_SPI_WriteDMA(const u8_t *out_data, u32_t len);
+void     SENSORIF_SECURE_RegisterSPIComplete(void (*callback)(void));
 #endif
 
 /* Note: most internal GPIO pull-ups have a value of around 50kOhms which is usually
@@ -169,6 +171,33 @@ void SENSORIF_SPI_Deinit(void);
  ************************************************************************************************************/
 ca_error SENSORIF_SPI_Write(u8_t out_data);
 
+/************************************************************************************************************/
+/*********************************************************************************************************/ /**
+ * \brief Writes a buffer to SPI slave in one transaction, waiting until the last byte has been sent.
+ * Large buffers are sent with DMA where the platform supports it, with the CPU sleeping in the meantime.
+ * \param out_data - data to send
+ * \param len - number of bytes to send
+ *************************************************************************************************************
+ * \return Return CA_ERROR_SUCCESS = 0x00 if successful, or the error that stopped the transfer
+ *************************************************************************************************************
+ ************************************************************************************************************/
+ca_error SENSORIF_SPI_WriteBuffer(const u8_t *out_data, u32_t len);
+
+/************************************************************************************************************/
+/*********************************************************************************************************/ /**
+ * \brief Starts writing a buffer to SPI slave, and returns without waiting for it to be sent.
+ * The buffer must not be modified until the callback has been called. Other SPI functions must
+ * not be used in the meantime.
+ * \param out_data - data to send
+ * \param len - number of bytes to send
+ * \param callback - called once the last byte has been sent, possibly from interrupt context. May be NULL.
+ *************************************************************************************************************
+ * \return Return CA_ERROR_SUCCESS = 0x00 if the transfer has started, CA_ERROR_BUSY if another transfer is
+ * still in progress
+ *************************************************************************************************************
+ ************************************************************************************************************/
+ca_error SENSORIF_SPI_WriteBufferAsync(const u8_t *out_data, u32_t len, void (*callback)(void));
+
 /************************************************************************************************************/
 /*********************************************************************************************************/ /**
  * \brief Read data in the RX while sending IDLE data to TX. This is intended for receive-only transmission from the slave.
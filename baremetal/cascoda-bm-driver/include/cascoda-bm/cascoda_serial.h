@@ -45,6 +45,10 @@ extern "C" {
 #define SERIAL_MAC_RX_LEN (254) //!< Maximum serial transfer payload length
 #endif
 
+#if !defined(SERIAL_RX_QUEUE_LEN)
+#define SERIAL_RX_QUEUE_LEN (4) //!< Number of received UART commands that can wait for dispatch (power of two)
+#endif
+
 /** Structure of serial transfers */
 struct SerialBuffer
 {
@@ -72,7 +76,8 @@ extern int (*cascoda_serial_dispatch)(u8_t *buf, size_t len, struct ca821x_dev *
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief Load next command into SerialRxBuffer if possible
- * Note: Not applicable to UART, as read into buffer via interrupt.
+ * For UART, this moves the oldest queued command into SerialRxBuffer, and
+ * acknowledges received commands with RX_RDY while there is room for more.
  *******************************************************************************
  * \return 1 if Command ready, 0 if not
  *******************************************************************************
@@ -83,6 +88,9 @@ u8_t SerialGetCommand(void);
 /***************************************************************************/ /**
  * \brief Read in next Command from Serial hardware
  *******************************************************************************
+ * For UART, called by the BSP from interrupt context when data has been
+ * received. Parses every complete command into the receive queue.
+ *******************************************************************************
  * \return 1 if Command ready, 0 if not
  *******************************************************************************
  ******************************************************************************/
@@ -140,11 +148,6 @@ void SerialSendRxRdy(void);
  */
 void SerialSendRxFail(void);
 
-/**
- * For an asynchronous (DMA) read, call this when the DMA transfer is complete.
- */
-void SerialReadComplete(void);
-
 /**
  * for power down, don't wait for RxRdy, power down immediately
  */
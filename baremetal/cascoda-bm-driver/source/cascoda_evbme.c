@@ -858,6 +858,7 @@ void cascoda_io_handler(struct ca821x_dev *pDeviceRef)
 	CA_OS_LockAPI();
 	DISPATCH_FromCA821x(pDeviceRef);
 	TASKLET_Process();
+	EVBME_StdoutProcess();
 
 #if defined(USE_USB) || defined(USE_UART)
 	SerialGetCommand();
@@ -882,10 +883,6 @@ void cascoda_io_handler(struct ca821x_dev *pDeviceRef)
 		{
 			EVBMESendDownStream(&SerialRxBuffer.CmdId, pDeviceRef);
 		}
-#if defined(USE_UART)
-		/* send RX_RDY */
-		SerialSendRxRdy();
-#endif /* USE_UART */
 		SerialRxPending = false;
 	}
 #endif /* USE_UART || USE_USB */
@@ -964,6 +961,7 @@ void EVBME_PowerDown(enum powerdown_mode mode, u32_t sleeptime_ms, struct ca821x
 		MLME_GET_request_sync(macDSN, 0, &attlen, dsn, pDeviceRef);
 	}
 
+	EVBME_StdoutFlush();
 #if defined(USE_USB)
 	BSP_DisableUSB();
 #endif /* USE_USB */
@@ -33,7 +33,9 @@
  */
 
 #include <assert.h>
+#include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #include <sys/time.h>
 #include <time.h>
 
@@ -45,54 +47,159 @@
 #include "cascoda-bm/cascoda_evbme.h"
 #include "cascoda-bm/cascoda_interface.h"
 #include "cascoda-bm/cascoda_os.h"
+#include "cascoda-bm/cascoda_serial.h"
 
-/** Max characters that can be buffered before being sent upstream */
-#define MAX_PUTC_CHARS (128)
+/*
+ * Printed text is buffered in a ring, and sent upstream from cascoda_io_handler rather than from printf. Complete
+ * lines are coalesced into frames of up to STDOUT_FRAME_LEN characters, separated by '\n', which the host splits
+ * back into lines. A line longer than a frame is sent in several frames.
+ */
 
-uint8_t PutcCount = 0;              //!< Current length of PutcBuffer
-uint8_t PutcBuffer[MAX_PUTC_CHARS]; //!< Debug message buffer
+/** Max characters that can be sent upstream in one frame */
+#define STDOUT_FRAME_LEN (SERIAL_MAC_RX_LEN)
+
+#if CASCODA_BM_STDOUT_BUFFER_SIZE < STDOUT_FRAME_LEN || CASCODA_BM_STDOUT_BUFFER_SIZE > UINT16_MAX
+#error "CASCODA_BM_STDOUT_BUFFER_SIZE must be between SERIAL_MAC_RX_LEN and 65535"
+#endif
+
+static uint8_t  sStdoutBuffer[CASCODA_BM_STDOUT_BUFFER_SIZE]; //!< Ring of printed characters
+static uint16_t sStdoutHead;                                  //!< Index of the oldest character
+static uint16_t sStdoutLen;                                   //!< Number of buffered characters
+static uint16_t sStdoutLinesLen;                              //!< Number of them that are in complete lines
+static uint8_t  sStdoutFrame[STDOUT_FRAME_LEN];               //!< Frame being sent upstream
+
+static struct EVBME_StdoutStats sStdoutStats;
 
 // EVBME_Message Function for Upstream Communications in:
 // - cascoda_serial_uart.c
 // - cascoda_serial_usb.c
 
+static uint8_t stdout_at(uint16_t offset)
+{
+	return sStdoutBuffer[(sStdoutHead + offset) % CASCODA_BM_STDOUT_BUFFER_SIZE];
+}
+
+static void stdout_consume(uint16_t len)
+{
+	sStdoutHead = (sStdoutHead + len) % CASCODA_BM_STDOUT_BUFFER_SIZE;
+	sStdoutLen -= len;
+	sStdoutLinesLen = (sStdoutLinesLen > len) ? sStdoutLinesLen - len : 0;
+}
+
 /**
- * Send buffered message upstream
+ * Send the oldest buffered characters upstream in one frame
+ *
+ * \param aPartial - also send the last line if it is incomplete
+ * \return true if a frame was sent
  */
-static void flushbuf()
+static bool stdout_send_frame(bool aPartial)
 {
-	if (PutcCount != 0)
+	uint16_t window = (sStdoutLinesLen < STDOUT_FRAME_LEN + 1) ? sStdoutLinesLen : STDOUT_FRAME_LEN + 1;
+	uint16_t len    = 0;
+	uint16_t skip   = 0;
+
+	// Send as many complete lines as fit, without the '\n' after the last one
+	for (uint16_t i = window; i > 0; i--)
 	{
-		if (EVBME_Message != NULL)
+		if (stdout_at(i - 1) == '\n')
 		{
-			EVBME_Message((char *)PutcBuffer, PutcCount);
+			len  = i - 1;
+			skip = 1;
+			break;
 		}
-		PutcCount = 0;
 	}
+
+	if (!skip)
+	{
+		if (sStdoutLen >= STDOUT_FRAME_LEN)
+			len = STDOUT_FRAME_LEN;
+		else if (aPartial && sStdoutLen)
+			len = sStdoutLen;
+		else
+			return false;
+	}
+
+	for (uint16_t i = 0; i < len; i++) sStdoutFrame[i] = stdout_at(i);
+	stdout_consume(len + skip);
+
+	if (EVBME_Message != NULL)
+	{
+		EVBME_Message((char *)sStdoutFrame, len);
+		sStdoutStats.mFramesSent++;
+	}
+	return true;
+}
+
+/**
+ * Make room for one character in the full buffer
+ */
+static void stdout_overflow(void)
+{
+	uint16_t drop = 0;
+
+	sStdoutStats.mOverflows++;
+
+#if defined(CASCODA_BM_STDOUT_OVERFLOW_BLOCK)
+	// A full buffer always holds a frame, so this makes progress
+	if (EVBME_Message != NULL && stdout_send_frame(false))
+		return;
+#endif
+
+	// Drop the oldest line, or a frame's worth of a line that is too long to send in one
+	while (drop < sStdoutLinesLen && drop < STDOUT_FRAME_LEN)
+	{
+		if (stdout_at(drop++) == '\n')
+			break;
+	}
+	if (drop == 0)
+		drop = STDOUT_FRAME_LEN;
+
+	stdout_consume(drop);
+	sStdoutStats.mBytesDropped += drop;
+}
+
+void EVBME_StdoutProcess(void)
+{
+	stdout_send_frame(false);
+}
+
+void EVBME_StdoutFlush(void)
+{
+	while (stdout_send_frame(true))
+		;
+}
+
+void EVBME_StdoutGetStats(struct EVBME_StdoutStats *aStats)
+{
+	*aStats = sStdoutStats;
 }
 
 /**
  * \brief putchar override for printf messages
  *
- * Writes characters to PutcBuffer until a newline is received, at which point
- * HOST_flush is called.
+ * Writes characters to the stdout buffer, which is sent upstream by EVBME_StdoutProcess. Empty lines are not sent.
  *
  * \param OutChar - Character to put in output buffer
  * \return Character written to output buffer
  */
 int putchar(int OutChar)
 {
-	if (OutChar == '\n')
-	{
-		flushbuf();
+	sStdoutStats.mBytesWritten++;
+
+	// Also skips the newline after a line that was sent in frames of its own because it was too long
+	if (OutChar == '\n' && sStdoutLen == sStdoutLinesLen)
 		return (int)OutChar;
-	}
-	PutcBuffer[PutcCount] = OutChar;
-	PutcCount++;
-	if (PutcCount == MAX_PUTC_CHARS)
-	{
-		flushbuf();
-	}
+
+	if (sStdoutLen == CASCODA_BM_STDOUT_BUFFER_SIZE)
+		stdout_overflow();
+
+	sStdoutBuffer[(sStdoutHead + sStdoutLen) % CASCODA_BM_STDOUT_BUFFER_SIZE] = OutChar;
+	sStdoutLen++;
+	if (OutChar == '\n')
+		sStdoutLinesLen = sStdoutLen;
+	if (sStdoutLen > sStdoutStats.mPeakUsage)
+		sStdoutStats.mPeakUsage = sStdoutLen;
+
 	return (int)OutChar;
 } // End of putchar()
 
@@ -177,6 +284,7 @@ int _lseek(int file, int ptr, int dir)
 void _exit(int status)
 {
 	(void)status;
+	EVBME_StdoutFlush();
 	BSP_SystemReset(SYSRESET_APROM);
 
 	while (1)
@@ -42,38 +42,137 @@
 #include "mbedtls/entropy_poll.h"
 
 #include "cascoda-util/cascoda_rand.h"
+#include "cascoda-util/cascoda_tasklet.h"
+#include "cascoda-util/cascoda_time.h"
 #include "ca821x_api.h"
+#include "ca821x_log.h"
 #include "ca821x_toolchain.h"
 #include "cascoda_bm_internal.h"
 
 #define MIN(a, b) (((a) < (b)) ? (a) : (b))
 
+/* Size of the entropy pool. One mbedtls entropy gather (MBEDTLS_ENTROPY_MAX_GATHER) can be served from a full pool. */
+#ifndef RAND_ENTROPY_POOL_SIZE
+#define RAND_ENTROPY_POOL_SIZE 128
+#endif
+
+/* Interval in ms between two refills of the pool, each of which takes one HWME_RANDOMNUM request */
+#ifndef RAND_ENTROPY_REFILL_INTERVAL
+#define RAND_ENTROPY_REFILL_INTERVAL 1
+#endif
+
 static struct ca821x_dev *entropyDev = NULL;
 
-static int getEntropy(void *data, unsigned char *output, size_t len, size_t *olen)
+/*
+ * Entropy from the CA-821x is read over SPI a few bytes at a time, so it is gathered into a pool in the background
+ * by a tasklet, and consumed by the seeding and reseeding of the DRBGs without waiting for the radio. On platforms
+ * with a TRNG (MBEDTLS_ENTROPY_HARDWARE_ALT), the TRNG output is mixed into the pool. When the pool runs out, the
+ * radio is read directly. The TRNG is never used in its place, as mbedtls already polls it as a separate source
+ * through mbedtls_hardware_poll, and it would be counted twice.
+ */
+static uint8_t    sEntropyPool[RAND_ENTROPY_POOL_SIZE];
+static uint16_t   sEntropyPoolLen = 0;
+static ca_tasklet sEntropyRefillTasklet;
+
+/* Read one batch of entropy from the CA-821x into aOut, which must hold MAX_HWME_ATTRIBUTE_SIZE bytes. The current
+ * firmware returns 2 bytes per request, but longer responses are used in full. Returns the number of bytes read. */
+static uint8_t readRadioEntropy(uint8_t *aOut)
+{
+	uint8_t readlen = 0;
+
+	if (!entropyDev || HWME_GET_request_sync(HWME_RANDOMNUM, &readlen, aOut, entropyDev) != MAC_SUCCESS)
+		return 0;
+
+	return MIN(readlen, MAX_HWME_ATTRIBUTE_SIZE);
+}
+
+/* Read entropy from the radio without using the pool. Returns the number of bytes read, which can be less than aLen. */
+static size_t readEntropyDirect(uint8_t *aOut, size_t aLen)
+{
+	uint8_t buf[MAX_HWME_ATTRIBUTE_SIZE];
+	size_t  readlen = MIN(readRadioEntropy(buf), aLen);
+
+	memcpy(aOut, buf, readlen);
+	return readlen;
+}
+
+static void scheduleEntropyRefill(void)
+{
+	if (entropyDev && sEntropyPoolLen < RAND_ENTROPY_POOL_SIZE && !TASKLET_IsQueued(&sEntropyRefillTasklet))
+		TASKLET_ScheduleDelta(&sEntropyRefillTasklet, RAND_ENTROPY_REFILL_INTERVAL, NULL);
+}
+
+static ca_error entropyRefillCallback(void *aContext)
+{
+	uint8_t buf[MAX_HWME_ATTRIBUTE_SIZE];
+	uint8_t readlen = readRadioEntropy(buf);
+
+	(void)aContext;
+
+	if (!readlen)
+		return CA_ERROR_FAIL;
+
+#if defined(MBEDTLS_ENTROPY_HARDWARE_ALT)
+	uint8_t trng[MAX_HWME_ATTRIBUTE_SIZE];
+	size_t  olen = 0;
+
+	// XOR of independent sources is at least as strong as the stronger one
+	if (mbedtls_hardware_poll(NULL, trng, readlen, &olen) == 0 && olen == readlen)
+	{
+		for (uint8_t i = 0; i < readlen; i++) buf[i] ^= trng[i];
+	}
+#endif
+
+	readlen = MIN(readlen, RAND_ENTROPY_POOL_SIZE - sEntropyPoolLen);
+	memcpy(sEntropyPool + sEntropyPoolLen, buf, readlen);
+	sEntropyPoolLen += readlen;
+
+	scheduleEntropyRefill();
+	return CA_ERROR_SUCCESS;
+}
+
+/* Fill aOut with entropy, from the pool first. Returns the number of bytes filled, less than aLen on failure. */
+static size_t getPooledEntropy(uint8_t *aOut, size_t aLen)
 {
-	size_t             outLen     = 0;
-	struct ca821x_dev *pDeviceRef = data;
+	size_t   outLen   = MIN(aLen, sEntropyPoolLen);
+	size_t   fromPool = outLen;
+	uint32_t start    = TIME_ReadAbsoluteTime();
+
+	// Taken from the end of the pool, and wiped so that it can never be handed out twice
+	sEntropyPoolLen -= outLen;
+	memcpy(aOut, sEntropyPool + sEntropyPoolLen, outLen);
+	memset(sEntropyPool + sEntropyPoolLen, 0, outLen);
 
-	while (outLen < len)
+	while (outLen < aLen)
 	{
-		uint8_t       readlen = 0;
-		uint8_t       buf[2];
-		size_t        remlen = len - outLen;
-		size_t        cpylen = 0;
-		ca_mac_status status = HWME_GET_request_sync(HWME_RANDOMNUM, &readlen, buf, pDeviceRef);
+		size_t readlen = readEntropyDirect(aOut + outLen, aLen - outLen);
 
-		if (status != MAC_SUCCESS || readlen != 2)
+		if (!readlen)
 			break;
+		outLen += readlen;
+	}
 
-		cpylen = MIN(remlen, readlen);
-		memcpy(output, buf, cpylen);
-		output += cpylen;
-		outLen += cpylen;
+	scheduleEntropyRefill();
+
+	if (fromPool < aLen)
+	{
+		ca_log_debg("Entropy: %u of %u bytes from pool, %u ms",
+		            (unsigned)fromPool,
+		            (unsigned)aLen,
+		            (unsigned)(TIME_ReadAbsoluteTime() - start));
 	}
+	return outLen;
+}
+
+static int getEntropy(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+	(void)data;
+
+	// mbedtls asks for MBEDTLS_ENTROPY_MAX_GATHER bytes, but only needs its threshold from a strong source
+	len   = MIN(len, MBEDTLS_ENTROPY_MIN_HARDWARE);
+	*olen = getPooledEntropy(output, len);
 
-	*olen = outLen;
-	if (outLen != len)
+	if (*olen != len)
 		return MBEDTLS_ERR_ENTROPY_SOURCE_FAILED;
 	return 0;
 }
@@ -89,12 +188,15 @@ CA_TOOL_WEAK mbedtls_ctr_drbg_context *otRandomCryptoMbedTlsContextGet(void)
 
 	if (!isInitialised)
 	{
+		uint32_t start = TIME_ReadAbsoluteTime();
+
 		mbedtls_ctr_drbg_init(&sContext);
 		mbedtls_entropy_init(&sEntropy);
 		mbedtls_entropy_add_source(
 		    &sEntropy, &getEntropy, entropyDev, MBEDTLS_ENTROPY_MIN_HARDWARE, MBEDTLS_ENTROPY_SOURCE_STRONG);
 		mbedtls_ctr_drbg_seed(&sContext, mbedtls_entropy_func, &sEntropy, NULL, 0);
 		isInitialised = true;
+		ca_log_debg("DRBG seeded in %u ms", (unsigned)(TIME_ReadAbsoluteTime() - start));
 	}
 
 	return &sContext;
@@ -104,6 +206,18 @@ void RAND_SetCryptoEntropyDev(struct ca821x_dev *pDeviceRef)
 {
 	entropyDev = pDeviceRef;
 	RAND_SeedFromDev(pDeviceRef);
+
+	if (!TASKLET_IsQueued(&sEntropyRefillTasklet))
+		TASKLET_Init(&sEntropyRefillTasklet, &entropyRefillCallback);
+	scheduleEntropyRefill();
+}
+
+ca_error RAND_GetEntropy(uint16_t aNumBytes, void *aBytesOut)
+{
+	if (getPooledEntropy(aBytesOut, aNumBytes) != aNumBytes)
+		return CA_ERROR_FAIL;
+
+	return CA_ERROR_SUCCESS;
 }
 
 ca_error RAND_GetCryptoBytes(uint16_t aNumBytes, void *aBytesOut)
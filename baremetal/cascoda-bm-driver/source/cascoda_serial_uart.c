@@ -50,6 +50,7 @@ enum serial_state
 	SERIAL_CMDID     = 1,
 	SERIAL_CMDLEN    = 2,
 	SERIAL_DATA      = 3,
+	SERIAL_DISCARD   = 4,
 };
 
 #define SERIAL_SOM (0xDE)
@@ -62,9 +63,13 @@ enum serial_state
 /****** Global Variables for Serial State                                ******/
 /******************************************************************************/
 static u8_t                SerialCount;                      //!< Number of bytes read so far
-static volatile u8_t       SerialRemainder;                  //!< Number of bytes left to receive
+static u8_t                SerialRemainder;                  //!< Number of bytes left to receive
 volatile enum serial_state SerialRxState = SERIAL_INBETWEEN; //!< State of serial receive state machine
 
+#if (SERIAL_RX_QUEUE_LEN & (SERIAL_RX_QUEUE_LEN - 1)) || SERIAL_RX_QUEUE_LEN > 128
+#error "SERIAL_RX_QUEUE_LEN must be a power of two, up to 128"
+#endif
+
 /* combine Serial Buffer and Framing for UART transfers */
 struct SerialUARTBuffer
 {
@@ -83,6 +88,18 @@ static volatile bool           SerialTxResendReq  = false; //!< Transmit resend
 static volatile u32_t          SerialRxTimeout    = 0;     //!< Rx timeout
 static u32_t                   SerialTxTimeout    = 0;     //!< RxRdy timeout
 static u8_t                    SerialTimeoutCount = 0;     //!< Number of timeouts
+static volatile bool           SerialRxResetReq   = false; //!< Discard the partially received command
+static volatile bool           SerialRxFailReq    = false; //!< A command was discarded, RX_FAIL required
+
+/*
+ * Commands are parsed by Serial_ReadInterface (in interrupt context) into a queue, and moved to SerialRxBuffer by
+ * SerialGetCommand (in application context) once the previous one has been dispatched. The queue counters are only
+ * written by one side each, and their difference is the number of queued commands.
+ */
+static struct SerialBuffer SerialRxQueue[SERIAL_RX_QUEUE_LEN]; //!< Received commands waiting to be dispatched
+static volatile u8_t       SerialRxQueueIn  = 0; //!< Number of commands received, written by Serial_ReadInterface
+static volatile u8_t       SerialRxQueueOut = 0; //!< Number of commands moved to SerialRxBuffer
+static u8_t                SerialRxRdySent  = 0; //!< Number of received commands acknowledged with RX_RDY
 
 static u8_t SerialCmdId  = 0xFF;
 static u8_t SerialCmdLen = 0;
@@ -119,8 +136,18 @@ static u8_t SerialFindStart(void)
 
 u8_t Serial_ReadInterface(void)
 {
-	u8_t Count;
+	struct SerialBuffer *slot     = &SerialRxQueue[SerialRxQueueIn % SERIAL_RX_QUEUE_LEN];
+	u8_t                 received = 0;
+	u8_t                 discard[16];
+	u8_t                 Count;
 
+	if (SerialRxResetReq)
+	{
+		SerialRxState    = SERIAL_INBETWEEN;
+		SerialRxResetReq = false;
+	}
+
+	// Parse as many commands as have been received, the BSP buffers the rest
 	while (1)
 	{
 		switch (SerialRxState)
@@ -132,57 +159,69 @@ u8_t Serial_ReadInterface(void)
 				SerialRxTimeout = TIME_ReadAbsoluteTime();
 				continue;
 			}
-			return 0;
+			return received;
 		case SERIAL_CMDID:
-			if ((Count = BSP_SerialRead(&SerialCmdId, 1)) != 0)
+			if (BSP_SerialRead(&SerialCmdId, 1) != 0)
 			{
 				SerialRxState = SERIAL_CMDLEN;
 				continue;
 			}
-			return 0;
+			return received;
 		case SERIAL_CMDLEN:
-			if ((Count = BSP_SerialRead(&SerialCmdLen, 1)) != 0)
+			if (BSP_SerialRead(&SerialCmdLen, 1) != 0)
 			{
+				SerialRemainder = SerialCmdLen;
+				SerialCount     = 0;
 				if (SerialReceivedRxRdy() || SerialReceivedRxFail())
 				{
 					SerialRxState = SERIAL_INBETWEEN;
-					return 1;
+				}
+				else if (SerialCmdLen > SERIAL_MAC_RX_LEN)
+				{
+					// Too long to ever be received, so the host gets RX_FAIL rather than waiting for RX_RDY
+					SerialRxFailReq = true;
+					SerialRxState   = SERIAL_DISCARD;
+				}
+				else if ((u8_t)(SerialRxQueueIn - SerialRxQueueOut) >= SERIAL_RX_QUEUE_LEN)
+				{
+					// Only if the host didn't wait for RX_RDY, ask it to send again
+					SerialRxFailReq = true;
+					SerialRxState   = SERIAL_DISCARD;
 				}
 				else
 				{
-					SerialRxBuffer.CmdId  = SerialCmdId;
-					SerialRxBuffer.CmdLen = SerialCmdLen;
-					SerialRemainder       = SerialCmdLen;
-					SerialCount           = 0;
-					if (SerialRemainder == 0)
-					{
-						SerialRxState   = SERIAL_INBETWEEN; // exit if 0 API packet length !!
-						SerialRxPending = true;
-						return 1;
-					}
-					else
-					{
-						SerialRxState = SERIAL_DATA;
-						continue;
-					}
+					slot->CmdId   = SerialCmdId;
+					slot->CmdLen  = SerialCmdLen;
+					SerialRxState = SERIAL_DATA;
 				}
+				continue;
 			}
-			return 0;
+			return received;
 		case SERIAL_DATA:
-			if ((Count = BSP_SerialRead(SerialRxBuffer.Data + SerialCount, SerialRemainder)) != 0)
+			if (SerialRemainder)
 			{
+				if ((Count = BSP_SerialRead(slot->Data + SerialCount, SerialRemainder)) == 0)
+					return received;
 				SerialCount += Count;
 				SerialRemainder -= Count;
-				if (SerialRemainder == 0)
-				{
-					SerialRxState   = SERIAL_INBETWEEN;
-					SerialRemainder = 0;
-					SerialCount     = 0;
-					SerialRxPending = true;
-					return 1;
-				}
+				continue;
+			}
+			SerialRxQueueIn++;
+			slot          = &SerialRxQueue[SerialRxQueueIn % SERIAL_RX_QUEUE_LEN];
+			received      = 1;
+			SerialRxState = SERIAL_INBETWEEN;
+			continue;
+		case SERIAL_DISCARD:
+			if (SerialRemainder)
+			{
+				Count = (SerialRemainder < sizeof(discard)) ? SerialRemainder : sizeof(discard);
+				if ((Count = BSP_SerialRead(discard, Count)) == 0)
+					return received;
+				SerialRemainder -= Count;
+				continue;
 			}
-			return 0;
+			SerialRxState = SERIAL_INBETWEEN;
+			continue;
 		}
 	}
 } // End of Serial_ReadInterface()
@@ -194,6 +233,26 @@ u8_t SerialGetCommand(void)
 	{
 		SerialResend();
 	}
+	if (SerialRxFailReq)
+	{
+		SerialRxFailReq = false;
+		SerialSendRxFail();
+	}
+	if (!SerialRxPending && SerialRxQueueIn != SerialRxQueueOut)
+	{
+		struct SerialBuffer *next = &SerialRxQueue[SerialRxQueueOut % SERIAL_RX_QUEUE_LEN];
+
+		memcpy(&SerialRxBuffer, next, next->CmdLen + 2);
+		SerialRxQueueOut++;
+		SerialRxPending = true;
+	}
+	/* Acknowledge received commands as soon as there is room for another one, so that the host can send the next
+	 * command while this one is dispatched */
+	while (SerialRxRdySent != SerialRxQueueIn && (u8_t)(SerialRxQueueIn - SerialRxQueueOut) < SERIAL_RX_QUEUE_LEN)
+	{
+		SerialSendRxRdy();
+		SerialRxRdySent++;
+	}
 	if (SerialRxPending)
 	{
 		SerialTimeoutCount = 0;
@@ -201,19 +260,6 @@ u8_t SerialGetCommand(void)
 	return SerialRxPending;
 }
 
-/******************************************************************************/
-/***************************************************************************/ /**
- * \brief Completes Serial Read
- *******************************************************************************
- ******************************************************************************/
-void SerialReadComplete(void)
-{
-	SerialRxState   = SERIAL_INBETWEEN;
-	SerialRemainder = 0;
-	SerialCount     = 0;
-	SerialRxPending = true;
-}
-
 void SerialSendRxRdy()
 {
 	uint8_t buf[3];
@@ -330,11 +376,10 @@ static void SerialCheckTxTimeout(void)
  ******************************************************************************/
 static void SerialCheckRxTimeout(void)
 {
-	if (SerialRxState != SERIAL_INBETWEEN && (TIME_ReadAbsoluteTime() - SerialRxTimeout) > RX_TIMEOUT)
+	if (SerialRxState != SERIAL_INBETWEEN && !SerialRxResetReq &&
+	    (TIME_ReadAbsoluteTime() - SerialRxTimeout) > RX_TIMEOUT)
 	{
-		BSP_SerialRead(NULL, 0); //Cancel DMA
-		SerialReadComplete();    //Reset rx state machine
-		SerialRxPending = false; //Remove pending transaction
+		SerialRxResetReq = true; //Reset rx state machine before parsing the repeat
 		SerialSendRxFail();      //Signal for repeat send
 	}
 }
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2026, Cascoda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Declarations of the OTA firmware download client
+ */
+/**
+ * @ingroup bm-thread
+ * @defgroup ota-client Over-the-air firmware download over CoAP
+ * @brief  Download a firmware image into the external flash with CoAP block-wise transfer
+ *
+ * The image is requested from the server with CoAP Block2, in blocks of up to
+ * 1024 bytes. Each block is written to the external flash, read back and added
+ * to a running CRC32, which must match the ETag of the image once the last block
+ * has been stored. The progress is kept in the settings, so that a download
+ * interrupted by a reset or a deep sleep continues from where it stopped, as
+ * long as the server still offers the same image.
+ *
+ * With OTA_ClientListen(), the client also receives the blocks that the server
+ * sends to a realm-local multicast group, so that a single transmission updates
+ * many nodes. These blocks arrive in any order and some are missed, so each one
+ * is marked in a bitmap once it has been written and read back. When the
+ * multicast transfer goes quiet, each node fetches only its missing blocks from
+ * the server by unicast, after a random delay so that the nodes don't all ask at
+ * once. The CRC32 is then computed by reading the blocks back in order.
+ *
+ * The matching server is posix/app/ot-ota-server.
+ *
+ * @{
+ */
+
+#ifndef OTA_CLIENT_H
+#define OTA_CLIENT_H
+
+#include <stdint.h>
+
+#include "openthread/coap.h"
+#include "ca821x_error.h"
+
+/** URI path of the firmware image on the server */
+#ifndef OTA_CLIENT_URI
+#define OTA_CLIENT_URI "ca/fw"
+#endif
+
+/** Largest block size requested, the server may answer with smaller blocks */
+#ifndef OTA_CLIENT_BLOCK_SZX
+#define OTA_CLIENT_BLOCK_SZX OT_COAP_OPTION_BLOCK_SZX_1024
+#endif
+
+/** Address of the image in the external flash, aligned to a 4kB sector */
+#ifndef OTA_CLIENT_FLASH_START
+#define OTA_CLIENT_FLASH_START 0x00000
+#endif
+
+/** Space reserved for the image in the external flash */
+#ifndef OTA_CLIENT_FLASH_SIZE
+#define OTA_CLIENT_FLASH_SIZE 0x100000
+#endif
+
+/** URI path of the resource receiving the blocks sent to the multicast group */
+#ifndef OTA_CLIENT_MULTICAST_URI
+#define OTA_CLIENT_MULTICAST_URI "ca/fwm"
+#endif
+
+/** Multicast group that the server sends the blocks to. The parents forward ff03::1 to their sleepy children. */
+#ifndef OTA_CLIENT_MULTICAST_GROUP
+#define OTA_CLIENT_MULTICAST_GROUP "ff03::1"
+#endif
+
+/** Size of the blocks sent to the multicast group, which is also the granularity of the bitmap of received blocks */
+#ifndef OTA_CLIENT_MULTICAST_SZX
+#define OTA_CLIENT_MULTICAST_SZX OT_COAP_OPTION_BLOCK_SZX_1024
+#endif
+
+/** Time without multicast blocks after which the missing blocks are fetched by unicast */
+#ifndef OTA_CLIENT_REPAIR_DELAY_MS
+#define OTA_CLIENT_REPAIR_DELAY_MS 10000
+#endif
+
+/** Upper bound of the random delay added before fetching the missing blocks, to spread the requests of the nodes */
+#ifndef OTA_CLIENT_REPAIR_JITTER_MS
+#define OTA_CLIENT_REPAIR_JITTER_MS 10000
+#endif
+
+/** The progress is saved to the settings each time this many bytes have been stored */
+#ifndef OTA_CLIENT_PERSIST_INTERVAL
+#define OTA_CLIENT_PERSIST_INTERVAL 0x1000
+#endif
+
+/** Number of consecutive failed requests before the download is paused */
+#ifndef OTA_CLIENT_MAX_RETRIES
+#define OTA_CLIENT_MAX_RETRIES 5
+#endif
+
+enum ota_client_state
+{
+	OTA_CLIENT_IDLE = 0,    //!< No image has been downloaded
+	OTA_CLIENT_DOWNLOADING, //!< Download in progress
+	OTA_CLIENT_RECEIVING,   //!< Blocks are being received from the multicast group
+	OTA_CLIENT_PAUSED,      //!< Download stopped part way, OTA_ClientStart() resumes it
+	OTA_CLIENT_COMPLETE,    //!< A complete and verified image is in the external flash
+};
+
+/** Progress of the download */
+struct ota_client_progress
+{
+	uint32_t imageCrc;  //!< CRC32 of the image, which is also its ETag
+	uint32_t imageSize; //!< Size of the image in bytes, 0 if not known yet
+	uint32_t offset;    //!< Number of bytes stored and verified from the start of the image
+	uint32_t received;  //!< Number of bytes received from the multicast group beyond offset
+};
+
+/**
+ * @brief Function called when a download ends.
+ *
+ * @param aStatus CA_ERROR_SUCCESS if the image was downloaded and verified,
+ * CA_ERROR_ALREADY if the image in the external flash is the one on the server,
+ * CA_ERROR_FAIL if the image didn't match its CRC and was discarded,
+ * CA_ERROR_NOT_FOUND if the server doesn't have an image,
+ * CA_ERROR_NO_BUFFER if the image is larger than OTA_CLIENT_FLASH_SIZE, or
+ * CA_ERROR_TIMEOUT if the download was paused after OTA_CLIENT_MAX_RETRIES failures.
+ * @param aContext Context passed to OTA_ClientStart() or OTA_ClientListen()
+ */
+typedef void (*ota_client_callback)(ca_error aStatus, void *aContext);
+
+/**
+ * @brief Initialise the OTA client, and load the progress of a previous download from the settings.
+ *
+ * The external flash must have been initialised with BSP_ExternalFlashInit().
+ */
+void OTA_ClientInit(void);
+
+/**
+ * @brief Start downloading the firmware image from a server, or resume the download.
+ *
+ * This is an asynchronous (non-blocking) function, which makes progress as long
+ * as otTaskletsProcess() and cascoda_io_handler() are being called regularly.
+ * If a complete image is already stored, the server is only asked whether it
+ * has a different one. CoAP must have been started with otCoapStart().
+ *
+ * @param aServer   Address of the server
+ * @param aCallback Function called when the download ends, or NULL
+ * @param aContext  Context passed to aCallback
+ *
+ * @return ca_error CA_ERROR_SUCCESS if the download started, CA_ERROR_ALREADY
+ * if a download is already in progress, or blocks are being received from the
+ * multicast group.
+ */
+ca_error OTA_ClientStart(const otIp6Address *aServer, ota_client_callback aCallback, void *aContext);
+
+/**
+ * @brief Pause the download in progress. The progress is saved, so that it can be resumed later.
+ *
+ * If the client is listening, the next block sent to the multicast group resumes the download.
+ */
+void OTA_ClientStop(void);
+
+/**
+ * @brief Receive the blocks that the server sends to OTA_CLIENT_MULTICAST_GROUP.
+ *
+ * A block of a different image restarts the download with that image. Once no
+ * block has been received for OTA_CLIENT_REPAIR_DELAY_MS, the missing blocks are
+ * fetched from the server that sent them, as with OTA_ClientStart(). A unicast
+ * download in progress is interrupted by the multicast transfer, and carries on
+ * after it. CoAP must have been started with otCoapStart().
+ *
+ * @param aCallback Function called when a download ends, or NULL. Replaced by the
+ * callback of OTA_ClientStart().
+ * @param aContext  Context passed to aCallback
+ *
+ * @return ca_error CA_ERROR_SUCCESS if the client is listening, CA_ERROR_ALREADY
+ * if it was already listening, or CA_ERROR_FAIL if the group cannot be subscribed to.
+ */
+ca_error OTA_ClientListen(ota_client_callback aCallback, void *aContext);
+
+/**
+ * @brief Stop receiving the blocks sent to the multicast group, pausing the download if blocks were being received.
+ */
+void OTA_ClientStopListening(void);
+
+/**
+ * @brief Get the state of the OTA client.
+ *
+ * @param aProgress Output for the progress of the download, or NULL
+ *
+ * @return enum ota_client_state the state of the client
+ */
+enum ota_client_state OTA_ClientGetState(struct ota_client_progress *aProgress);
+
+#endif // OTA_CLIENT_H
+
+/**
+ * @}
+ */
@@ -74,6 +74,10 @@ static const uint16_t sensordemo_key = 0xCA5C;
 static const uint16_t actuatordemo_key = 0xCA5D;
 /** Flash settings key for the stack profiler */
 static const uint16_t stack_profiler_key = 0xCA5E;
+/** Flash settings key for the ETag of the image on the e-ink display */
+static const uint16_t eink_etag_key = 0xCA5F;
+/** Flash settings key for the progress of the OTA firmware download */
+static const uint16_t ota_client_key = 0xCA61;
 /** Flash settings key used for storing OCF data */
 static const uint16_t OC_SETTINGS_KEY = 0xe107;
 /** Flash settings key used for storing OCF encryption private key */
@@ -28,6 +28,7 @@
 
 #include "openthread/platform/entropy.h"
 #include "cascoda-bm/cascoda_types.h"
+#include "cascoda-util/cascoda_rand.h"
 #include "ca821x_api.h"
 #include "code_utils.h"
 #include "hwme_tdme.h"
@@ -35,29 +36,12 @@
 
 otError otPlatEntropyGet(uint8_t *aOutput, uint16_t aOutputLength)
 {
-	struct ca821x_dev *pDeviceRef = PlatformGetDeviceRef();
-	otError            error      = OT_ERROR_NONE;
-	uint8_t            result[2];
-	uint8_t            len;
-	uint16_t           curLen = 0;
+	otError error = OT_ERROR_NONE;
 
 	otEXPECT_ACTION(aOutput != NULL, error = OT_ERROR_INVALID_ARGS);
 
-	while (curLen < aOutputLength)
-	{
-		HWME_GET_request_sync(HWME_RANDOMNUM, &len, result, pDeviceRef);
-		otEXPECT_ACTION(len == 2, error = OT_ERROR_ABORT);
-
-		if (curLen == aOutputLength - 1)
-		{
-			aOutput[curLen++] = result[0];
-		}
-		else
-		{
-			aOutput[curLen++] = result[0];
-			aOutput[curLen++] = result[1];
-		}
-	}
+	// Served from the background entropy pool of cascoda-bm
+	otEXPECT_ACTION(RAND_GetEntropy(aOutputLength, aOutput) == CA_ERROR_SUCCESS, error = OT_ERROR_ABORT);
 
 exit:
 	return error;
@@ -0,0 +1,768 @@
+/*
+ * Copyright (c) 2026, Cascoda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "ota_client.h"
+
+#include "cascoda-bm/cascoda_interface.h"
+#include "cascoda-util/cascoda_hash.h"
+#include "cascoda-util/cascoda_settings.h"
+#include "cascoda-util/cascoda_tasklet.h"
+#include "openthread/coap.h"
+#include "openthread/ip6.h"
+#include "openthread/random_noncrypto.h"
+#include "ca821x_endian.h"
+#include "ca821x_log.h"
+#include "platform.h"
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+#define SECTOR_SIZE 0x1000
+#define MULTICAST_BLOCK_SIZE (16 << OTA_CLIENT_MULTICAST_SZX)
+#define MULTICAST_BLOCK_COUNT (OTA_CLIENT_FLASH_SIZE / MULTICAST_BLOCK_SIZE)
+#define ETAG_LENGTH 4
+
+#if OTA_CLIENT_FLASH_START % SECTOR_SIZE
+#error "OTA_CLIENT_FLASH_START must be aligned to a 4kB sector"
+#endif
+
+#if OTA_CLIENT_BLOCK_SZX > OTA_CLIENT_MULTICAST_SZX
+#error "The unicast blocks must not be larger than the multicast blocks"
+#endif
+
+#if OTA_CLIENT_FLASH_SIZE % SECTOR_SIZE
+#error "OTA_CLIENT_FLASH_SIZE must be a multiple of a 4kB sector"
+#endif
+
+enum time_constants
+{
+	// The time between retries, if a request fails
+	RETRY_MS = 5 * 1000,
+};
+
+/** Download progress, as stored in the settings */
+struct ota_client_record
+{
+	struct ota_client_progress progress; //!< Image and number of bytes stored
+	uint32_t                   crc;      //!< CRC32 of the first progress.offset bytes, before the final one's complement
+	uint8_t                    complete; //!< Whether the whole image has been stored and verified
+	//! Blocks received from the multicast group beyond progress.offset, one bit per MULTICAST_BLOCK_SIZE
+	uint8_t received[(MULTICAST_BLOCK_COUNT + 7) / 8];
+};
+
+/** Step of the flash operation in progress */
+enum flash_phase
+{
+	FLASH_ERASE,   //!< Erasing the sector of the block, before its first block is written
+	FLASH_PROGRAM, //!< Writing the block
+	FLASH_VERIFY,  //!< Reading the block back, comparing it and adding it to the CRC
+};
+
+static enum ota_client_state    sState = OTA_CLIENT_IDLE;
+static struct ota_client_record sRecord;
+static uint32_t                 sUnsavedBytes; //!< Number of bytes stored since the progress was saved
+static otIp6Address             sServer;
+static ota_client_callback      sCallback;
+static void                    *sCallbackContext;
+static ExternalFlashInfo        sFlashInfo;
+static otCoapResource           sMulticastResource;
+static bool                     sListening;
+// This tasklet sends the request for the next block, or fetches the missing blocks once the multicast transfer ended
+static ca_tasklet sTasklet;
+static uint8_t    sRetries;
+// Incremented when a download starts or stops, so that late responses and flash callbacks are ignored
+static uint8_t sGeneration;
+
+// Block being written to the external flash and read back, or a stored block only read back to compute its CRC
+static uint8_t          sBlock[MULTICAST_BLOCK_SIZE];
+static uint32_t         sBlockOffset;
+static uint16_t         sBlockLength;
+static uint16_t         sBlockPos;
+static enum flash_phase sBlockPhase;
+static bool             sBlockWrite;
+static uint32_t         sBlockCrc;
+static uint8_t          sBlockGeneration;
+static bool             sFlashBusy;
+static uint8_t          sReadBuffer[128];
+// Offset of the sector erased last, so that it is only erased once
+static uint32_t sErasedSector = UINT32_MAX;
+
+static void continue_download(void);
+
+static void save_progress(void)
+{
+	ca_error error;
+
+	error = caUtilSettingsSet(PlatformGetDeviceRef(), ota_client_key, (const uint8_t *)&sRecord, sizeof(sRecord));
+	if (error)
+		ca_log_warn("OTA: Failed to save progress, error %s", ca_error_str(error));
+	else
+		sUnsavedBytes = 0;
+}
+
+static void reset_progress(uint32_t aImageCrc, uint32_t aImageSize)
+{
+	memset(&sRecord, 0, sizeof(sRecord));
+	sRecord.progress.imageCrc  = aImageCrc;
+	sRecord.progress.imageSize = aImageSize;
+	sRecord.crc                = 0xFFFFFFFF;
+	sErasedSector              = UINT32_MAX;
+}
+
+static bool is_received(uint32_t aOffset)
+{
+	uint32_t block = aOffset / MULTICAST_BLOCK_SIZE;
+
+	return sRecord.received[block / 8] & (1 << (block % 8));
+}
+
+static void set_received(uint32_t aOffset, bool aReceived)
+{
+	uint32_t block = aOffset / MULTICAST_BLOCK_SIZE;
+
+	if (aReceived)
+		sRecord.received[block / 8] |= (1 << (block % 8));
+	else
+		sRecord.received[block / 8] &= ~(1 << (block % 8));
+}
+
+/* The blocks can be written in any order, so a sector is erased unless part of the image is already stored in it */
+static bool needs_erase(uint32_t aOffset)
+{
+	uint32_t sector = aOffset - (aOffset % SECTOR_SIZE);
+
+	if (sector == sErasedSector || sRecord.progress.offset > sector)
+		return false;
+
+	for (uint32_t offset = sector; offset < sector + SECTOR_SIZE; offset += MULTICAST_BLOCK_SIZE)
+	{
+		if (is_received(offset))
+			return false;
+	}
+	return true;
+}
+
+/* The state to go back to when no download is in progress */
+static enum ota_client_state get_stopped_state(void)
+{
+	if (sRecord.complete)
+		return OTA_CLIENT_COMPLETE;
+	if (sRecord.progress.offset || sRecord.progress.received)
+		return OTA_CLIENT_PAUSED;
+	return OTA_CLIENT_IDLE;
+}
+
+static void stop_download(enum ota_client_state aState)
+{
+	sState = aState;
+	sGeneration++;
+	TASKLET_Cancel(&sTasklet);
+}
+
+static void finish_download(enum ota_client_state aState, ca_error aStatus)
+{
+	stop_download(aState);
+	if (sCallback)
+		sCallback(aStatus, sCallbackContext);
+}
+
+static void request_next_block(uint32_t aDelay)
+{
+	TASKLET_Cancel(&sTasklet);
+	TASKLET_ScheduleDelta(&sTasklet, aDelay, NULL);
+}
+
+static void retry(void)
+{
+	if (++sRetries <= OTA_CLIENT_MAX_RETRIES)
+	{
+		request_next_block(RETRY_MS);
+		return;
+	}
+
+	if (sRecord.complete)
+		ca_log_warn("OTA: Cannot reach the server");
+	else
+		ca_log_warn("OTA: Download paused at %lu of %lu bytes",
+		            (unsigned long)(sRecord.progress.offset + sRecord.progress.received),
+		            (unsigned long)sRecord.progress.imageSize);
+	if (sUnsavedBytes)
+		save_progress();
+	finish_download(get_stopped_state(), CA_ERROR_TIMEOUT);
+}
+
+/* A resumed download may have used smaller blocks, so the offset must be a multiple of the block size */
+static otCoapBlockSzx get_block_szx(uint32_t aOffset)
+{
+	otCoapBlockSzx szx = OTA_CLIENT_BLOCK_SZX;
+
+	while (szx > OT_COAP_OPTION_BLOCK_SZX_16 && aOffset % otCoapBlockSizeFromExponent(szx))
+		szx = (otCoapBlockSzx)(szx - 1);
+	return szx;
+}
+
+static void image_stored(void)
+{
+	if (~sRecord.crc != sRecord.progress.imageCrc)
+	{
+		ca_log_warn("OTA: Image doesn't match its CRC, discarding it");
+		reset_progress(0, 0);
+		save_progress();
+		finish_download(OTA_CLIENT_IDLE, CA_ERROR_FAIL);
+		return;
+	}
+
+	ca_log_note("OTA: Image %08lx downloaded and verified", (unsigned long)sRecord.progress.imageCrc);
+	sRecord.complete = 1;
+	save_progress();
+	finish_download(OTA_CLIENT_COMPLETE, CA_ERROR_SUCCESS);
+}
+
+static void block_stored(void)
+{
+	sRetries = 0;
+
+	if (sBlockOffset != sRecord.progress.offset)
+	{
+		// Received ahead from the multicast group, its CRC is computed once the blocks before it are stored
+		set_received(sBlockOffset, true);
+		sRecord.progress.received += sBlockLength;
+		sUnsavedBytes += sBlockLength;
+	}
+	else if (sBlockWrite)
+	{
+		sRecord.progress.offset += sBlockLength;
+		sRecord.crc = sBlockCrc;
+		sUnsavedBytes += sBlockLength;
+	}
+	else
+	{
+		// A block received ahead, which has been read back to add it to the CRC
+		set_received(sBlockOffset, false);
+		sRecord.progress.received -= sBlockLength;
+		sRecord.progress.offset += sBlockLength;
+		sRecord.crc = sBlockCrc;
+	}
+
+	continue_download();
+}
+
+static void flash_failed(ca_error aError)
+{
+	if (aError == CA_ERROR_FAIL)
+	{
+		// The flash didn't hold what was written, so nothing stored so far can be trusted
+		ca_log_warn("OTA: Verification failed at %lu, restarting the download", (unsigned long)sBlockOffset);
+		reset_progress(sRecord.progress.imageCrc, sRecord.progress.imageSize);
+		save_progress();
+	}
+
+	// A block received from the multicast group is simply dropped, and fetched later
+	if (sState == OTA_CLIENT_DOWNLOADING)
+		retry();
+}
+
+/* Write the block to the external flash and read it back, or only read it back, one flash instruction per call */
+static ca_error flash_step(void *aContext)
+{
+	uint32_t address = OTA_CLIENT_FLASH_START + sBlockOffset + sBlockPos;
+	uint8_t  count   = MIN((uint32_t)(sBlockLength - sBlockPos), sFlashInfo.readWriteLimit);
+	ca_error error   = CA_ERROR_SUCCESS;
+
+	(void)aContext;
+
+	// The download was stopped or restarted while the block was being written
+	if (sBlockGeneration != sGeneration)
+	{
+		sFlashBusy = false;
+		if (sState == OTA_CLIENT_DOWNLOADING)
+			continue_download();
+		return CA_ERROR_SUCCESS;
+	}
+
+	switch (sBlockPhase)
+	{
+	case FLASH_ERASE:
+		error = BSP_ExternalFlashPartialErase(SECTOR_4KB, address - (address % SECTOR_SIZE));
+		if (!error)
+		{
+			sErasedSector = sBlockOffset - (sBlockOffset % SECTOR_SIZE);
+			sBlockPhase   = FLASH_PROGRAM;
+		}
+		break;
+	case FLASH_PROGRAM:
+		count = MIN(count, sFlashInfo.pageSize - (address % sFlashInfo.pageSize));
+		error = BSP_ExternalFlashProgram(address, count, sBlock + sBlockPos);
+		if (!error)
+			sBlockPos += count;
+		if (sBlockPos == sBlockLength)
+		{
+			sBlockPhase = FLASH_VERIFY;
+			sBlockPos   = 0;
+		}
+		break;
+	case FLASH_VERIFY:
+		error = BSP_ExternalFlashReadData(address, count, sReadBuffer);
+		if (!error && sBlockWrite && memcmp(sReadBuffer, sBlock + sBlockPos, count))
+			error = CA_ERROR_FAIL;
+		if (!error)
+		{
+			HASH_CRC32_stream(sReadBuffer, count, &sBlockCrc);
+			sBlockPos += count;
+		}
+		if (!error && sBlockPos == sBlockLength)
+		{
+			sFlashBusy = false;
+			block_stored();
+			return CA_ERROR_SUCCESS;
+		}
+		break;
+	}
+
+	if (!error)
+		error = BSP_ExternalFlashScheduleCallback(&flash_step, NULL);
+	if (error)
+	{
+		sFlashBusy = false;
+		flash_failed(error);
+	}
+	return CA_ERROR_SUCCESS;
+}
+
+/**
+ * Start storing a block of the image.
+ *
+ * @param aOffset Offset of the block in the image
+ * @param aLength Length of the block
+ * @param aWrite  true to write sBlock to the flash, false to only read the stored block back and compute its CRC
+ */
+static ca_error start_flash(uint32_t aOffset, uint16_t aLength, bool aWrite)
+{
+	ca_error error;
+
+	sBlockOffset     = aOffset;
+	sBlockLength     = aLength;
+	sBlockPos        = 0;
+	sBlockWrite      = aWrite;
+	sBlockPhase      = !aWrite ? FLASH_VERIFY : needs_erase(aOffset) ? FLASH_ERASE : FLASH_PROGRAM;
+	sBlockCrc        = sRecord.crc;
+	sBlockGeneration = sGeneration;
+
+	error = BSP_ExternalFlashScheduleCallback(&flash_step, NULL);
+	if (!error)
+		sFlashBusy = true;
+	return error;
+}
+
+/* Add the blocks received ahead to the CRC, then check the complete image or ask the server for the next block */
+static void continue_download(void)
+{
+	uint32_t offset = sRecord.progress.offset;
+	uint32_t size   = sRecord.progress.imageSize;
+
+	// Called again once the flash operation in progress has ended
+	if (sFlashBusy)
+		return;
+
+	if (sUnsavedBytes >= OTA_CLIENT_PERSIST_INTERVAL)
+		save_progress();
+
+	if (!sRecord.complete && size && offset < size && is_received(offset))
+	{
+		if (start_flash(offset, MIN(size - offset, MULTICAST_BLOCK_SIZE), false) && sState == OTA_CLIENT_DOWNLOADING)
+			retry();
+		return;
+	}
+
+	if (!sRecord.complete && size && offset == size)
+		image_stored();
+	else if (sState == OTA_CLIENT_DOWNLOADING)
+		request_next_block(0);
+}
+
+static void handle_response(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo, otError aError)
+{
+	otCoapOptionIterator iterator;
+	const otCoapOption  *option;
+	uint8_t              etag[ETAG_LENGTH];
+	bool                 hasEtag = false;
+	uint64_t             block2  = 0;
+	uint64_t             size2   = 0;
+	uint32_t             imageCrc;
+	uint32_t             blockSize;
+	uint32_t             offset;
+	uint16_t             length;
+	bool                 more;
+
+	(void)aMessageInfo;
+
+	if ((uintptr_t)aContext != sGeneration)
+		return;
+
+	if (aError != OT_ERROR_NONE)
+	{
+		ca_log_warn("OTA: Request failed, error %d", aError);
+		goto exit;
+	}
+
+	switch (otCoapMessageGetCode(aMessage))
+	{
+	case OT_COAP_CODE_CONTENT:
+		break;
+	case OT_COAP_CODE_VALID:
+		// The server still has the image that is stored
+		if (!sRecord.complete)
+			goto exit;
+		ca_log_info("OTA: Image is up to date");
+		finish_download(OTA_CLIENT_COMPLETE, CA_ERROR_ALREADY);
+		return;
+	case OT_COAP_CODE_NOT_FOUND:
+		ca_log_warn("OTA: Server has no image");
+		finish_download(get_stopped_state(), CA_ERROR_NOT_FOUND);
+		return;
+	default:
+		goto exit;
+	}
+
+	if (otCoapOptionIteratorInit(&iterator, aMessage) != OT_ERROR_NONE)
+		goto exit;
+
+	for (option = otCoapOptionIteratorGetFirstOption(&iterator); option != NULL;
+	     option = otCoapOptionIteratorGetNextOption(&iterator))
+	{
+		if (option->mNumber == OT_COAP_OPTION_E_TAG && option->mLength == ETAG_LENGTH)
+			hasEtag = (otCoapOptionIteratorGetOptionValue(&iterator, etag) == OT_ERROR_NONE);
+		else if (option->mNumber == OT_COAP_OPTION_BLOCK2)
+			otCoapOptionIteratorGetOptionUintValue(&iterator, &block2);
+		else if (option->mNumber == OT_COAP_OPTION_SIZE2)
+			otCoapOptionIteratorGetOptionUintValue(&iterator, &size2);
+	}
+
+	if (!hasEtag)
+		goto exit;
+	imageCrc = GETBE32(etag);
+
+	if (imageCrc != sRecord.progress.imageCrc || !sRecord.progress.imageSize || sRecord.complete)
+	{
+		if (sRecord.complete && imageCrc == sRecord.progress.imageCrc)
+		{
+			finish_download(OTA_CLIENT_COMPLETE, CA_ERROR_ALREADY);
+			return;
+		}
+		if (!size2)
+			goto exit;
+		if (size2 > OTA_CLIENT_FLASH_SIZE)
+		{
+			ca_log_warn("OTA: Image of %lu bytes doesn't fit", (unsigned long)size2);
+			finish_download(get_stopped_state(), CA_ERROR_NO_BUFFER);
+			return;
+		}
+
+		// A different image, so the download starts again from the beginning
+		ca_log_note("OTA: Downloading image %08lx, %lu bytes", (unsigned long)imageCrc, (unsigned long)size2);
+		reset_progress(imageCrc, (uint32_t)size2);
+		save_progress();
+		if (block2 >> 4)
+		{
+			request_next_block(0);
+			return;
+		}
+	}
+
+	offset    = sRecord.progress.offset;
+	blockSize = otCoapBlockSizeFromExponent((otCoapBlockSzx)(block2 & 0x07));
+	more      = (block2 >> 3) & 0x01;
+	length    = otMessageGetLength(aMessage) - otMessageGetOffset(aMessage);
+
+	if ((block2 >> 4) * blockSize != offset || length > blockSize || length > sizeof(sBlock) ||
+	    offset + length > sRecord.progress.imageSize || (more && length != blockSize) ||
+	    (!more && offset + length != sRecord.progress.imageSize))
+	{
+		goto exit;
+	}
+
+	otMessageRead(aMessage, otMessageGetOffset(aMessage), sBlock, length);
+	if (start_flash(offset, length, true) == CA_ERROR_SUCCESS)
+		return;
+
+exit:
+	retry();
+}
+
+static void send_request(void)
+{
+	otError        error   = OT_ERROR_NONE;
+	otMessage     *message = NULL;
+	otMessageInfo  messageInfo;
+	uint8_t        etag[ETAG_LENGTH];
+	uint32_t       offset = sRecord.complete ? 0 : sRecord.progress.offset;
+	otCoapBlockSzx szx    = get_block_szx(offset);
+
+	message = otCoapNewMessage(OT_INSTANCE, NULL);
+	if (message == NULL)
+	{
+		error = OT_ERROR_NO_BUFS;
+		goto exit;
+	}
+
+	otCoapMessageInit(message, OT_COAP_TYPE_CONFIRMABLE, OT_COAP_CODE_GET);
+	otCoapMessageGenerateToken(message, 2);
+
+	// Let the server check whether the stored image is still the current one
+	if (sRecord.complete)
+	{
+		PUTBE32(sRecord.progress.imageCrc, etag);
+		SuccessOrExit(error = otCoapMessageAppendOption(message, OT_COAP_OPTION_E_TAG, sizeof(etag), etag));
+	}
+
+	SuccessOrExit(error = otCoapMessageAppendUriPathOptions(message, OTA_CLIENT_URI));
+	SuccessOrExit(error = otCoapMessageAppendBlock2Option(
+	                  message, offset / otCoapBlockSizeFromExponent(szx), false, szx));
+
+	memset(&messageInfo, 0, sizeof(messageInfo));
+	messageInfo.mPeerAddr = sServer;
+	messageInfo.mPeerPort = OT_DEFAULT_COAP_PORT;
+
+	error = otCoapSendRequest(OT_INSTANCE, message, &messageInfo, &handle_response, (void *)(uintptr_t)sGeneration);
+
+exit:
+	if (error)
+	{
+		if (message)
+			otMessageFree(message);
+		ca_log_warn("OTA: Cannot send request, error %d", error);
+		retry();
+	}
+}
+
+static ca_error handle_timer(void *aContext)
+{
+	(void)aContext;
+
+	if (sState == OTA_CLIENT_RECEIVING)
+	{
+		// The multicast transfer is over, so the blocks that were missed are fetched from the server
+		ca_log_info("OTA: Multicast transfer ended with %lu of %lu bytes",
+		            (unsigned long)(sRecord.progress.offset + sRecord.progress.received),
+		            (unsigned long)sRecord.progress.imageSize);
+		sState   = OTA_CLIENT_DOWNLOADING;
+		sRetries = 0;
+		continue_download();
+	}
+	else if (sState == OTA_CLIENT_DOWNLOADING)
+	{
+		send_request();
+	}
+	return CA_ERROR_SUCCESS;
+}
+
+static void handle_multicast_block(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo)
+{
+	otCoapOptionIterator iterator;
+	const otCoapOption  *option;
+	uint8_t              etag[ETAG_LENGTH];
+	bool                 hasEtag = false;
+	uint64_t             block1  = 0;
+	uint64_t             size1   = 0;
+	uint32_t             imageCrc;
+	uint32_t             delay;
+	uint32_t             offset;
+	uint16_t             length;
+	bool                 more;
+
+	(void)aContext;
+
+	if (otCoapMessageGetCode(aMessage) != OT_COAP_CODE_POST ||
+	    otCoapOptionIteratorInit(&iterator, aMessage) != OT_ERROR_NONE)
+	{
+		return;
+	}
+
+	for (option = otCoapOptionIteratorGetFirstOption(&iterator); option != NULL;
+	     option = otCoapOptionIteratorGetNextOption(&iterator))
+	{
+		if (option->mNumber == OT_COAP_OPTION_E_TAG && option->mLength == ETAG_LENGTH)
+			hasEtag = (otCoapOptionIteratorGetOptionValue(&iterator, etag) == OT_ERROR_NONE);
+		else if (option->mNumber == OT_COAP_OPTION_BLOCK1)
+			otCoapOptionIteratorGetOptionUintValue(&iterator, &block1);
+		else if (option->mNumber == OT_COAP_OPTION_SIZE1)
+			otCoapOptionIteratorGetOptionUintValue(&iterator, &size1);
+	}
+
+	if (!hasEtag || (block1 & 0x07) != OTA_CLIENT_MULTICAST_SZX)
+		return;
+	imageCrc = GETBE32(etag);
+
+	// The image is already stored
+	if (sRecord.complete && imageCrc == sRecord.progress.imageCrc)
+		return;
+
+	if (imageCrc != sRecord.progress.imageCrc || !sRecord.progress.imageSize || sRecord.complete)
+	{
+		if (!size1 || size1 > OTA_CLIENT_FLASH_SIZE)
+			return;
+
+		ca_log_note("OTA: Receiving image %08lx, %lu bytes", (unsigned long)imageCrc, (unsigned long)size1);
+		stop_download(OTA_CLIENT_RECEIVING);
+		reset_progress(imageCrc, (uint32_t)size1);
+		save_progress();
+	}
+	else if (sState != OTA_CLIENT_RECEIVING)
+	{
+		// Also interrupts a unicast download, which carries on once the multicast transfer is over
+		stop_download(OTA_CLIENT_RECEIVING);
+	}
+
+	// The missing blocks are fetched once the blocks stop coming, or shortly after the last one
+	sServer = aMessageInfo->mPeerAddr;
+	more    = (block1 >> 3) & 0x01;
+	delay   = otRandomNonCryptoGetUint32() % (OTA_CLIENT_REPAIR_JITTER_MS + 1);
+	if (more)
+		delay += OTA_CLIENT_REPAIR_DELAY_MS;
+	TASKLET_Cancel(&sTasklet);
+	TASKLET_ScheduleDelta(&sTasklet, delay, NULL);
+
+	offset = (uint32_t)(block1 >> 4) * MULTICAST_BLOCK_SIZE;
+	length = otMessageGetLength(aMessage) - otMessageGetOffset(aMessage);
+
+	if (offset >= sRecord.progress.imageSize || length > MULTICAST_BLOCK_SIZE ||
+	    offset + length > sRecord.progress.imageSize || (more && length != MULTICAST_BLOCK_SIZE) ||
+	    (!more && offset + length != sRecord.progress.imageSize))
+	{
+		return;
+	}
+
+	// Already stored, or the flash is busy with the previous block, in which case this one is fetched later
+	if (offset < sRecord.progress.offset || is_received(offset) || sFlashBusy)
+		return;
+
+	otMessageRead(aMessage, otMessageGetOffset(aMessage), sBlock, length);
+	start_flash(offset, length, true);
+}
+
+void OTA_ClientInit(void)
+{
+	uint16_t length = sizeof(sRecord);
+
+	TASKLET_Init(&sTasklet, &handle_timer);
+
+	if (caUtilSettingsGet(PlatformGetDeviceRef(), ota_client_key, 0, (uint8_t *)&sRecord, &length) ||
+	    length != sizeof(sRecord) ||
+	    sRecord.progress.offset + sRecord.progress.received > sRecord.progress.imageSize)
+	{
+		reset_progress(0, 0);
+	}
+	sUnsavedBytes = 0;
+	sState        = get_stopped_state();
+
+	if (sState == OTA_CLIENT_PAUSED)
+		ca_log_info("OTA: Download paused at %lu of %lu bytes",
+		            (unsigned long)(sRecord.progress.offset + sRecord.progress.received),
+		            (unsigned long)sRecord.progress.imageSize);
+}
+
+ca_error OTA_ClientStart(const otIp6Address *aServer, ota_client_callback aCallback, void *aContext)
+{
+	if (sState == OTA_CLIENT_DOWNLOADING || sState == OTA_CLIENT_RECEIVING)
+		return CA_ERROR_ALREADY;
+
+	BSP_ExternalFlashGetInfo(&sFlashInfo);
+	sServer          = *aServer;
+	sCallback        = aCallback;
+	sCallbackContext = aContext;
+	sRetries         = 0;
+	sState           = OTA_CLIENT_DOWNLOADING;
+	sGeneration++;
+
+	continue_download();
+	return CA_ERROR_SUCCESS;
+}
+
+void OTA_ClientStop(void)
+{
+	if (sState != OTA_CLIENT_DOWNLOADING && sState != OTA_CLIENT_RECEIVING)
+		return;
+
+	if (sUnsavedBytes)
+		save_progress();
+	stop_download(get_stopped_state());
+}
+
+ca_error OTA_ClientListen(ota_client_callback aCallback, void *aContext)
+{
+	otIp6Address group;
+	otError      error;
+
+	if (sListening)
+		return CA_ERROR_ALREADY;
+
+	// ff03::1 is always subscribed to
+	if (otIp6AddressFromString(OTA_CLIENT_MULTICAST_GROUP, &group) != OT_ERROR_NONE)
+		return CA_ERROR_FAIL;
+	error = otIp6SubscribeMulticastAddress(OT_INSTANCE, &group);
+	if (error != OT_ERROR_NONE && error != OT_ERROR_ALREADY)
+		return CA_ERROR_FAIL;
+
+	BSP_ExternalFlashGetInfo(&sFlashInfo);
+	sCallback        = aCallback;
+	sCallbackContext = aContext;
+
+	memset(&sMulticastResource, 0, sizeof(sMulticastResource));
+	sMulticastResource.mUriPath = OTA_CLIENT_MULTICAST_URI;
+	sMulticastResource.mHandler = &handle_multicast_block;
+	otCoapAddResource(OT_INSTANCE, &sMulticastResource);
+	sListening = true;
+	return CA_ERROR_SUCCESS;
+}
+
+void OTA_ClientStopListening(void)
+{
+	otIp6Address group;
+
+	if (!sListening)
+		return;
+
+	otCoapRemoveResource(OT_INSTANCE, &sMulticastResource);
+	if (otIp6AddressFromString(OTA_CLIENT_MULTICAST_GROUP, &group) == OT_ERROR_NONE)
+		otIp6UnsubscribeMulticastAddress(OT_INSTANCE, &group);
+	sListening = false;
+
+	if (sState == OTA_CLIENT_RECEIVING)
+		OTA_ClientStop();
+}
+
+enum ota_client_state OTA_ClientGetState(struct ota_client_progress *aProgress)
+{
+	if (aProgress)
+		*aProgress = sRecord.progress;
+	return sState;
+}
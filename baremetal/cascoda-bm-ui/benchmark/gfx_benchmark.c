@@ -0,0 +1,449 @@
+/*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file
+ * Host benchmark for the gfx library and the SSD1681 e-paper driver, built on the dummy posix platform.
+ *
+ * A set of representative screens is rendered into the frame buffer, and each one is sent to a
+ * simulated display with a full update and with a partial update. The SENSORIF SPI, GPIO and wait
+ * functions are wrapped at link time, so that the real display driver can run without hardware while
+ * the SPI bytes, refreshes and delays are counted. Rendered frames can be dumped as PBM images.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cascoda-bm/cascoda_sensorif.h"
+#include "cascoda-bm/cascoda_types.h"
+#include "cascoda_dummy.h"
+#include "gfx_driver.h"
+#include "gfx_library.h"
+#include "knx_iot_image_1_54.h"
+#include "sif_ssd1681.h"
+
+/** SSD1681 commands that are tracked to count refreshes */
+#define CMD_MASTER_ACTIVATION 0x20
+#define CMD_DISPLAY_UPDATE_CONTROL_2 0x22
+/** DISPLAY_UPDATE_CONTROL_2 values used by the driver for full and partial updates */
+#define UPDATE_SEQUENCE_FULL 0xC7
+#define UPDATE_SEQUENCE_PARTIAL 0xCF
+
+/** Typical refresh times of the Waveshare 1.54" panel, used to estimate the update time */
+#define FULL_REFRESH_MS 2000
+#define PARTIAL_REFRESH_MS 300
+
+/** Default number of times each screen is drawn to measure the drawing time */
+#define DEFAULT_ITERATIONS 200
+
+/** Counters for the graphics and display operations */
+struct bench_counters
+{
+	u32_t pixel_calls;       //!< Calls to gfx_drv_drawPixel
+	u32_t span_calls;        //!< Calls to the span and rectangle fills of the gfx driver
+	u32_t glyph_calls;       //!< Glyphs blitted from the glyph cache of the gfx driver
+	u32_t pixels;            //!< Pixels covered by all the calls, before clipping
+	u32_t spi_bytes;         //!< Bytes written to the display over SPI
+	u32_t spi_transfers;     //!< Number of calls to the SENSORIF SPI write functions
+	u32_t full_refreshes;    //!< Full refreshes started on the display
+	u32_t partial_refreshes; //!< Partial refreshes started on the display
+	u32_t waited_ms;         //!< Time spent in WAIT_ms delays
+};
+
+/** One benchmark screen */
+struct bench_screen
+{
+	const char *name;
+	void (*draw)(void);
+};
+
+static struct bench_counters sCounters;
+static u8_t                  sDC;
+static u8_t                  sLastCommand;
+static u8_t                  sUpdateSequence;
+
+/* Wrapped functions ------------------------------------------------------- */
+
+void __real_gfx_drv_drawPixel(int16_t x, int16_t y, uint16_t color);
+void __real_gfx_drv_fillRect(int16_t xmin, int16_t ymin, int16_t xmax, int16_t ymax, uint16_t color);
+void __real_gfx_drv_drawHLine(int16_t xmin, int16_t xmax, int16_t y, uint16_t color);
+void __real_gfx_drv_drawVLine(int16_t x, int16_t ymin, int16_t ymax, uint16_t color);
+bool __real_gfx_drv_drawGlyph(int16_t x, int16_t y, const uint8_t *columns, uint8_t size, uint16_t color, uint16_t bg);
+ca_error __real_BSP_ModuleSetGPIOPin(u8_t mpin, u8_t val);
+void     CHILI_FastForward(u32_t ticks);
+
+static void countSpan(int16_t xmin, int16_t ymin, int16_t xmax, int16_t ymax)
+{
+	sCounters.span_calls++;
+	sCounters.pixels += (u32_t)(abs(xmax - xmin) + 1) * (u32_t)(abs(ymax - ymin) + 1);
+}
+
+void __wrap_gfx_drv_drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+	sCounters.pixel_calls++;
+	sCounters.pixels++;
+	__real_gfx_drv_drawPixel(x, y, color);
+}
+
+void __wrap_gfx_drv_fillRect(int16_t xmin, int16_t ymin, int16_t xmax, int16_t ymax, uint16_t color)
+{
+	countSpan(xmin, ymin, xmax, ymax);
+	__real_gfx_drv_fillRect(xmin, ymin, xmax, ymax, color);
+}
+
+void __wrap_gfx_drv_drawHLine(int16_t xmin, int16_t xmax, int16_t y, uint16_t color)
+{
+	countSpan(xmin, y, xmax, y);
+	__real_gfx_drv_drawHLine(xmin, xmax, y, color);
+}
+
+void __wrap_gfx_drv_drawVLine(int16_t x, int16_t ymin, int16_t ymax, uint16_t color)
+{
+	countSpan(x, ymin, x, ymax);
+	__real_gfx_drv_drawVLine(x, ymin, ymax, color);
+}
+
+bool __wrap_gfx_drv_drawGlyph(int16_t x, int16_t y, const uint8_t *columns, uint8_t size, uint16_t color, uint16_t bg)
+{
+	if (!__real_gfx_drv_drawGlyph(x, y, columns, size, color, bg))
+		return false;
+
+	sCounters.glyph_calls++;
+	sCounters.pixels += 6 * 8 * size * size;
+	return true;
+}
+
+// the data/command pin tells apart the commands in the SPI stream
+ca_error __wrap_BSP_ModuleSetGPIOPin(u8_t mpin, u8_t val)
+{
+	if (mpin == SIF_SSD1681_DC_PIN)
+		sDC = val;
+	return __real_BSP_ModuleSetGPIOPin(mpin, val);
+}
+
+static void spiByte(u8_t byte)
+{
+	sCounters.spi_bytes++;
+
+	if (sDC)
+	{
+		if (sLastCommand == CMD_DISPLAY_UPDATE_CONTROL_2)
+			sUpdateSequence = byte;
+		return;
+	}
+
+	sLastCommand = byte;
+	if (byte != CMD_MASTER_ACTIVATION)
+		return;
+	if (sUpdateSequence == UPDATE_SEQUENCE_FULL)
+		sCounters.full_refreshes++;
+	else if (sUpdateSequence == UPDATE_SEQUENCE_PARTIAL)
+		sCounters.partial_refreshes++;
+}
+
+ca_error __wrap_SENSORIF_SPI_Write(u8_t out_data)
+{
+	sCounters.spi_transfers++;
+	spiByte(out_data);
+	return CA_ERROR_SUCCESS;
+}
+
+ca_error __wrap_SENSORIF_SPI_WriteBuffer(const u8_t *out_data, u32_t len)
+{
+	sCounters.spi_transfers++;
+	for (u32_t i = 0; i < len; i++) spiByte(out_data[i]);
+	return CA_ERROR_SUCCESS;
+}
+
+// the dummy platform has no tick interrupt, so time moves forward whenever the driver waits
+void __wrap_BSP_Waiting(void)
+{
+	sCounters.waited_ms++;
+	CHILI_FastForward(1);
+}
+
+/* Screens ------------------------------------------------------------------ */
+
+/** 16x16 icon, one bit per pixel, MSB first */
+static const uint8_t sIcon[] = {
+    0x03, 0xC0, 0x04, 0x20, 0x04, 0x20, 0x04, 0xA0, 0x04, 0xA0, 0x04, 0xA0, 0x04, 0xA0, 0x04, 0xA0,
+    0x04, 0xA0, 0x09, 0xD0, 0x13, 0xE8, 0x13, 0xE8, 0x13, 0xE8, 0x09, 0xD0, 0x04, 0x20, 0x03, 0xC0,
+};
+
+/** Data for the charts */
+static const uint8_t sChartData[] = {
+    40, 52, 61, 70, 74, 71, 66, 58, 47, 38, 30, 27, 29, 35, 44, 55, 63, 68, 66, 60,
+};
+
+static void drawText(uint16_t x, uint16_t y, uint8_t size, const char *text)
+{
+	display_setCursor(x, y);
+	display_setTextSize(size);
+	display_puts((const uint8_t *)text);
+}
+
+static void screenText(void)
+{
+	display_setTextColor(BLACK, WHITE);
+	drawText(4, 4, 3, "Room 1");
+	drawText(4, 36, 2, "21.5 C  45%");
+	drawText(4, 60, 1, "The quick brown fox jumps over the lazy dog. THE QUICK BROWN FOX");
+	drawText(4, 84, 1, "0123456789 !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~");
+	display_setTextColor(WHITE, BLACK);
+	drawText(4, 110, 2, " Inverted ");
+	display_setTextColor(BLACK, BLACK);
+	drawText(4, 140, 1, "Transparent text over the background");
+	drawText(4, 160, 4, "12:34");
+}
+
+static void screenQR(void)
+{
+	SIF_SSD1681_overlay_qr_code("https://www.cascoda.com", get_framebuffer(), 2, 40, 20);
+	gfx_drv_markDirty(40, 20, LCDWIDTH - 1, LCDHEIGHT - 1);
+	display_setTextColor(BLACK, WHITE);
+	drawText(30, 170, 2, "Scan me");
+}
+
+static void screenBitmap(void)
+{
+	display_drawBitmapV2_bg(0, 0, knx_iot_logo, LCDWIDTH, LCDHEIGHT, WHITE, BLACK);
+	for (uint16_t i = 0; i < 8; i++) display_drawBitmapV2(8 + i * 24, 176, sIcon, 16, 16, BLACK);
+}
+
+static void screenChart(void)
+{
+	const uint16_t x0 = 20, y0 = 180, step = 9;
+
+	display_setTextColor(BLACK, WHITE);
+	drawText(4, 2, 1, "Temperature, last 20 hours");
+	display_drawLine(x0, 20, x0, y0, BLACK);
+	display_drawLine(x0, y0, x0 + 20 * step, y0, BLACK);
+	for (uint16_t y = 20; y < y0; y += 20)
+	{
+		for (uint16_t x = x0; x < x0 + 20 * step; x += 4) display_drawPixel(x, y, BLACK);
+	}
+	for (uint16_t i = 0; i < sizeof(sChartData); i++)
+	{
+		display_fillRect(x0 + 2 + i * step, y0 - sChartData[i], step - 3, sChartData[i], BLACK);
+		if (i)
+			display_drawLine(x0 + 4 + (i - 1) * step,
+			                 y0 - 2 * sChartData[i - 1],
+			                 x0 + 4 + i * step,
+			                 y0 - 2 * sChartData[i],
+			                 BLACK);
+	}
+	drawText(4, 186, 1, "0h");
+	drawText(170, 186, 1, "20h");
+}
+
+static void screenShapes(void)
+{
+	display_fillRoundRect(4, 4, 92, 60, 10, BLACK);
+	display_drawRoundRect(104, 4, 92, 60, 10, BLACK);
+	display_fillCircle(50, 110, 36, BLACK);
+	display_drawCircle(150, 110, 36, BLACK);
+	display_fillTriangle(10, 190, 90, 190, 50, 150, BLACK);
+	display_drawTriangle(110, 190, 190, 190, 150, 150, BLACK);
+	display_progressbar(4, 66, 92, 70);
+	display_slider(104, 72, 88, 30);
+}
+
+static const struct bench_screen sScreens[] = {
+    {"text", screenText},
+    {"qr", screenQR},
+    {"bitmap", screenBitmap},
+    {"chart", screenChart},
+    {"shapes", screenShapes},
+};
+
+/* Benchmark ---------------------------------------------------------------- */
+
+static double nowUs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// SPI transfer time at the SENSORIF clock, plus refreshes and driver delays
+static u32_t estimateMs(const struct bench_counters *counters)
+{
+	return (u32_t)((u64_t)counters->spi_bytes * 8 * 1000 / SENSORIF_SPI_CLK_FREQUENCY) +
+	       counters->full_refreshes * FULL_REFRESH_MS + counters->partial_refreshes * PARTIAL_REFRESH_MS +
+	       counters->waited_ms;
+}
+
+static void drawScreen(const struct bench_screen *screen)
+{
+	display_setRotation(0);
+	display_clear();
+	screen->draw();
+}
+
+// PBM has 1 for black pixels, where the frame buffer has 1 for white.
+// fputc is retargeted by cascoda-bm-driver, so whole rows are written with fwrite.
+static int dumpFrame(const char *dir, const char *name)
+{
+	char     path[256];
+	uint8_t  row[LCDWIDTH / 8];
+	FILE    *file;
+	uint8_t *frame = get_framebuffer();
+
+	snprintf(path, sizeof(path), "%s/%s.pbm", dir, name);
+	file = fopen(path, "wb");
+	if (!file)
+	{
+		fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	fprintf(file, "P4\n%d %d\n", LCDWIDTH, LCDHEIGHT);
+	for (int y = 0; y < LCDHEIGHT; y++)
+	{
+		for (int x = 0; x < LCDWIDTH / 8; x++) row[x] = ~frame[y * (LCDWIDTH / 8) + x];
+		fwrite(row, 1, sizeof(row), file);
+	}
+	fclose(file);
+	return 0;
+}
+
+static void printUsage(const char *exec_name)
+{
+	fprintf(stderr, "Usage: %s [-n ITERATIONS] [-o DIRECTORY]\n", exec_name);
+	fprintf(stderr, "\tRender a set of representative screens with the gfx library, and send them to\n");
+	fprintf(stderr, "\ta simulated SSD1681 display with full and partial updates.\n\n");
+	fprintf(stderr, "\t-n ITERATIONS  Number of times each screen is drawn to time it (default %d)\n", DEFAULT_ITERATIONS);
+	fprintf(stderr, "\t-o DIRECTORY   Dump the rendered screens to DIRECTORY as PBM images\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const size_t          num_screens = sizeof(sScreens) / sizeof(sScreens[0]);
+	struct bench_counters draw[sizeof(sScreens) / sizeof(sScreens[0])];
+	struct bench_counters full[sizeof(sScreens) / sizeof(sScreens[0])];
+	struct bench_counters partial[sizeof(sScreens) / sizeof(sScreens[0])];
+	double                draw_us[sizeof(sScreens) / sizeof(sScreens[0])];
+	const char           *dump_dir   = NULL;
+	long                  iterations = DEFAULT_ITERATIONS;
+	int                   opt;
+
+	while ((opt = getopt(argc, argv, "n:o:h")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n':
+			iterations = strtol(optarg, NULL, 0);
+			if (iterations <= 0)
+			{
+				printUsage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'o':
+			dump_dir = optarg;
+			break;
+		default:
+			printUsage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	// The simulated panel is always idle, else every BUSY wait of the driver runs into its timeout
+	DUMMY_ModuleSetGPIOInput(SIF_SSD1681_BUSY_PIN, 0);
+
+	// Drawing cost and full updates, each screen on its own
+	for (size_t i = 0; i < num_screens; i++)
+	{
+		double start;
+
+		memset(&sCounters, 0, sizeof(sCounters));
+		drawScreen(&sScreens[i]);
+		draw[i] = sCounters;
+
+		if (dump_dir && dumpFrame(dump_dir, sScreens[i].name))
+			return EXIT_FAILURE;
+
+		start = nowUs();
+		for (long n = 0; n < iterations; n++) drawScreen(&sScreens[i]);
+		draw_us[i] = (nowUs() - start) / iterations;
+
+		memset(&sCounters, 0, sizeof(sCounters));
+		display_render_full();
+		full[i] = sCounters;
+	}
+
+	// Partial updates from one screen to the next, with the display kept awake
+	display_clear();
+	display_render_partial(false);
+	for (size_t i = 0; i < num_screens; i++)
+	{
+		drawScreen(&sScreens[i]);
+		memset(&sCounters, 0, sizeof(sCounters));
+		display_render_partial(false);
+		partial[i] = sCounters;
+	}
+	SIF_SSD1681_DeepSleep();
+	SIF_SSD1681_Deinitialise();
+
+	printf("%-8s %9s %8s %8s %6s %8s | %-20s | %-20s\n", "", "", "", "", "", "", "full update", "partial update");
+	printf("%-8s %9s %8s %8s %6s %8s | %7s %5s %6s | %7s %5s %6s\n",
+	       "screen",
+	       "draw us",
+	       "pixel",
+	       "span",
+	       "glyph",
+	       "pixels",
+	       "SPI B",
+	       "xfers",
+	       "est ms",
+	       "SPI B",
+	       "xfers",
+	       "est ms");
+	for (size_t i = 0; i < num_screens; i++)
+	{
+		printf("%-8s %9.1f %8u %8u %6u %8u | %7u %5u %6u | %7u %5u %6u\n",
+		       sScreens[i].name,
+		       draw_us[i],
+		       draw[i].pixel_calls,
+		       draw[i].span_calls,
+		       draw[i].glyph_calls,
+		       draw[i].pixels,
+		       full[i].spi_bytes,
+		       full[i].spi_transfers,
+		       estimateMs(&full[i]),
+		       partial[i].spi_bytes,
+		       partial[i].spi_transfers,
+		       estimateMs(&partial[i]));
+	}
+
+	return EXIT_SUCCESS;
+}
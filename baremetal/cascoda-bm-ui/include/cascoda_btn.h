@@ -46,6 +46,16 @@
 #define BTN_SHARED_SENSE_DELAY 2
 #endif
 
+/* time [ms] the input of a button with interrupt has to be stable after an edge before it is sampled */
+#ifndef BTN_DEBOUNCE_TIME
+#define BTN_DEBOUNCE_TIME 20
+#endif
+
+/* interval [ms] at which buttons with interrupt are sampled while pressed, or while the LED of a shared pin is on */
+#ifndef BTN_ACTIVE_SENSE_INTERVAL
+#define BTN_ACTIVE_SENSE_INTERVAL 50
+#endif
+
 /* Execute short press callback when pressed or on release
  * Note: BTN_SHORTPRESS_RELEASED should only be used when
  * the same button is being registered with a long press
@@ -126,6 +136,7 @@ ca_error Btn_RegisterButtonInput(uint8_t ledBtn);
 
 /**
  * \brief Register button input with interrupt (for sleepy devices)
+ * The button is handled from the interrupts on its edges instead of being scanned, see Btn_PollButtons().
  * \param ledBtn - reference to button
  * \return status
  *
@@ -142,6 +153,8 @@ ca_error Btn_RegisterSharedButtonLED(uint8_t ledBtn);
 
 /**
  * \brief Register button as shared input/output with interrupt (for sleepy devices)
+ * The button is handled from the interrupts on its edges instead of being scanned, see Btn_PollButtons().
+ * While the LED is on, the pin cannot signal a press, so it is sampled every BTN_ACTIVE_SENSE_INTERVAL instead.
  * \param ledBtn - reference to button
  * \return status
  *
@@ -218,6 +231,10 @@ ca_error Btn_SenseOutput(uint8_t ledBtn, uint8_t* val);
 
 /**
  * \brief Main polling function to activate callbacks for any buttons that are currently being pressed
+ * Buttons registered with an interrupt are not scanned. Their interrupts timestamp the edges, which this
+ * function hands over to a tasklet that samples the buttons once debounced, and times long presses and
+ * holds while a button is pressed. With only interrupt buttons, this returns straight away when no edge
+ * occurred, and nothing is scheduled while no button is pressed, so the device can sleep between presses.
  * \return status
  *
  */
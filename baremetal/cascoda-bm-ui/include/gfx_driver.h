@@ -6,6 +6,9 @@ Copyright 2023 Cascoda LTD.
 #ifndef GFX_DRIVER_H
 #define GFX_DRIVER_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -30,14 +33,48 @@ extern "C" {
 #define BLACK 0
 #define WHITE 1
 
+// number of text glyphs kept pre-rendered for the current rotation, 0 disables the glyph cache
+#ifndef GFX_GLYPH_CACHE_ENTRIES
+#define GFX_GLYPH_CACHE_ENTRIES 16
+#endif
+// largest text size whose glyphs are cached, each entry takes about 6 * size * size bytes
+#ifndef GFX_GLYPH_CACHE_MAX_SIZE
+#define GFX_GLYPH_CACHE_MAX_SIZE 3
+#endif
+// keep a copy of the frame last sent to the display (LCDWIDTH * LCDHEIGHT / 8 bytes), to leave out of partial
+// updates what was redrawn unchanged. 0 only refreshes the bounding box of the changes made since the last update
+#ifndef GFX_DIRTY_SHADOW
+#define GFX_DIRTY_SHADOW 1
+#endif
+
 // retrieve the frame buffer
 uint8_t* get_framebuffer(void);
 // clear the frame buffer
 void gfx_drv_clearDisplay(void);
 // draw pixel in the frame buffer
 void gfx_drv_drawPixel(int16_t x, int16_t y, uint16_t color);
-// set the low level rotation
+// fill a rectangle in the frame buffer, corners inclusive and in any order
+void gfx_drv_fillRect(int16_t xmin, int16_t ymin, int16_t xmax, int16_t ymax, uint16_t color);
+// draw a horizontal line in the frame buffer, from xmin to xmax inclusive
+void gfx_drv_drawHLine(int16_t xmin, int16_t xmax, int16_t y, uint16_t color);
+// draw a vertical line in the frame buffer, from ymin to ymax inclusive
+void gfx_drv_drawVLine(int16_t x, int16_t ymin, int16_t ymax, uint16_t color);
+// draw a 5x8 font glyph (columns LSB at the top) magnified by size, with one column of spacing on the right.
+// the glyph is rendered once for the current rotation and cached. if bg differs from color, the background of the
+// whole 6x8 cell is drawn as well. returns false if the glyph cannot be cached or is not entirely on the display,
+// in which case nothing is drawn.
+bool gfx_drv_drawGlyph(int16_t x, int16_t y, const uint8_t *columns, uint8_t size, uint16_t color, uint16_t bg);
+// set the low level rotation, which empties the glyph cache
 void gfx_drv_setRotation(uint16_t rotation);
+// get the region of the frame buffer that changed since the display was last updated,
+// in frame buffer pixels (unrotated, inclusive, x aligned to bytes). returns false if nothing changed.
+bool gfx_drv_getDirtyRegion(uint16_t *xmin, uint16_t *ymin, uint16_t *xmax, uint16_t *ymax);
+// mark a region as changed, for code writing into get_framebuffer() directly
+void gfx_drv_markDirty(uint16_t xmin, uint16_t ymin, uint16_t xmax, uint16_t ymax);
+// the display has been updated with the frame buffer, nothing is dirty anymore
+void gfx_drv_clearDirtyRegion(void);
+// the display content is unknown, the next update must cover the whole frame buffer
+void gfx_drv_invalidate(void);
 
 #ifdef __cplusplus
 }
@@ -191,6 +191,9 @@ void display_clear(void);
   . To do a full update (always preceded with a clear), simply call the function `display_render_full()`.
   . To do a partial update, call the function `display_render_partial()`, with `true` or `false` as the argument depending
     on whether you want the eink display to be put in Deep Sleep mode after the update is done.
+    Partial updates only send what changed, and are fastest when the display is kept awake between them.
+    If drawing into `get_framebuffer()` directly rather than with the display_ functions, call
+    `gfx_drv_markDirty()` on the region that was drawn.
 */
 #if (defined EPAPER_2_9_INCH || defined EPAPER_MIKROE_1_54_INCH)
 
@@ -246,8 +249,16 @@ void display_render_nowait(SIF_SSD1608_Update_Mode updt_mode, SIF_SSD1608_Clear_
 */
 void display_render_full(void);
 
+/** Number of partial updates after which display_render_partial() does a full update instead, to remove ghosting */
+#ifndef GFX_PARTIAL_UPDATES_PER_FULL
+#define GFX_PARTIAL_UPDATES_PER_FULL 20
+#endif
+
 /**
     \brief Displays the frame buffer onto the eink display using partial update (fast).
+    Only the region of the frame buffer that changed since the last update is sent to the
+    display, and nothing is sent if it did not change. Every GFX_PARTIAL_UPDATES_PER_FULL
+    partial updates, a full update is done instead.
     \param sleep_when_done If true, will set the eink display into Deep Sleep
     mode after the partial update is done.
 */
@@ -121,15 +121,19 @@ void SIF_IL3820_Deinitialise(void);
 /***************************************************************************/ /**
  * \brief Clears the display
  *******************************************************************************
+ * \return CA_ERROR_SUCCESS, or the error of the SPI transfer that failed
+ *******************************************************************************
  ******************************************************************************/
-void SIF_IL3820_ClearDisplay(void);
+ca_error SIF_IL3820_ClearDisplay(void);
 
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief Clears the display many times to make sure there is no ghost image
  *******************************************************************************
+ * \return CA_ERROR_SUCCESS, or the error of the SPI transfer that failed
+ *******************************************************************************
  ******************************************************************************/
-void SIF_IL3820_StrongClearDisplay(void);
+ca_error SIF_IL3820_StrongClearDisplay(void);
 
 /******************************************************************************/
 /***************************************************************************/ /**
@@ -141,14 +145,18 @@ void SIF_IL3820_DeepSleep(void);
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief Creates a QR code and overlays it on top of a pre-existing image
- *        at the given coordinates.
+ *        at the given coordinates. The symbol of the last text is cached,
+ *        so redrawing the same QR code does not generate it again.
  *******************************************************************************
  * \param text  - The text string that is encoded into a QR symbol.
  * \param image - The image that is overlaid by the QR symbol.
- * \param scale - scaling of the image, 1 or 2 supported.
+ * \param scale - scaling of the image, the size of a QR module in pixels.
  * \param x     - The x-coordinate of the top-left corner of the QR symbol.
  * \param y     - The y-coordinate of the top-left corner of the QR symbol.
  *******************************************************************************
+ * \return CA_ERROR_SUCCESS, CA_ERROR_FAIL if the text is too long, or
+ *         CA_ERROR_INVALID_ARGS if the symbol does not fit in the image
+ *******************************************************************************
  ******************************************************************************/
 ca_error SIF_IL3820_overlay_qr_code(const char *text, uint8_t *image, uint8_t scale, uint8_t x, uint8_t y);
 
@@ -160,8 +168,42 @@ ca_error SIF_IL3820_overlay_qr_code(const char *text, uint8_t *image, uint8_t sc
  * \param mode - Whether or not the display will be cleared before the image
  * is displayed
  *******************************************************************************
+ * \return CA_ERROR_SUCCESS, or the error of the SPI transfer that failed, in
+ * which case the display is not refreshed but still put into deep sleep
+ *******************************************************************************
+ ******************************************************************************/
+ca_error SIF_IL3820_DisplayImage(const uint8_t *image, SIF_IL3820_Clear_Mode mode);
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Starts writing a new image into the display RAM, piece by piece, with
+ * SIF_IL3820_WriteFrameMemory. This allows an image to be displayed without
+ * holding all of it in memory at once, for instance while it is decompressed.
+ *******************************************************************************
+ ******************************************************************************/
+void SIF_IL3820_StartFrameMemory(void);
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Writes the next part of the image into the display RAM. Data past the
+ * end of the image is ignored.
+ *******************************************************************************
+ * \param data   - The next bytes of the image, in the same format as for
+ * SIF_IL3820_DisplayImage.
+ * \param length - The number of bytes in data.
+ *******************************************************************************
+ * \return CA_ERROR_SUCCESS, or the error of the SPI transfer that failed
+ *******************************************************************************
+ ******************************************************************************/
+ca_error SIF_IL3820_WriteFrameMemory(const uint8_t *data, uint16_t length);
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Displays the image written with SIF_IL3820_WriteFrameMemory, then puts
+ * the display into deep sleep.
+ *******************************************************************************
  ******************************************************************************/
-void SIF_IL3820_DisplayImage(const uint8_t *image, SIF_IL3820_Clear_Mode mode);
+void SIF_IL3820_DisplayFrameMemory(void);
 
 #ifdef __cplusplus
 }
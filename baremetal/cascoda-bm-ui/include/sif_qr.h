@@ -0,0 +1,144 @@
+/*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @ingroup bm-sensorif
+ * @defgroup bm-sensorif-qr QR code overlays for the E-Paper displays
+ * @brief Generation of QR code symbols, and drawing them into E-Paper images.
+ *
+ * Encoding a QR code is by far the most expensive part of drawing it, so the
+ * last symbol generated is cached, together with its text. The cache can
+ * be persisted by the application (eg. in its settings) with SIF_QR_GetCache()
+ * and SIF_QR_SetCache(), so that it survives a reset.
+ *
+ * @{
+*/
+
+#ifndef SIF_QR_H
+#define SIF_QR_H
+
+#include <stdint.h>
+#include "ca821x_error.h"
+#include "qrcodegen.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Highest QR code version generated, which limits the length of the text */
+#ifndef SIF_QR_MAX_VERSION
+#define SIF_QR_MAX_VERSION 10
+#endif
+
+/**
+ * Mask pattern of the QR code symbols. The default qrcodegen_Mask_AUTO encodes
+ * the symbol with all 8 masks to pick the best one. A fixed mask (qrcodegen_Mask_0
+ * to qrcodegen_Mask_7) is about 8 times faster to encode, and almost always scans fine.
+ */
+#ifndef SIF_QR_MASK
+#define SIF_QR_MASK qrcodegen_Mask_AUTO
+#endif
+
+/** Longest text whose symbol is cached, the symbols of longer texts are generated every time */
+#ifndef SIF_QR_CACHE_TEXT_LEN
+#define SIF_QR_CACHE_TEXT_LEN 128
+#endif
+
+/** The last QR code symbol generated, and the text it was generated from */
+struct sif_qr_cache
+{
+	uint16_t length;                      //!< Length of the text, 0 if nothing is cached
+	char     text[SIF_QR_CACHE_TEXT_LEN]; //!< The text, not null terminated
+	uint8_t  qrcode[qrcodegen_BUFFER_LEN_FOR_VERSION(SIF_QR_MAX_VERSION)]; //!< The symbol, in qrcodegen format
+};
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Generates the QR code symbol of a text, or gets it from the cache if the
+ *        text is the same as the last one.
+ *******************************************************************************
+ * \param text   - The text string that is encoded into a QR symbol.
+ * \param qrcode - Set to the symbol, which is valid until the next call.
+ *******************************************************************************
+ * \return CA_ERROR_SUCCESS, or CA_ERROR_FAIL if the text is too long
+ *******************************************************************************
+ ******************************************************************************/
+ca_error SIF_QR_Encode(const char *text, const uint8_t **qrcode);
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Draws a QR code symbol into an image, with dark modules as black (0) pixels.
+ *******************************************************************************
+ * \param qrcode - The symbol, from SIF_QR_Encode().
+ * \param image  - The image that is overlaid by the QR symbol.
+ * \param width  - The width of the image in pixels, a multiple of 8.
+ * \param height - The height of the image in pixels.
+ * \param scale  - The size of a module of the symbol, in pixels.
+ * \param x      - The x-coordinate of the top-left corner of the QR symbol.
+ * \param y      - The y-coordinate of the top-left corner of the QR symbol.
+ *******************************************************************************
+ * \return CA_ERROR_SUCCESS, or CA_ERROR_INVALID_ARGS if the symbol does not fit
+ *******************************************************************************
+ ******************************************************************************/
+ca_error SIF_QR_Embed(const uint8_t *qrcode,
+                      uint8_t       *image,
+                      uint16_t       width,
+                      uint16_t       height,
+                      uint8_t        scale,
+                      uint16_t       x,
+                      uint16_t       y);
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Gets the cache of the last QR code symbol, to persist it.
+ *******************************************************************************
+ * \return The cache, which has a length of 0 if there is nothing to persist
+ *******************************************************************************
+ ******************************************************************************/
+const struct sif_qr_cache *SIF_QR_GetCache(void);
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Restores a persisted cache, so that its symbol does not need to be
+ *        generated again.
+ *******************************************************************************
+ * \param cache - The cache, as previously returned by SIF_QR_GetCache().
+ *******************************************************************************
+ * \return CA_ERROR_SUCCESS, or CA_ERROR_INVALID_ARGS if the cache is not valid
+ *******************************************************************************
+ ******************************************************************************/
+ca_error SIF_QR_SetCache(const struct sif_qr_cache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIF_QR_H
+
+/**
+ * @}
+ */
@@ -148,15 +148,19 @@ void SIF_SSD1608_Deinitialise(void);
 /***************************************************************************/ /**
  * \brief Clears the display
  *******************************************************************************
+ * \return CA_ERROR_SUCCESS, or the error of the SPI transfer that failed
+ *******************************************************************************
  ******************************************************************************/
-void SIF_SSD1608_ClearDisplay(void);
+ca_error SIF_SSD1608_ClearDisplay(void);
 
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief Clears the display many times to make sure there is no ghost image
  *******************************************************************************
+ * \return CA_ERROR_SUCCESS, or the error of the SPI transfer that failed
+ *******************************************************************************
  ******************************************************************************/
-void SIF_SSD1608_StrongClearDisplay(void);
+ca_error SIF_SSD1608_StrongClearDisplay(void);
 
 /******************************************************************************/
 /***************************************************************************/ /**
@@ -168,14 +172,18 @@ void SIF_SSD1608_DeepSleep(void);
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief Creates a QR code and overlays it on top of a pre-existing image
- *        at the given coordinates.
+ *        at the given coordinates. The symbol of the last text is cached,
+ *        so redrawing the same QR code does not generate it again.
  *******************************************************************************
  * \param text  - The text string that is encoded into a QR symbol.
  * \param image - The image that is overlaid by the QR symbol.
- * \param scale - scaling of the image, 1 or 2 supported.
+ * \param scale - scaling of the image, the size of a QR module in pixels.
  * \param x     - The x-coordinate of the top-left corner of the QR symbol.
  * \param y     - The y-coordinate of the top-left corner of the QR symbol.
  *******************************************************************************
+ * \return CA_ERROR_SUCCESS, CA_ERROR_FAIL if the text is too long, or
+ *         CA_ERROR_INVALID_ARGS if the symbol does not fit in the image
+ *******************************************************************************
  ******************************************************************************/
 ca_error SIF_SSD1608_overlay_qr_code(const char *text, uint8_t *image, uint8_t scale, uint8_t x, uint8_t y);
 
@@ -192,8 +200,11 @@ ca_error SIF_SSD1608_overlay_qr_code(const char *text, uint8_t *image, uint8_t s
  * built with half resolution in mind. This allows the option to display an
  * image (typically stored in flash) using full resolution, as an exception.
  *******************************************************************************
+ * \return CA_ERROR_SUCCESS, or the error of the SPI transfer that failed, in
+ * which case the display is not refreshed but still put into deep sleep
+ *******************************************************************************
  ******************************************************************************/
-void SIF_SSD1608_DisplayImage(const uint8_t *image, SIF_SSD1608_Clear_Mode mode, bool full_resolution);
+ca_error SIF_SSD1608_DisplayImage(const uint8_t *image, SIF_SSD1608_Clear_Mode mode, bool full_resolution);
 
 /******************************************************************************/
 /***************************************************************************/ /**
@@ -209,8 +220,11 @@ void SIF_SSD1608_DisplayImage(const uint8_t *image, SIF_SSD1608_Clear_Mode mode,
  * built with half resolution in mind. This allows the option to display an
  * image (typically stored in flash) using full resolution, as an exception.
  *******************************************************************************
+ * \return CA_ERROR_SUCCESS, or the error of the SPI transfer that failed, in
+ * which case the display is not refreshed
+ *******************************************************************************
  ******************************************************************************/
-void SIF_SSD1608_DisplayImageNoWait(const uint8_t *image, SIF_SSD1608_Clear_Mode mode, bool full_resolution);
+ca_error SIF_SSD1608_DisplayImageNoWait(const uint8_t *image, SIF_SSD1608_Clear_Mode mode, bool full_resolution);
 
 /******************************************************************************/
 /***************************************************************************/ /**
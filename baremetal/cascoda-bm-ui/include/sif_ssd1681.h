@@ -144,15 +144,19 @@ void SIF_SSD1681_Deinitialise(void);
 /***************************************************************************/ /**
  * \brief Clears the display
  *******************************************************************************
+ * \return Status of the SPI transfer, the display is not refreshed on error
+ *******************************************************************************
  ******************************************************************************/
-void SIF_SSD1681_ClearDisplay(void);
+ca_error SIF_SSD1681_ClearDisplay(void);
 
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief Clears the display many times to make sure there is no ghost image
  *******************************************************************************
+ * \return Status of the SPI transfer, the display is not refreshed on error
+ *******************************************************************************
  ******************************************************************************/
-void SIF_SSD1681_StrongClearDisplay(void);
+ca_error SIF_SSD1681_StrongClearDisplay(void);
 
 /******************************************************************************/
 /***************************************************************************/ /**
@@ -164,14 +168,18 @@ void SIF_SSD1681_DeepSleep(void);
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief Creates a QR code and overlays it on top of a pre-existing image
- *        at the given coordinates.
+ *        at the given coordinates. The symbol of the last text is cached,
+ *        so redrawing the same QR code does not generate it again.
  *******************************************************************************
  * \param text  - The text string that is encoded into a QR symbol.
  * \param image - The image that is overlaid by the QR symbol.
- * \param scale - scaling of the image, 1 or 2 supported.
+ * \param scale - scaling of the image, the size of a QR module in pixels.
  * \param x     - The x-coordinate of the top-left corner of the QR symbol.
  * \param y     - The y-coordinate of the top-left corner of the QR symbol.
  *******************************************************************************
+ * \return CA_ERROR_SUCCESS, CA_ERROR_FAIL if the text is too long, or
+ *         CA_ERROR_INVALID_ARGS if the symbol does not fit in the image
+ *******************************************************************************
  ******************************************************************************/
 ca_error SIF_SSD1681_overlay_qr_code(const char *text, uint8_t *image, uint8_t scale, uint8_t x, uint8_t y);
 
@@ -186,8 +194,10 @@ ca_error SIF_SSD1681_overlay_qr_code(const char *text, uint8_t *image, uint8_t s
  * built with half resolution in mind. This allows the option to display an
  * image (typically stored in flash) using full resolution, as an exception.
  *******************************************************************************
+ * \return Status of the SPI transfer, the display is not refreshed on error
+ *******************************************************************************
  ******************************************************************************/
-void SIF_SSD1681_SetFrameMemory(const uint8_t *image, bool full_resolution);
+ca_error SIF_SSD1681_SetFrameMemory(const uint8_t *image, bool full_resolution);
 
 /******************************************************************************/
 /***************************************************************************/ /**
@@ -195,8 +205,33 @@ void SIF_SSD1681_SetFrameMemory(const uint8_t *image, bool full_resolution);
  *******************************************************************************
  * \param image - The image that is copied into the RAM.
  *******************************************************************************
+ * \return Status of the SPI transfer
+ *******************************************************************************
  ******************************************************************************/
-void SIF_SSD1681_SetFrameMemoryPartial(const uint8_t *image);
+ca_error SIF_SSD1681_SetFrameMemoryPartial(const uint8_t *image);
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Copies a rectangular region of the image into the eink display's RAM,
+ * for partial update. Only the region is sent over SPI, the rest of the RAM
+ * keeps what was previously written to it.
+ *******************************************************************************
+ * \param image - The image that the region is copied from.
+ * \param xmin  - Left edge of the region in image pixels, rounded down to a
+ * multiple of 8.
+ * \param ymin  - Top edge of the region in image pixels.
+ * \param xmax  - Right edge of the region in image pixels (inclusive), rounded
+ * up to a multiple of 8.
+ * \param ymax  - Bottom edge of the region in image pixels (inclusive).
+ *******************************************************************************
+ * \return Status of the SPI transfer
+ *******************************************************************************
+ ******************************************************************************/
+ca_error SIF_SSD1681_SetFrameMemoryRegion(const uint8_t *image,
+                                         uint16_t       xmin,
+                                         uint16_t       ymin,
+                                         uint16_t       xmax,
+                                         uint16_t       ymax);
 
 /******************************************************************************/
 /***************************************************************************/ /**
@@ -221,8 +256,10 @@ void SIF_SSD1681_DisplayPartFrame(void);
  * NOTE: It is necessary to call this function for the first ever partial update,
  * or for the first partial update after waking up from deep sleep.
  *******************************************************************************
+ * \return Status of the SPI transfer, the display is not refreshed on error
+ *******************************************************************************
  ******************************************************************************/
-void SIF_SSD1681_DisplayPartBaseImageWhite(void);
+ca_error SIF_SSD1681_DisplayPartBaseImageWhite(void);
 
 #ifdef __cplusplus
 }
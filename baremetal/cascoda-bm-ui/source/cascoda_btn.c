@@ -33,6 +33,7 @@
 #include "cascoda-bm/cascoda_evbme.h"
 #include "cascoda-bm/cascoda_interface.h"
 #include "cascoda-bm/cascoda_wait.h"
+#include "cascoda-util/cascoda_tasklet.h"
 #include "cascoda-util/cascoda_time.h"
 
 #include <stdint.h>
@@ -59,17 +60,241 @@ static uint8_t UseGPIOWakeup = 0;
 static uint8_t SleepPermanently = 0;
 
 // button interrupt occured
-static uint8_t BtnHasInterrupt = 0;
+static volatile uint8_t BtnHasInterrupt = 0;
+
+/* Buttons with interrupt are sampled by a tasklet, after their edges have been debounced,
+ * instead of being scanned by Btn_PollButtons(). The interrupts only timestamp the edges.
+ */
+static ca_tasklet BtnTasklet;
+static uint8_t    BtnTaskletInitialised = 0;
+
+/* first edge [ms] since the button was last sampled, valid while edgePending is set */
+static volatile uint32_t edgeTime[NUM_LEDBTN];
+static volatile uint8_t  edgePending[NUM_LEDBTN];
+/* most recent edge [ms] of any button, debouncing ends BTN_DEBOUNCE_TIME after it */
+static volatile uint32_t lastEdgeTime;
+/* edges are ignored until edgeMaskEnd while edgeMasked is set, as the LED of a shared pin is switched */
+static volatile uint32_t edgeMaskEnd[NUM_LEDBTN];
+static volatile uint8_t  edgeMasked[NUM_LEDBTN];
+
+/* shared pins whose LED has been released to sense the button, while BtnSensing is set */
+static uint8_t senseReleased[NUM_LEDBTN];
+static uint8_t BtnSensing = 0;
+
+static ca_error handleButton(btn_callback_info *callback, uint8_t pressed, uint32_t event_time, uint32_t current_time);
 
 /* ISR for buttons */
-static int btn_isr(void)
+static int btn_isr(uint8_t ledBtn)
 {
+	uint32_t now = TIME_ReadAbsoluteTime();
+
 	/* set interrupt flag */
 	BtnHasInterrupt = 1;
-	/* only wakeup, the rest is handled in in polling function */
+
+	if (edgeMasked[ledBtn])
+	{
+		if (TIME_Cmp(now, edgeMaskEnd[ledBtn]) < 0)
+			return 0;
+		edgeMasked[ledBtn] = 0;
+	}
+
+	/* timestamp the edge, the rest is handled in the button tasklet */
+	if (!edgePending[ledBtn])
+	{
+		edgeTime[ledBtn]    = now;
+		edgePending[ledBtn] = 1;
+	}
+	lastEdgeTime = now;
+
 	return 0;
 }
 
+/* GPIO callbacks do not get the pin, so each button needs its own */
+static int btn_isr_0(void)
+{
+	return btn_isr(0);
+}
+
+static int btn_isr_1(void)
+{
+	return btn_isr(1);
+}
+
+static int btn_isr_2(void)
+{
+	return btn_isr(2);
+}
+
+static int btn_isr_3(void)
+{
+	return btn_isr(3);
+}
+
+static int (*const btn_isrs[NUM_LEDBTN])(void) = {btn_isr_0, btn_isr_1, btn_isr_2, btn_isr_3};
+
+/* ignore the edges of a pin for a while, eg. when switching the LED of a shared pin */
+static void maskEdges(uint8_t ledBtn, uint32_t until)
+{
+	edgeMaskEnd[ledBtn] = until;
+	edgeMasked[ledBtn]  = 1;
+	edgePending[ledBtn] = 0;
+}
+
+/* check whether a button with interrupt has to be sampled periodically */
+static bool isActive(uint8_t ledBtn)
+{
+	uint8_t led;
+
+	if (buttonCallbacks[ledBtn].lastState == BTN_PRESSED)
+		return true;
+
+	/* a shared pin cannot signal a press while its LED is on */
+	if (registeredPinTypes[ledBtn] == PINTYPE_SHARED)
+	{
+		if (Btn_SenseOutput(ledBtn, &led) == CA_ERROR_SUCCESS && led == LED_ON)
+			return true;
+	}
+
+	return false;
+}
+
+/* time [ms] from now until a time, 0 if it is in the past */
+static uint32_t timeUntil(uint32_t time, uint32_t now)
+{
+	if (TIME_Cmp(time, now) <= 0)
+		return 0;
+	return time - now;
+}
+
+/* schedule the button tasklet for the next debounced edge, hold callback or periodic sample */
+static void btnScheduleNext(uint32_t now)
+{
+	uint32_t delta    = UINT32_MAX;
+	bool     debounce = false;
+
+	for (uint8_t ledBtn = 0; ledBtn < NUM_LEDBTN; ledBtn++)
+	{
+		btn_callback_info *callback = &buttonCallbacks[ledBtn];
+
+		if (registeredPinInterrupts[ledBtn] != PIN_INTERRUPT)
+			continue;
+
+		if (edgePending[ledBtn])
+			debounce = true;
+
+		if (isActive(ledBtn))
+		{
+			if (delta > BTN_ACTIVE_SENSE_INTERVAL)
+				delta = BTN_ACTIVE_SENSE_INTERVAL;
+			if (callback->holdCallback != NULL && callback->lastState == BTN_PRESSED)
+			{
+				uint32_t hold = timeUntil(callback->holdTimeLast + callback->holdTimeInterval, now);
+
+				if (delta > hold)
+					delta = hold;
+			}
+		}
+	}
+
+	if (debounce)
+		delta = timeUntil(lastEdgeTime + BTN_DEBOUNCE_TIME, now);
+
+	TASKLET_Cancel(&BtnTasklet);
+	if (delta != UINT32_MAX)
+		TASKLET_ScheduleDelta(&BtnTasklet, delta, NULL);
+}
+
+/* sample the buttons with interrupt and process their callbacks */
+static ca_error btnTaskletCallback(void *context)
+{
+	uint32_t now = TIME_ReadAbsoluteTime();
+	uint8_t  pressed, led;
+
+	(void)context;
+
+	if (!BtnSensing)
+	{
+		/* release the LEDs of shared pins first, and give the pullups time to settle */
+		for (uint8_t ledBtn = 0; ledBtn < NUM_LEDBTN; ledBtn++)
+		{
+			if (registeredPinInterrupts[ledBtn] != PIN_INTERRUPT || registeredPinTypes[ledBtn] != PINTYPE_SHARED)
+				continue;
+			if (Btn_SenseOutput(ledBtn, &led) != CA_ERROR_SUCCESS || led != LED_ON)
+				continue;
+			maskEdges(ledBtn, now + UINT32_MAX / 2);
+			BSP_ModuleSetGPIOPin(registeredPinMappings[ledBtn], LED_OFF);
+			senseReleased[ledBtn] = 1;
+			BtnSensing            = 1;
+		}
+
+		if (BtnSensing)
+			return TASKLET_ScheduleDelta(&BtnTasklet, BTN_SHARED_SENSE_DELAY, NULL);
+	}
+
+	for (uint8_t ledBtn = 0; ledBtn < NUM_LEDBTN; ledBtn++)
+	{
+		btn_callback_info *callback   = &buttonCallbacks[ledBtn];
+		uint32_t           event_time = now;
+		bool               edge       = false;
+
+		if (registeredPinInterrupts[ledBtn] != PIN_INTERRUPT)
+			continue;
+
+		/* clear the edge before sampling, so that a later edge is sampled again */
+		if (edgePending[ledBtn])
+		{
+			event_time          = edgeTime[ledBtn];
+			edgePending[ledBtn] = 0;
+			edge                = true;
+		}
+
+		if (BSP_ModuleSenseGPIOPin(registeredPinMappings[ledBtn], &pressed))
+			pressed = callback->lastState;
+
+		if (senseReleased[ledBtn])
+		{
+			BSP_ModuleSetGPIOPin(registeredPinMappings[ledBtn], LED_ON);
+			maskEdges(ledBtn, now + BTN_DEBOUNCE_TIME);
+			senseReleased[ledBtn] = 0;
+		}
+
+		if (callback->shortPressCallback == NULL && callback->longPressCallback == NULL &&
+		    callback->holdCallback == NULL)
+		{
+			callback->lastState = BTN_RELEASED; /* not registererd as button */
+			continue;
+		}
+
+		/* the state changed at the edge, as far as the debounced input tells */
+		if (!edge || pressed == callback->lastState)
+			event_time = now;
+
+		handleButton(callback, pressed, event_time, now);
+	}
+
+	BtnSensing = 0;
+	btnScheduleNext(now);
+
+	return CA_ERROR_SUCCESS;
+}
+
+/* register the edge interrupts of a button, and the tasklet to handle them */
+static void btnRegisterIRQ(uint8_t ledBtn, struct gpio_input_args *args)
+{
+	if (!BtnTaskletInitialised)
+	{
+		TASKLET_Init(&BtnTasklet, &btnTaskletCallback);
+		BtnTaskletInitialised = 1;
+	}
+
+	args->irq      = MODULE_PIN_IRQ_BOTH;
+	args->callback = btn_isrs[ledBtn];
+
+	edgePending[ledBtn]   = 0;
+	edgeMasked[ledBtn]    = 0;
+	senseReleased[ledBtn] = 0;
+}
+
 /* register LED output (open drain) */
 ca_error Btn_RegisterLEDOutput(uint8_t ledBtn)
 {
@@ -117,8 +342,7 @@ ca_error Btn_RegisterButtonIRQInput(uint8_t ledBtn)
 	args.mpin     = registeredPinMappings[ledBtn];
 	args.pullup   = MODULE_PIN_PULLUP_OFF;
 	args.debounce = MODULE_PIN_DEBOUNCE_ON;
-	args.irq      = MODULE_PIN_IRQ_FALL;
-	args.callback = btn_isr;
+	btnRegisterIRQ(ledBtn, &args);
 
 	/* Register the pin */
 	if ((status = BSP_ModuleRegisterGPIOInput(&args)))
@@ -163,8 +387,7 @@ ca_error Btn_RegisterSharedIRQButtonLED(uint8_t ledBtn)
 	args.mpin     = registeredPinMappings[ledBtn];
 	args.pullup   = MODULE_PIN_PULLUP_OFF;
 	args.debounce = MODULE_PIN_DEBOUNCE_ON;
-	args.irq      = MODULE_PIN_IRQ_FALL;
-	args.callback = btn_isr;
+	btnRegisterIRQ(ledBtn, &args);
 
 	/* Register the pin */
 	if ((status = BSP_ModuleRegisterGPIOSharedInputOutputOD(&args, MODULE_PIN_TYPE_LED)))
@@ -187,6 +410,8 @@ ca_error Btn_DeRegister(uint8_t ledBtn)
 
 	buttonCallbacks[ledBtn].lastState = BTN_RELEASED;
 	registeredPinTypes[ledBtn]        = PINTYPE_NONE;
+	edgePending[ledBtn]               = 0;
+	senseReleased[ledBtn]             = 0;
 
 	if (registeredPinInterrupts[ledBtn] == PIN_INTERRUPT)
 		if ((status = Btn_DecrementGPIOWakeup()))
@@ -227,8 +452,24 @@ ca_error Btn_SetButtonHoldCallback(uint8_t ledBtn, btn_callback callback, void *
 /* set the state of the LED */
 ca_error Btn_SetLED(uint8_t ledBtn, uint8_t val)
 {
+	ca_error status;
+	uint32_t now;
+
 	// Change the state of the LED
-	return BSP_ModuleSetGPIOPin(registeredPinMappings[ledBtn], val);
+	if ((status = BSP_ModuleSetGPIOPin(registeredPinMappings[ledBtn], val)))
+		return status;
+
+	// The edge on a shared pin with interrupt is not a button press. While the
+	// LED is on, the button has to be sampled periodically instead.
+	if (registeredPinTypes[ledBtn] == PINTYPE_SHARED && registeredPinInterrupts[ledBtn] == PIN_INTERRUPT &&
+	    !BtnSensing)
+	{
+		now = TIME_ReadAbsoluteTime();
+		maskEdges(ledBtn, now + BTN_DEBOUNCE_TIME);
+		btnScheduleNext(now);
+	}
+
+	return status;
 }
 
 // Get the state of the LED/button
@@ -280,10 +521,25 @@ ca_error Btn_SenseOutput(uint8_t ledBtn, uint8_t *val)
 ca_error Btn_PollButtons(void)
 {
 	uint8_t pressed;
+	bool    shared = false;
 
-	/* Loop through each button */
+	/* Hand the edges of buttons with interrupt over to the button tasklet */
+	if (BtnHasInterrupt)
+	{
+		BtnHasInterrupt = 0;
+		if (!BtnSensing)
+			btnScheduleNext(TIME_ReadAbsoluteTime());
+	}
+
+	/* Loop through each button without interrupt */
 	for (uint8_t ledBtn = 0; ledBtn < NUM_LEDBTN; ledBtn++)
 	{
+		if (registeredPinInterrupts[ledBtn] == PIN_INTERRUPT)
+			continue;
+
+		if (registeredPinTypes[ledBtn] == PINTYPE_SHARED)
+			shared = true;
+
 		/* Check if the button is registered with any callback */
 		if (buttonCallbacks[ledBtn].shortPressCallback != NULL || buttonCallbacks[ledBtn].longPressCallback != NULL ||
 		    buttonCallbacks[ledBtn].holdCallback != NULL)
@@ -301,9 +557,9 @@ ca_error Btn_PollButtons(void)
 	}
 
 	/* Add a delay to not affect brightness of shared LEDs too much */
-	for (uint8_t ledBtn = 0; ledBtn < NUM_LEDBTN; ledBtn++)
+	for (uint8_t ledBtn = 0; shared && ledBtn < NUM_LEDBTN; ledBtn++)
 	{
-		if (registeredPinTypes[ledBtn] == PINTYPE_SHARED)
+		if (registeredPinTypes[ledBtn] == PINTYPE_SHARED && registeredPinInterrupts[ledBtn] != PIN_INTERRUPT)
 		{
 			Btn_SenseOutput(ledBtn, &pressed);
 			if (pressed == LED_ON)
@@ -315,7 +571,6 @@ ca_error Btn_PollButtons(void)
 		}
 	}
 
-	BtnHasInterrupt = 0;
 	return CA_ERROR_SUCCESS;
 }
 
@@ -323,16 +578,20 @@ ca_error Btn_PollButtons(void)
 /* This is shared by Btn_PollButtons() and Btn_PollButtonsExt() */
 ca_error Btn_HandleButtonCallbacks(btn_callback_info *callback, uint8_t pressed)
 {
-	uint32_t current_time;
+	uint32_t current_time = TIME_ReadAbsoluteTime();
 
-	current_time = TIME_ReadAbsoluteTime();
+	return handleButton(callback, pressed, current_time, current_time);
+}
 
+/* process the button callbacks, for a change of state at event_time */
+static ca_error handleButton(btn_callback_info *callback, uint8_t pressed, uint32_t event_time, uint32_t current_time)
+{
 	/* button pressed */
 	if ((pressed == BTN_PRESSED) && (callback->lastState == BTN_RELEASED))
 	{
-		callback->currentPressTime = current_time;
+		callback->currentPressTime = event_time;
 		callback->lastState        = pressed;
-		callback->holdTimeLast     = current_time;
+		callback->holdTimeLast     = event_time;
 		/* handle shortPressCallback immediately */
 		if ((callback->shortPressCallback != NULL) && (callback->shortPressMode == BTN_SHORTPRESS_PRESSED))
 		{
@@ -356,9 +615,9 @@ ca_error Btn_HandleButtonCallbacks(btn_callback_info *callback, uint8_t pressed)
 		/* handle short press functionality if not already handled */
 		if ((callback->shortPressCallback != NULL) && (callback->shortPressMode == BTN_SHORTPRESS_RELEASED))
 		{
-			if (((current_time <= (callback->currentPressTime + callback->longPressTimeThreshold)) ||
+			if (((event_time <= (callback->currentPressTime + callback->longPressTimeThreshold)) ||
 			     (callback->longPressCallback == NULL)) &&
-			    (current_time > (callback->currentPressTime + BTN_MIN_PRESS_TIME)))
+			    (event_time > (callback->currentPressTime + BTN_MIN_PRESS_TIME)))
 			{
 				callback->shortPressCallback(callback->shortPressContext);
 			}
@@ -367,7 +626,7 @@ ca_error Btn_HandleButtonCallbacks(btn_callback_info *callback, uint8_t pressed)
 		/* long press functionality */
 		if (callback->longPressCallback != NULL)
 		{
-			if (current_time > (callback->currentPressTime + callback->longPressTimeThreshold))
+			if (event_time > (callback->currentPressTime + callback->longPressTimeThreshold))
 			{
 				callback->longPressCallback(callback->longPressContext);
 			}
@@ -376,6 +635,8 @@ ca_error Btn_HandleButtonCallbacks(btn_callback_info *callback, uint8_t pressed)
 		callback->lastState        = pressed;
 		callback->currentPressTime = 0;
 	}
+
+	return CA_ERROR_SUCCESS;
 }
 
 /* One additional GPIO is now being used for wakeup */
@@ -411,12 +672,12 @@ void Btn_SetSleepPermanently(void)
 /* Note: Only use when Btn_PollButtons() is in the main loop */
 bool Btn_CanSleep(void)
 {
-	if (BtnHasInterrupt)
+	if (BtnHasInterrupt || BtnSensing)
 		return false;
 
 	for (uint8_t ledBtn = 0; ledBtn < NUM_LEDBTN; ledBtn++)
 	{
-		if (buttonCallbacks[ledBtn].lastState == BTN_PRESSED)
+		if (buttonCallbacks[ledBtn].lastState == BTN_PRESSED || edgePending[ledBtn])
 			return false;
 	}
 
@@ -23,30 +23,111 @@ Copyright 2023 Cascoda LTD.
 // the memory buffer for the LCD
 static uint8_t frame_buffer[LCDWIDTH * LCDHEIGHT / 8];
 
-// reduces how much is refreshed, which speeds it up!
-// originally derived from Steve Evans/JCW's mod but cleaned up and
-// optimized
-//#define enablePartialUpdate
+// bytes per line of the frame buffer
+#define LINEBYTES ((LCDWIDTH + 7) / 8)
 
-#ifdef enablePartialUpdate
+// reduces how much is refreshed, which speeds it up!
+// The bounding box of everything drawn since the last update is kept in frame
+// buffer (unrotated) coordinates, and is narrowed down at update time by
+// comparing its edge lines and byte columns with a copy of the frame that was
+// last sent to the display. This catches the common case of clearing the frame
+// buffer and redrawing mostly the same content.
+static bool     dirty = true;
 static uint16_t xUpdateMin;
-static uint16_t xUpdateMax;
+static uint16_t xUpdateMax = LCDWIDTH - 1;
 static uint16_t yUpdateMin;
-static uint16_t yUpdateMax;
+static uint16_t yUpdateMax = LCDHEIGHT - 1;
+
+#if GFX_DIRTY_SHADOW
+// copy of the frame last sent to the display
+static bool    shadow_valid;
+static uint8_t shadow_buffer[sizeof(frame_buffer)];
 #endif
 
 static uint16_t rotation = 0;
 
+// the bounding box of the frame buffer bytes changed by one drawing operation
+struct changed_bytes
+{
+	bool     changed;
+	uint16_t imin; // first byte column
+	uint16_t imax; // last byte column
+	uint16_t ymin;
+	uint16_t ymax;
+};
+
+#if GFX_GLYPH_CACHE_ENTRIES
+// bytes needed for the largest glyph cell of 6x8 font pixels, in any rotation
+#define GLYPH_BYTES (8 * GFX_GLYPH_CACHE_MAX_SIZE * ((6 * GFX_GLYPH_CACHE_MAX_SIZE + 7) / 8))
+
+// a glyph pre-rendered in frame buffer orientation, with byte aligned lines
+struct glyph
+{
+	uint8_t  columns[5];        // font columns the glyph was rendered from
+	uint8_t  size;              // text size, 0 if the entry is unused
+	uint16_t width;             // width in frame buffer pixels
+	uint16_t height;            // height in frame buffer pixels
+	uint8_t  bits[GLYPH_BYTES]; // 1 for the pixels of the character, MSB first
+};
+
+static struct glyph glyph_cache[GFX_GLYPH_CACHE_ENTRIES];
+static uint8_t      glyph_next; // next entry to be replaced
+#endif
+
 uint8_t* get_framebuffer()
 {
 	return frame_buffer;
 }
 
-// needed for partial update
-// not yet implemented
+// map a point from drawing coordinates to frame buffer coordinates
+static void rotate(int16_t *x, int16_t *y)
+{
+	int16_t t;
+
+	switch (rotation)
+	{
+	case 1:
+		t  = *x;
+		*x = *y;
+		*y = LCDHEIGHT - 1 - t;
+		break;
+	case 2:
+		*x = LCDWIDTH - 1 - *x;
+		*y = LCDHEIGHT - 1 - *y;
+		break;
+	case 3:
+		t  = *x;
+		*x = LCDWIDTH - 1 - *y;
+		*y = t;
+		break;
+	}
+}
+
+// clip a rectangle to the frame buffer, returns false if nothing is left
+static bool clipRect(int16_t *xmin, int16_t *ymin, int16_t *xmax, int16_t *ymax)
+{
+	if (*xmin < 0)
+		*xmin = 0;
+	if (*ymin < 0)
+		*ymin = 0;
+	if (*xmax >= LCDWIDTH)
+		*xmax = LCDWIDTH - 1;
+	if (*ymax >= LCDHEIGHT)
+		*ymax = LCDHEIGHT - 1;
+	return (*xmin <= *xmax) && (*ymin <= *ymax);
+}
+
 static void updateBoundingBox(uint16_t xmin, uint16_t ymin, uint16_t xmax, uint16_t ymax)
 {
-#ifdef enablePartialUpdate
+	if (!dirty)
+	{
+		xUpdateMin = xmin;
+		xUpdateMax = xmax;
+		yUpdateMin = ymin;
+		yUpdateMax = ymax;
+		dirty      = true;
+		return;
+	}
 	if (xmin < xUpdateMin)
 		xUpdateMin = xmin;
 	if (xmax > xUpdateMax)
@@ -55,60 +136,125 @@ static void updateBoundingBox(uint16_t xmin, uint16_t ymin, uint16_t xmax, uint1
 		yUpdateMin = ymin;
 	if (ymax > yUpdateMax)
 		yUpdateMax = ymax;
-		//SIF_IL3820_SetWindow(xmin, xmax, ymin, ymax);
+}
+
+#if GFX_DIRTY_SHADOW
+// whether the byte columns x0 to x1 of a line are the same as on the display
+static bool lineClean(uint16_t y, uint16_t x0, uint16_t x1)
+{
+	uint16_t offset = x0 + y * LINEBYTES;
+
+	return !memcmp(frame_buffer + offset, shadow_buffer + offset, x1 - x0 + 1);
+}
+
+// whether the lines y0 to y1 of a byte column are the same as on the display
+static bool columnClean(uint16_t x, uint16_t y0, uint16_t y1)
+{
+	for (uint16_t y = y0; y <= y1; y++)
+	{
+		if (frame_buffer[x + y * LINEBYTES] != shadow_buffer[x + y * LINEBYTES])
+			return false;
+	}
+	return true;
+}
 #endif
-	uint64_t address = 0;
-
-	/*
-     xmin,ymax            xmax (), ymax()   ^  
-        line --------                     | j
-                                          |
-     xmin,ymin            xmax, ymin
-            ---> i
-     
-     width  = x
-     height = y (e.g. the longer side)
-     
-     width == xmax - xmin
-     height = ymax - ymin
-  */
-
-	printf("updating bounding box xMin=%d yMin=%d xMax=%d yMax=%d\n", xmin, ymin, xmax, ymax);
-
-	// SIF_IL3820_SetWindow(0, SIF_IL3820_WIDTH, 0, SIF_IL3820_HEIGHT);
-	//SIF_IL3820_SetWindow(xmin, xmax, ymin, ymax);
-
-	uint16_t distance = xmax - xmin;
-	uint16_t width    = (distance % 8 == 0) ? (distance / 8) : (distance / 8 + 1);
-	printf("updating bounding box width %d %d\n", distance, width);
-
-	/*
-    //per line
-	SIF_IL3820_SetWindow(0, SIF_IL3820_WIDTH, 0, SIF_IL3820_HEIGHT);
-	for (u16_t j = 0; j < height; j++)
-	{
-		SIF_IL3820_SetCursor(0, j);
-		SIF_IL3820_SendCommand(WRITE_RAM);
-		for (u16_t i = 0; i < width; i++)
-		{
-			SIF_IL3820_SendData(0xFF);
-		}
+
+bool gfx_drv_getDirtyRegion(uint16_t *xmin, uint16_t *ymin, uint16_t *xmax, uint16_t *ymax)
+{
+	uint16_t x0, x1, y0, y1;
+
+	if (!dirty)
+		return false;
+
+	x0 = xUpdateMin / 8;
+	x1 = xUpdateMax / 8;
+	y0 = yUpdateMin;
+	y1 = yUpdateMax;
+
+#if GFX_DIRTY_SHADOW
+	// nothing outside of the bounding box can differ from the display, so only the inside is compared
+	if (shadow_valid)
+	{
+		while (y0 <= y1 && lineClean(y0, x0, x1)) y0++;
+		if (y0 > y1)
+			return false;
+		while (lineClean(y1, x0, x1)) y1--;
+		while (x0 < x1 && columnClean(x0, y0, y1)) x0++;
+		while (x1 > x0 && columnClean(x1, y0, y1)) x1--;
 	}
-*/
+#endif
+
+	*xmin = x0 * 8;
+	*xmax = (x1 * 8) + 7;
+	*ymin = y0;
+	*ymax = y1;
+	if (*xmax >= LCDWIDTH)
+		*xmax = LCDWIDTH - 1;
+
+	return true;
+}
+
+void gfx_drv_markDirty(uint16_t xmin, uint16_t ymin, uint16_t xmax, uint16_t ymax)
+{
+	if (xmax >= LCDWIDTH)
+		xmax = LCDWIDTH - 1;
+	if (ymax >= LCDHEIGHT)
+		ymax = LCDHEIGHT - 1;
+	if (xmin > xmax || ymin > ymax)
+		return;
+	updateBoundingBox(xmin, ymin, xmax, ymax);
+}
+
+void gfx_drv_clearDirtyRegion(void)
+{
+#if GFX_DIRTY_SHADOW
+	memcpy(shadow_buffer, frame_buffer, sizeof(shadow_buffer));
+	shadow_valid = true;
+#endif
+	dirty = false;
+}
+
+void gfx_drv_invalidate(void)
+{
+#if GFX_DIRTY_SHADOW
+	shadow_valid = false;
+#endif
+	updateBoundingBox(0, 0, LCDWIDTH - 1, LCDHEIGHT - 1);
+}
+
+// write the bits of value selected by mask into a frame buffer byte, keeping track of it if it changed
+static void writeByte(struct changed_bytes *changes, uint16_t i, uint16_t y, uint8_t mask, uint8_t value)
+{
+	uint8_t *byte = &frame_buffer[i + y * LINEBYTES];
+	uint8_t  old  = *byte;
+
+	*byte = (old & ~mask) | (value & mask);
+	if (*byte == old)
+		return;
 
-	//for (uint16_t j = yUpdateMin; j < yUpdateMax; j++)
-	for (uint16_t j = ymin; j < ymax; j++)
+	// only track bytes that actually changed, redrawing is free. lines are written from the top.
+	if (!changes->changed)
 	{
-		//SIF_IL3820_SetCursor(xmin, j);
-		// SIF_IL3820_SendCommand(WRITE_RAM);
-		for (uint16_t i = xmin; i < xmin + width; i++)
-		{
-			address = i + j * width;
-			//printf("gfx_drv_drawPixel address %d %d %d %d\n", i, j, width, address);
-			//SIF_IL3820_SendData(frame_buffer[address]);
-		}
+		changes->imin = changes->imax = i;
+		changes->ymin                 = y;
+		changes->changed              = true;
 	}
-	//SIF_IL3820_TurnOnDisplay();
+	if (i < changes->imin)
+		changes->imin = i;
+	if (i > changes->imax)
+		changes->imax = i;
+	changes->ymax = y;
+}
+
+// add the changed bytes to the update bounding box, limited to the drawn pixels from xmin to xmax
+static void commitChanges(const struct changed_bytes *changes, uint16_t xmin, uint16_t xmax)
+{
+	if (!changes->changed)
+		return;
+	updateBoundingBox((changes->imin * 8 > xmin) ? changes->imin * 8 : xmin,
+	                  changes->ymin,
+	                  (changes->imax * 8 + 7 < xmax) ? changes->imax * 8 + 7 : xmax,
+	                  changes->ymax);
 }
 
 // the most basic function, set a single pixel
@@ -117,32 +263,258 @@ void gfx_drv_drawPixel(int16_t x, int16_t y, uint16_t color)
 	if ((x < 0) || (x >= LCDWIDTH) || (y < 0) || (y >= LCDHEIGHT))
 		return;
 
-	int16_t t;
-	switch (rotation)
-	{
-	case 1:
-		t = x;
-		x = y;
-		y = LCDHEIGHT - 1 - t;
-		break;
-	case 2:
-		x = LCDWIDTH - 1 - x;
-		y = LCDHEIGHT - 1 - y;
-		break;
-	case 3:
-		t = x;
-		x = LCDWIDTH - 1 - y;
-		y = t;
-		break;
-	}
+	rotate(&x, &y);
 
 	if ((x < 0) || (x >= LCDWIDTH) || (y < 0) || (y >= LCDHEIGHT))
 		return;
 
+	uint8_t *byte = &frame_buffer[(x + (y * LCDWIDTH)) / 8];
+	uint8_t  old  = *byte;
+
 	if (color)
-		frame_buffer[(x + (y * LCDWIDTH)) / 8] |= (1 << (7 - (x % 8)));
+		*byte |= (1 << (7 - (x % 8)));
 	else
-		frame_buffer[(x + (y * LCDWIDTH)) / 8] &= ~(1 << (7 - (x % 8)));
+		*byte &= ~(1 << (7 - (x % 8)));
+
+	// only track pixels that actually changed, redrawing is free
+	if (*byte != old)
+		updateBoundingBox(x, y, x, y);
+}
+
+// fill a rectangle in frame buffer coordinates, which must already be clipped.
+// whole bytes are written at once, with masks for the partial bytes at the edges.
+static void fillFrameRect(uint16_t xmin, uint16_t ymin, uint16_t xmax, uint16_t ymax, uint16_t color)
+{
+	uint8_t              fill    = color ? 0xFF : 0x00;
+	uint16_t             first   = xmin / 8;
+	uint16_t             last    = xmax / 8;
+	uint8_t              lmask   = 0xFF >> (xmin % 8);
+	uint8_t              rmask   = 0xFF << (7 - (xmax % 8));
+	struct changed_bytes changes = {0};
+
+	if (first == last)
+	{
+		lmask &= rmask;
+		rmask = lmask;
+	}
+
+	for (uint16_t y = ymin; y <= ymax; y++)
+	{
+		for (uint16_t i = first; i <= last; i++)
+		{
+			uint8_t mask = (i == first) ? lmask : (i == last) ? rmask : 0xFF;
+
+			writeByte(&changes, i, y, mask, fill);
+		}
+	}
+
+	commitChanges(&changes, xmin, xmax);
+}
+
+// fill a rectangle, rotation and clipping are only handled once for the whole of it
+void gfx_drv_fillRect(int16_t xmin, int16_t ymin, int16_t xmax, int16_t ymax, uint16_t color)
+{
+	int16_t t;
+
+	if (xmin > xmax)
+	{
+		t    = xmin;
+		xmin = xmax;
+		xmax = t;
+	}
+	if (ymin > ymax)
+	{
+		t    = ymin;
+		ymin = ymax;
+		ymax = t;
+	}
+
+	// same clipping as gfx_drv_drawPixel, before and after the rotation
+	if (!clipRect(&xmin, &ymin, &xmax, &ymax))
+		return;
+
+	rotate(&xmin, &ymin);
+	rotate(&xmax, &ymax);
+	if (xmin > xmax)
+	{
+		t    = xmin;
+		xmin = xmax;
+		xmax = t;
+	}
+	if (ymin > ymax)
+	{
+		t    = ymin;
+		ymin = ymax;
+		ymax = t;
+	}
+
+	if (!clipRect(&xmin, &ymin, &xmax, &ymax))
+		return;
+
+	fillFrameRect(xmin, ymin, xmax, ymax, color);
+}
+
+void gfx_drv_drawHLine(int16_t xmin, int16_t xmax, int16_t y, uint16_t color)
+{
+	gfx_drv_fillRect(xmin, y, xmax, y, color);
+}
+
+void gfx_drv_drawVLine(int16_t x, int16_t ymin, int16_t ymax, uint16_t color)
+{
+	gfx_drv_fillRect(x, ymin, x, ymax, color);
+}
+
+#if GFX_GLYPH_CACHE_ENTRIES
+// render the 6x8 cell of a glyph magnified by size, turned to the current rotation
+static void renderGlyph(struct glyph *glyph, const uint8_t *columns, uint8_t size)
+{
+	uint16_t cw = 6 * size; // cell size in drawing coordinates
+	uint16_t ch = 8 * size;
+	uint16_t fx, fy, stride;
+
+	memcpy(glyph->columns, columns, sizeof(glyph->columns));
+	glyph->size   = size;
+	glyph->width  = (rotation % 2) ? ch : cw;
+	glyph->height = (rotation % 2) ? cw : ch;
+	stride        = (glyph->width + 7) / 8;
+	memset(glyph->bits, 0, sizeof(glyph->bits));
+
+	// the last column of the cell is spacing, and stays clear
+	for (uint16_t u = 0; u < 5 * size; u++)
+	{
+		for (uint16_t v = 0; v < ch; v++)
+		{
+			if (!((columns[u / size] >> (v / size)) & 1))
+				continue;
+
+			// same mapping as rotate(), relative to the top left corner of the cell in the frame buffer
+			switch (rotation)
+			{
+			case 1:
+				fx = v;
+				fy = cw - 1 - u;
+				break;
+			case 2:
+				fx = cw - 1 - u;
+				fy = ch - 1 - v;
+				break;
+			case 3:
+				fx = ch - 1 - v;
+				fy = u;
+				break;
+			default:
+				fx = u;
+				fy = v;
+				break;
+			}
+			glyph->bits[fx / 8 + fy * stride] |= 0x80 >> (fx % 8);
+		}
+	}
+}
+
+// find a glyph in the cache, rendering it in place of the oldest entry if it is not there
+static const struct glyph *getGlyph(const uint8_t *columns, uint8_t size)
+{
+	struct glyph *glyph;
+
+	for (uint8_t i = 0; i < GFX_GLYPH_CACHE_ENTRIES; i++)
+	{
+		glyph = &glyph_cache[i];
+		if (glyph->size == size && !memcmp(glyph->columns, columns, sizeof(glyph->columns)))
+			return glyph;
+	}
+
+	glyph      = &glyph_cache[glyph_next];
+	glyph_next = (glyph_next + 1) % GFX_GLYPH_CACHE_ENTRIES;
+	renderGlyph(glyph, columns, size);
+	return glyph;
+}
+
+// mask of the pixels of byte i that are within a line of width pixels
+static uint8_t lineMask(uint16_t i, uint16_t width)
+{
+	return (i < width / 8) ? 0xFF : (uint8_t)(0xFF << (8 - (width % 8)));
+}
+
+// copy a glyph into the frame buffer at (xmin, ymin), shifting its lines into place a byte at a time
+static void blitGlyph(const struct glyph *glyph, uint16_t xmin, uint16_t ymin, uint16_t color, bool opaque)
+{
+	struct changed_bytes changes = {0};
+	uint8_t              fill    = color ? 0xFF : 0x00;
+	uint8_t              shift   = xmin % 8;
+	uint16_t             first   = xmin / 8;
+	uint16_t             stride  = (glyph->width + 7) / 8;
+	uint16_t             count   = (shift + glyph->width + 7) / 8;
+
+	for (uint16_t y = 0; y < glyph->height; y++)
+	{
+		const uint8_t *line = glyph->bits + y * stride;
+		uint8_t        bits = 0, cell = 0; // previous glyph byte, and mask of the cell in it
+
+		for (uint16_t i = 0; i < count; i++)
+		{
+			uint8_t next_bits = (i < stride) ? line[i] : 0;
+			uint8_t next_cell = (i < stride) ? lineMask(i, glyph->width) : 0;
+			uint8_t out_bits  = (next_bits >> shift) | (uint8_t)(bits << (8 - shift));
+			uint8_t out_cell  = (next_cell >> shift) | (uint8_t)(cell << (8 - shift));
+
+			bits = next_bits;
+			cell = next_cell;
+
+			// opaque text sets the whole cell, transparent text only the pixels of the character
+			if (opaque)
+				writeByte(&changes, first + i, ymin + y, out_cell, color ? out_bits : ~out_bits);
+			else if (out_bits)
+				writeByte(&changes, first + i, ymin + y, out_bits, fill);
+		}
+	}
+
+	commitChanges(&changes, xmin, xmin + glyph->width - 1);
+}
+#endif
+
+bool gfx_drv_drawGlyph(int16_t x, int16_t y, const uint8_t *columns, uint8_t size, uint16_t color, uint16_t bg)
+{
+#if GFX_GLYPH_CACHE_ENTRIES
+	int16_t xmin = x, ymin = y, xmax, ymax, t;
+
+	if (size == 0 || size > GFX_GLYPH_CACHE_MAX_SIZE)
+		return false;
+
+	// only glyphs that gfx_drv_drawPixel would not clip at all, before or after the rotation
+	if (x < 0 || y < 0 || x + 6 * size > LCDWIDTH || y + 8 * size > LCDHEIGHT)
+		return false;
+	xmax = x + 6 * size - 1;
+	ymax = y + 8 * size - 1;
+
+	rotate(&xmin, &ymin);
+	rotate(&xmax, &ymax);
+	if (xmin > xmax)
+	{
+		t    = xmin;
+		xmin = xmax;
+		xmax = t;
+	}
+	if (ymin > ymax)
+	{
+		t    = ymin;
+		ymin = ymax;
+		ymax = t;
+	}
+	if (xmin < 0 || ymin < 0 || xmax >= LCDWIDTH || ymax >= LCDHEIGHT)
+		return false;
+
+	blitGlyph(getGlyph(columns, size), xmin, ymin, color, bg != color);
+	return true;
+#else
+	(void)x;
+	(void)y;
+	(void)columns;
+	(void)size;
+	(void)color;
+	(void)bg;
+	return false;
+#endif
 }
 
 // the most basic function, get a single pixel
@@ -160,7 +532,7 @@ void gfx_drv_clearDisplay(void)
 	ca_log_debg("gfx_drv_clearDisplay");
 	//white = 0xFF
 	//black = 0x00
-	memset(frame_buffer, 0xFF, LCDWIDTH * LCDHEIGHT / 8);
+	fillFrameRect(0, 0, LCDWIDTH - 1, LCDHEIGHT - 1, WHITE);
 	// check the first 8 pixels
 	ca_log_debg("  frame_buffer[0] %d\n", frame_buffer[0]);
 }
@@ -168,5 +540,12 @@ void gfx_drv_clearDisplay(void)
 // set the rotation for drawing
 void gfx_drv_setRotation(uint16_t new_rotation)
 {
+	if (new_rotation == rotation)
+		return;
 	rotation = new_rotation;
+
+#if GFX_GLYPH_CACHE_ENTRIES
+	// the cached glyphs are turned to the old rotation
+	for (uint8_t i = 0; i < GFX_GLYPH_CACHE_ENTRIES; i++) glyph_cache[i].size = 0;
+#endif
 }
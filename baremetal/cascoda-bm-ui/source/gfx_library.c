@@ -235,25 +235,59 @@ void display_fixed_image_nowait(const uint8_t *image)
 
 #elif defined EPAPER_WAVESHARE_1_54_INCH
 
+// number of partial updates done since the last full update
+static uint16_t partial_update_count;
+
 void display_render_full(void)
 {
+	ca_error error;
+
 	SIF_SSD1681_Initialise();
-	SIF_SSD1681_SetFrameMemory(get_framebuffer(), false);
+	error = SIF_SSD1681_SetFrameMemory(get_framebuffer(), false);
 	SIF_SSD1681_DisplayFrame();
 	SIF_SSD1681_DeepSleep();
 	SIF_SSD1681_Deinitialise();
+	// the panel may not show the frame buffer if the transfer failed, so do not treat it as clean
+	if (error)
+		gfx_drv_invalidate();
+	else
+		gfx_drv_clearDirtyRegion();
+	partial_update_count = 0;
 }
 
 void display_render_partial(bool sleep_when_done)
 {
+	uint16_t xmin, ymin, xmax, ymax;
+
+	// partial updates accumulate ghosting, so every so often do a full one instead
+	if (partial_update_count >= GFX_PARTIAL_UPDATES_PER_FULL)
+	{
+		display_render_full();
+		return;
+	}
+
 	if (SIF_SSD1681_IsAsleep())
 	{
 		SIF_SSD1681_Initialise();
 		SIF_SSD1681_DisplayPartBaseImageWhite();
+		gfx_drv_invalidate();
 	}
 
-	SIF_SSD1681_SetFrameMemoryPartial(get_framebuffer());
-	SIF_SSD1681_DisplayPartFrame();
+	// only the part of the frame buffer that changed is sent to the display
+	if (gfx_drv_getDirtyRegion(&xmin, &ymin, &xmax, &ymax))
+	{
+		if (SIF_SSD1681_SetFrameMemoryRegion(get_framebuffer(), xmin, ymin, xmax, ymax))
+		{
+			// resend the whole frame next time, the panel RAM is now unknown
+			gfx_drv_invalidate();
+		}
+		else
+		{
+			SIF_SSD1681_DisplayPartFrame();
+			gfx_drv_clearDirtyRegion();
+			partial_update_count++;
+		}
+	}
 
 	if (sleep_when_done)
 	{
@@ -269,6 +303,7 @@ void display_fixed_image(const uint8_t *image)
 	SIF_SSD1681_DisplayFrame();
 	SIF_SSD1681_DeepSleep();
 	SIF_SSD1681_Deinitialise();
+	gfx_drv_invalidate();
 }
 
 #endif
@@ -289,12 +324,12 @@ void display_fillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t c
 
 void display_drawHLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t color)
 {
-	writeLine(x0, y0, x0 + x1, y0, color);
+	gfx_drv_drawHLine(x0, x0 + x1, y0, color);
 }
 
 void display_drawVLine(uint16_t x0, uint16_t y0, uint16_t y1, uint16_t color)
 {
-	writeLine(x0, y0, x0, y0 + y1, color);
+	gfx_drv_drawVLine(x0, y0, y0 + y1, color);
 }
 
 // global variables
@@ -400,8 +435,9 @@ static const uint8_t font[256][5] = {
 /**************************************************************************/
 void writeLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color)
 {
-	bool    steep = abs((int16_t)(y1 - y0)) > abs((int16_t)(x1 - x0));
-	int16_t dx, dy, err, ystep;
+	bool     steep = abs((int16_t)(y1 - y0)) > abs((int16_t)(x1 - x0));
+	int16_t  dx, dy, err, ystep;
+	uint16_t run; // start of the pixels drawn on the current line
 	if (steep)
 	{
 		_swap_int16_t(x0, y0);
@@ -429,17 +465,22 @@ void writeLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t colo
 		ystep = -1;
 	}
 
-	for (; x0 <= x1; x0++)
+	// the pixels on each line are drawn together, as one span
+	for (run = x0; x0 <= x1; x0++)
 	{
-		if (steep)
-		{
-			display_drawPixel(y0, x0, color);
-		}
-		else
+		err -= dy;
+		if (err < 0 || x0 == x1)
 		{
-			display_drawPixel(x0, y0, color);
+			if (steep)
+			{
+				gfx_drv_drawVLine(y0, run, x0, color);
+			}
+			else
+			{
+				gfx_drv_drawHLine(run, x0, y0, color);
+			}
+			run = x0 + 1;
 		}
-		err -= dy;
 		if (err < 0)
 		{
 			y0 += ystep;
@@ -451,11 +492,11 @@ void writeLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t colo
 // display_fillRect(cursor_x + 5 * textsize, cursor_y, textsize, 8 * textsize, textbgcolor);
 void fillRect(uint16_t x0, uint16_t y0, uint16_t w, int16_t h, uint16_t color)
 {
-	for (int i = 0; i < w; i++)
-	{
-		// write line works with x0, x1, y0 y1
-		writeLine(x0 + i, y0, x0 + i, y0 + h, color);
-	}
+	if (w == 0)
+		return;
+
+	// columns x0 to x0 + w - 1, rows y0 to y0 + h
+	gfx_drv_fillRect(x0, y0, x0 + w - 1, y0 + h, color);
 }
 
 /**************************************************************************/
@@ -854,46 +895,63 @@ void display_fillTriangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, ui
 
 /**************************************************************************/
 /*!
-    @brief  Print one byte/character of data
-    @param  c  The 8-bit ascii character to write
+    @brief  Draw one column of a character at the text cursor. When magnified,
+            each run of pixels of the same color is filled as one rectangle.
+    @param  x     X coordinate of the column
+    @param  line  The column of the character, LSB at the top
 */
 /**************************************************************************/
-void display_putc(uint8_t c)
+static void drawGlyphColumn(int16_t x, uint8_t line)
 {
-	uint8_t i, j;
-	if (c == ' ' && cursor_x == 0 && wrap)
-		return;
-	if (c == '\r')
+	uint8_t  j, k, bit;
+	uint16_t color;
+
+	// single pixels are cheaper to set one by one than as spans
+	if (textsize == 1)
 	{
-		cursor_x = 0;
+		for (j = 0; j < 8; j++, line >>= 1)
+		{
+			if (line & 1)
+				display_drawPixel(x, cursor_y + j, textcolor);
+			else if (textbgcolor != textcolor)
+				display_drawPixel(x, cursor_y + j, textbgcolor);
+		}
 		return;
 	}
-	if (c == '\n')
+
+	for (j = 0; j < 8; j = k + 1)
 	{
-		cursor_y += textsize * 8;
-		return;
+		bit = line & 1;
+		for (k = j; k < 7 && ((line >> 1) & 1) == bit; k++) line >>= 1;
+		line >>= 1;
+
+		if (!bit && textbgcolor == textcolor)
+			continue;
+		color = bit ? textcolor : textbgcolor;
+
+		// display_fillRect fills one line more than its height
+		display_fillRect(x, cursor_y + j * textsize, textsize, (k - j + 1) * textsize - 1, color);
 	}
+}
+
+/**************************************************************************/
+/*!
+    @brief  Draw a character at the text cursor, with the current text size
+            and colors. Glyphs are blitted from the glyph cache of the gfx
+            driver where possible, and drawn column by column otherwise.
+    @param  columns  The 5 columns of the character, LSB at the top
+*/
+/**************************************************************************/
+static void drawGlyph(const uint8_t *columns)
+{
+	uint8_t i;
+
+	if (gfx_drv_drawGlyph(cursor_x, cursor_y, columns, textsize, textcolor, textbgcolor))
+		return;
 
 	for (i = 0; i < 5; i++)
 	{
-		uint8_t line = font[c][i];
-		for (j = 0; j < 8; j++, line >>= 1)
-		{
-			if (line & 1)
-			{
-				if (textsize == 1)
-					display_drawPixel(cursor_x + i, cursor_y + j, textcolor);
-				else
-					display_fillRect(cursor_x + i * textsize, cursor_y + j * textsize, textsize, textsize, textcolor);
-			}
-			else if (textbgcolor != textcolor)
-			{
-				if (textsize == 1)
-					display_drawPixel(cursor_x + i, cursor_y + j, textbgcolor);
-				else
-					display_fillRect(cursor_x + i * textsize, cursor_y + j * textsize, textsize, textsize, textbgcolor);
-			}
-		}
+		drawGlyphColumn(cursor_x + i * textsize, columns[i]);
 	}
 
 	if (textbgcolor != textcolor)
@@ -901,8 +959,32 @@ void display_putc(uint8_t c)
 		if (textsize == 1)
 			display_drawVLine(cursor_x + 5, cursor_y, 7, textbgcolor);
 		else
-			display_fillRect(cursor_x + 5 * textsize, cursor_y, textsize, 8 * textsize, textbgcolor);
+			display_fillRect(cursor_x + 5 * textsize, cursor_y, textsize, 8 * textsize - 1, textbgcolor);
 	}
+}
+
+/**************************************************************************/
+/*!
+    @brief  Print one byte/character of data
+    @param  c  The 8-bit ascii character to write
+*/
+/**************************************************************************/
+void display_putc(uint8_t c)
+{
+	if (c == ' ' && cursor_x == 0 && wrap)
+		return;
+	if (c == '\r')
+	{
+		cursor_x = 0;
+		return;
+	}
+	if (c == '\n')
+	{
+		cursor_y += textsize * 8;
+		return;
+	}
+
+	drawGlyph(font[c]);
 
 	cursor_x += textsize * 6;
 
@@ -960,36 +1042,7 @@ void display_puts_max_n(const uint8_t *s, uint8_t n)
 // print custom char (dimension: 7x5 or 8x5 pixel)
 void display_customChar(const uint8_t *c)
 {
-	uint8_t i, j;
-	for (i = 0; i < 5; i++)
-	{
-		uint8_t line = c[i];
-		for (j = 0; j < 8; j++, line >>= 1)
-		{
-			if (line & 1)
-			{
-				if (textsize == 1)
-					display_drawPixel(cursor_x + i, cursor_y + j, textcolor);
-				else
-					display_fillRect(cursor_x + i * textsize, cursor_y + j * textsize, textsize, textsize, textcolor);
-			}
-			else if (textbgcolor != textcolor)
-			{
-				if (textsize == 1)
-					display_drawPixel(cursor_x + i, cursor_y + j, textbgcolor);
-				else
-					display_fillRect(cursor_x + i * textsize, cursor_y + j * textsize, textsize, textsize, textbgcolor);
-			}
-		}
-	}
-
-	if (textbgcolor != textcolor)
-	{ // If opaque, draw vertical line for last column
-		if (textsize == 1)
-			display_drawVLine(cursor_x + 5, cursor_y, 8, textbgcolor);
-		else
-			display_fillRect(cursor_x + 5 * textsize, cursor_y, textsize, 8 * textsize, textbgcolor);
-	}
+	drawGlyph(c);
 
 	cursor_x += textsize * 6;
 
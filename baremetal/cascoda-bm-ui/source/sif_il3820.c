@@ -32,6 +32,7 @@
 */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "cascoda-bm/cascoda_interface.h"
 #include "cascoda-bm/cascoda_sensorif.h"
@@ -39,8 +40,8 @@
 #include "cascoda-bm/cascoda_types.h"
 #include "cascoda-bm/cascoda_wait.h"
 #include "cascoda-util/cascoda_time.h"
-#include "qrcodegen.h"
 #include "sif_il3820.h"
+#include "sif_qr.h"
 
 /* EPD commands */
 #define DRIVER_OUTPUT_CONTROL 0x01
@@ -78,6 +79,12 @@ static const uint8_t SIF_IL3820_lut_partial_update[30] = {0x10, 0x18, 0x18, 0x08
                                                           0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
                                                           0x13, 0x14, 0x44, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 
+// Offset in the frame memory of the next byte written by SIF_IL3820_WriteFrameMemory
+static u16_t g_frame_position;
+
+// Size of the buffer used to send the same byte many times
+#define SIF_IL3820_FILL_CHUNK 64
+
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief Sends a command using SPI
@@ -110,6 +117,46 @@ static void SIF_IL3820_SendData(uint8_t data_byte)
 	} while (error != CA_ERROR_SUCCESS);
 }
 
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Sends a buffer of data bytes using SPI, in a single transaction
+ * \param data - The data bytes to send
+ * \param length - Number of bytes to send
+ *******************************************************************************
+ * \return Status of the SPI transfer
+ *******************************************************************************
+ ******************************************************************************/
+static ca_error SIF_IL3820_SendDataBuffer(const uint8_t *data, u32_t length)
+{
+	BSP_ModuleSetGPIOPin(SIF_IL3820_DC_PIN, 1);
+	return SENSORIF_SPI_WriteBuffer(data, length);
+}
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Sends the same data byte several times using SPI
+ * \param data_byte - The data byte to send
+ * \param count - Number of times to send it
+ *******************************************************************************
+ * \return Status of the first SPI transfer that failed, else CA_ERROR_SUCCESS
+ *******************************************************************************
+ ******************************************************************************/
+static ca_error SIF_IL3820_SendRepeatedData(uint8_t data_byte, u32_t count)
+{
+	uint8_t  buffer[SIF_IL3820_FILL_CHUNK];
+	ca_error error = CA_ERROR_SUCCESS;
+
+	memset(buffer, data_byte, sizeof(buffer));
+	while (count && !error)
+	{
+		u32_t length = (count < sizeof(buffer)) ? count : sizeof(buffer);
+
+		error = SIF_IL3820_SendDataBuffer(buffer, length);
+		count -= length;
+	}
+	return error;
+}
+
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief Sets the display window
@@ -201,35 +248,6 @@ static void SIF_IL3820_Reset(void)
 	WAIT_ms(2);
 }
 
-/******************************************************************************/
-/***************************************************************************/ /**
- * \brief This function replaces the appropriate bits of the image with the bits
- *        of the QR code based on the specified x and y coordinates.
- *******************************************************************************
- * \param qrcode - The array containing the QR code data.
- * \param image  - The image array that will be modified.
- * \param scale  - The image scaling, currently supported 1 & 2.
- * \param x_pos  - The x-coordinate of the top-left corner of the QR symbol.
- * \param y_pos  - The y-coordinate of the top-left corner of the QR symbol.
- *******************************************************************************
- ******************************************************************************/
-static void SIF_IL3820_embed_qr(const uint8_t *qrcode, uint8_t *image, uint8_t scale, uint8_t x_pos, uint8_t y_pos)
-{
-	int size        = qrcodegen_getSize(qrcode);
-	int size_scaled = size * scale;
-
-	for (int y = y_pos; y < y_pos + size_scaled; y++)
-	{
-		for (int x = x_pos; x < x_pos + size_scaled; x++)
-		{
-			if (!qrcodegen_getModule(qrcode, (x - x_pos) / scale, (y - y_pos) / scale))
-				image[(x + (y * SIF_IL3820_WIDTH)) / 8] |= (1 << (7 - (x % 8)));
-			else
-				image[(x + (y * SIF_IL3820_WIDTH)) / 8] &= ~(1 << (7 - (x % 8)));
-		}
-	}
-}
-
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief This function sets the Lookup table (LUT) register in the display
@@ -240,20 +258,16 @@ static void SIF_IL3820_embed_qr(const uint8_t *qrcode, uint8_t *image, uint8_t s
  ******************************************************************************/
 static ca_error SIF_IL3820_SetLut(SIF_IL3820_Update_Mode mode)
 {
+	ca_error error;
+
 	SIF_IL3820_SendCommand(WRITE_LUT_REGISTER);
 	if (mode == FULL_UPDATE)
 	{
-		for (u8_t i = 0; i < sizeof(SIF_IL3820_lut_full_update); ++i)
-		{
-			SIF_IL3820_SendData(SIF_IL3820_lut_full_update[i]);
-		}
+		error = SIF_IL3820_SendDataBuffer(SIF_IL3820_lut_full_update, sizeof(SIF_IL3820_lut_full_update));
 	}
 	else if (mode == PARTIAL_UPDATE)
 	{
-		for (u8_t i = 0; i < sizeof(SIF_IL3820_lut_partial_update); ++i)
-		{
-			SIF_IL3820_SendData(SIF_IL3820_lut_partial_update[i]);
-		}
+		error = SIF_IL3820_SendDataBuffer(SIF_IL3820_lut_partial_update, sizeof(SIF_IL3820_lut_partial_update));
 	}
 	else
 	{
@@ -261,6 +275,8 @@ static ca_error SIF_IL3820_SetLut(SIF_IL3820_Update_Mode mode)
 		return CA_ERROR_INVALID_ARGS;
 	}
 
+	if (error)
+		return error;
 	return SIF_IL3820_WaitUntilIdle();
 }
 
@@ -362,61 +378,93 @@ void SIF_IL3820_Deinitialise(void)
 	    SIF_IL3820_BUSY_PIN, MODULE_PIN_PULLUP_ON, MODULE_PIN_DEBOUNCE_ON, MODULE_PIN_IRQ_OFF, NULL});
 }
 
-static void SIF_IL3820_Display(const uint8_t *image)
+void SIF_IL3820_StartFrameMemory(void)
+{
+	SIF_IL3820_SetWindow(0, SIF_IL3820_WIDTH, 0, SIF_IL3820_HEIGHT);
+	g_frame_position = 0;
+}
+
+ca_error SIF_IL3820_WriteFrameMemory(const uint8_t *data, uint16_t length)
 {
-	u16_t width, height;
+	ca_error error = CA_ERROR_SUCCESS;
+	u16_t    width, height;
 	width  = (SIF_IL3820_WIDTH % 8 == 0) ? (SIF_IL3820_WIDTH / 8) : (SIF_IL3820_WIDTH / 8 + 1);
 	height = SIF_IL3820_HEIGHT;
 
-	u64_t address = 0;
-
 	//BSP_ModuleSetGPIOPin(SIF_IL3820_CS_PIN, 0);
 
-	SIF_IL3820_SetWindow(0, SIF_IL3820_WIDTH, 0, SIF_IL3820_HEIGHT);
-	for (u16_t j = 0; j < height; j++)
+	while (length && g_frame_position < (width * height) && !error)
 	{
-		SIF_IL3820_SetCursor(0, j);
-		SIF_IL3820_SendCommand(WRITE_RAM);
-		for (u16_t i = 0; i < width; i++)
+		u16_t column = g_frame_position % width;
+		u16_t count  = width - column;
+
+		// Start of a new line
+		if (column == 0)
 		{
-			address = i + j * width;
-			SIF_IL3820_SendData(image[address]);
+			SIF_IL3820_SetCursor(0, g_frame_position / width);
+			SIF_IL3820_SendCommand(WRITE_RAM);
 		}
+
+		// Send up to the end of the line in one go
+		if (count > length)
+			count = length;
+		error = SIF_IL3820_SendDataBuffer(data, count);
+
+		data += count;
+		length -= count;
+		g_frame_position += count;
 	}
 
+	//BSP_ModuleSetGPIOPin(SIF_IL3820_CS_PIN, 1);
+	return error;
+}
+
+void SIF_IL3820_DisplayFrameMemory(void)
+{
 	SIF_IL3820_TurnOnDisplay();
+	SIF_IL3820_DeepSleep();
+}
 
-	//BSP_ModuleSetGPIOPin(SIF_IL3820_CS_PIN, 1);
+static ca_error SIF_IL3820_Display(const uint8_t *image)
+{
+	ca_error error;
+
+	SIF_IL3820_StartFrameMemory();
+	error = SIF_IL3820_WriteFrameMemory(image, ARRAY_SIZE);
+	if (!error)
+		SIF_IL3820_TurnOnDisplay();
+	return error;
 }
 
-void SIF_IL3820_ClearDisplay(void)
+ca_error SIF_IL3820_ClearDisplay(void)
 {
-	u16_t width, height;
+	ca_error error = CA_ERROR_SUCCESS;
+	u16_t    width, height;
 	width  = (SIF_IL3820_WIDTH % 8 == 0) ? (SIF_IL3820_WIDTH / 8) : (SIF_IL3820_WIDTH / 8 + 1);
 	height = SIF_IL3820_HEIGHT;
 
 	//BSP_ModuleSetGPIOPin(SIF_IL3820_CS_PIN, 0);
 
 	SIF_IL3820_SetWindow(0, SIF_IL3820_WIDTH, 0, SIF_IL3820_HEIGHT);
-	for (u16_t j = 0; j < height; j++)
+	for (u16_t j = 0; j < height && !error; j++)
 	{
 		SIF_IL3820_SetCursor(0, j);
 		SIF_IL3820_SendCommand(WRITE_RAM);
-		for (u16_t i = 0; i < width; i++)
-		{
-			SIF_IL3820_SendData(0xFF);
-		}
+		error = SIF_IL3820_SendRepeatedData(0xFF, width);
 	}
-	SIF_IL3820_TurnOnDisplay();
+	if (!error)
+		SIF_IL3820_TurnOnDisplay();
 
 	//BSP_ModuleSetGPIOPin(SIF_IL3820_CS_PIN, 0);
+	return error;
 }
 
-void SIF_IL3820_StrongClearDisplay(void)
+ca_error SIF_IL3820_StrongClearDisplay(void)
 {
-	SIF_IL3820_ClearDisplay();
-	SIF_IL3820_ClearDisplay();
-	SIF_IL3820_ClearDisplay();
+	ca_error error = SIF_IL3820_ClearDisplay();
+
+	for (int i = 1; i < 3 && !error; i++) error = SIF_IL3820_ClearDisplay();
+	return error;
 }
 
 void SIF_IL3820_DeepSleep(void)
@@ -429,26 +477,23 @@ void SIF_IL3820_DeepSleep(void)
 
 ca_error SIF_IL3820_overlay_qr_code(const char *text, uint8_t *image, uint8_t scale, uint8_t x, uint8_t y)
 {
-	enum qrcodegen_Ecc errCorLvl = qrcodegen_Ecc_LOW; // Error correction level
-
-	// Make the QR Code symbol
-	uint8_t qrcode[qrcodegen_BUFFER_LEN_FOR_VERSION(10)];
-	uint8_t tempBuffer[qrcodegen_BUFFER_LEN_FOR_VERSION(10)];
-	bool    success = qrcodegen_encodeText(
-        text, tempBuffer, qrcode, errCorLvl, qrcodegen_VERSION_MIN, qrcodegen_VERSION_MAX, qrcodegen_Mask_AUTO, true);
-	if (success)
-	{
-		SIF_IL3820_embed_qr(qrcode, image, scale, x, y);
-		return CA_ERROR_SUCCESS;
-	}
-	return CA_ERROR_FAIL;
+	const uint8_t *qrcode;
+	ca_error       status = SIF_QR_Encode(text, &qrcode);
+
+	if (status)
+		return status;
+	return SIF_QR_Embed(qrcode, image, SIF_IL3820_WIDTH, SIF_IL3820_HEIGHT, scale, x, y);
 }
 
-void SIF_IL3820_DisplayImage(const uint8_t *image, SIF_IL3820_Clear_Mode mode)
+ca_error SIF_IL3820_DisplayImage(const uint8_t *image, SIF_IL3820_Clear_Mode mode)
 {
+	ca_error error = CA_ERROR_SUCCESS;
+
 	if (mode == WITH_CLEAR)
-		SIF_IL3820_ClearDisplay();
+		error = SIF_IL3820_ClearDisplay();
 
-	SIF_IL3820_Display(image);
+	if (!error)
+		error = SIF_IL3820_Display(image);
 	SIF_IL3820_DeepSleep();
+	return error;
 }
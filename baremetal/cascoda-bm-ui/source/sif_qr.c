@@ -0,0 +1,148 @@
+/**
+ * @file
+ *//*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * QR code generation and drawing for the E-Paper displays.
+*/
+#include <string.h>
+
+#include "qrcodegen.h"
+#include "sif_qr.h"
+
+/* The last symbol generated */
+static struct sif_qr_cache g_qr_cache;
+
+ca_error SIF_QR_Encode(const char *text, const uint8_t **qrcode)
+{
+	uint8_t tempBuffer[qrcodegen_BUFFER_LEN_FOR_VERSION(SIF_QR_MAX_VERSION)];
+	size_t  length = strlen(text);
+
+	*qrcode = g_qr_cache.qrcode;
+	if (g_qr_cache.length && g_qr_cache.length == length && !memcmp(g_qr_cache.text, text, length))
+		return CA_ERROR_SUCCESS;
+
+	g_qr_cache.length = 0;
+	if (!qrcodegen_encodeText(text,
+	                          tempBuffer,
+	                          g_qr_cache.qrcode,
+	                          qrcodegen_Ecc_LOW,
+	                          qrcodegen_VERSION_MIN,
+	                          SIF_QR_MAX_VERSION,
+	                          SIF_QR_MASK,
+	                          true))
+		return CA_ERROR_FAIL;
+
+	// The symbol is still valid until the next call, it just cannot be found again
+	if (length <= sizeof(g_qr_cache.text))
+	{
+		memcpy(g_qr_cache.text, text, length);
+		g_qr_cache.length = length;
+	}
+	return CA_ERROR_SUCCESS;
+}
+
+ca_error SIF_QR_Embed(const uint8_t *qrcode,
+                      uint8_t       *image,
+                      uint16_t       width,
+                      uint16_t       height,
+                      uint8_t        scale,
+                      uint16_t       x,
+                      uint16_t       y)
+{
+	int      size        = qrcodegen_getSize(qrcode);
+	uint32_t size_scaled = (uint32_t)size * scale;
+	uint16_t stride      = width / 8;
+	uint16_t first       = x / 8;
+	uint16_t last, px;
+	uint8_t  lmask, rmask;
+
+	if (scale == 0 || x + size_scaled > width || y + size_scaled > height)
+		return CA_ERROR_INVALID_ARGS;
+
+	last  = (x + size_scaled - 1) / 8;
+	lmask = 0xFF >> (x % 8);
+	rmask = 0xFF << (7 - ((x + size_scaled - 1) % 8));
+	if (first == last)
+	{
+		lmask &= rmask;
+		rmask = lmask;
+	}
+
+	for (int row = 0; row < size; row++)
+	{
+		uint8_t *line = image + (y + row * scale) * stride;
+
+		// Draw the first line of the row of modules, with dark modules black
+		px = x;
+		for (int column = 0; column < size; column++)
+		{
+			bool dark = qrcodegen_getModule(qrcode, column, row);
+
+			for (uint8_t i = 0; i < scale; i++, px++)
+			{
+				if (dark)
+					line[px / 8] &= ~(0x80 >> (px % 8));
+				else
+					line[px / 8] |= (0x80 >> (px % 8));
+			}
+		}
+
+		// The other lines of the row are the same, so they are copied a byte at a time
+		for (uint8_t j = 1; j < scale; j++)
+		{
+			uint8_t *copy = line + j * stride;
+
+			copy[first] = (copy[first] & ~lmask) | (line[first] & lmask);
+			if (last == first)
+				continue;
+			memcpy(&copy[first + 1], &line[first + 1], last - first - 1);
+			copy[last] = (copy[last] & ~rmask) | (line[last] & rmask);
+		}
+	}
+
+	return CA_ERROR_SUCCESS;
+}
+
+const struct sif_qr_cache *SIF_QR_GetCache(void)
+{
+	return &g_qr_cache;
+}
+
+ca_error SIF_QR_SetCache(const struct sif_qr_cache *cache)
+{
+	// The first byte of a symbol is its size, which must be that of a version that fits in the buffer
+	uint8_t size = cache->qrcode[0];
+
+	if (!cache->length || cache->length > sizeof(cache->text) || size < 21 ||
+	    size > (SIF_QR_MAX_VERSION * 4 + 17) || (size - 17) % 4)
+		return CA_ERROR_INVALID_ARGS;
+
+	memcpy(&g_qr_cache, cache, sizeof(g_qr_cache));
+	return CA_ERROR_SUCCESS;
+}
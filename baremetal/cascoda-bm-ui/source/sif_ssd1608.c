@@ -32,6 +32,7 @@
 */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "cascoda-bm/cascoda_interface.h"
 #include "cascoda-bm/cascoda_sensorif.h"
@@ -39,7 +40,7 @@
 #include "cascoda-bm/cascoda_types.h"
 #include "cascoda-bm/cascoda_wait.h"
 #include "cascoda-util/cascoda_time.h"
-#include "qrcodegen.h"
+#include "sif_qr.h"
 #include "sif_ssd1608.h"
 
 /* EPD commands */
@@ -81,6 +82,9 @@ static const uint8_t SIF_SSD1608_lut_partial_update[30] = {0x10, 0x18, 0x18, 0x0
                                                            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
                                                            0x13, 0x14, 0x44, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 
+// Size of the buffer used to send the same byte many times
+#define SIF_SSD1608_FILL_CHUNK 64
+
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief Sends a command using SPI
@@ -113,6 +117,46 @@ static void SIF_SSD1608_SendData(uint8_t data_byte)
 	} while (error != CA_ERROR_SUCCESS);
 }
 
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Sends a buffer of data bytes using SPI, in a single transaction
+ * \param data - The data bytes to send
+ * \param length - Number of bytes to send
+ *******************************************************************************
+ * \return Status of the SPI transfer
+ *******************************************************************************
+ ******************************************************************************/
+static ca_error SIF_SSD1608_SendDataBuffer(const uint8_t *data, u32_t length)
+{
+	BSP_ModuleSetGPIOPin(SIF_SSD1608_DC_PIN, 1);
+	return SENSORIF_SPI_WriteBuffer(data, length);
+}
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Sends the same data byte several times using SPI
+ * \param data_byte - The data byte to send
+ * \param count - Number of times to send it
+ *******************************************************************************
+ * \return Status of the first SPI transfer that failed, else CA_ERROR_SUCCESS
+ *******************************************************************************
+ ******************************************************************************/
+static ca_error SIF_SSD1608_SendRepeatedData(uint8_t data_byte, u32_t count)
+{
+	uint8_t  buffer[SIF_SSD1608_FILL_CHUNK];
+	ca_error error = CA_ERROR_SUCCESS;
+
+	memset(buffer, data_byte, sizeof(buffer));
+	while (count && !error)
+	{
+		u32_t length = (count < sizeof(buffer)) ? count : sizeof(buffer);
+
+		error = SIF_SSD1608_SendDataBuffer(buffer, length);
+		count -= length;
+	}
+	return error;
+}
+
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief Sets the display window
@@ -227,35 +271,6 @@ static void SIF_SSD1608_Reset(void)
 	WAIT_ms(2);
 }
 
-/******************************************************************************/
-/***************************************************************************/ /**
- * \brief This function replaces the appropriate bits of the image with the bits
- *        of the QR code based on the specified x and y coordinates.
- *******************************************************************************
- * \param qrcode - The array containing the QR code data.
- * \param image  - The image array that will be modified.
- * \param scale  - The image scaling, currently supported 1 & 2.
- * \param x_pos  - The x-coordinate of the top-left corner of the QR symbol.
- * \param y_pos  - The y-coordinate of the top-left corner of the QR symbol.
- *******************************************************************************
- ******************************************************************************/
-static void SIF_SSD1608_embed_qr(const uint8_t *qrcode, uint8_t *image, uint8_t scale, uint8_t x_pos, uint8_t y_pos)
-{
-	int size        = qrcodegen_getSize(qrcode);
-	int size_scaled = size * scale;
-
-	for (int y = y_pos; y < y_pos + size_scaled; y++)
-	{
-		for (int x = x_pos; x < x_pos + size_scaled; x++)
-		{
-			if (!qrcodegen_getModule(qrcode, (x - x_pos) / scale, (y - y_pos) / scale))
-				image[(x + (y * SIF_SSD1608_WIDTH)) / 8] |= (1 << (7 - (x % 8)));
-			else
-				image[(x + (y * SIF_SSD1608_WIDTH)) / 8] &= ~(1 << (7 - (x % 8)));
-		}
-	}
-}
-
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief This function sets the Lookup table (LUT) register in the display
@@ -266,20 +281,16 @@ static void SIF_SSD1608_embed_qr(const uint8_t *qrcode, uint8_t *image, uint8_t
  ******************************************************************************/
 static ca_error SIF_SSD1608_SetLut(SIF_SSD1608_Update_Mode mode)
 {
+	ca_error error;
+
 	SIF_SSD1608_SendCommand(WRITE_LUT_REGISTER);
 	if (mode == FULL_UPDATE)
 	{
-		for (u8_t i = 0; i < sizeof(SIF_SSD1608_lut_full_update); ++i)
-		{
-			SIF_SSD1608_SendData(SIF_SSD1608_lut_full_update[i]);
-		}
+		error = SIF_SSD1608_SendDataBuffer(SIF_SSD1608_lut_full_update, sizeof(SIF_SSD1608_lut_full_update));
 	}
 	else if (mode == PARTIAL_UPDATE)
 	{
-		for (u8_t i = 0; i < sizeof(SIF_SSD1608_lut_partial_update); ++i)
-		{
-			SIF_SSD1608_SendData(SIF_SSD1608_lut_partial_update[i]);
-		}
+		error = SIF_SSD1608_SendDataBuffer(SIF_SSD1608_lut_partial_update, sizeof(SIF_SSD1608_lut_partial_update));
 	}
 	else
 	{
@@ -287,6 +298,8 @@ static ca_error SIF_SSD1608_SetLut(SIF_SSD1608_Update_Mode mode)
 		return CA_ERROR_INVALID_ARGS;
 	}
 
+	if (error)
+		return error;
 	return SIF_SSD1608_WaitUntilIdle();
 }
 
@@ -460,8 +473,10 @@ static void SIF_SSD1608_Transform(uint8_t input_byte, uint8_t output_buf[2])
  * resolution.
  *******************************************************************************
  ******************************************************************************/
-static void SIF_SSD1608_ClearRightEdge(void)
+static ca_error SIF_SSD1608_ClearRightEdge(void)
 {
+	ca_error error = CA_ERROR_SUCCESS;
+
 #define SIF_SSD1608_RIGHT_EDGE_WIDTH (SIF_SSD1608_WIDTH_PHYSICAL - SIF_SSD1608_WIDTH_WINDOW)
 #define SIF_SSD1608_RIGHT_EDGE_HEIGHT (SIF_SSD1608_HEIGHT_PHYSICAL)
 	u16_t width  = (SIF_SSD1608_RIGHT_EDGE_WIDTH % 8 == 0) ? (SIF_SSD1608_RIGHT_EDGE_WIDTH / 8)
@@ -469,18 +484,16 @@ static void SIF_SSD1608_ClearRightEdge(void)
 	u16_t height = SIF_SSD1608_RIGHT_EDGE_HEIGHT;
 
 	SIF_SSD1608_SetWindow(0, SIF_SSD1608_WIDTH_PHYSICAL - 1, 0, SIF_SSD1608_HEIGHT_PHYSICAL - 1);
-	for (int j = 0; j < height; j++)
+	for (int j = 0; j < height && !error; j++)
 	{
 		SIF_SSD1608_SetCursor(SIF_SSD1608_WIDTH_WINDOW, j);
 		SIF_SSD1608_SendCommand(WRITE_RAM);
-		for (int i = 0; i < width; i++)
-		{
-			SIF_SSD1608_SendData(0xff);
-		}
+		error = SIF_SSD1608_SendRepeatedData(0xff, width);
 	}
 
 #undef SIF_SSD1608_RIGHT_EDGE_WIDTH
 #undef SIF_SSD1608_RIGHT_EDGE_HEIGHT
+	return error;
 }
 
 /******************************************************************************/
@@ -489,8 +502,10 @@ static void SIF_SSD1608_ClearRightEdge(void)
  * resolution.
  *******************************************************************************
  ******************************************************************************/
-static void SIF_SSD1608_ClearBottomEdge(void)
+static ca_error SIF_SSD1608_ClearBottomEdge(void)
 {
+	ca_error error = CA_ERROR_SUCCESS;
+
 #define SIF_SSD1608_BOTTOM_EDGE_WIDTH (SIF_SSD1608_WIDTH_PHYSICAL)
 #define SIF_SSD1608_BOTTOM_EDGE_HEIGHT (SIF_SSD1608_HEIGHT_PHYSICAL - SIF_SSD1608_WIDTH_WINDOW)
 	u16_t width  = (SIF_SSD1608_BOTTOM_EDGE_WIDTH % 8 == 0) ? (SIF_SSD1608_BOTTOM_EDGE_WIDTH / 8)
@@ -498,18 +513,16 @@ static void SIF_SSD1608_ClearBottomEdge(void)
 	u16_t height = SIF_SSD1608_BOTTOM_EDGE_HEIGHT;
 
 	SIF_SSD1608_SetWindow(0, SIF_SSD1608_WIDTH_PHYSICAL - 1, 0, SIF_SSD1608_HEIGHT_PHYSICAL - 1);
-	for (int j = 0; j < height; j++)
+	for (int j = 0; j < height && !error; j++)
 	{
 		SIF_SSD1608_SetCursor(0, j + SIF_SSD1608_WIDTH_WINDOW);
 		SIF_SSD1608_SendCommand(WRITE_RAM);
-		for (int i = 0; i < width; i++)
-		{
-			SIF_SSD1608_SendData(0xff);
-		}
+		error = SIF_SSD1608_SendRepeatedData(0xff, width);
 	}
 
 #undef SIF_SSD1608_BOTTOM_EDGE_WIDTH
 #undef SIF_SSD1608_BOTTOM_EDGE_HEIGHT
+	return error;
 }
 
 /******************************************************************************/
@@ -520,51 +533,43 @@ static void SIF_SSD1608_ClearBottomEdge(void)
  * \param[in] image - The image that is to be copied.
  *******************************************************************************
  ******************************************************************************/
-static void SIF_SSD1608_DisplayHalfRes(const uint8_t *image, bool no_wait)
+static ca_error SIF_SSD1608_DisplayHalfRes(const uint8_t *image, bool no_wait)
 {
-	u16_t width  = (SIF_SSD1608_WIDTH % 8 == 0) ? (SIF_SSD1608_WIDTH / 8) : (SIF_SSD1608_WIDTH / 8 + 1);
-	u16_t height = SIF_SSD1608_HEIGHT;
+	ca_error error  = CA_ERROR_SUCCESS;
+	u16_t    width  = (SIF_SSD1608_WIDTH % 8 == 0) ? (SIF_SSD1608_WIDTH / 8) : (SIF_SSD1608_WIDTH / 8 + 1);
+	u16_t    height = SIF_SSD1608_HEIGHT;
 
-	u64_t address  = 0;
 	u16_t offset_y = 0;
 
-	u8_t transformation_result[2] = {0x00};
+	u8_t line[2 * (SIF_SSD1608_WIDTH / 8 + 1)];
 
 	SIF_SSD1608_SetWindow(0, SIF_SSD1608_WIDTH_WINDOW - 1, 0, SIF_SSD1608_HEIGHT_WINDOW - 1);
-	for (u16_t j = 0; j < height; j++)
+	for (u16_t j = 0; j < height && !error; j++)
 	{
+		// Generates two bytes from each byte of the jth line of image
+		for (u16_t i = 0; i < width; i++) SIF_SSD1608_Transform(image[i + j * width], &line[i * 2]);
+
 		// Write jth line of image to the next line in eink RAM
 		SIF_SSD1608_SetCursor(0, j + offset_y);
 		SIF_SSD1608_SendCommand(WRITE_RAM);
-		for (u16_t i = 0; i < width; i++)
-		{
-			address = i + j * width;
-
-			// Generates two bytes from the ith byte in image
-			SIF_SSD1608_Transform(image[address], transformation_result);
-
-			// Writes those two generated bytes to eink RAM
-			SIF_SSD1608_SendData(transformation_result[0]);
-			SIF_SSD1608_SendData(transformation_result[1]);
-		}
+		error = SIF_SSD1608_SendDataBuffer(line, 2 * width);
+		if (error)
+			break;
 
 		// Write the same jth line of image to the next line in eink RAM
 		SIF_SSD1608_SetCursor(0, j + (++offset_y));
 		SIF_SSD1608_SendCommand(WRITE_RAM);
-		for (u16_t i = 0; i < width; i++)
-		{
-			address = i + j * width;
-			SIF_SSD1608_Transform(image[address], transformation_result);
-
-			SIF_SSD1608_SendData(transformation_result[0]);
-			SIF_SSD1608_SendData(transformation_result[1]);
-		}
+		error = SIF_SSD1608_SendDataBuffer(line, 2 * width);
 	}
 
-	SIF_SSD1608_ClearRightEdge();
-	SIF_SSD1608_ClearBottomEdge();
+	if (!error)
+		error = SIF_SSD1608_ClearRightEdge();
+	if (!error)
+		error = SIF_SSD1608_ClearBottomEdge();
 
-	SIF_SSD1608_TurnOnDisplay(no_wait);
+	if (!error)
+		SIF_SSD1608_TurnOnDisplay(no_wait);
+	return error;
 }
 
 #endif // EPAPER_FULL_RESOLUTION
@@ -576,37 +581,35 @@ static void SIF_SSD1608_DisplayHalfRes(const uint8_t *image, bool no_wait)
  * \param[in] image - The image that is to be copied.
  *******************************************************************************
  ******************************************************************************/
-static void SIF_SSD1608_DisplayFullRes(const uint8_t *image, bool no_wait)
+static ca_error SIF_SSD1608_DisplayFullRes(const uint8_t *image, bool no_wait)
 {
-	u16_t width, height;
+	ca_error error = CA_ERROR_SUCCESS;
+	u16_t    width, height;
 	width =
 	    (SIF_SSD1608_WIDTH_PHYSICAL % 8 == 0) ? (SIF_SSD1608_WIDTH_PHYSICAL / 8) : (SIF_SSD1608_WIDTH_PHYSICAL / 8 + 1);
 	height = SIF_SSD1608_HEIGHT_PHYSICAL;
 
-	u64_t address = 0;
-
 	//BSP_ModuleSetGPIOPin(SIF_SSD1608_CS_PIN, 0);
 
 	SIF_SSD1608_SetWindow(0, SIF_SSD1608_WIDTH_PHYSICAL - 1, 0, SIF_SSD1608_HEIGHT_PHYSICAL - 1);
-	for (u16_t j = 0; j < height; j++)
+	for (u16_t j = 0; j < height && !error; j++)
 	{
 		SIF_SSD1608_SetCursor(0, j);
 		SIF_SSD1608_SendCommand(WRITE_RAM);
-		for (u16_t i = 0; i < width; i++)
-		{
-			address = i + j * width;
-			SIF_SSD1608_SendData(image[address]);
-		}
+		error = SIF_SSD1608_SendDataBuffer(&image[j * width], width);
 	}
 
-	SIF_SSD1608_TurnOnDisplay(no_wait);
+	if (!error)
+		SIF_SSD1608_TurnOnDisplay(no_wait);
 
 	//BSP_ModuleSetGPIOPin(SIF_SSD1608_CS_PIN, 1);
+	return error;
 }
 
-void SIF_SSD1608_ClearDisplay(void)
+ca_error SIF_SSD1608_ClearDisplay(void)
 {
-	u16_t width, height;
+	ca_error error = CA_ERROR_SUCCESS;
+	u16_t    width, height;
 	width =
 	    (SIF_SSD1608_WIDTH_PHYSICAL % 8 == 0) ? (SIF_SSD1608_WIDTH_PHYSICAL / 8) : (SIF_SSD1608_WIDTH_PHYSICAL / 8 + 1);
 	height = SIF_SSD1608_HEIGHT_PHYSICAL;
@@ -614,25 +617,25 @@ void SIF_SSD1608_ClearDisplay(void)
 	//BSP_ModuleSetGPIOPin(SIF_SSD1608_CS_PIN, 0);
 
 	SIF_SSD1608_SetWindow(0, SIF_SSD1608_WIDTH_PHYSICAL - 1, 0, SIF_SSD1608_HEIGHT_PHYSICAL - 1);
-	for (u16_t j = 0; j < height; j++)
+	for (u16_t j = 0; j < height && !error; j++)
 	{
 		SIF_SSD1608_SetCursor(0, j);
 		SIF_SSD1608_SendCommand(WRITE_RAM);
-		for (u16_t i = 0; i < width; i++)
-		{
-			SIF_SSD1608_SendData(0xFF);
-		}
+		error = SIF_SSD1608_SendRepeatedData(0xFF, width);
 	}
-	SIF_SSD1608_TurnOnDisplay(false);
+	if (!error)
+		SIF_SSD1608_TurnOnDisplay(false);
 
 	//BSP_ModuleSetGPIOPin(SIF_SSD1608_CS_PIN, 0);
+	return error;
 }
 
-void SIF_SSD1608_StrongClearDisplay(void)
+ca_error SIF_SSD1608_StrongClearDisplay(void)
 {
-	SIF_SSD1608_ClearDisplay();
-	SIF_SSD1608_ClearDisplay();
-	SIF_SSD1608_ClearDisplay();
+	ca_error error = SIF_SSD1608_ClearDisplay();
+
+	for (int i = 1; i < 3 && !error; i++) error = SIF_SSD1608_ClearDisplay();
+	return error;
 }
 
 void SIF_SSD1608_DeepSleep(void)
@@ -645,55 +648,57 @@ void SIF_SSD1608_DeepSleep(void)
 
 ca_error SIF_SSD1608_overlay_qr_code(const char *text, uint8_t *image, uint8_t scale, uint8_t x, uint8_t y)
 {
-	enum qrcodegen_Ecc errCorLvl = qrcodegen_Ecc_LOW; // Error correction level
-
-	// Make the QR Code symbol
-	uint8_t qrcode[qrcodegen_BUFFER_LEN_FOR_VERSION(10)];
-	uint8_t tempBuffer[qrcodegen_BUFFER_LEN_FOR_VERSION(10)];
-	bool    success = qrcodegen_encodeText(
-        text, tempBuffer, qrcode, errCorLvl, qrcodegen_VERSION_MIN, qrcodegen_VERSION_MAX, qrcodegen_Mask_AUTO, true);
-	if (success)
-	{
-		SIF_SSD1608_embed_qr(qrcode, image, scale, x, y);
-		return CA_ERROR_SUCCESS;
-	}
-	return CA_ERROR_FAIL;
+	const uint8_t *qrcode;
+	ca_error       status = SIF_QR_Encode(text, &qrcode);
+
+	if (status)
+		return status;
+	return SIF_QR_Embed(qrcode, image, SIF_SSD1608_WIDTH, SIF_SSD1608_HEIGHT, scale, x, y);
 }
 
-void SIF_SSD1608_DisplayImage(const uint8_t *image, SIF_SSD1608_Clear_Mode mode, bool full_resolution)
+ca_error SIF_SSD1608_DisplayImage(const uint8_t *image, SIF_SSD1608_Clear_Mode mode, bool full_resolution)
 {
+	ca_error error = CA_ERROR_SUCCESS;
+
 #ifdef EPAPER_FULL_RESOLUTION
 	(void)full_resolution;
 #endif
 
 	if (mode == WITH_CLEAR)
-		SIF_SSD1608_ClearDisplay();
+		error = SIF_SSD1608_ClearDisplay();
 
+	if (!error)
+	{
 #ifndef EPAPER_FULL_RESOLUTION
-	if (!full_resolution)
-		SIF_SSD1608_DisplayHalfRes(image, false);
-	else
+		if (!full_resolution)
+			error = SIF_SSD1608_DisplayHalfRes(image, false);
+		else
 #endif
-		SIF_SSD1608_DisplayFullRes(image, false);
+			error = SIF_SSD1608_DisplayFullRes(image, false);
+	}
 
 	SIF_SSD1608_DeepSleep();
+	return error;
 }
 
-void SIF_SSD1608_DisplayImageNoWait(const uint8_t *image, SIF_SSD1608_Clear_Mode mode, bool full_resolution)
+ca_error SIF_SSD1608_DisplayImageNoWait(const uint8_t *image, SIF_SSD1608_Clear_Mode mode, bool full_resolution)
 {
+	ca_error error = CA_ERROR_SUCCESS;
+
 #ifdef EPAPER_FULL_RESOLUTION
 	(void)full_resolution;
 #endif
 
 	if (mode == WITH_CLEAR)
-		SIF_SSD1608_ClearDisplay();
+		error = SIF_SSD1608_ClearDisplay();
+	if (error)
+		return error;
 
 #ifndef EPAPER_FULL_RESOLUTION
 	if (!full_resolution)
-		SIF_SSD1608_DisplayHalfRes(image, true);
-	else
+		return SIF_SSD1608_DisplayHalfRes(image, true);
 #endif
-		SIF_SSD1608_DisplayFullRes(image, true);
+	return SIF_SSD1608_DisplayFullRes(image, true);
 }
 
 /* scheduled power-down when not waiting for busy signal */
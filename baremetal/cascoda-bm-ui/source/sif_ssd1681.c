@@ -32,6 +32,7 @@
 */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "cascoda-bm/cascoda_interface.h"
 #include "cascoda-bm/cascoda_sensorif.h"
@@ -39,7 +40,7 @@
 #include "cascoda-bm/cascoda_types.h"
 #include "cascoda-bm/cascoda_wait.h"
 #include "cascoda-util/cascoda_time.h"
-#include "qrcodegen.h"
+#include "sif_qr.h"
 #include "sif_ssd1681.h"
 
 /* EPD commands */
@@ -94,6 +95,9 @@ static const uint8_t SIF_SSD1681_lut_partial_update[] = {
 // Used so that the first partial update is done with a clear
 static bool g_is_asleep = true;
 
+// Size of the buffer used to send the same byte many times
+#define SIF_SSD1681_FILL_CHUNK 64
+
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief Sends a command using SPI
@@ -126,6 +130,46 @@ static void SIF_SSD1681_SendData(uint8_t data_byte)
 	} while (error != CA_ERROR_SUCCESS);
 }
 
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Sends a buffer of data bytes using SPI, in a single transaction
+ * \param data - The data bytes to send
+ * \param length - Number of bytes to send
+ *******************************************************************************
+ * \return Status of the SPI transfer
+ *******************************************************************************
+ ******************************************************************************/
+static ca_error SIF_SSD1681_SendDataBuffer(const uint8_t *data, u32_t length)
+{
+	BSP_ModuleSetGPIOPin(SIF_SSD1681_DC_PIN, 1);
+	return SENSORIF_SPI_WriteBuffer(data, length);
+}
+
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Sends the same data byte several times using SPI
+ * \param data_byte - The data byte to send
+ * \param count - Number of times to send it
+ *******************************************************************************
+ * \return Status of the first SPI transfer that failed, else CA_ERROR_SUCCESS
+ *******************************************************************************
+ ******************************************************************************/
+static ca_error SIF_SSD1681_SendRepeatedData(uint8_t data_byte, u32_t count)
+{
+	uint8_t  buffer[SIF_SSD1681_FILL_CHUNK];
+	ca_error error = CA_ERROR_SUCCESS;
+
+	memset(buffer, data_byte, sizeof(buffer));
+	while (count && !error)
+	{
+		u32_t length = (count < sizeof(buffer)) ? count : sizeof(buffer);
+
+		error = SIF_SSD1681_SendDataBuffer(buffer, length);
+		count -= length;
+	}
+	return error;
+}
+
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief Sets the display window
@@ -220,35 +264,6 @@ static void SIF_SSD1681_Reset(void)
 	WAIT_ms(50); // Originally WAIT_ms(200)
 }
 
-/******************************************************************************/
-/***************************************************************************/ /**
- * \brief This function replaces the appropriate bits of the image with the bits
- *        of the QR code based on the specified x and y coordinates.
- *******************************************************************************
- * \param qrcode - The array containing the QR code data.
- * \param image  - The image array that will be modified.
- * \param scale  - The image scaling, currently supported 1 & 2.
- * \param x_pos  - The x-coordinate of the top-left corner of the QR symbol.
- * \param y_pos  - The y-coordinate of the top-left corner of the QR symbol.
- *******************************************************************************
- ******************************************************************************/
-static void SIF_SSD1681_embed_qr(const uint8_t *qrcode, uint8_t *image, uint8_t scale, uint8_t x_pos, uint8_t y_pos)
-{
-	int size        = qrcodegen_getSize(qrcode);
-	int size_scaled = size * scale;
-
-	for (int y = y_pos; y < y_pos + size_scaled; y++)
-	{
-		for (int x = x_pos; x < x_pos + size_scaled; x++)
-		{
-			if (!qrcodegen_getModule(qrcode, (x - x_pos) / scale, (y - y_pos) / scale))
-				image[(x + (y * SIF_SSD1681_WIDTH)) / 8] |= (1 << (7 - (x % 8)));
-			else
-				image[(x + (y * SIF_SSD1681_WIDTH)) / 8] &= ~(1 << (7 - (x % 8)));
-		}
-	}
-}
-
 /******************************************************************************/
 /***************************************************************************/ /**
  * \brief This function sets the Lookup table (LUT) register in the display
@@ -264,11 +279,9 @@ static ca_error SIF_SSD1681_SetLut(SIF_SSD1681_Update_Mode mode)
 	SIF_SSD1681_SendCommand(WRITE_LUT_REGISTER);
 	if (mode == FULL_UPDATE)
 	{
-		for (u8_t i = 0; i < 153; ++i)
-		{
-			SIF_SSD1681_SendData(SIF_SSD1681_lut_full_update[i]);
-		}
-		err = SIF_SSD1681_WaitUntilIdle();
+		err = SIF_SSD1681_SendDataBuffer(SIF_SSD1681_lut_full_update, 153);
+		if (!err)
+			err = SIF_SSD1681_WaitUntilIdle();
 		if (err)
 			return err;
 		SIF_SSD1681_SendCommand(0x3f);
@@ -287,11 +300,9 @@ static ca_error SIF_SSD1681_SetLut(SIF_SSD1681_Update_Mode mode)
 	}
 	else if (mode == PARTIAL_UPDATE)
 	{
-		for (u8_t i = 0; i < 153; ++i)
-		{
-			SIF_SSD1681_SendData(SIF_SSD1681_lut_partial_update[i]);
-		}
-		err = SIF_SSD1681_WaitUntilIdle();
+		err = SIF_SSD1681_SendDataBuffer(SIF_SSD1681_lut_partial_update, 153);
+		if (!err)
+			err = SIF_SSD1681_WaitUntilIdle();
 		if (err)
 			return err;
 		SIF_SSD1681_SendCommand(0x3f);
@@ -373,55 +384,52 @@ static void SIF_SSD1681_Transform(uint8_t input_byte, uint8_t output_buf[2])
 
 /******************************************************************************/
 /***************************************************************************/ /**
- * \brief Actually copies the image into the eink's RAM.
- * Half resolution.
+ * \brief Sends lines of a half resolution image. Every line is transformed once
+ * and sent twice, as a single transaction. The RAM window must match the bytes
+ * being written, so that the address counter wraps around to the next line.
  *******************************************************************************
  * \param[in] image - The image that is to be copied.
+ * \param x0 - First byte of each line to send
+ * \param x1 - Last byte of each line to send
+ * \param ymin - First line to send
+ * \param ymax - Last line to send
  *******************************************************************************
  ******************************************************************************/
-static void SIF_SSD1681_DisplayHalfRes(const uint8_t *image)
+static ca_error SIF_SSD1681_SendHalfResLines(const uint8_t *image, u16_t x0, u16_t x1, u16_t ymin, u16_t ymax)
 {
-	u16_t width  = (SIF_SSD1681_WIDTH % 8 == 0) ? (SIF_SSD1681_WIDTH / 8) : (SIF_SSD1681_WIDTH / 8 + 1);
-	u16_t height = SIF_SSD1681_HEIGHT;
-
-	u64_t address  = 0;
-	u16_t offset_y = 0;
-
-	u8_t transformation_result[2] = {0x00};
+	ca_error error  = CA_ERROR_SUCCESS;
+	u16_t    width  = (SIF_SSD1681_WIDTH % 8 == 0) ? (SIF_SSD1681_WIDTH / 8) : (SIF_SSD1681_WIDTH / 8 + 1);
+	u16_t    length = (x1 - x0 + 1) * 2;
+	u8_t     line[4 * (SIF_SSD1681_WIDTH / 8 + 1)];
 
-	//BSP_ModuleSetGPIOPin(SIF_SSD1681_CS_PIN, 0);
-
-	for (u16_t j = 0; j < height; ++j)
+	for (u16_t j = ymin; j <= ymax && !error; j++)
 	{
-		// Write jth line of image to the next line in eink RAM.
-		SIF_SSD1681_SetCursor(0, j + offset_y);
-		SIF_SSD1681_SendCommand(WRITE_RAM);
-		for (u16_t i = 0; i < width; i++)
-		{
-			address = i + j * width;
-
-			// Generates two bytes from ith byte in image
-			SIF_SSD1681_Transform(image[address], transformation_result);
-
-			// Writes those two generated bytes to eink RAM.
-			SIF_SSD1681_SendData(transformation_result[0]);
-			SIF_SSD1681_SendData(transformation_result[1]);
-		}
-
-		// Write the same jth line of image to the next line in eink RAM.
-		SIF_SSD1681_SetCursor(0, j + (++offset_y));
-		SIF_SSD1681_SendCommand(WRITE_RAM);
-		for (u16_t i = 0; i < width; i++)
-		{
-			address = i + j * width;
-			SIF_SSD1681_Transform(image[address], transformation_result);
+		// Generates two bytes from each byte of the line
+		for (u16_t i = x0; i <= x1; i++) SIF_SSD1681_Transform(image[i + j * width], &line[(i - x0) * 2]);
 
-			SIF_SSD1681_SendData(transformation_result[0]);
-			SIF_SSD1681_SendData(transformation_result[1]);
-		}
+		// The same line is written to the next line in eink RAM too.
+		memcpy(line + length, line, length);
+		error = SIF_SSD1681_SendDataBuffer(line, 2 * length);
 	}
+	return error;
+}
 
-	//BSP_ModuleSetGPIOPin(SIF_SSD1681_CS_PIN, 1);
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Actually copies the image into the eink's RAM.
+ * Half resolution. The RAM window must be set to SIF_SSD1681_WIDTH_WINDOW.
+ *******************************************************************************
+ * \param[in] image - The image that is to be copied.
+ *******************************************************************************
+ ******************************************************************************/
+static ca_error SIF_SSD1681_DisplayHalfRes(const uint8_t *image)
+{
+	u16_t width  = (SIF_SSD1681_WIDTH % 8 == 0) ? (SIF_SSD1681_WIDTH / 8) : (SIF_SSD1681_WIDTH / 8 + 1);
+	u16_t height = SIF_SSD1681_HEIGHT;
+
+	SIF_SSD1681_SetCursor(0, 0);
+	SIF_SSD1681_SendCommand(WRITE_RAM);
+	return SIF_SSD1681_SendHalfResLines(image, 0, width - 1, 0, height - 1);
 }
 
 /******************************************************************************/
@@ -430,36 +438,33 @@ static void SIF_SSD1681_DisplayHalfRes(const uint8_t *image)
  * resolution.
  *******************************************************************************
  ******************************************************************************/
-static void SIF_SSD1681_ClearRightEdge(void)
+static ca_error SIF_SSD1681_ClearRightEdge(void)
 {
+	ca_error error = CA_ERROR_SUCCESS;
+
 #define SIF_SSD1681_RIGHT_EDGE_WIDTH (SIF_SSD1681_WIDTH_PHYSICAL - SIF_SSD1681_WIDTH_WINDOW)
 #define SIF_SSD1681_RIGHT_EDGE_HEIGHT (SIF_SSD1681_HEIGHT_PHYSICAL)
 	u16_t width  = (SIF_SSD1681_RIGHT_EDGE_WIDTH % 8 == 0) ? (SIF_SSD1681_RIGHT_EDGE_WIDTH / 8)
 	                                                       : (SIF_SSD1681_RIGHT_EDGE_WIDTH / 8 + 1);
 	u16_t height = SIF_SSD1681_RIGHT_EDGE_HEIGHT;
 
-	for (int j = 0; j < height; j++)
+	for (int j = 0; j < height && !error; j++)
 	{
 		SIF_SSD1681_SetCursor(SIF_SSD1681_WIDTH_WINDOW, j);
 		SIF_SSD1681_SendCommand(WRITE_RAM);
-		for (int i = 0; i < width; i++)
-		{
-			SIF_SSD1681_SendData(0xff);
-		}
+		error = SIF_SSD1681_SendRepeatedData(0xff, width);
 	}
 
-	for (int j = 0; j < height; j++)
+	for (int j = 0; j < height && !error; j++)
 	{
 		SIF_SSD1681_SetCursor(SIF_SSD1681_WIDTH_WINDOW, j);
 		SIF_SSD1681_SendCommand(WRITE_RAM_RED);
-		for (int i = 0; i < width; i++)
-		{
-			SIF_SSD1681_SendData(0xff);
-		}
+		error = SIF_SSD1681_SendRepeatedData(0xff, width);
 	}
 
 #undef SIF_SSD1681_RIGHT_EDGE_WIDTH
 #undef SIF_SSD1681_RIGHT_EDGE_HEIGHT
+	return error;
 }
 
 /******************************************************************************/
@@ -468,36 +473,33 @@ static void SIF_SSD1681_ClearRightEdge(void)
  * resolution.
  *******************************************************************************
  ******************************************************************************/
-static void SIF_SSD1681_ClearBottomEdge(void)
+static ca_error SIF_SSD1681_ClearBottomEdge(void)
 {
+	ca_error error = CA_ERROR_SUCCESS;
+
 #define SIF_SSD1681_BOTTOM_EDGE_WIDTH (SIF_SSD1681_WIDTH_PHYSICAL)
 #define SIF_SSD1681_BOTTOM_EDGE_HEIGHT (SIF_SSD1681_HEIGHT_PHYSICAL - SIF_SSD1681_WIDTH_WINDOW)
 	u16_t width  = (SIF_SSD1681_BOTTOM_EDGE_WIDTH % 8 == 0) ? (SIF_SSD1681_BOTTOM_EDGE_WIDTH / 8)
 	                                                        : (SIF_SSD1681_BOTTOM_EDGE_WIDTH / 8 + 1);
 	u16_t height = SIF_SSD1681_BOTTOM_EDGE_HEIGHT;
 
-	for (int j = 0; j < height; j++)
+	for (int j = 0; j < height && !error; j++)
 	{
 		SIF_SSD1681_SetCursor(0, j + SIF_SSD1681_WIDTH_WINDOW);
 		SIF_SSD1681_SendCommand(WRITE_RAM);
-		for (int i = 0; i < width; i++)
-		{
-			SIF_SSD1681_SendData(0xff);
-		}
+		error = SIF_SSD1681_SendRepeatedData(0xff, width);
 	}
 
-	for (int j = 0; j < height; j++)
+	for (int j = 0; j < height && !error; j++)
 	{
 		SIF_SSD1681_SetCursor(0, j + SIF_SSD1681_WIDTH_WINDOW);
 		SIF_SSD1681_SendCommand(WRITE_RAM_RED);
-		for (int i = 0; i < width; i++)
-		{
-			SIF_SSD1681_SendData(0xff);
-		}
+		error = SIF_SSD1681_SendRepeatedData(0xff, width);
 	}
 
 #undef SIF_SSD1681_BOTTOM_EDGE_WIDTH
 #undef SIF_SSD1681_BOTTOM_EDGE_HEIGHT
+	return error;
 }
 #endif // EPAPER_FULL_RESOLUTION
 
@@ -508,27 +510,15 @@ static void SIF_SSD1681_ClearBottomEdge(void)
  * \param[in] image - The image that is to be copied.
  *******************************************************************************
  ******************************************************************************/
-static void SIF_SSD1681_DisplayFullRes(const uint8_t *image)
+static ca_error SIF_SSD1681_DisplayFullRes(const uint8_t *image)
 {
 	u16_t width, height;
 	width =
 	    (SIF_SSD1681_WIDTH_PHYSICAL % 8 == 0) ? (SIF_SSD1681_WIDTH_PHYSICAL / 8) : (SIF_SSD1681_WIDTH_PHYSICAL / 8 + 1);
 	height = SIF_SSD1681_HEIGHT_PHYSICAL;
 
-	u64_t address = 0;
-
-	//BSP_ModuleSetGPIOPin(SIF_SSD1681_CS_PIN, 0);
-
-	for (u16_t j = 0; j < height; j++)
-	{
-		for (u16_t i = 0; i < width; i++)
-		{
-			address = i + j * width;
-			SIF_SSD1681_SendData(image[address]);
-		}
-	}
-
-	//BSP_ModuleSetGPIOPin(SIF_SSD1681_CS_PIN, 1);
+	// The whole frame is contiguous, so it can be sent in one transaction
+	return SIF_SSD1681_SendDataBuffer(image, width * height);
 }
 
 static ca_error SIF_SSD1681_WakeUpAndSetConfig(void)
@@ -642,9 +632,10 @@ void SIF_SSD1681_Deinitialise(void)
 	    SIF_SSD1681_BUSY_PIN, MODULE_PIN_PULLUP_ON, MODULE_PIN_DEBOUNCE_ON, MODULE_PIN_IRQ_OFF, NULL});
 }
 
-void SIF_SSD1681_ClearDisplay()
+ca_error SIF_SSD1681_ClearDisplay()
 {
-	u16_t width, height;
+	ca_error error;
+	u16_t    width, height;
 	width =
 	    (SIF_SSD1681_WIDTH_PHYSICAL % 8 == 0) ? (SIF_SSD1681_WIDTH_PHYSICAL / 8) : (SIF_SSD1681_WIDTH_PHYSICAL / 8 + 1);
 	height = SIF_SSD1681_HEIGHT_PHYSICAL;
@@ -655,34 +646,28 @@ void SIF_SSD1681_ClearDisplay()
 	SIF_SSD1681_SetWindow(0, SIF_SSD1681_WIDTH_PHYSICAL - 1, 0, SIF_SSD1681_HEIGHT_PHYSICAL - 1);
 
 	SIF_SSD1681_SendCommand(WRITE_RAM);
-	for (int j = 0; j < height; j++)
+	error = SIF_SSD1681_SendRepeatedData(0xff, width * height);
+	if (!error)
 	{
-		for (int i = 0; i < width; i++)
-		{
-			SIF_SSD1681_SendData(0xff);
-		}
-	}
-	SIF_SSD1681_SendCommand(WRITE_RAM_RED);
-	for (int j = 0; j < height; j++)
-	{
-		for (int i = 0; i < width; i++)
-		{
-			SIF_SSD1681_SendData(0xff);
-		}
+		SIF_SSD1681_SendCommand(WRITE_RAM_RED);
+		error = SIF_SSD1681_SendRepeatedData(0xff, width * height);
 	}
 	// Set window resolution back to what it was.
 	SIF_SSD1681_SetWindow(0, SIF_SSD1681_WIDTH_WINDOW - 1, 0, SIF_SSD1681_HEIGHT_WINDOW - 1);
 
-	SIF_SSD1681_TurnOnDisplay(FULL_UPDATE);
+	if (!error)
+		SIF_SSD1681_TurnOnDisplay(FULL_UPDATE);
 
 	//BSP_ModuleSetGPIOPin(SIF_SSD1681_CS_PIN, 0);
+	return error;
 }
 
-void SIF_SSD1681_StrongClearDisplay(void)
+ca_error SIF_SSD1681_StrongClearDisplay(void)
 {
-	SIF_SSD1681_ClearDisplay();
-	SIF_SSD1681_ClearDisplay();
-	SIF_SSD1681_ClearDisplay();
+	ca_error error = SIF_SSD1681_ClearDisplay();
+
+	for (int i = 1; i < 3 && !error; i++) error = SIF_SSD1681_ClearDisplay();
+	return error;
 }
 
 void SIF_SSD1681_DeepSleep(void)
@@ -696,23 +681,18 @@ void SIF_SSD1681_DeepSleep(void)
 
 ca_error SIF_SSD1681_overlay_qr_code(const char *text, uint8_t *image, uint8_t scale, uint8_t x, uint8_t y)
 {
-	enum qrcodegen_Ecc errCorLvl = qrcodegen_Ecc_LOW; // Error correction level
-
-	// Make the QR Code symbol
-	uint8_t qrcode[qrcodegen_BUFFER_LEN_FOR_VERSION(10)];
-	uint8_t tempBuffer[qrcodegen_BUFFER_LEN_FOR_VERSION(10)];
-	bool    success = qrcodegen_encodeText(
-        text, tempBuffer, qrcode, errCorLvl, qrcodegen_VERSION_MIN, qrcodegen_VERSION_MAX, qrcodegen_Mask_AUTO, true);
-	if (success)
-	{
-		SIF_SSD1681_embed_qr(qrcode, image, scale, x, y);
-		return CA_ERROR_SUCCESS;
-	}
-	return CA_ERROR_FAIL;
+	const uint8_t *qrcode;
+	ca_error       status = SIF_QR_Encode(text, &qrcode);
+
+	if (status)
+		return status;
+	return SIF_QR_Embed(qrcode, image, SIF_SSD1681_WIDTH, SIF_SSD1681_HEIGHT, scale, x, y);
 }
 
-void SIF_SSD1681_SetFrameMemory(const uint8_t *image, bool full_resolution)
+ca_error SIF_SSD1681_SetFrameMemory(const uint8_t *image, bool full_resolution)
 {
+	ca_error error;
+
 #ifdef EPAPER_FULL_RESOLUTION
 	(void)full_resolution;
 #endif
@@ -735,24 +715,39 @@ void SIF_SSD1681_SetFrameMemory(const uint8_t *image, bool full_resolution)
 #ifndef EPAPER_FULL_RESOLUTION
 	if (!full_resolution)
 	{
-		SIF_SSD1681_DisplayHalfRes(image);
-		SIF_SSD1681_ClearBottomEdge();
-		SIF_SSD1681_ClearRightEdge();
+		error = SIF_SSD1681_DisplayHalfRes(image);
+		if (!error)
+			error = SIF_SSD1681_ClearBottomEdge();
+		if (!error)
+			error = SIF_SSD1681_ClearRightEdge();
 	}
 	else
 #endif
 	{
-		SIF_SSD1681_DisplayFullRes(image);
+		error = SIF_SSD1681_DisplayFullRes(image);
 	}
 
-	SIF_SSD1681_TurnOnDisplay(FULL_UPDATE);
+	if (!error)
+		SIF_SSD1681_TurnOnDisplay(FULL_UPDATE);
+	return error;
 }
 
-void SIF_SSD1681_SetFrameMemoryPartial(const uint8_t *image)
+/******************************************************************************/
+/***************************************************************************/ /**
+ * \brief Resets the panel and configures it for a partial update.
+ *******************************************************************************
+ * \return Status of the LUT transfer
+ *******************************************************************************
+ ******************************************************************************/
+static ca_error SIF_SSD1681_PreparePartial(void)
 {
+	ca_error error;
+
 	SIF_SSD1681_Reset();
 
-	SIF_SSD1681_SetLut(PARTIAL_UPDATE);
+	error = SIF_SSD1681_SetLut(PARTIAL_UPDATE);
+	if (error)
+		return error;
 	SIF_SSD1681_SendCommand(0x37);
 	SIF_SSD1681_SendData(0x00);
 	SIF_SSD1681_SendData(0x00);
@@ -772,16 +767,62 @@ void SIF_SSD1681_SetFrameMemoryPartial(const uint8_t *image)
 	SIF_SSD1681_SendData(0xc0);
 	SIF_SSD1681_SendCommand(0x20);
 	SIF_SSD1681_WaitUntilIdle();
+	return CA_ERROR_SUCCESS;
+}
+
+ca_error SIF_SSD1681_SetFrameMemoryPartial(const uint8_t *image)
+{
+	ca_error error = SIF_SSD1681_PreparePartial();
+
+	if (error)
+		return error;
 
 	SIF_SSD1681_SetWindow(0, SIF_SSD1681_WIDTH_WINDOW - 1, 0, SIF_SSD1681_HEIGHT_WINDOW - 1);
 	SIF_SSD1681_SetCursor(0, 0);
 	SIF_SSD1681_SendCommand(WRITE_RAM);
 
 #ifdef EPAPER_FULL_RESOLUTION
-	SIF_SSD1681_DisplayFullRes(image);
+	return SIF_SSD1681_DisplayFullRes(image);
+#else
+	return SIF_SSD1681_DisplayHalfRes(image);
+#endif
+}
+
+ca_error SIF_SSD1681_SetFrameMemoryRegion(const uint8_t *image,
+                                         uint16_t       xmin,
+                                         uint16_t       ymin,
+                                         uint16_t       xmax,
+                                         uint16_t       ymax)
+{
+	ca_error error = SIF_SSD1681_PreparePartial();
+	u16_t    x0    = xmin / 8;
+	u16_t    x1    = xmax / 8;
+
+	if (error)
+		return error;
+
+	// The RAM window wraps the address counter around the region, so it can be
+	// written in one go, without setting the cursor for every line.
+#ifdef EPAPER_FULL_RESOLUTION
+	SIF_SSD1681_SetWindow(x0 * 8, (x1 * 8) + 7, ymin, ymax);
+	SIF_SSD1681_SetCursor(x0 * 8, ymin);
+#else
+	SIF_SSD1681_SetWindow(x0 * 16, (x1 * 16) + 15, ymin * 2, (ymax * 2) + 1);
+	SIF_SSD1681_SetCursor(x0 * 16, ymin * 2);
+#endif
+	SIF_SSD1681_SendCommand(WRITE_RAM);
+
+#ifdef EPAPER_FULL_RESOLUTION
+	u16_t width = (SIF_SSD1681_WIDTH % 8 == 0) ? (SIF_SSD1681_WIDTH / 8) : (SIF_SSD1681_WIDTH / 8 + 1);
+
+	for (u16_t j = ymin; j <= ymax && !error; j++)
+		error = SIF_SSD1681_SendDataBuffer(&image[x0 + j * width], x1 - x0 + 1);
 #else
-	SIF_SSD1681_DisplayHalfRes(image);
+	error = SIF_SSD1681_SendHalfResLines(image, x0, x1, ymin, ymax);
 #endif
+
+	SIF_SSD1681_SetWindow(0, SIF_SSD1681_WIDTH_WINDOW - 1, 0, SIF_SSD1681_HEIGHT_WINDOW - 1);
+	return error;
 }
 
 void SIF_SSD1681_DisplayFrame(void)
@@ -794,35 +835,25 @@ void SIF_SSD1681_DisplayPartFrame(void)
 	SIF_SSD1681_TurnOnDisplay(PARTIAL_UPDATE);
 }
 
-void SIF_SSD1681_DisplayPartBaseImageWhite(void)
+ca_error SIF_SSD1681_DisplayPartBaseImageWhite(void)
 {
-	u16_t width =
+	ca_error error;
+	u16_t    width =
 	    (SIF_SSD1681_WIDTH_PHYSICAL % 8 == 0) ? (SIF_SSD1681_WIDTH_PHYSICAL / 8) : (SIF_SSD1681_WIDTH_PHYSICAL / 8 + 1);
 	u16_t height = SIF_SSD1681_HEIGHT_PHYSICAL;
 
-	int address = 0;
-
 	SIF_SSD1681_SetWindow(0, SIF_SSD1681_WIDTH_PHYSICAL - 1, 0, SIF_SSD1681_HEIGHT_PHYSICAL - 1);
 	SIF_SSD1681_SendCommand(WRITE_RAM);
-	for (int j = 0; j < height; j++)
-	{
-		for (int i = 0; i < width; i++)
-		{
-			address = i + j * width;
-			SIF_SSD1681_SendData(0xff);
-		}
-	}
+	error = SIF_SSD1681_SendRepeatedData(0xff, width * height);
 
-	SIF_SSD1681_SendCommand(WRITE_RAM_RED);
-	for (int j = 0; j < height; j++)
+	if (!error)
 	{
-		for (int i = 0; i < width; i++)
-		{
-			address = i + j * width;
-			SIF_SSD1681_SendData(0xff);
-		}
+		SIF_SSD1681_SendCommand(WRITE_RAM_RED);
+		error = SIF_SSD1681_SendRepeatedData(0xff, width * height);
 	}
 	SIF_SSD1681_SetWindow(0, SIF_SSD1681_WIDTH_WINDOW - 1, 0, SIF_SSD1681_HEIGHT_WINDOW - 1);
 
-	SIF_SSD1681_DisplayFrame();
+	if (!error)
+		SIF_SSD1681_DisplayFrame();
+	return error;
 }
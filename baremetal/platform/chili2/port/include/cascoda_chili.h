@@ -278,30 +278,23 @@ void CHILI_UARTFIFOWrite(u8_t *pBuffer, u32_t BufferSize);
 
 /******************************************************************************/
 /***************************************************************************/ /**
- * \brief Buffer FIFO Read
- *******************************************************************************
- * \param pBuffer - Pointer to Data Buffer
- * \param BufferSize - Max. Characters to Read
- *******************************************************************************
- * \return Number of Characters placed in Buffer
+ * \brief Start continuous UART reception into the receive ring, using DMA.
+ *        Must be called after CHILI_UARTInit().
  *******************************************************************************
  ******************************************************************************/
-u32_t CHILI_UARTFIFORead(u8_t *pBuffer, u32_t BufferSize);
+void CHILI_UARTDMARxStart(void);
 
 /******************************************************************************/
 /***************************************************************************/ /**
- * \brief Set up DMA for UART Read
+ * \brief Read received characters from the receive ring
  *******************************************************************************
  * \param pBuffer - Pointer to Data Buffer
  * \param BufferSize - Max. Characters to Read
  *******************************************************************************
+ * \return Number of Characters placed in Buffer
+ *******************************************************************************
  ******************************************************************************/
-void CHILI_UARTDMASetupRead(u8_t *pBuffer, u32_t BufferSize);
-
-/**
- * Cancel a configured DMA Read. Can be used if a DMA transaction times out.
- */
-void CHILI_UARTDMAReadCancel(void);
+u32_t CHILI_UARTRxRingRead(u8_t *pBuffer, u32_t BufferSize);
 
 /******************************************************************************/
 /***************************************************************************/ /**
@@ -371,6 +364,7 @@ void cascoda_isr_chili_init(void);
 
 #if defined(USE_UART)
 #define UART_FIFOSIZE 16
+#define UART_RX_RING_SIZE 1024 /* receive ring, must be even */
 #define UART_RX_DMA_CH 0
 #define UART_TX_DMA_CH 1
 #if (UART_CHANNEL == 0)
@@ -436,6 +430,7 @@ void cascoda_isr_chili_init(void);
 
 #define SPI_RX_DMA_CH 2
 #define SPI_TX_DMA_CH 3
+#define SENSORIF_SPI_TX_DMA_CH 4
 
 #ifdef __cplusplus
 }
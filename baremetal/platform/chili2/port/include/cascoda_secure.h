@@ -133,4 +133,7 @@ void CHILI_SPIDMAIRQHandler(void);
 /** Register the SPIComplete callback on trustzone (Compiles to nothing on non-tz) */
 void CHILI_RegisterSPIComplete(void (*callback)(void));
 
+/** Interrupt Handler for sensorif SPI DMA */
+void SENSORIF_SECURE_SPI_DMAIRQHandler(void);
+
 #endif
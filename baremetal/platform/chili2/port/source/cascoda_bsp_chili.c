@@ -263,14 +263,7 @@ void BSP_SerialWriteAll(u8_t *pBuffer, u32_t BufferSize)
 
 u32_t BSP_SerialRead(u8_t *pBuffer, u32_t BufferSize)
 {
-	u32_t numBytes = 0;
-	if (BufferSize > 1)
-		CHILI_UARTDMASetupRead(pBuffer, BufferSize);
-	else if (BufferSize == 0)
-		CHILI_UARTDMAReadCancel();
-	else
-		numBytes = CHILI_UARTFIFORead(pBuffer, BufferSize);
-	return (numBytes);
+	return CHILI_UARTRxRingRead(pBuffer, BufferSize);
 }
 
 void BSP_SerialWaitWhileBusy(void)
@@ -103,7 +103,10 @@ void CHILI_SystemReInit()
 #if defined(USE_UART)
 	/* requires re-initialisation to set correct baudrate */
 	if (CHILI_GetEnableCommsInterface())
+	{
 		CHILI_UARTInit();
+		CHILI_UARTDMARxStart();
+	}
 #endif /* USE_UART */
 
 	/* initialise timers */
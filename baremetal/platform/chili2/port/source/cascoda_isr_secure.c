@@ -203,6 +203,11 @@ void PDMA0_IRQHandler(void)
 		return;
 	}
 
+#if defined(USE_UART)
+	if (u32Status & (1 << (PDMA_INTSTS_REQTOF0_Pos + UART_RX_DMA_CH))) /* UART Rx Idle */
+		CHILI_UARTDMAIRQHandler();
+#endif /* USE_UART */
+
 	if (u32Status & PDMA_INTSTS_TDIF_Msk) /* Transfer Done */
 	{
 #if defined(USE_UART)
@@ -216,5 +221,7 @@ void PDMA0_IRQHandler(void)
 
 			CHILI_SPIDMAIRQHandler();
 		}
+		if (PDMA_GET_TD_STS(PDMA0) & (1 << SENSORIF_SPI_TX_DMA_CH))
+			SENSORIF_SECURE_SPI_DMAIRQHandler();
 	}
 }
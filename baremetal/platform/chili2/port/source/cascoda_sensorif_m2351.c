@@ -56,6 +56,9 @@
 
 #define MAX(x, y) ((x) > (y) ? (x) : (y))
 
+/* Buffers shorter than this are written through the FIFO, as it is quicker than setting up the DMA */
+#define SENSORIF_SPI_DMA_MIN_LENGTH 32
+
 /* M2351 I2C Interface Module used:
  * -------------------------------------------------------------------------
  * Number  Module   SDA     SCL		Module Configuration
@@ -85,6 +88,10 @@ static uint32_t SENSORIF_SPINUM;
 static SPI_T   *SENSORIF_SPIIF;
 static uint8_t  SPI_CHIP_SELECT;
 
+/* Asynchronous SPI write in progress, and the callback to call when it is complete */
+static volatile bool SENSORIF_SPI_TxBusy;
+static void (*SENSORIF_SPI_TxCallback)(void);
+
 static uint32_t SENSORIF_UARTNUM;
 static UART_T  *SENSORIF_UARTIF;
 static uint64_t SENSORIF_UART_MODULE;
@@ -114,6 +121,17 @@ static u8_t SENSORIF_SPI_PopByte(u8_t *InByte)
 	return 1;
 }
 
+/* Called by the secure side when a DMA write has been sent */
+static void SENSORIF_SPI_TxComplete(void)
+{
+	void (*callback)(void) = SENSORIF_SPI_TxCallback;
+
+	SENSORIF_SPI_TxCallback = NULL;
+	SENSORIF_SPI_TxBusy     = false;
+	if (callback)
+		callback();
+}
+
 #if !defined(USE_UART)
 static u8_t SENSORIF_UART_ReverseBits(u8_t input)
 {
@@ -156,6 +174,7 @@ void SENSORIF_I2C_Config(u32_t portnum)
 void SENSORIF_SPI_Config(u32_t portnum)
 {
 	SENSORIF_SECURE_SPI_Config(portnum);
+	SENSORIF_SECURE_RegisterSPIComplete(SENSORIF_SPI_TxComplete);
 	SENSORIF_SPINUM = portnum;
 	/* SPI module */
 	if (SENSORIF_SPINUM == 1)
@@ -332,6 +351,8 @@ enum sensorif_i2c_status SENSORIF_I2C_Read(u8_t slaveaddr, u8_t *pdata, u32_t *p
 
 ca_error SENSORIF_SPI_Write(u8_t out_data)
 {
+	if (SENSORIF_SPI_TxBusy)
+		return CA_ERROR_BUSY;
 	if (!SPI_GET_TX_FIFO_FULL_FLAG(SENSORIF_SPIIF))
 	{
 		SPI_WRITE_TX(SENSORIF_SPIIF, out_data);
@@ -342,6 +363,56 @@ ca_error SENSORIF_SPI_Write(u8_t out_data)
 	return CA_ERROR_FAIL;
 }
 
+ca_error SENSORIF_SPI_WriteBuffer(const u8_t *out_data, u32_t len)
+{
+	ca_error error;
+
+	/* Let any asynchronous write finish first */
+	while (SENSORIF_SPI_TxBusy)
+		;
+
+	if (len < SENSORIF_SPI_DMA_MIN_LENGTH)
+	{
+		/* Keep the FIFO full rather than waiting for it to drain after every byte */
+		for (u32_t i = 0; i < len; i++)
+		{
+			while (SPI_GET_TX_FIFO_FULL_FLAG(SENSORIF_SPIIF))
+				;
+			SPI_WRITE_TX(SENSORIF_SPIIF, out_data[i]);
+		}
+		while (SPI_IS_BUSY(SENSORIF_SPIIF))
+			;
+		return CA_ERROR_SUCCESS;
+	}
+
+	error = SENSORIF_SPI_WriteBufferAsync(out_data, len, NULL);
+
+	/* Sleep until the DMA transfer done interrupt */
+	while (error == CA_ERROR_SUCCESS && SENSORIF_SPI_TxBusy) __WFI();
+
+	return error;
+}
+
+ca_error SENSORIF_SPI_WriteBufferAsync(const u8_t *out_data, u32_t len, void (*callback)(void))
+{
+	ca_error error;
+
+	if (SENSORIF_SPI_TxBusy)
+		return CA_ERROR_BUSY;
+
+	SENSORIF_SPI_TxBusy     = true;
+	SENSORIF_SPI_TxCallback = callback;
+
+	error = SENSORIF_SECURE_SPI_WriteDMA(out_data, len);
+	if (error != CA_ERROR_SUCCESS)
+	{
+		SENSORIF_SPI_TxCallback = NULL;
+		SENSORIF_SPI_TxBusy     = false;
+	}
+
+	return error;
+}
+
 void SENSORIF_SPI_FULL_DUPLEX_RXONLY(u8_t *RxBuf, u8_t RxLen)
 {
 	for (u8_t i = 0; i < RxLen; i++)
@@ -1,8 +1,10 @@
 
+#include <arm_cmse.h>
 #include <stdio.h>
 /* Platform */
 #include "M2351.h"
 #include "i2c.h"
+#include "pdma.h"
 #include "spi.h"
 #include "sys.h"
 /* Cascoda */
@@ -11,6 +13,7 @@
 #include "cascoda-bm/cascoda_types.h"
 #include "cascoda_chili.h"
 #include "cascoda_chili_config.h"
+#include "cascoda_secure.h"
 
 #ifndef CASCODA_CHILI2_CONFIG
 #error CASCODA_CHILI2_CONFIG has to be defined! Please include the file "cascoda_chili_config.h"
@@ -22,6 +25,13 @@ static I2C_T*  SENSORIF_I2CIF_S;
 static uint8_t SENSORIF_SPINUM_S;
 static SPI_T*  SENSORIF_SPIIF_S;
 
+#if defined(__ARM_FEATURE_CMSE) && (__ARM_FEATURE_CMSE == 3L)
+typedef __NONSECURE_CALL void (*SENSORIF_SPI_Complete_t)(void);
+#else
+typedef void (*SENSORIF_SPI_Complete_t)(void);
+#endif
+static SENSORIF_SPI_Complete_t SENSORIF_SPI_Complete_callback_S;
+
 static uint8_t  SENSORIF_UARTNUM_S;
 static UART_T*  SENSORIF_UARTIF_S;
 static uint32_t SENSORIF_UART_MODULE_S;
@@ -427,6 +437,66 @@ __NONSECURE_ENTRY void SENSORIF_SPI_Deinit(void)
 		CLK_DisableModuleClock(SPI2_MODULE);
 }
 
+__NONSECURE_ENTRY ca_error SENSORIF_SECURE_SPI_WriteDMA(const u8_t* out_data, u32_t len)
+{
+	if (len == 0 || len > (PDMA_DSCT_CTL_TXCNT_Msk >> PDMA_DSCT_CTL_TXCNT_Pos) + 1)
+		return CA_ERROR_INVALID_ARGS;
+#if defined(__ARM_FEATURE_CMSE) && (__ARM_FEATURE_CMSE == 3L)
+	// Check that the pointer is actually nonsecure.
+	if (!cmse_check_address_range((void*)out_data, len, CMSE_NONSECURE))
+		return CA_ERROR_INVALID_ARGS;
+#endif
+	if (PDMA_IS_CH_BUSY(PDMA0, SENSORIF_SPI_TX_DMA_CH))
+		return CA_ERROR_BUSY;
+
+	/* Reset channel, and connect it to the Tx of the sensorif SPI module */
+	PDMA0->CHRST |= (1 << SENSORIF_SPI_TX_DMA_CH);
+	PDMA_SetTransferMode(PDMA0, SENSORIF_SPI_TX_DMA_CH, PDMA_SPI0_TX + (2 * SENSORIF_SPINUM_S), FALSE, 0);
+	/* Single requests of 8 bits, from the buffer to the fixed Tx register */
+	PDMA_SetBurstType(PDMA0, SENSORIF_SPI_TX_DMA_CH, PDMA_REQ_SINGLE, 0);
+	PDMA_SetTransferCnt(PDMA0, SENSORIF_SPI_TX_DMA_CH, PDMA_WIDTH_8, len);
+	PDMA_SetTransferAddr(PDMA0,
+	                     SENSORIF_SPI_TX_DMA_CH,
+	                     (uint32_t)out_data,
+	                     PDMA_SAR_INC,
+	                     (uint32_t)&SENSORIF_SPIIF_S->TX,
+	                     PDMA_DAR_FIX);
+	PDMA0->DSCT[SENSORIF_SPI_TX_DMA_CH].CTL |= PDMA_DSCT_CTL_TBINTDIS_Msk;
+
+	/* Enable channel and its transfer done interrupt, then let the SPI module request data */
+	PDMA0->CHCTL |= (1 << SENSORIF_SPI_TX_DMA_CH);
+	PDMA_EnableInt(PDMA0, SENSORIF_SPI_TX_DMA_CH, PDMA_INT_TRANS_DONE);
+	SPI_TRIGGER_TX_PDMA(SENSORIF_SPIIF_S);
+
+	return CA_ERROR_SUCCESS;
+}
+
+void SENSORIF_SECURE_SPI_DMAIRQHandler(void)
+{
+	PDMA_CLR_TD_FLAG(PDMA0, (1 << SENSORIF_SPI_TX_DMA_CH));
+	PDMA_DisableInt(PDMA0, SENSORIF_SPI_TX_DMA_CH, PDMA_INT_TRANS_DONE);
+	SPI_DISABLE_TX_PDMA(SENSORIF_SPIIF_S);
+
+	/* The DMA is done once the last byte is in the FIFO, wait for it to be shifted out */
+	while (SPI_IS_BUSY(SENSORIF_SPIIF_S))
+		;
+	/* Nothing is read back during a write */
+	if (!(SENSORIF_SPIIF_S->CTL & SPI_CTL_HALFDPX_Msk))
+		SPI_ClearRxFIFO(SENSORIF_SPIIF_S);
+
+	if (SENSORIF_SPI_Complete_callback_S)
+		SENSORIF_SPI_Complete_callback_S();
+}
+
+__NONSECURE_ENTRY void SENSORIF_SECURE_RegisterSPIComplete(void (*callback)(void))
+{
+#if defined(__ARM_FEATURE_CMSE) && (__ARM_FEATURE_CMSE == 3L)
+	SENSORIF_SPI_Complete_callback_S = (SENSORIF_SPI_Complete_t)cmse_nsfptr_create(callback);
+#else
+	SENSORIF_SPI_Complete_callback_S = callback;
+#endif
+}
+
 #if !defined(USE_UART)
 __NONSECURE_ENTRY void SENSORIF_UART_Init(void)
 {
@@ -33,6 +33,7 @@
 */
 /* System */
 #include <stdio.h>
+#include <string.h>
 /* Platform */
 #include "M2351.h"
 /* Cascoda */
@@ -49,6 +50,21 @@
 #if defined(USE_UART)
 
 #define UART_WAITTIMEOUT 50 /* wait while uart is busy timeout [ms] */
+#define UART_RX_RING_HALF (UART_RX_RING_SIZE / 2)
+#define UART_RX_IDLE_BITS 20 /* line idle time before received data is parsed [bit periods] */
+
+/*
+ * Received data is written by the PDMA into a circular buffer, using two scatter-gather descriptors that point at
+ * each other, one per half of the buffer. The completion of each half and a request timeout on the PDMA channel
+ * (idle line) call Serial_ReadInterface, which reads the buffer with CHILI_UARTRxRingRead. The request timeout is
+ * armed by the receive data interrupt at the start of each burst, so that an idle line doesn't interrupt.
+ * The descriptors only hold the low 16 bits of the next descriptor address, the high bits are in PDMA0->SCATBA, so
+ * both of them (32 bytes) are aligned to their size, to always sit in the same 64 KB window.
+ */
+static u8_t          sRxRing[UART_RX_RING_SIZE];                     //!< Receive ring, written by the PDMA
+static DSCT_T        sRxDescriptors[2] __attribute__((aligned(32))); //!< Scatter-gather descriptors of the halves
+static u32_t         sRxTail;                                        //!< Index of the next byte to read in sRxRing
+static volatile u8_t sRxHalf;                                        //!< Half of sRxRing being written by the PDMA
 
 void CHILI_UARTFIFOWrite(u8_t *pBuffer, u32_t BufferSize)
 {
@@ -78,61 +94,69 @@ void CHILI_UARTDMAWrite(u8_t *pBuffer, u32_t BufferSize)
 	UART->INTEN |= UART_INTEN_TXPDMAEN_Msk;
 }
 
-u32_t CHILI_UARTFIFORead(u8_t *pBuffer, u32_t BufferSize)
+void CHILI_UARTDMARxStart(void)
 {
-	u32_t numBytes = 0;
+	u32_t timeout = (UART_RX_IDLE_BITS * (SystemCoreClock >> 8)) / UART_BAUDRATE + 1;
 
-	/* Note that this is basically redefining the vendor BSP function UART_Read() */
-	/* which cannot read a previously unknown number of bytes. */
-
-	while ((!(UART->FIFOSTS & UART_FIFOSTS_RXEMPTY_Msk)) && (numBytes < BufferSize)) /* Rx FIFO empty ? */
+	/* Shared by all the channels of PDMA0, but the UART Rx channel is the only one using scatter-gather */
+	PDMA0->SCATBA = (uint32_t)sRxDescriptors & PDMA_SCATBA_SCATBA_Msk;
+	for (u8_t i = 0; i < 2; i++)
 	{
-		pBuffer[numBytes] = UART->DAT;
-		++numBytes;
+		sRxDescriptors[i].CTL = ((UART_RX_RING_HALF - 1) << PDMA_DSCT_CTL_TXCNT_Pos) | PDMA_WIDTH_8 | PDMA_SAR_FIX |
+		                        PDMA_DAR_INC | PDMA_REQ_SINGLE | PDMA_OP_SCATTER;
+		sRxDescriptors[i].SA   = (uint32_t)&UART->DAT;
+		sRxDescriptors[i].DA   = (uint32_t)(sRxRing + i * UART_RX_RING_HALF);
+		sRxDescriptors[i].NEXT = (uint32_t)&sRxDescriptors[!i] - PDMA0->SCATBA;
 	}
+	sRxTail = 0;
+	sRxHalf = 0;
 
-	return (numBytes);
+	PDMA_SetTransferMode(PDMA0, UART_RX_DMA_CH, PDMA_UART_RX, TRUE, (uint32_t)&sRxDescriptors[0]);
+	PDMA_CLR_TD_FLAG(PDMA0, (1 << UART_RX_DMA_CH));
+	PDMA_EnableInt(PDMA0, UART_RX_DMA_CH, PDMA_INT_TRANS_DONE);
+	/* Time-out clock is HCLK/2^8 */
+	PDMA0->TOUTPSC &= ~PDMA_TOUTPSC_TOUTPSC0_Msk;
+	PDMA_SetTimeOut(PDMA0, UART_RX_DMA_CH, FALSE, timeout > 0xFFFF ? 0xFFFF : timeout);
+	PDMA_EnableInt(PDMA0, UART_RX_DMA_CH, PDMA_INT_TIMEOUT);
+
+	/* Receive data interrupt only to detect the start of a burst, the PDMA empties the FIFO */
+	UART->INTEN |= UART_INTEN_RDAIEN_Msk | UART_INTEN_RXPDMAEN_Msk;
 }
 
-void CHILI_UARTDMASetupRead(u8_t *pBuffer, u32_t BufferSize)
+/**
+ * Index in sRxRing of the next byte that the PDMA will write
+ */
+static u32_t CHILI_UARTRxRingHead(void)
 {
-	/* Note: */
-	/* This needs to be fast, so BSP functions have been flattened out to direct register writes */
-	/* UART_RX_DMA_CHANNEL fixed to 0 */
+	/* Read before the completion flag: TXCNT is reloaded with the next descriptor when the half completes, so a count
+	 * read just after the completion would point back to the start of the half */
+	u32_t remaining = ((PDMA0->DSCT[UART_RX_DMA_CH].CTL & PDMA_DSCT_CTL_TXCNT_Msk) >> PDMA_DSCT_CTL_TXCNT_Pos) + 1;
 
-	/* Clear PDMA transfer done interrupt flag */
-	PDMA_CLR_TD_FLAG(PDMA0, (1 << UART_RX_DMA_CH));
+	/* A half completed since the last interrupt, even after the count was read, is read to its end, and the next half
+	 * after the interrupt */
+	if (PDMA_GET_TD_STS(PDMA0) & (1 << UART_RX_DMA_CH))
+		return ((sRxHalf + 1) * UART_RX_RING_HALF) % UART_RX_RING_SIZE;
 
-	/* Set request source; set basic mode. */
-	// PDMA_SetTransferMode(PDMA0, UART_RX_DMA_CH, PDMA_UART_RX, FALSE, 0);
-#if (UART_RX_DMA_CH < 4)
-	PDMA0->REQSEL0_3 = (PDMA0->REQSEL0_3 & ~(0x7F << 8 * UART_RX_DMA_CH)) | (PDMA_UART_RX << (8 * UART_RX_DMA_CH));
-#else
-	PDMA0->REQSEL4_7 =
-	    (PDMA0->REQSEL4_7 & ~(0x7F << 8 * (UART_RX_DMA_CH - 4))) | (PDMA_UART_RX << (8 * (UART_RX_DMA_CH - 4)));
-#endif
-	PDMA0->DSCT[UART_RX_DMA_CH].CTL = (PDMA0->DSCT[UART_RX_DMA_CH].CTL & ~PDMA_DSCT_CTL_OPMODE_Msk) | PDMA_OP_BASIC;
+	return (sRxHalf * UART_RX_RING_HALF) + UART_RX_RING_HALF - remaining;
+}
 
-	/* Set transfer width (8 bits) and transfer count */
-	// PDMA_SetTransferCnt(PDMA0, UART_RX_DMA_CH, PDMA_WIDTH_8, BufferSize);
-	PDMA0->DSCT[UART_RX_DMA_CH].CTL &= ~(PDMA_DSCT_CTL_TXCNT_Msk | PDMA_DSCT_CTL_TXWIDTH_Msk);
-	PDMA0->DSCT[UART_RX_DMA_CH].CTL |= (PDMA_WIDTH_8 | ((BufferSize - 1) << PDMA_DSCT_CTL_TXCNT_Pos));
+u32_t CHILI_UARTRxRingRead(u8_t *pBuffer, u32_t BufferSize)
+{
+	u32_t head     = CHILI_UARTRxRingHead();
+	u32_t numBytes = 0;
 
-	/* Set source/destination address and attributes */
-	// PDMA_SetTransferAddr(PDMA0, UART_RX_DMA_CH, (uint32_t)&UART->DAT, PDMA_SAR_FIX, (uint32_t)pBuffer, PDMA_DAR_INC);
-	PDMA0->DSCT[UART_RX_DMA_CH].SA = (uint32_t)&UART->DAT;
-	PDMA0->DSCT[UART_RX_DMA_CH].DA = (uint32_t)pBuffer;
-	PDMA0->DSCT[UART_RX_DMA_CH].CTL &= ~(PDMA_DSCT_CTL_SAINC_Msk | PDMA_DSCT_CTL_DAINC_Msk);
-	PDMA0->DSCT[UART_RX_DMA_CH].CTL |= (PDMA_SAR_FIX | PDMA_DAR_INC);
-
-	/* Interrupt switching, note that correct sequence is crucial */
-	/* Disable UART Rx interrupt */
-	UART->INTEN &= ~UART_INTEN_RDAIEN_Msk;
-	/* Enable PDMA Transfer Done Interrupt */
-	// PDMA_EnableInt(PDMA0, UART_RX_DMA_CH, PDMA_INT_TRANS_DONE);
-	PDMA0->INTEN |= (1 << UART_RX_DMA_CH);
-	/* Enable UART Rx PDMA function */
-	UART->INTEN |= UART_INTEN_RXPDMAEN_Msk;
+	while (numBytes < BufferSize && sRxTail != head)
+	{
+		u32_t count = ((head > sRxTail) ? head : UART_RX_RING_SIZE) - sRxTail;
+
+		if (count > BufferSize - numBytes)
+			count = BufferSize - numBytes;
+		memcpy(pBuffer + numBytes, sRxRing + sRxTail, count);
+		numBytes += count;
+		sRxTail = (sRxTail + count) % UART_RX_RING_SIZE;
+	}
+
+	return (numBytes);
 }
 
 void CHILI_UARTFIFOIRQHandler(void)
@@ -143,8 +167,12 @@ void CHILI_UARTFIFOIRQHandler(void)
 	/* line status - clear */
 	if (UART->INTSTS & UART_INTSTS_HWRLSIF_Msk)
 		UART->FIFOSTS = (UART_FIFOSTS_BIF_Msk | UART_FIFOSTS_FEF_Msk | UART_FIFOSTS_PEF_Msk);
-	/* receive data available  & not switched to DMA*/
-	while ((UART->INTSTS & UART_INTSTS_RDAINT_Msk) && (UART->INTEN & UART_INTEN_RDAIEN_Msk)) Serial_ReadInterface();
+	/* start of a burst: wait for the line to go idle */
+	if (UART->INTEN & UART_INTEN_RDAIEN_Msk)
+	{
+		UART->INTEN &= ~UART_INTEN_RDAIEN_Msk;
+		PDMA0->TOUTEN |= (1 << UART_RX_DMA_CH);
+	}
 }
 
 void CHILI_UARTDMAIRQHandler(void)
@@ -158,34 +186,29 @@ void CHILI_UARTDMAIRQHandler(void)
 		UART->INTEN &= ~UART_INTEN_TXPDMAEN_Msk;
 		PDMA_DisableInt(PDMA0, UART_TX_DMA_CH, PDMA_INT_TRANS_DONE);
 	}
-	/* UART Rx PDMA transfer done interrupt flag */
+	/* UART Rx PDMA half of the ring complete */
 	if (PDMA_GET_TD_STS(PDMA0) & (1 << UART_RX_DMA_CH))
 	{
-		/* Clear PDMA transfer done interrupt flag */
 		PDMA_CLR_TD_FLAG(PDMA0, (1 << UART_RX_DMA_CH));
-		/* Disable UART Rx PDMA function and enable UART Rx interrupt */
-		UART->INTEN &= ~UART_INTEN_RXPDMAEN_Msk;
+		sRxHalf = !sRxHalf;
+		Serial_ReadInterface();
+	}
+	/* UART Rx line idle */
+	if (PDMA_GET_INT_STATUS(PDMA0) & (1 << (PDMA_INTSTS_REQTOF0_Pos + UART_RX_DMA_CH)))
+	{
+		/* Disarm until the next burst */
+		PDMA0->TOUTEN &= ~(1 << UART_RX_DMA_CH);
+		PDMA_CLR_TMOUT_FLAG(PDMA0, UART_RX_DMA_CH);
 		UART->INTEN |= UART_INTEN_RDAIEN_Msk;
-		PDMA_DisableInt(PDMA0, UART_RX_DMA_CH, PDMA_INT_TRANS_DONE);
-		/* finish serial access */
-		SerialReadComplete();
+		Serial_ReadInterface();
 	}
 }
 
-void CHILI_UARTDMAReadCancel(void)
-{
-	PDMA_CLR_TD_FLAG(PDMA0, (1 << UART_RX_DMA_CH));
-	/* Disable UART Rx PDMA function and enable UART Rx interrupt */
-	UART->INTEN &= ~UART_INTEN_RXPDMAEN_Msk;
-	UART->INTEN |= UART_INTEN_RDAIEN_Msk;
-	PDMA_DisableInt(PDMA0, UART_RX_DMA_CH, PDMA_INT_TRANS_DONE);
-}
-
 void CHILI_UARTWaitWhileBusy(void)
 {
 	u32_t sttime = BSP_ReadAbsoluteTime();
-	/* check DMA */
-	while (PDMA_IS_CH_BUSY(PDMA0, UART_TX_DMA_CH) || PDMA_IS_CH_BUSY(PDMA0, UART_RX_DMA_CH))
+	/* check DMA, the Rx channel runs continuously */
+	while (PDMA_IS_CH_BUSY(PDMA0, UART_TX_DMA_CH))
 	{
 		if ((BSP_ReadAbsoluteTime() - sttime) > UART_WAITTIMEOUT)
 			return;
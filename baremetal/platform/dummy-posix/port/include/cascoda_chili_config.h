@@ -0,0 +1,9 @@
+/*
+ * Platform configuration of the dummy posix platform, which is only used for testing baremetal code on posix.
+ */
+#ifndef CASCODA_CHILI_CONFIG_H
+#define CASCODA_CHILI_CONFIG_H
+
+#define CASCODA_CHILI2_CONFIG 0
+
+#endif //CASCODA_CHILI_CONFIG_H
@@ -0,0 +1,78 @@
+/*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+//System
+/*
+ * Hooks of the dummy posix platform, for unit tests to control the simulated hardware.
+ */
+#ifndef CASCODA_DUMMY_H
+#define CASCODA_DUMMY_H
+
+#include "cascoda-bm/cascoda_types.h"
+#include "ca821x_error.h"
+
+/* number of simulated module pins */
+#define DUMMY_NUM_MODULE_PINS 32
+
+/**
+ * \brief FastForward time by the given amount
+ * \param ticks - Time in Ticks (1ms)
+ *
+ */
+void CHILI_FastForward(u32_t ticks);
+
+/**
+ * \brief Drive the external input of a simulated module pin, eg. a button
+ * The input is pulled high when not driven. If the level of the pin changes, and the
+ * pin was registered with an interrupt on that edge, its callback is called directly.
+ * \param mpin - module pin number
+ * \param val - level driven onto the pin
+ * \return status
+ *
+ */
+ca_error DUMMY_ModuleSetGPIOInput(u8_t mpin, u8_t val);
+
+/**
+ * \brief Receive data on the simulated UART, as the DMA of a real platform would
+ * The data is written to a receive ring, and Serial_ReadInterface() is called each
+ * time half of the ring has been written, and once the line goes idle at the end.
+ * \param data - received data
+ * \param len - length of the data
+ * \return status
+ * \retval CA_ERROR_NO_BUFFER Unread data was overwritten and lost
+ *
+ */
+ca_error DUMMY_SerialRxInject(const u8_t *data, u32_t len);
+
+/**
+ * \brief Capture the data written to the simulated UART
+ * \param hook - function called with the data of each BSP_SerialWriteAll(), or NULL
+ *
+ */
+void DUMMY_SerialSetTxHook(void (*hook)(const u8_t *data, u32_t len));
+
+#endif //CASCODA_DUMMY_H
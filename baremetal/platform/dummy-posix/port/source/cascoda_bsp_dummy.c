@@ -34,10 +34,12 @@
 #include "cascoda-bm/cascoda_evbme.h"
 #include "cascoda-bm/cascoda_interface.h"
 #include "cascoda-bm/cascoda_sensorif.h"
+#include "cascoda-bm/cascoda_serial.h"
 #include "cascoda-bm/cascoda_spi.h"
 #include "cascoda-bm/cascoda_types.h"
 #include "cascoda-util/cascoda_time.h"
 #include "ca821x_api.h"
+#include "cascoda_dummy.h"
 
 #define MAX(x, y) ((x) > (y) ? (x) : (y))
 
@@ -95,6 +97,11 @@ void BSP_DisableSerialIRQ(void)
 {
 }
 
+bool BSP_IsCommsInterfaceEnabled(void)
+{
+	return false;
+}
+
 #if defined(USE_USB)
 void BSP_USBSerialWrite(u8_t *pBuffer)
 {
@@ -113,9 +120,22 @@ void BSP_USBSerialRxDequeue(void)
 
 #if defined(USE_UART)
 
+/* Model of a DMA receive ring, see DUMMY_SerialRxInject */
+#define DUMMY_UART_RX_RING_SIZE 1024
+
+static u8_t  sUartRxRing[DUMMY_UART_RX_RING_SIZE];
+static u32_t sUartRxHead;
+static u32_t sUartRxTail;
+
+static void (*sUartTxHook)(const u8_t *data, u32_t len);
+
 void BSP_SerialWriteAll(u8_t *pBuffer, u32_t BufferSize)
 {
-	if (pBuffer[0] == 0)
+	if (sUartTxHook)
+	{
+		sUartTxHook(pBuffer, BufferSize);
+	}
+	else if (pBuffer[0] == 0)
 	{
 		//Only print EVBME messages
 		printf("%.*s, BufferSize, pBuffer");
@@ -124,7 +144,46 @@ void BSP_SerialWriteAll(u8_t *pBuffer, u32_t BufferSize)
 
 u32_t BSP_SerialRead(u8_t *pBuffer, u32_t BufferSize)
 {
-	return 0;
+	u32_t numBytes = 0;
+
+	while (numBytes < BufferSize && sUartRxTail != sUartRxHead)
+	{
+		u32_t count = ((sUartRxHead > sUartRxTail) ? sUartRxHead : DUMMY_UART_RX_RING_SIZE) - sUartRxTail;
+
+		if (count > BufferSize - numBytes)
+			count = BufferSize - numBytes;
+		memcpy(pBuffer + numBytes, sUartRxRing + sUartRxTail, count);
+		numBytes += count;
+		sUartRxTail = (sUartRxTail + count) % DUMMY_UART_RX_RING_SIZE;
+	}
+
+	return numBytes;
+}
+
+ca_error DUMMY_SerialRxInject(const u8_t *data, u32_t len)
+{
+	ca_error error = CA_ERROR_SUCCESS;
+
+	for (u32_t i = 0; i < len; i++)
+	{
+		sUartRxRing[sUartRxHead] = data[i];
+		sUartRxHead              = (sUartRxHead + 1) % DUMMY_UART_RX_RING_SIZE;
+		// Like the real DMA, this overwrites the unread data
+		if (sUartRxHead == sUartRxTail)
+			error = CA_ERROR_NO_BUFFER;
+		// Half transfer interrupt
+		if (sUartRxHead % (DUMMY_UART_RX_RING_SIZE / 2) == 0)
+			Serial_ReadInterface();
+	}
+	// Idle line interrupt
+	Serial_ReadInterface();
+
+	return error;
+}
+
+void DUMMY_SerialSetTxHook(void (*hook)(const u8_t *data, u32_t len))
+{
+	sUartTxHook = hook;
 }
 
 void BSP_SerialWaitWhileBusy(void)
@@ -221,49 +280,159 @@ void BSP_UseExternalClock(u8_t useExternalClock)
 {
 }
 
+/* Simulated module pin */
+struct dummy_pin
+{
+	u8_t registered; //!< Pin is registered
+	u8_t output;     //!< Pin drives its output latch
+	u8_t opendrain;  //!< Output only pulls low, shared with the input
+	u8_t latch;      //!< Output latch
+	u8_t driven_low; //!< Pin is pulled low externally, see DUMMY_ModuleSetGPIOInput()
+	u8_t irq;        //!< Edge(s) triggering the callback
+	int (*callback)(void);
+};
+
+static struct dummy_pin dummy_pins[DUMMY_NUM_MODULE_PINS];
+
+/* Level of a simulated pin, undriven inputs are pulled high */
+static u8_t dummy_pin_level(struct dummy_pin *pin)
+{
+	if (pin->output && !pin->opendrain)
+		return pin->latch;
+	if (pin->output && pin->latch == 0)
+		return 0;
+	return pin->driven_low ? 0 : 1;
+}
+
+/* Call the interrupt callback of a pin if its level has changed on an enabled edge */
+static void dummy_pin_edge(struct dummy_pin *pin, u8_t old_level)
+{
+	u8_t level = dummy_pin_level(pin);
+
+	if (!pin->registered || !pin->callback || level == old_level)
+		return;
+	if (pin->irq == MODULE_PIN_IRQ_BOTH || (pin->irq == MODULE_PIN_IRQ_FALL && level == 0) ||
+	    (pin->irq == MODULE_PIN_IRQ_RISE && level == 1))
+		pin->callback();
+}
+
+static struct dummy_pin *dummy_pin_get(u8_t mpin)
+{
+	if (mpin >= DUMMY_NUM_MODULE_PINS)
+		return NULL;
+	return &dummy_pins[mpin];
+}
+
+static ca_error dummy_pin_register(u8_t mpin, struct gpio_input_args *args, u8_t output, u8_t opendrain)
+{
+	struct dummy_pin *pin = dummy_pin_get(mpin);
+
+	if (!pin)
+		return CA_ERROR_INVALID_ARGS;
+	if (pin->registered)
+		return CA_ERROR_ALREADY;
+
+	pin->registered = 1;
+	pin->output     = output;
+	pin->opendrain  = opendrain;
+	pin->latch      = 1;
+	pin->irq        = args ? args->irq : MODULE_PIN_IRQ_OFF;
+	pin->callback   = args ? args->callback : NULL;
+
+	return CA_ERROR_SUCCESS;
+}
+
+ca_error DUMMY_ModuleSetGPIOInput(u8_t mpin, u8_t val)
+{
+	struct dummy_pin *pin = dummy_pin_get(mpin);
+	u8_t              old_level;
+
+	if (!pin)
+		return CA_ERROR_INVALID_ARGS;
+
+	old_level       = dummy_pin_level(pin);
+	pin->driven_low = val ? 0 : 1;
+	dummy_pin_edge(pin, old_level);
+
+	return CA_ERROR_SUCCESS;
+}
+
 ca_error BSP_ModuleRegisterGPIOInput(struct gpio_input_args *args)
 {
-	return CA_ERROR_NOT_HANDLED;
+	return dummy_pin_register(args->mpin, args, 0, 0);
 }
 
 ca_error BSP_ModuleRegisterGPIOOutput(u8_t mpin, module_pin_type isled)
 {
-	return CA_ERROR_NOT_HANDLED;
+	return dummy_pin_register(mpin, NULL, 1, 0);
 }
 
 ca_error BSP_ModuleRegisterGPIOOutputOD(u8_t mpin, module_pin_type isled)
 {
-	return CA_ERROR_NOT_HANDLED;
+	return dummy_pin_register(mpin, NULL, 1, 1);
 }
 
 ca_error BSP_ModuleRegisterGPIOSharedInputOutputOD(struct gpio_input_args *args, module_pin_type isled)
 {
-	return CA_ERROR_NOT_HANDLED;
+	return dummy_pin_register(args->mpin, args, 1, 1);
 }
 
 ca_error BSP_ModuleDeregisterGPIOPin(u8_t mpin)
 {
-	return CA_ERROR_NOT_HANDLED;
+	struct dummy_pin *pin = dummy_pin_get(mpin);
+
+	if (!pin || !pin->registered)
+		return CA_ERROR_INVALID_ARGS;
+
+	pin->registered = 0;
+	pin->output     = 0;
+	pin->callback   = NULL;
+
+	return CA_ERROR_SUCCESS;
 }
 
 u8_t BSP_ModuleIsGPIOPinRegistered(u8_t mpin)
 {
-	return CA_ERROR_NOT_HANDLED;
+	struct dummy_pin *pin = dummy_pin_get(mpin);
+
+	return pin ? pin->registered : 0;
 }
 
 ca_error BSP_ModuleSetGPIOPin(u8_t mpin, u8_t val)
 {
-	return CA_ERROR_NOT_HANDLED;
+	struct dummy_pin *pin = dummy_pin_get(mpin);
+	u8_t              old_level;
+
+	if (!pin || !pin->registered || !pin->output)
+		return CA_ERROR_INVALID_ARGS;
+
+	old_level  = dummy_pin_level(pin);
+	pin->latch = val ? 1 : 0;
+	dummy_pin_edge(pin, old_level);
+
+	return CA_ERROR_SUCCESS;
 }
 
 ca_error BSP_ModuleSenseGPIOPin(u8_t mpin, u8_t *val)
 {
-	return CA_ERROR_NOT_HANDLED;
+	struct dummy_pin *pin = dummy_pin_get(mpin);
+
+	if (!pin || !pin->registered)
+		return CA_ERROR_INVALID_ARGS;
+
+	*val = dummy_pin_level(pin);
+	return CA_ERROR_SUCCESS;
 }
 
 ca_error BSP_ModuleSenseGPIOPinOutput(u8_t mpin, u8_t *val)
 {
-	return CA_ERROR_NOT_HANDLED;
+	struct dummy_pin *pin = dummy_pin_get(mpin);
+
+	if (!pin || !pin->registered || !pin->output)
+		return CA_ERROR_INVALID_ARGS;
+
+	*val = pin->latch;
+	return CA_ERROR_SUCCESS;
 }
 
 ca_error BSP_ModuleSetGPIOOutputPermanent(u8_t mpin)
@@ -423,6 +592,25 @@ ca_error SENSORIF_SPI_Write(u8_t out_data)
 	return CA_ERROR_NOT_FOUND;
 }
 
+ca_error SENSORIF_SPI_WriteBuffer(const u8_t *out_data, u32_t len)
+{
+	ca_error error = CA_ERROR_SUCCESS;
+
+	for (u32_t i = 0; i < len && error == CA_ERROR_SUCCESS; i++) error = SENSORIF_SPI_Write(out_data[i]);
+
+	return error;
+}
+
+ca_error SENSORIF_SPI_WriteBufferAsync(const u8_t *out_data, u32_t len, void (*callback)(void))
+{
+	ca_error error = SENSORIF_SPI_WriteBuffer(out_data, len);
+
+	if (error == CA_ERROR_SUCCESS && callback)
+		callback();
+
+	return error;
+}
+
 void SENSORIF_SPI_Init(bool is_eink_display_present)
 {
 	(void)is_eink_display_present;
@@ -0,0 +1,179 @@
+/**
+ * @file
+ * @brief  Unit tests for the interrupt driven buttons, using the simulated GPIOs of the dummy platform
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+//cmocka must be after system headers
+#include <cmocka.h>
+
+#include "cascoda-bm/cascoda_interface.h"
+#include "cascoda-bm/cascoda_types.h"
+#include "cascoda-util/cascoda_tasklet.h"
+#include "cascoda-util/cascoda_time.h"
+#include "cascoda_btn.h"
+#include "cascoda_dummy.h"
+
+#define BTN_PIN 5
+#define SHARED_PIN 6
+
+static int shortPresses, longPresses, holds;
+
+static void shortPressCallback(void *context)
+{
+	shortPresses++;
+}
+
+static void longPressCallback(void *context)
+{
+	longPresses++;
+}
+
+static void holdCallback(void *context)
+{
+	holds++;
+}
+
+/* Run the main loop for a number of ms */
+static void run(uint32_t ms)
+{
+	while (ms--)
+	{
+		Btn_PollButtons();
+		TASKLET_Process();
+		CHILI_FastForward(1);
+	}
+	Btn_PollButtons();
+	TASKLET_Process();
+}
+
+/* Bounce the input a few times before it settles */
+static void bounce(u8_t mpin, u8_t val)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		DUMMY_ModuleSetGPIOInput(mpin, val);
+		CHILI_FastForward(1);
+		DUMMY_ModuleSetGPIOInput(mpin, !val);
+		CHILI_FastForward(1);
+	}
+	DUMMY_ModuleSetGPIOInput(mpin, val);
+}
+
+static bool isScheduled(void)
+{
+	uint32_t delta;
+
+	return TASKLET_GetTimeToNext(&delta) == CA_ERROR_SUCCESS;
+}
+
+static int setup(void **state)
+{
+	registeredPinMappings[0] = BTN_PIN;
+	registeredPinMappings[1] = SHARED_PIN;
+	Btn_IncrementGPIOWakeup();
+	Btn_RegisterButtonIRQInput(0);
+	Btn_IncrementGPIOWakeup();
+	Btn_RegisterSharedIRQButtonLED(1);
+	Btn_SetButtonShortPressCallback(0, shortPressCallback, NULL, BTN_SHORTPRESS_RELEASED);
+	Btn_SetButtonLongPressCallback(0, longPressCallback, NULL, 1000);
+	Btn_SetButtonHoldCallback(0, holdCallback, NULL, 200);
+	Btn_SetButtonShortPressCallback(1, shortPressCallback, NULL, BTN_SHORTPRESS_PRESSED);
+	return 0;
+}
+
+static int reset(void **state)
+{
+	shortPresses = 0;
+	longPresses  = 0;
+	holds        = 0;
+	return 0;
+}
+
+static void idle_test(void **state)
+{
+	run(100);
+	assert_false(isScheduled());
+	assert_true(Btn_CanSleep());
+}
+
+static void short_press_test(void **state)
+{
+	bounce(BTN_PIN, BTN_PRESSED);
+	assert_false(Btn_CanSleep());
+	run(100);
+	assert_false(Btn_CanSleep());
+	bounce(BTN_PIN, BTN_RELEASED);
+	run(BTN_DEBOUNCE_TIME - 1);
+	assert_int_equal(shortPresses, 0);
+	run(1);
+	assert_int_equal(shortPresses, 1);
+	assert_int_equal(longPresses, 0);
+	assert_int_equal(holds, 0);
+
+	run(1000);
+	assert_int_equal(shortPresses, 1);
+	assert_false(isScheduled());
+	assert_true(Btn_CanSleep());
+}
+
+static void long_press_test(void **state)
+{
+	DUMMY_ModuleSetGPIOInput(BTN_PIN, BTN_PRESSED);
+	run(1500);
+	/* holds are timed from the edge, not from the end of debouncing */
+	assert_int_equal(holds, 7);
+	DUMMY_ModuleSetGPIOInput(BTN_PIN, BTN_RELEASED);
+	run(100);
+	assert_int_equal(shortPresses, 0);
+	assert_int_equal(longPresses, 1);
+	assert_int_equal(holds, 7);
+	assert_false(isScheduled());
+}
+
+static void shared_led_test(void **state)
+{
+	u8_t led;
+
+	/* switching the LED is not a button press */
+	Btn_SetLED(1, LED_ON);
+	run(100);
+	assert_int_equal(shortPresses, 0);
+	assert_true(isScheduled());
+	Btn_SenseOutput(1, &led);
+	assert_int_equal(led, LED_ON);
+
+	/* while the LED is on, the button is sampled periodically */
+	DUMMY_ModuleSetGPIOInput(SHARED_PIN, BTN_PRESSED);
+	run(BTN_ACTIVE_SENSE_INTERVAL + BTN_SHARED_SENSE_DELAY);
+	assert_int_equal(shortPresses, 1);
+	DUMMY_ModuleSetGPIOInput(SHARED_PIN, BTN_RELEASED);
+	run(100);
+	Btn_SenseOutput(1, &led);
+	assert_int_equal(led, LED_ON);
+
+	Btn_SetLED(1, LED_OFF);
+	run(100);
+	assert_int_equal(shortPresses, 1);
+	assert_false(isScheduled());
+
+	/* with the LED off, the press interrupts */
+	DUMMY_ModuleSetGPIOInput(SHARED_PIN, BTN_PRESSED);
+	run(BTN_DEBOUNCE_TIME);
+	assert_int_equal(shortPresses, 2);
+	DUMMY_ModuleSetGPIOInput(SHARED_PIN, BTN_RELEASED);
+	run(100);
+	assert_false(isScheduled());
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+	    cmocka_unit_test_setup(idle_test, reset),
+	    cmocka_unit_test_setup(short_press_test, reset),
+	    cmocka_unit_test_setup(long_press_test, reset),
+	    cmocka_unit_test_setup(shared_led_test, reset),
+	};
+	return cmocka_run_group_tests(tests, setup, NULL);
+}
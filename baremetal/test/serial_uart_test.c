@@ -0,0 +1,216 @@
+/**
+ * @file
+ * @brief  Unit tests for the UART command framing, using the simulated DMA receive ring of the dummy platform
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+//cmocka must be after system headers
+#include <cmocka.h>
+
+#include "cascoda-bm/cascoda_serial.h"
+#include "cascoda-bm/cascoda_types.h"
+#include "cascoda_dummy.h"
+#include "evbme_messages.h"
+
+#define SERIAL_SOM 0xDE
+#define TEST_CMDID 0x42
+
+static int rxRdyCount, rxFailCount;
+
+static void txHook(const u8_t *data, u32_t len)
+{
+	if (len == 3 && data[0] == SERIAL_SOM && data[1] == EVBME_RXRDY)
+		rxRdyCount++;
+	if (len == 3 && data[0] == SERIAL_SOM && data[1] == EVBME_RXFAIL)
+		rxFailCount++;
+}
+
+/* Build a frame whose payload bytes are seq, seq + 1, ... */
+static u32_t makeFrame(u8_t *frame, u8_t len, u8_t seq)
+{
+	frame[0] = SERIAL_SOM;
+	frame[1] = TEST_CMDID;
+	frame[2] = len;
+	for (u8_t i = 0; i < len; i++) frame[3 + i] = seq + i;
+	return len + 3;
+}
+
+static void sendFrame(u8_t len, u8_t seq)
+{
+	u8_t frame[SERIAL_MAC_RX_LEN + 3];
+
+	assert_int_equal(DUMMY_SerialRxInject(frame, makeFrame(frame, len, seq)), CA_ERROR_SUCCESS);
+}
+
+/* Check that the next command is the frame, and mark it as dispatched */
+static void dispatchFrame(u8_t len, u8_t seq)
+{
+	assert_true(SerialGetCommand());
+	assert_int_equal(SerialRxBuffer.CmdId, TEST_CMDID);
+	assert_int_equal(SerialRxBuffer.CmdLen, len);
+	for (u8_t i = 0; i < len; i++) assert_int_equal(SerialRxBuffer.Data[i], (u8_t)(seq + i));
+	SerialRxPending = false;
+}
+
+static int setup(void **state)
+{
+	(void)state;
+	DUMMY_SerialSetTxHook(txHook);
+	return 0;
+}
+
+static int reset(void **state)
+{
+	(void)state;
+	while (SerialGetCommand()) SerialRxPending = false;
+	rxRdyCount  = 0;
+	rxFailCount = 0;
+	return 0;
+}
+
+/** Several commands received in one burst are all queued, and acknowledged straight away */
+static void burst_test(void **state)
+{
+	u8_t  burst[3 * (SERIAL_MAC_RX_LEN + 3)];
+	u32_t len = 0;
+	(void)state;
+
+	len += makeFrame(burst + len, 10, 1);
+	len += makeFrame(burst + len, 0, 0);
+	len += makeFrame(burst + len, SERIAL_MAC_RX_LEN, 3);
+	assert_int_equal(DUMMY_SerialRxInject(burst, len), CA_ERROR_SUCCESS);
+
+	dispatchFrame(10, 1);
+	assert_int_equal(rxRdyCount, 3);
+	dispatchFrame(0, 0);
+	dispatchFrame(SERIAL_MAC_RX_LEN, 3);
+	assert_false(SerialGetCommand());
+	assert_int_equal(rxFailCount, 0);
+}
+
+/** A command split across several receive interrupts is reassembled */
+static void split_test(void **state)
+{
+	u8_t  frame[SERIAL_MAC_RX_LEN + 3];
+	u32_t len = makeFrame(frame, 100, 7);
+	(void)state;
+
+	assert_int_equal(DUMMY_SerialRxInject(frame, 2), CA_ERROR_SUCCESS);
+	assert_false(SerialGetCommand());
+	assert_int_equal(DUMMY_SerialRxInject(frame + 2, 50), CA_ERROR_SUCCESS);
+	assert_false(SerialGetCommand());
+	assert_int_equal(DUMMY_SerialRxInject(frame + 52, len - 52), CA_ERROR_SUCCESS);
+	dispatchFrame(100, 7);
+	assert_int_equal(rxRdyCount, 1);
+}
+
+/** RX_RDY is held back while the queue is full, so the host stops sending */
+static void flow_control_test(void **state)
+{
+	(void)state;
+
+	/* The first command waits in SerialRxBuffer, the next ones fill the queue */
+	for (u8_t i = 0; i <= SERIAL_RX_QUEUE_LEN; i++)
+	{
+		sendFrame(20, i);
+		assert_true(SerialGetCommand());
+		assert_int_equal(rxRdyCount, (i < SERIAL_RX_QUEUE_LEN) ? i + 1 : i);
+	}
+
+	for (u8_t i = 0; i <= SERIAL_RX_QUEUE_LEN; i++) dispatchFrame(20, i);
+	assert_int_equal(rxRdyCount, SERIAL_RX_QUEUE_LEN + 1);
+
+	/* A host that doesn't wait for RX_RDY is asked to send the command that didn't fit again */
+	for (u8_t i = 0; i <= SERIAL_RX_QUEUE_LEN; i++) sendFrame(20, i);
+	assert_true(SerialGetCommand());
+	assert_int_equal(rxFailCount, 1);
+	for (u8_t i = 0; i < SERIAL_RX_QUEUE_LEN; i++) dispatchFrame(20, i);
+	assert_false(SerialGetCommand());
+}
+
+/** A command that doesn't complete is discarded, and the repeat is received */
+static void timeout_test(void **state)
+{
+	u8_t frame[SERIAL_MAC_RX_LEN + 3];
+	(void)state;
+
+	makeFrame(frame, 30, 9);
+	assert_int_equal(DUMMY_SerialRxInject(frame, 20), CA_ERROR_SUCCESS);
+	CHILI_FastForward(1000);
+	assert_false(SerialGetCommand());
+	assert_int_equal(rxFailCount, 1);
+
+	sendFrame(30, 9);
+	dispatchFrame(30, 9);
+	assert_int_equal(rxRdyCount, 1);
+}
+
+/** A command longer than the receive buffer is discarded with RX_FAIL, and the next command is received */
+static void oversized_test(void **state)
+{
+	u8_t frame[255 + 3];
+	(void)state;
+
+	frame[0] = SERIAL_SOM;
+	frame[1] = TEST_CMDID;
+	frame[2] = SERIAL_MAC_RX_LEN + 1;
+	memset(frame + 3, 0, SERIAL_MAC_RX_LEN + 1);
+	assert_int_equal(DUMMY_SerialRxInject(frame, SERIAL_MAC_RX_LEN + 4), CA_ERROR_SUCCESS);
+	assert_false(SerialGetCommand());
+	assert_int_equal(rxFailCount, 1);
+	assert_int_equal(rxRdyCount, 0);
+
+	sendFrame(40, 5);
+	dispatchFrame(40, 5);
+	assert_int_equal(rxRdyCount, 1);
+}
+
+/** Host side throughput of the framing, with commands received in bursts of three */
+static void throughput_test(void **state)
+{
+	const u32_t     numBursts = 20000;
+	u8_t            burst[3 * (SERIAL_MAC_RX_LEN + 3)];
+	u32_t           len = 0;
+	struct timespec start, end;
+	double          seconds;
+	(void)state;
+
+	for (u8_t i = 0; i < 3; i++) len += makeFrame(burst + len, SERIAL_MAC_RX_LEN, i);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (u32_t i = 0; i < numBursts; i++)
+	{
+		assert_int_equal(DUMMY_SerialRxInject(burst, len), CA_ERROR_SUCCESS);
+		for (u8_t j = 0; j < 3; j++)
+		{
+			assert_true(SerialGetCommand());
+			SerialRxPending = false;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	assert_int_equal(rxRdyCount, 3 * numBursts);
+	assert_int_equal(rxFailCount, 0);
+	seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	print_message("%u commands (%u bytes) framed in %.3f s, %.1f Mbit/s\n",
+	              3 * numBursts,
+	              len * numBursts,
+	              seconds,
+	              (len * numBursts * 8) / (seconds * 1e6));
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+	    cmocka_unit_test_setup(burst_test, reset),
+	    cmocka_unit_test_setup(split_test, reset),
+	    cmocka_unit_test_setup(flow_control_test, reset),
+	    cmocka_unit_test_setup(timeout_test, reset),
+	    cmocka_unit_test_setup(oversized_test, reset),
+	    cmocka_unit_test_setup(throughput_test, reset),
+	};
+	return cmocka_run_group_tests(tests, setup, NULL);
+}
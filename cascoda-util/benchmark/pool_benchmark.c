@@ -0,0 +1,520 @@
+/*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file
+ * Host benchmark for the pool allocator, replaying an allocation trace against the pool and against malloc.
+ *
+ * The trace is either a log captured from a device with POOLS_TRACE enabled in the ot-cli-lwm2m example, or a
+ * synthetic trace modelled on the wakaama client: long-lived objects, registration updates, notifications
+ * with their CoAP transactions, and short-lived URIs and strings. For each allocator, the replay reports the
+ * time per operation, the failed allocations, and for the pool the high water mark of each class.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cascoda-util/cascoda_pool.h"
+
+/** Default number of wakaama steps in the synthetic trace */
+#define DEFAULT_STEPS 200000
+/** Default number of times the trace is replayed to time it */
+#define DEFAULT_ITERATIONS 10
+/** Maximum length of a line of a captured trace */
+#define MAX_LINE 256
+
+/** One operation of a trace */
+struct trace_op
+{
+	uint32_t slot; //!< Index of the allocation, unique among the live allocations
+	uint32_t size; //!< Size of an allocation [bytes], 0 for a free
+};
+
+/** A trace, with its operations resolved to slots */
+struct trace
+{
+	struct trace_op *ops;
+	size_t           num_ops;
+	size_t           cap_ops;
+	uint32_t         num_slots; //!< Number of slots needed to replay the trace
+	uint32_t        *free_slots;
+	uint32_t         num_free_slots;
+};
+
+/** Same classes and counts as the wakaama pool of the ot-cli-lwm2m example */
+static POOL_STORAGE(sPool16, 16, 16);
+static POOL_STORAGE(sPool32, 32, 20);
+static POOL_STORAGE(sPool64, 64, 56);
+static POOL_STORAGE(sPool128, 128, 16);
+static POOL_STORAGE(sPool256, 256, 8);
+static POOL_STORAGE(sPool512, 512, 2);
+static POOL_STORAGE(sPool1024, 1024, 2);
+
+static ca_pool_class sClasses[] = {
+    POOL_CLASS(sPool16, 16, 16),
+    POOL_CLASS(sPool32, 32, 20),
+    POOL_CLASS(sPool64, 64, 56),
+    POOL_CLASS(sPool128, 128, 16),
+    POOL_CLASS(sPool256, 256, 8),
+    POOL_CLASS(sPool512, 512, 2),
+    POOL_CLASS(sPool1024, 1024, 2),
+};
+
+#define NUM_CLASSES (sizeof(sClasses) / sizeof(sClasses[0]))
+
+static ca_pool sPool;
+
+/* Trace building ----------------------------------------------------------- */
+
+static void addOp(struct trace *trace, uint32_t slot, uint32_t size)
+{
+	if (trace->num_ops == trace->cap_ops)
+	{
+		trace->cap_ops = trace->cap_ops ? trace->cap_ops * 2 : 1024;
+		trace->ops     = realloc(trace->ops, trace->cap_ops * sizeof(*trace->ops));
+		if (!trace->ops)
+		{
+			fprintf(stderr, "Out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	trace->ops[trace->num_ops].slot = slot;
+	trace->ops[trace->num_ops].size = size;
+	trace->num_ops++;
+}
+
+static uint32_t traceAlloc(struct trace *trace, uint32_t size)
+{
+	uint32_t slot;
+
+	if (trace->num_free_slots)
+	{
+		slot = trace->free_slots[--trace->num_free_slots];
+	}
+	else
+	{
+		slot              = trace->num_slots++;
+		trace->free_slots = realloc(trace->free_slots, trace->num_slots * sizeof(*trace->free_slots));
+		if (!trace->free_slots)
+		{
+			fprintf(stderr, "Out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	addOp(trace, slot, size ? size : 1);
+	return slot;
+}
+
+static void traceFree(struct trace *trace, uint32_t slot)
+{
+	addOp(trace, slot, 0);
+	trace->free_slots[trace->num_free_slots++] = slot;
+}
+
+/* Synthetic trace ---------------------------------------------------------- */
+
+/** An allocation of the synthetic trace, freed at a later step */
+struct pending_free
+{
+	uint32_t slot;
+	uint32_t step;
+};
+
+static uint32_t sRandState = 1;
+
+static uint32_t randRange(uint32_t min, uint32_t max)
+{
+	sRandState = sRandState * 1103515245 + 12345;
+	return min + (sRandState >> 8) % (max - min + 1);
+}
+
+static void allocFor(struct trace *trace, struct pending_free *pending, size_t *num_pending, uint32_t size,
+                     uint32_t free_step)
+{
+	pending[*num_pending].slot = traceAlloc(trace, size);
+	pending[*num_pending].step = free_step;
+	(*num_pending)++;
+}
+
+static void buildSyntheticTrace(struct trace *trace, uint32_t steps)
+{
+	struct pending_free pending[256];
+	size_t              num_pending = 0;
+
+	// Context, objects and instances, which live for the whole session
+	traceAlloc(trace, 180);
+	for (int i = 0; i < 24; i++) traceAlloc(trace, randRange(8, 56));
+
+	for (uint32_t step = 0; step < steps; step++)
+	{
+		// Registration update: payload, query, registration data and the CoAP transaction
+		if (step % 600 == 0)
+		{
+			uint32_t done = step + randRange(2, 20);
+
+			allocFor(trace, pending, &num_pending, randRange(120, 220), step);
+			allocFor(trace, pending, &num_pending, randRange(40, 64), step);
+			allocFor(trace, pending, &num_pending, 24, done);
+			allocFor(trace, pending, &num_pending, 64, done);
+			allocFor(trace, pending, &num_pending, randRange(140, 200), done);
+		}
+
+		// Notification of an observed resource, with its data array, transaction and packet buffer
+		if (randRange(0, 9) < 3)
+		{
+			uint32_t done = step + randRange(1, 8);
+
+			allocFor(trace, pending, &num_pending, 24 * randRange(1, 4), step);
+			allocFor(trace, pending, &num_pending, 64, done);
+			allocFor(trace, pending, &num_pending, randRange(40, 140), done);
+		}
+
+		// URIs and strings parsed from incoming messages
+		for (uint32_t i = randRange(0, 3); i > 0; i--)
+			allocFor(trace, pending, &num_pending, randRange(8, 100), step + randRange(0, 2));
+
+		// An observation created or cancelled now and then
+		if (randRange(0, 199) == 0)
+			allocFor(trace, pending, &num_pending, 48, step + randRange(100, 5000));
+
+		// Free everything that is due, keeping the list compact
+		for (size_t i = 0; i < num_pending;)
+		{
+			if (pending[i].step <= step || num_pending == sizeof(pending) / sizeof(pending[0]))
+			{
+				traceFree(trace, pending[i].slot);
+				pending[i] = pending[--num_pending];
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+}
+
+/* Captured trace ----------------------------------------------------------- */
+
+/** Map from a pointer of the captured trace to its slot */
+struct live_ptr
+{
+	unsigned long long ptr;
+	uint32_t           slot;
+};
+
+static int loadTrace(struct trace *trace, const char *path, const char *tag)
+{
+	char             line[MAX_LINE];
+	char             prefix[32];
+	struct live_ptr *live     = NULL;
+	size_t           num_live = 0;
+	FILE            *file     = fopen(path, "r");
+
+	if (!file)
+	{
+		perror(path);
+		return -1;
+	}
+
+	snprintf(prefix, sizeof(prefix), "%s: ", tag);
+	while (fgets(line, sizeof(line), file))
+	{
+		unsigned long long ptr;
+		unsigned           size;
+		char              *op = strstr(line, prefix);
+
+		if (!op)
+			continue;
+		op += strlen(prefix);
+
+		if (sscanf(op, "a %llx %u", &ptr, &size) == 2)
+		{
+			live = realloc(live, (num_live + 1) * sizeof(*live));
+			if (!live)
+				break;
+			live[num_live].ptr  = ptr;
+			live[num_live].slot = traceAlloc(trace, size);
+			num_live++;
+		}
+		else if (sscanf(op, "f %llx", &ptr) == 1)
+		{
+			// Allocations that failed on the device are logged as a null pointer, and were never freed
+			for (size_t i = num_live; i > 0; i--)
+			{
+				if (live[i - 1].ptr == ptr)
+				{
+					traceFree(trace, live[i - 1].slot);
+					live[i - 1] = live[--num_live];
+					break;
+				}
+			}
+		}
+	}
+
+	free(live);
+	fclose(file);
+	return 0;
+}
+
+/* Replay ------------------------------------------------------------------- */
+
+/** Results of replaying a trace with one allocator */
+struct replay_result
+{
+	double   ns_per_op;
+	uint32_t failures;
+	size_t   peak_bytes; //!< Highest sum of the requested sizes of the live allocations
+};
+
+static double nowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void replayPool(const struct trace *trace, void **slots, long iterations, struct replay_result *result)
+{
+	double start, elapsed = 0;
+
+	for (long n = 0; n < iterations; n++)
+	{
+		POOL_Init(&sPool, sClasses, sizeof(sClasses) / sizeof(sClasses[0]));
+		memset(slots, 0, trace->num_slots * sizeof(*slots));
+
+		start = nowNs();
+		for (size_t i = 0; i < trace->num_ops; i++)
+		{
+			const struct trace_op *op = &trace->ops[i];
+
+			if (op->size)
+				slots[op->slot] = POOL_Alloc(&sPool, op->size);
+			else
+				POOL_Free(&sPool, slots[op->slot]);
+		}
+		elapsed += nowNs() - start;
+	}
+
+	result->ns_per_op = elapsed / iterations / trace->num_ops;
+	result->failures  = sPool.failures;
+}
+
+static void replayMalloc(const struct trace *trace, void **slots, long iterations, struct replay_result *result)
+{
+	double start, elapsed = 0;
+
+	for (long n = 0; n < iterations; n++)
+	{
+		memset(slots, 0, trace->num_slots * sizeof(*slots));
+
+		start = nowNs();
+		for (size_t i = 0; i < trace->num_ops; i++)
+		{
+			const struct trace_op *op = &trace->ops[i];
+
+			if (op->size)
+			{
+				slots[op->slot] = malloc(op->size);
+			}
+			else
+			{
+				free(slots[op->slot]);
+				slots[op->slot] = NULL;
+			}
+		}
+		elapsed += nowNs() - start;
+
+		// Allocations still live at the end of the trace
+		for (uint32_t i = 0; i < trace->num_slots; i++) free(slots[i]);
+	}
+
+	result->ns_per_op = elapsed / iterations / trace->num_ops;
+	result->failures  = 0;
+}
+
+static size_t peakBytes(const struct trace *trace)
+{
+	uint32_t *sizes = calloc(trace->num_slots, sizeof(*sizes));
+	size_t    live = 0, peak = 0;
+
+	if (!sizes)
+		return 0;
+
+	for (size_t i = 0; i < trace->num_ops; i++)
+	{
+		const struct trace_op *op = &trace->ops[i];
+
+		if (op->size)
+		{
+			sizes[op->slot] = op->size;
+			live += op->size;
+			if (live > peak)
+				peak = live;
+		}
+		else
+		{
+			live -= sizes[op->slot];
+		}
+	}
+
+	free(sizes);
+	return peak;
+}
+
+/** Highest number of live allocations that the smallest class large enough for them would serve, for each class */
+static void peakPerClass(const struct trace *trace, uint32_t *peaks)
+{
+	uint8_t *classes           = calloc(trace->num_slots, sizeof(*classes));
+	uint32_t live[NUM_CLASSES] = {0};
+
+	memset(peaks, 0, NUM_CLASSES * sizeof(*peaks));
+	if (!classes)
+		return;
+
+	for (size_t i = 0; i < trace->num_ops; i++)
+	{
+		const struct trace_op *op = &trace->ops[i];
+		uint8_t                c  = 0;
+
+		if (!op->size)
+		{
+			if (classes[op->slot] < NUM_CLASSES)
+				live[classes[op->slot]]--;
+			continue;
+		}
+
+		while (c < NUM_CLASSES && op->size > sClasses[c].blockSize) c++;
+		classes[op->slot] = c;
+		if (c < NUM_CLASSES && ++live[c] > peaks[c])
+			peaks[c] = live[c];
+	}
+
+	free(classes);
+}
+
+static void printUsage(const char *exec_name)
+{
+	fprintf(stderr, "Usage: %s [-n ITERATIONS] [-s STEPS] [-t TAG] [TRACE]\n", exec_name);
+	fprintf(stderr, "\tReplay an allocation trace against the pool allocator and against malloc.\n\n");
+	fprintf(stderr, "\t-n ITERATIONS  Number of times the trace is replayed (default %d)\n", DEFAULT_ITERATIONS);
+	fprintf(stderr, "\t-s STEPS       Number of wakaama steps in the synthetic trace (default %d)\n", DEFAULT_STEPS);
+	fprintf(stderr, "\t-t TAG         Pool to replay from a captured trace, lwm2m or mbedtls (default lwm2m)\n");
+	fprintf(stderr, "\tTRACE          Log captured with POOLS_TRACE, instead of the synthetic trace\n");
+}
+
+int main(int argc, char *argv[])
+{
+	struct trace         trace      = {0};
+	struct replay_result pool       = {0};
+	struct replay_result heap       = {0};
+	long                 iterations = DEFAULT_ITERATIONS;
+	long                 steps      = DEFAULT_STEPS;
+	const char          *tag        = "lwm2m";
+	uint32_t             peaks[NUM_CLASSES];
+	void               **slots;
+	int                  opt;
+
+	while ((opt = getopt(argc, argv, "n:s:t:h")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n':
+			iterations = strtol(optarg, NULL, 0);
+			break;
+		case 's':
+			steps = strtol(optarg, NULL, 0);
+			break;
+		case 't':
+			tag = optarg;
+			break;
+		default:
+			printUsage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (iterations <= 0 || steps <= 0)
+	{
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (optind < argc)
+	{
+		if (loadTrace(&trace, argv[optind], tag))
+			return EXIT_FAILURE;
+	}
+	else
+	{
+		buildSyntheticTrace(&trace, (uint32_t)steps);
+	}
+
+	if (!trace.num_ops)
+	{
+		fprintf(stderr, "The trace is empty\n");
+		return EXIT_FAILURE;
+	}
+
+	slots = calloc(trace.num_slots, sizeof(*slots));
+	if (!slots)
+		return EXIT_FAILURE;
+
+	replayPool(&trace, slots, iterations, &pool);
+	replayMalloc(&trace, slots, iterations, &heap);
+
+	printf("%zu operations, %u allocations live at most, %zu bytes live at most\n\n",
+	       trace.num_ops,
+	       trace.num_slots,
+	       peakBytes(&trace));
+	printf("%-8s %8s %9s\n", "", "ns/op", "failures");
+	printf("%-8s %8.1f %9u\n", "pool", pool.ns_per_op, pool.failures);
+	printf("%-8s %8.1f %9u\n\n", "malloc", heap.ns_per_op, heap.failures);
+
+	// The peak is the number of blocks that a class needs for the trace to never spill out of it
+	peakPerClass(&trace, peaks);
+	printf("%6s %6s %10s %7s %6s\n", "block", "count", "high water", "spills", "peak");
+	for (size_t i = 0; i < sizeof(sClasses) / sizeof(sClasses[0]); i++)
+	{
+		printf("%6u %6u %10u %7u %6u\n",
+		       sClasses[i].blockSize,
+		       sClasses[i].blockCount,
+		       sClasses[i].stats.highWater,
+		       sClasses[i].stats.spills,
+		       peaks[i]);
+	}
+	if (pool.failures)
+		printf("Largest failed allocation: %zu bytes\n", sPool.largestFailure);
+
+	free(slots);
+	free(trace.ops);
+	free(trace.free_slots);
+	return pool.failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
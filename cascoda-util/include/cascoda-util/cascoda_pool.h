@@ -0,0 +1,157 @@
+/*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * @brief  Fixed-block pool allocator
+ */
+/**
+ * @ingroup cascoda-util
+ * @defgroup ca-pool Pool allocator
+ * @brief  Allocator with fixed-size blocks in a few size classes, for bounded memory and O(1) allocation
+ *
+ * A pool is made of a small table of classes, sorted by ascending block size. An allocation takes a block
+ * from the smallest class that is large enough, or from the next larger class if that one is exhausted.
+ * The blocks of each class are statically allocated, so the pool cannot fragment, and the statistics of
+ * each class show how many of its blocks are needed.
+ *
+ * Example:
+ * @code
+ * static POOL_STORAGE(small, 32, 16);
+ * static POOL_STORAGE(large, 256, 4);
+ * static ca_pool_class classes[] = {POOL_CLASS(small, 32, 16), POOL_CLASS(large, 256, 4)};
+ * static ca_pool       pool;
+ *
+ * POOL_Init(&pool, classes, 2);
+ * void *p = POOL_Alloc(&pool, 40);
+ * POOL_Free(&pool, p);
+ * @endcode
+ *
+ * @{
+ */
+
+#ifndef CASCODA_POOL_H
+#define CASCODA_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ca821x_error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Alignment of the blocks [bytes], the block sizes must be a multiple of it */
+#define POOL_ALIGN 8
+
+/** Declare the storage for a class of count blocks of size bytes, aligned to POOL_ALIGN */
+#define POOL_STORAGE(name, size, count) uint64_t name[((size) * (count) + POOL_ALIGN - 1) / POOL_ALIGN]
+
+/** Initialiser for an entry of the class table, using storage declared with POOL_STORAGE */
+#define POOL_CLASS(storage, size, count) \
+	{                                    \
+		(storage), (size), (count)       \
+	}
+
+/** Statistics of a class of blocks */
+typedef struct ca_pool_stats
+{
+	uint16_t inUse;     //!< Number of blocks currently allocated
+	uint16_t highWater; //!< Highest number of blocks allocated at the same time
+	uint32_t spills;    //!< Number of allocations passed on to a larger class, because this one was exhausted
+} ca_pool_stats;
+
+/** A class of blocks of the same size */
+typedef struct ca_pool_class
+{
+	void         *storage;    //!< Storage for the blocks, see POOL_STORAGE
+	uint16_t      blockSize;  //!< Size of each block [bytes], a multiple of POOL_ALIGN
+	uint16_t      blockCount; //!< Number of blocks
+	void         *freeList;   //!< Internal: First free block, the free blocks are linked through their first word
+	ca_pool_stats stats;      //!< Statistics of the class
+} ca_pool_class;
+
+/** A pool allocator */
+typedef struct ca_pool
+{
+	ca_pool_class *classes;        //!< Table of classes, sorted by ascending block size
+	uint8_t        numClasses;     //!< Number of classes in the table
+	uint32_t       failures;       //!< Number of allocations that could not be served
+	size_t         largestFailure; //!< Largest size [bytes] of an allocation that could not be served
+} ca_pool;
+
+/**
+ * Initialise a pool, and free all of its blocks.
+ * @param aPool Pool to initialise
+ * @param aClasses Table of classes, sorted by ascending block size. Must stay valid while the pool is in use.
+ * @param aNumClasses Number of classes in the table
+ * @return status
+ * @retval CA_ERROR_SUCCESS Pool initialised
+ * @retval CA_ERROR_INVALID_ARGS A class is not sorted, its block size is not a multiple of POOL_ALIGN, or it has
+ *                              no storage
+ */
+ca_error POOL_Init(ca_pool *aPool, ca_pool_class *aClasses, uint8_t aNumClasses);
+
+/**
+ * Allocate a block from a pool.
+ * @param aPool Pool to allocate from
+ * @param aSize Size of the allocation [bytes]
+ * @return Pointer to a block of at least aSize bytes, or NULL if there is no free block that is large enough
+ */
+void *POOL_Alloc(ca_pool *aPool, size_t aSize);
+
+/**
+ * Allocate a zeroed block for an array from a pool, like calloc.
+ * @param aPool Pool to allocate from
+ * @param aCount Number of elements
+ * @param aSize Size of each element [bytes]
+ * @return Pointer to a zeroed block of at least aCount * aSize bytes, or NULL if there is no free block that is
+ *         large enough
+ */
+void *POOL_Calloc(ca_pool *aPool, size_t aCount, size_t aSize);
+
+/**
+ * Free a block allocated from a pool.
+ * @param aPool Pool the block was allocated from
+ * @param aPtr Block to free. Can be NULL.
+ * @return status
+ * @retval CA_ERROR_SUCCESS Block freed, or aPtr was NULL
+ * @retval CA_ERROR_INVALID_ARGS aPtr is not a block of this pool
+ */
+ca_error POOL_Free(ca_pool *aPool, void *aPtr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CASCODA_POOL_H
+
+/**
+ * @}
+ */
@@ -104,6 +104,22 @@ void RAND_SeedFromDev(struct ca821x_dev *pDeviceRef);
  */
 ca_error RAND_GetCryptoBytes(uint16_t aNumBytes, void *aBytesOut);
 
+/**
+ * Get raw entropy from the hardware random number generators, for seeding other generators.
+ *
+ * On baremetal, the entropy is taken from a pool that is refilled in the background from the
+ * CA-821x (and the TRNG of the host MCU, if any), so that seeding does not have to wait for
+ * many SPI transfers. If the pool runs out, the rest is read directly from the CA-821x.
+ * Only available on baremetal.
+ *
+ * @param aNumBytes The number of bytes to fill with entropy
+ * @param[out] aBytesOut The start address to fill with entropy
+ * @return Cascoda Error code
+ * @retval CA_ERROR_SUCCESS Success, aBytesOut is filled with aNumBytes of entropy.
+ * @retval CA_ERROR_FAIL The hardware failed to provide enough entropy, aBytesOut is indeterminate
+ */
+ca_error RAND_GetEntropy(uint16_t aNumBytes, void *aBytesOut);
+
 /**
  * @brief
  * Add the radio-based RNG as an entropy source used by mbedTLS
@@ -0,0 +1,164 @@
+/*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file
+ * @brief  Fixed-block pool allocator
+ */
+
+#include <string.h>
+
+#include "cascoda-util/cascoda_pool.h"
+
+/**
+ * Find the class that a block belongs to.
+ * @param aPool The pool
+ * @param aPtr The block
+ * @return The class of the block, or NULL if it is not a block of the pool
+ */
+static ca_pool_class *GetClass(ca_pool *aPool, void *aPtr)
+{
+	for (uint8_t i = 0; i < aPool->numClasses; i++)
+	{
+		ca_pool_class *poolClass = &aPool->classes[i];
+		uintptr_t      offset    = (uintptr_t)aPtr - (uintptr_t)poolClass->storage;
+
+		if (offset < (uintptr_t)poolClass->blockSize * poolClass->blockCount)
+		{
+			if (offset % poolClass->blockSize)
+				return NULL;
+			return poolClass;
+		}
+	}
+
+	return NULL;
+}
+
+ca_error POOL_Init(ca_pool *aPool, ca_pool_class *aClasses, uint8_t aNumClasses)
+{
+	for (uint8_t i = 0; i < aNumClasses; i++)
+	{
+		ca_pool_class *poolClass = &aClasses[i];
+		uint8_t       *block     = poolClass->storage;
+
+		if (!poolClass->storage || !poolClass->blockSize || (poolClass->blockSize % POOL_ALIGN))
+			return CA_ERROR_INVALID_ARGS;
+		if (i && poolClass->blockSize <= aClasses[i - 1].blockSize)
+			return CA_ERROR_INVALID_ARGS;
+
+		//Link all blocks into the free list, lowest address first
+		poolClass->freeList = NULL;
+		for (uint16_t j = poolClass->blockCount; j > 0; j--)
+		{
+			void **freeBlock = (void **)(block + (size_t)(j - 1) * poolClass->blockSize);
+
+			*freeBlock          = poolClass->freeList;
+			poolClass->freeList = freeBlock;
+		}
+		memset(&poolClass->stats, 0, sizeof(poolClass->stats));
+	}
+
+	aPool->classes        = aClasses;
+	aPool->numClasses     = aNumClasses;
+	aPool->failures       = 0;
+	aPool->largestFailure = 0;
+
+	return CA_ERROR_SUCCESS;
+}
+
+void *POOL_Alloc(ca_pool *aPool, size_t aSize)
+{
+	ca_pool_class *exhausted = NULL;
+
+	for (uint8_t i = 0; i < aPool->numClasses; i++)
+	{
+		ca_pool_class *poolClass = &aPool->classes[i];
+		void         **block     = poolClass->freeList;
+
+		if (aSize > poolClass->blockSize)
+			continue;
+
+		if (!block)
+		{
+			//Only count the spill against the class that would normally serve this size
+			if (!exhausted)
+				exhausted = poolClass;
+			continue;
+		}
+
+		poolClass->freeList = *block;
+		if (++poolClass->stats.inUse > poolClass->stats.highWater)
+			poolClass->stats.highWater = poolClass->stats.inUse;
+		if (exhausted)
+			exhausted->stats.spills++;
+
+		return block;
+	}
+
+	aPool->failures++;
+	if (aSize > aPool->largestFailure)
+		aPool->largestFailure = aSize;
+
+	return NULL;
+}
+
+void *POOL_Calloc(ca_pool *aPool, size_t aCount, size_t aSize)
+{
+	void *block;
+
+	if (aSize && aCount > SIZE_MAX / aSize)
+	{
+		aPool->failures++;
+		aPool->largestFailure = SIZE_MAX;
+		return NULL;
+	}
+
+	block = POOL_Alloc(aPool, aCount * aSize);
+	if (block)
+		memset(block, 0, aCount * aSize);
+
+	return block;
+}
+
+ca_error POOL_Free(ca_pool *aPool, void *aPtr)
+{
+	ca_pool_class *poolClass;
+	void         **block = aPtr;
+
+	if (!aPtr)
+		return CA_ERROR_SUCCESS;
+
+	poolClass = GetClass(aPool, aPtr);
+	if (!poolClass)
+		return CA_ERROR_INVALID_ARGS;
+
+	*block              = poolClass->freeList;
+	poolClass->freeList = block;
+	poolClass->stats.inUse--;
+
+	return CA_ERROR_SUCCESS;
+}
@@ -0,0 +1,168 @@
+/*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file
+ * @brief  Unit tests for the pool allocator
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+//cmocka must be after system headers
+#include <cmocka.h>
+#include "cascoda-util/cascoda_pool.h"
+
+static POOL_STORAGE(small, 16, 4);
+static POOL_STORAGE(medium, 64, 2);
+static POOL_STORAGE(large, 256, 1);
+
+static ca_pool_class classes[] = {
+    POOL_CLASS(small, 16, 4),
+    POOL_CLASS(medium, 64, 2),
+    POOL_CLASS(large, 256, 1),
+};
+static ca_pool pool;
+
+static int setup(void **state)
+{
+	return POOL_Init(&pool, classes, 3);
+}
+
+static void init_test(void **state)
+{
+	ca_pool_class badSize[]  = {POOL_CLASS(small, 12, 4)};
+	ca_pool_class unsorted[] = {POOL_CLASS(medium, 64, 2), POOL_CLASS(small, 16, 4)};
+	ca_pool       badPool;
+
+	assert_int_equal(POOL_Init(&badPool, badSize, 1), CA_ERROR_INVALID_ARGS);
+	assert_int_equal(POOL_Init(&badPool, unsorted, 2), CA_ERROR_INVALID_ARGS);
+}
+
+static void size_class_test(void **state)
+{
+	uint8_t *a = POOL_Alloc(&pool, 1);
+	uint8_t *b = POOL_Alloc(&pool, 16);
+	uint8_t *c = POOL_Alloc(&pool, 17);
+	uint8_t *d = POOL_Alloc(&pool, 256);
+
+	assert_ptr_equal(a, (uint8_t *)small);
+	assert_ptr_equal(b, (uint8_t *)small + 16);
+	assert_ptr_equal(c, (uint8_t *)medium);
+	assert_ptr_equal(d, (uint8_t *)large);
+	assert_int_equal((uintptr_t)c % POOL_ALIGN, 0);
+
+	//Too large for any class
+	assert_null(POOL_Alloc(&pool, 257));
+	assert_int_equal(pool.failures, 1);
+	assert_int_equal(pool.largestFailure, 257);
+
+	assert_int_equal(classes[0].stats.inUse, 2);
+	assert_int_equal(classes[1].stats.inUse, 1);
+	assert_int_equal(classes[2].stats.inUse, 1);
+
+	assert_int_equal(POOL_Free(&pool, a), CA_ERROR_SUCCESS);
+	assert_int_equal(POOL_Free(&pool, b), CA_ERROR_SUCCESS);
+	assert_int_equal(POOL_Free(&pool, c), CA_ERROR_SUCCESS);
+	assert_int_equal(POOL_Free(&pool, d), CA_ERROR_SUCCESS);
+	assert_int_equal(POOL_Free(&pool, NULL), CA_ERROR_SUCCESS);
+
+	assert_int_equal(classes[0].stats.inUse, 0);
+	assert_int_equal(classes[0].stats.highWater, 2);
+	assert_int_equal(classes[1].stats.highWater, 1);
+}
+
+static void exhaust_test(void **state)
+{
+	void *blocks[7];
+
+	//Small requests spill over into the larger classes once the small class is exhausted
+	for (int i = 0; i < 7; i++)
+	{
+		blocks[i] = POOL_Alloc(&pool, 8);
+		assert_non_null(blocks[i]);
+	}
+	assert_null(POOL_Alloc(&pool, 8));
+
+	assert_int_equal(classes[0].stats.spills, 3);
+	assert_int_equal(classes[1].stats.spills, 0);
+	assert_int_equal(classes[2].stats.inUse, 1);
+	assert_int_equal(pool.failures, 1);
+
+	//Freed blocks go back to their own class
+	assert_int_equal(POOL_Free(&pool, blocks[6]), CA_ERROR_SUCCESS);
+	assert_int_equal(classes[2].stats.inUse, 0);
+	assert_ptr_equal(POOL_Alloc(&pool, 100), blocks[6]);
+
+	//Last freed, first reused
+	assert_int_equal(POOL_Free(&pool, blocks[1]), CA_ERROR_SUCCESS);
+	assert_ptr_equal(POOL_Alloc(&pool, 16), blocks[1]);
+}
+
+static void invalid_free_test(void **state)
+{
+	uint8_t  other[16];
+	uint8_t *a = POOL_Alloc(&pool, 16);
+
+	assert_int_equal(POOL_Free(&pool, other), CA_ERROR_INVALID_ARGS);
+	assert_int_equal(POOL_Free(&pool, a + 4), CA_ERROR_INVALID_ARGS);
+	assert_int_equal(classes[0].stats.inUse, 1);
+	assert_int_equal(POOL_Free(&pool, a), CA_ERROR_SUCCESS);
+}
+
+static void calloc_test(void **state)
+{
+	uint8_t *a = POOL_Alloc(&pool, 64);
+	uint8_t *b;
+
+	memset(a, 0xAA, 64);
+	assert_int_equal(POOL_Free(&pool, a), CA_ERROR_SUCCESS);
+
+	b = POOL_Calloc(&pool, 8, 8);
+	assert_ptr_equal(a, b);
+	for (int i = 0; i < 64; i++)
+	{
+		assert_int_equal(b[i], 0);
+	}
+
+	//Overflowing size
+	assert_null(POOL_Calloc(&pool, SIZE_MAX / 2, 4));
+	assert_int_equal(pool.failures, 1);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {cmocka_unit_test_setup(init_test, setup),
+	                                   cmocka_unit_test_setup(size_class_test, setup),
+	                                   cmocka_unit_test_setup(exhaust_test, setup),
+	                                   cmocka_unit_test_setup(invalid_free_test, setup),
+	                                   cmocka_unit_test_setup(calloc_test, setup)};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
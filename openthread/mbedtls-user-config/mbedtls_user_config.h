@@ -78,6 +78,19 @@
 #ifndef MBEDTLS_X509_CRT_PARSE_C
 #define MBEDTLS_X509_CRT_PARSE_C
 #endif
+
+/* needed for DTLS session resumption and connection IDs */
+#ifndef MBEDTLS_SSL_SESSION_TICKETS
+#define MBEDTLS_SSL_SESSION_TICKETS
+#endif
+
+#ifndef MBEDTLS_SSL_DTLS_CONNECTION_ID
+#define MBEDTLS_SSL_DTLS_CONNECTION_ID
+#endif
+
+/* only keep a digest of the server certificate in the session, so that a certificate based session is small
+ * enough to be cached and resumed (see DTLS_SESSION_MAX_LEN) */
+#undef MBEDTLS_SSL_KEEP_PEER_CERTIFICATE
 #endif //CASCODA_BUILD_SECURE_LWM2M
 
 #if CASCODA_BUILD_LWIP
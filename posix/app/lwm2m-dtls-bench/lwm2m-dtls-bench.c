@@ -0,0 +1,623 @@
+/*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file
+ * Host test harness for the DTLS session cache of the ot-cli-lwm2m example, against a local DTLS server.
+ *
+ * The server runs in a thread on the loopback interface, and is configured like a LwM2M server: PSK, cookies, a
+ * session ID cache, and optionally session tickets and Connection IDs. The client is configured like the device,
+ * and uses baremetal/app/ot-cli-lwm2m/shared/dtls_session.c. It repeats handshakes with the server in three modes:
+ *  - full: the cached session is dropped before each handshake
+ *  - resumed: the session cached in RAM is offered
+ *  - reboot: the cache is reloaded from the settings before each handshake, as after a reboot of the device
+ * For each mode, the harness reports the bytes and datagrams exchanged and the time taken by a handshake.
+ *
+ * Finally, the client moves to another port, as if its address changed, and checks that its connection survives.
+ * The server drops the datagrams from an unknown address unless they carry a Connection ID, like a server that
+ * finds its connections by address.
+ *
+ * A handshake resumed a session if the client skipped its key exchange, which is read from the handshake state of
+ * the mbedtls 2.x ssl context.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_cache.h"
+#include "mbedtls/ssl_cookie.h"
+#include "mbedtls/ssl_ticket.h"
+#include "mbedtls/timing.h"
+
+#include "ca821x-posix/ca821x-types.h"
+#include "cascoda-util/cascoda_settings.h"
+#include "ca821x_api.h"
+#include "dtls_session.h"
+
+/** Default number of handshakes in each mode */
+#define DEFAULT_HANDSHAKES 20
+/** Length of the application data exchanged after each handshake, like a small CoAP message */
+#define PING_LEN 64
+/** Time the server waits for application data before dropping the connection [ms] */
+#define SERVER_READ_TIMEOUT 1000
+/** Time the client waits for the reply to its application data [ms] */
+#define CLIENT_READ_TIMEOUT 2000
+/** Application name of the settings of the client */
+#define SETTINGS_NAME "lwm2m-dtls-bench"
+
+static const unsigned char sPsk[]          = {0x6c, 0x77, 0x6d, 0x32, 0x6d, 0x2d, 0x64, 0x74,
+                                              0x6c, 0x73, 0x2d, 0x62, 0x65, 0x6e, 0x63, 0x68};
+static const char          sPskIdentity[]  = "lwm2m-dtls-bench";
+static const int           sCiphersuites[] = {MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8, 0};
+static const unsigned char sServerCid[]    = {0xca, 0x5c, 0x0d, 0xa0};
+
+/** The local DTLS server */
+struct server
+{
+	int                          fd;
+	struct sockaddr_in           addr;       //!< Address of the server
+	struct sockaddr_in           peer;       //!< Address of the client of the current connection
+	struct sockaddr_in           from;       //!< Source of the last datagram passed to mbedtls
+	bool                         useTickets; //!< Issue session tickets
+	bool                         useCid;     //!< Accept Connection IDs
+	bool                         hasCid;     //!< A Connection ID was negotiated for the current connection
+	volatile bool                stop;       //!< Set to stop the server thread
+	unsigned                     dropped;    //!< Datagrams dropped because they came from an unknown address
+	mbedtls_entropy_context      entropy;
+	mbedtls_ctr_drbg_context     drbg;
+	mbedtls_ssl_config           conf;
+	mbedtls_ssl_context          ssl;
+	mbedtls_ssl_cookie_ctx       cookie;
+	mbedtls_ssl_cache_context    cache;
+	mbedtls_timing_delay_context timer;
+#if defined(MBEDTLS_SSL_TICKET_C)
+	mbedtls_ssl_ticket_context ticket;
+#endif
+};
+
+/** The client, configured like the device */
+struct client
+{
+	int                          fd;
+	struct sockaddr_in           server;      //!< Address of the server
+	size_t                       txBytes;     //!< Bytes sent in total
+	size_t                       rxBytes;     //!< Bytes received in total
+	unsigned                     txDatagrams; //!< Datagrams sent in total
+	unsigned                     rxDatagrams; //!< Datagrams received in total
+	mbedtls_entropy_context      entropy;
+	mbedtls_ctr_drbg_context     drbg;
+	mbedtls_ssl_config           conf;
+	mbedtls_ssl_context          ssl;
+	mbedtls_timing_delay_context timer;
+};
+
+/** Handshake modes */
+enum mode
+{
+	MODE_FULL,
+	MODE_RESUMED,
+	MODE_REBOOT,
+	MODE_COUNT,
+};
+
+static const char *const sModeNames[MODE_COUNT] = {"full", "resumed", "reboot"};
+
+/** Results of the handshakes of one mode */
+struct results
+{
+	unsigned handshakes; //!< Successful handshakes
+	unsigned resumed;    //!< Handshakes that resumed a session
+	unsigned failures;   //!< Failed handshakes or application data exchanges
+	size_t   txBytes;
+	size_t   rxBytes;
+	unsigned datagrams;
+	double   ms;
+};
+
+static double now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void check(int rval, const char *what)
+{
+	if (rval)
+	{
+		fprintf(stderr, "%s failed, error -0x%x\n", what, (unsigned)-rval);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/* Open a socket on the loopback interface, on an ephemeral port, and write its address to addr */
+static int open_socket(struct sockaddr_in *addr)
+{
+	socklen_t len = sizeof(*addr);
+	int       fd  = socket(AF_INET, SOCK_DGRAM, 0);
+
+	memset(addr, 0, sizeof(*addr));
+	addr->sin_family      = AF_INET;
+	addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (fd < 0 || bind(fd, (struct sockaddr *)addr, sizeof(*addr)) || getsockname(fd, (struct sockaddr *)addr, &len))
+	{
+		perror("Cannot open socket");
+		exit(EXIT_FAILURE);
+	}
+	return fd;
+}
+
+/* Wait for a datagram, for up to timeout ms, or forever if timeout is 0 */
+static int wait_readable(int fd, uint32_t timeout)
+{
+	struct pollfd pfd = {.fd = fd, .events = POLLIN};
+
+	return poll(&pfd, 1, timeout ? (int)timeout : -1);
+}
+
+static bool same_address(const struct sockaddr_in *a, const struct sockaddr_in *b)
+{
+	return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
+
+static int server_send(void *ctx, const unsigned char *buf, size_t len)
+{
+	struct server *srv  = ctx;
+	ssize_t        rval = sendto(srv->fd, buf, len, 0, (struct sockaddr *)&srv->peer, sizeof(srv->peer));
+
+	return rval < 0 ? MBEDTLS_ERR_NET_SEND_FAILED : (int)rval;
+}
+
+static int server_recv(void *ctx, unsigned char *buf, size_t len, uint32_t timeout)
+{
+	struct server *srv      = ctx;
+	double         deadline = now_ms() + timeout;
+
+	for (;;)
+	{
+		struct sockaddr_in from;
+		socklen_t          fromLen = sizeof(from);
+		double             left    = deadline - now_ms();
+		ssize_t            rval;
+		bool               isCid = false;
+
+		if (timeout && left < 1)
+			return MBEDTLS_ERR_SSL_TIMEOUT;
+		if (wait_readable(srv->fd, timeout ? (uint32_t)left : 0) <= 0)
+			return MBEDTLS_ERR_SSL_TIMEOUT;
+
+		rval = recvfrom(srv->fd, buf, len, 0, (struct sockaddr *)&from, &fromLen);
+		if (rval < 0)
+			return MBEDTLS_ERR_NET_RECV_FAILED;
+
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+		isCid = srv->hasCid && rval > 0 && buf[0] == MBEDTLS_SSL_MSG_CID;
+#endif
+		if (!same_address(&from, &srv->peer) && !isCid)
+		{
+			srv->dropped++;
+			continue;
+		}
+
+		srv->from = from;
+		return (int)rval;
+	}
+}
+
+static void *server_thread(void *arg)
+{
+	struct server *srv = arg;
+	unsigned char  buf[1024];
+
+	while (!srv->stop)
+	{
+		socklen_t peerLen = sizeof(srv->peer);
+		int       rval;
+
+		// Wait for a ClientHello, and take its source as the address of the client
+		if (wait_readable(srv->fd, 100) <= 0)
+			continue;
+		if (recvfrom(srv->fd, buf, 1, MSG_PEEK, (struct sockaddr *)&srv->peer, &peerLen) < 0)
+			continue;
+
+		mbedtls_ssl_session_reset(&srv->ssl);
+		mbedtls_ssl_set_client_transport_id(&srv->ssl, (const unsigned char *)&srv->peer, sizeof(srv->peer));
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+		if (srv->useCid)
+			mbedtls_ssl_set_cid(&srv->ssl, MBEDTLS_SSL_CID_ENABLED, sServerCid, sizeof(sServerCid));
+#endif
+		srv->hasCid = false;
+
+		do
+		{
+			rval = mbedtls_ssl_handshake(&srv->ssl);
+		} while (rval == MBEDTLS_ERR_SSL_WANT_READ || rval == MBEDTLS_ERR_SSL_WANT_WRITE);
+		// This includes MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED, the client then sends its ClientHello again
+		if (rval)
+			continue;
+
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+		{
+			int enabled = MBEDTLS_SSL_CID_DISABLED;
+
+			mbedtls_ssl_get_peer_cid(&srv->ssl, &enabled, NULL, NULL);
+			srv->hasCid = (enabled == MBEDTLS_SSL_CID_ENABLED);
+		}
+#endif
+
+		// Echo the application data until the client closes the connection or goes quiet
+		for (;;)
+		{
+			rval = mbedtls_ssl_read(&srv->ssl, buf, sizeof(buf));
+			if (rval == MBEDTLS_ERR_SSL_WANT_READ || rval == MBEDTLS_ERR_SSL_WANT_WRITE)
+				continue;
+			if (rval <= 0)
+				break;
+			// The record was authenticated, so follow the client if it moved
+			srv->peer = srv->from;
+			mbedtls_ssl_write(&srv->ssl, buf, (size_t)rval);
+		}
+	}
+	return NULL;
+}
+
+static void server_start(struct server *srv, pthread_t *thread)
+{
+	srv->fd = open_socket(&srv->addr);
+
+	mbedtls_entropy_init(&srv->entropy);
+	mbedtls_ctr_drbg_init(&srv->drbg);
+	check(mbedtls_ctr_drbg_seed(&srv->drbg, mbedtls_entropy_func, &srv->entropy, NULL, 0), "Server seed");
+
+	mbedtls_ssl_config_init(&srv->conf);
+	check(mbedtls_ssl_config_defaults(
+	          &srv->conf, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_DATAGRAM, MBEDTLS_SSL_PRESET_DEFAULT),
+	      "Server config");
+	mbedtls_ssl_conf_rng(&srv->conf, mbedtls_ctr_drbg_random, &srv->drbg);
+	mbedtls_ssl_conf_ciphersuites(&srv->conf, sCiphersuites);
+	check(mbedtls_ssl_conf_psk(
+	          &srv->conf, sPsk, sizeof(sPsk), (const unsigned char *)sPskIdentity, strlen(sPskIdentity)),
+	      "Server PSK");
+	mbedtls_ssl_conf_read_timeout(&srv->conf, SERVER_READ_TIMEOUT);
+
+	mbedtls_ssl_cookie_init(&srv->cookie);
+	check(mbedtls_ssl_cookie_setup(&srv->cookie, mbedtls_ctr_drbg_random, &srv->drbg), "Server cookies");
+	mbedtls_ssl_conf_dtls_cookies(&srv->conf, mbedtls_ssl_cookie_write, mbedtls_ssl_cookie_check, &srv->cookie);
+
+	mbedtls_ssl_cache_init(&srv->cache);
+	mbedtls_ssl_conf_session_cache(&srv->conf, &srv->cache, mbedtls_ssl_cache_get, mbedtls_ssl_cache_set);
+
+#if defined(MBEDTLS_SSL_TICKET_C)
+	mbedtls_ssl_ticket_init(&srv->ticket);
+	if (srv->useTickets)
+	{
+		check(mbedtls_ssl_ticket_setup(
+		          &srv->ticket, mbedtls_ctr_drbg_random, &srv->drbg, MBEDTLS_CIPHER_AES_128_GCM, 24 * 3600),
+		      "Server tickets");
+		mbedtls_ssl_conf_session_tickets_cb(
+		    &srv->conf, mbedtls_ssl_ticket_write, mbedtls_ssl_ticket_parse, &srv->ticket);
+	}
+#endif
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+	if (srv->useCid)
+		check(mbedtls_ssl_conf_cid(&srv->conf, sizeof(sServerCid), MBEDTLS_SSL_UNEXPECTED_CID_IGNORE), "Server CID");
+#endif
+
+	mbedtls_ssl_init(&srv->ssl);
+	check(mbedtls_ssl_setup(&srv->ssl, &srv->conf), "Server setup");
+	mbedtls_ssl_set_bio(&srv->ssl, srv, server_send, NULL, server_recv);
+	mbedtls_ssl_set_timer_cb(&srv->ssl, &srv->timer, mbedtls_timing_set_delay, mbedtls_timing_get_delay);
+
+	if (pthread_create(thread, NULL, server_thread, srv))
+	{
+		fprintf(stderr, "Cannot start the server\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+static int client_send(void *ctx, const unsigned char *buf, size_t len)
+{
+	struct client *cli  = ctx;
+	ssize_t        rval = sendto(cli->fd, buf, len, 0, (struct sockaddr *)&cli->server, sizeof(cli->server));
+
+	if (rval < 0)
+		return MBEDTLS_ERR_NET_SEND_FAILED;
+	cli->txBytes += (size_t)rval;
+	cli->txDatagrams++;
+	return (int)rval;
+}
+
+static int client_recv(void *ctx, unsigned char *buf, size_t len, uint32_t timeout)
+{
+	struct client *cli  = ctx;
+	int            wait = wait_readable(cli->fd, timeout);
+	ssize_t        rval;
+
+	if (wait == 0)
+		return MBEDTLS_ERR_SSL_TIMEOUT;
+	if (wait < 0)
+		return MBEDTLS_ERR_NET_RECV_FAILED;
+
+	rval = recv(cli->fd, buf, len, 0);
+	if (rval < 0)
+		return MBEDTLS_ERR_NET_RECV_FAILED;
+	cli->rxBytes += (size_t)rval;
+	cli->rxDatagrams++;
+	return (int)rval;
+}
+
+/* Same configuration as connection_dns_callback in ot-cli-lwm2m/shared/mbedtlsconnection.c */
+static void client_init(struct client *cli, const struct sockaddr_in *server)
+{
+	struct sockaddr_in addr;
+
+	cli->fd     = open_socket(&addr);
+	cli->server = *server;
+
+	mbedtls_entropy_init(&cli->entropy);
+	mbedtls_ctr_drbg_init(&cli->drbg);
+	check(mbedtls_ctr_drbg_seed(&cli->drbg, mbedtls_entropy_func, &cli->entropy, NULL, 0), "Client seed");
+
+	mbedtls_ssl_config_init(&cli->conf);
+	check(mbedtls_ssl_config_defaults(
+	          &cli->conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_DATAGRAM, MBEDTLS_SSL_PRESET_DEFAULT),
+	      "Client config");
+	mbedtls_ssl_conf_authmode(&cli->conf, MBEDTLS_SSL_VERIFY_NONE);
+	mbedtls_ssl_conf_rng(&cli->conf, mbedtls_ctr_drbg_random, &cli->drbg);
+	mbedtls_ssl_conf_min_version(&cli->conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+	mbedtls_ssl_conf_max_version(&cli->conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+	mbedtls_ssl_conf_ciphersuites(&cli->conf, sCiphersuites);
+	check(mbedtls_ssl_conf_psk(
+	          &cli->conf, sPsk, sizeof(sPsk), (const unsigned char *)sPskIdentity, strlen(sPskIdentity)),
+	      "Client PSK");
+	mbedtls_ssl_conf_read_timeout(&cli->conf, CLIENT_READ_TIMEOUT);
+	dtls_session_configure(&cli->conf);
+
+	mbedtls_ssl_init(&cli->ssl);
+	check(mbedtls_ssl_setup(&cli->ssl, &cli->conf), "Client setup");
+	mbedtls_ssl_set_bio(&cli->ssl, cli, client_send, NULL, client_recv);
+	mbedtls_ssl_set_timer_cb(&cli->ssl, &cli->timer, mbedtls_timing_set_delay, mbedtls_timing_get_delay);
+}
+
+/* Perform a handshake, offering the cached session, and add its cost to the results */
+static int client_handshake(struct client *cli, const char *uri, struct results *res)
+{
+	size_t   txBytes   = cli->txBytes;
+	size_t   rxBytes   = cli->rxBytes;
+	unsigned datagrams = cli->txDatagrams + cli->rxDatagrams;
+	bool     resumed   = true;
+	double   start;
+	int      rval = 0;
+
+	mbedtls_ssl_session_reset(&cli->ssl);
+	dtls_session_setup(&cli->ssl, uri);
+
+	start = now_ms();
+	while (cli->ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER)
+	{
+		// An abbreviated handshake goes from the ServerHello straight to the ChangeCipherSpec
+		if (cli->ssl.state == MBEDTLS_SSL_CLIENT_KEY_EXCHANGE)
+			resumed = false;
+		rval = mbedtls_ssl_handshake_step(&cli->ssl);
+		if (rval && rval != MBEDTLS_ERR_SSL_WANT_READ && rval != MBEDTLS_ERR_SSL_WANT_WRITE)
+		{
+			fprintf(stderr, "Handshake failed, error -0x%x\n", (unsigned)-rval);
+			dtls_session_forget(uri);
+			res->failures++;
+			return rval;
+		}
+	}
+
+	res->handshakes++;
+	res->resumed += resumed;
+	res->ms += now_ms() - start;
+	res->txBytes += cli->txBytes - txBytes;
+	res->rxBytes += cli->rxBytes - rxBytes;
+	res->datagrams += cli->txDatagrams + cli->rxDatagrams - datagrams;
+
+	dtls_session_save(&cli->ssl, uri);
+	return 0;
+}
+
+/* Exchange application data with the server, which echoes it */
+static int client_ping(struct client *cli)
+{
+	unsigned char buf[PING_LEN];
+	int           rval;
+
+	memset(buf, 0x5a, sizeof(buf));
+	rval = mbedtls_ssl_write(&cli->ssl, buf, sizeof(buf));
+	if (rval < 0)
+		return rval;
+
+	do
+	{
+		rval = mbedtls_ssl_read(&cli->ssl, buf, sizeof(buf));
+	} while (rval == MBEDTLS_ERR_SSL_WANT_READ || rval == MBEDTLS_ERR_SSL_WANT_WRITE);
+
+	if (rval < 0)
+		return rval;
+	return rval == PING_LEN ? 0 : -1;
+}
+
+/* Move the client to another port, as if its address changed */
+static void client_move(struct client *cli)
+{
+	struct sockaddr_in addr;
+
+	close(cli->fd);
+	cli->fd = open_socket(&addr);
+}
+
+static void print_results(const char *name, const struct results *res)
+{
+	double count = res->handshakes ? res->handshakes : 1;
+
+	printf("%-8s %10u %8u %9.0f %9.0f %9.1f %8.2f %8u\n",
+	       name,
+	       res->handshakes,
+	       res->resumed,
+	       res->txBytes / count,
+	       res->rxBytes / count,
+	       res->datagrams / count,
+	       res->ms / count,
+	       res->failures);
+}
+
+static void usage(const char *exec_name)
+{
+	fprintf(stderr, "Usage: %s [-n HANDSHAKES] [-c] [-t]\n", exec_name);
+	fprintf(stderr, "\tMeasure the DTLS handshakes of the LwM2M client against a local DTLS server.\n\n");
+	fprintf(stderr, "\t-n HANDSHAKES  Number of handshakes in each mode (default %d)\n", DEFAULT_HANDSHAKES);
+	fprintf(stderr, "\t-c             The server does not accept Connection IDs\n");
+	fprintf(stderr, "\t-t             The server does not issue session tickets, and only caches session IDs\n");
+}
+
+int main(int argc, char *argv[])
+{
+	static struct server        srv;
+	static struct client        cli;
+	struct ca821x_exchange_base exchange   = {0};
+	struct ca821x_dev           dev        = {0};
+	struct results              results[MODE_COUNT];
+	struct results              moveResults;
+	pthread_t                   thread;
+	char                        uri[64];
+	int                         handshakes = DEFAULT_HANDSHAKES;
+	unsigned                    failures   = 0;
+	bool                        hasCid;
+	bool                        moved;
+	int                         opt;
+
+	srv.useTickets = true;
+	srv.useCid     = true;
+
+	while ((opt = getopt(argc, argv, "n:cth")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n':
+			handshakes = atoi(optarg);
+			break;
+		case 'c':
+			srv.useCid = false;
+			break;
+		case 't':
+			srv.useTickets = false;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+	if (handshakes <= 0)
+	{
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	// Start from empty settings, which hold the sessions persisted by the cache
+	dev.exchange_context = &exchange;
+	caUtilSettingsInit(&dev, SETTINGS_NAME, 1);
+	caUtilSettingsWipe(&dev, SETTINGS_NAME, 1);
+	dtls_session_init(&dev);
+
+	server_start(&srv, &thread);
+	client_init(&cli, &srv.addr);
+	snprintf(uri, sizeof(uri), "coaps://127.0.0.1:%u", (unsigned)ntohs(srv.addr.sin_port));
+
+	memset(results, 0, sizeof(results));
+	for (int mode = 0; mode < MODE_COUNT; mode++)
+	{
+		for (int i = 0; i < handshakes; i++)
+		{
+			if (mode == MODE_FULL)
+				dtls_session_forget(uri);
+			else if (mode == MODE_REBOOT)
+				dtls_session_init(&dev);
+
+			if (client_handshake(&cli, uri, &results[mode]))
+				continue;
+			if (client_ping(&cli))
+				results[mode].failures++;
+			mbedtls_ssl_close_notify(&cli.ssl);
+		}
+		failures += results[mode].failures;
+	}
+
+	printf("%-8s %10s %8s %9s %9s %9s %8s %8s\n",
+	       "mode",
+	       "handshakes",
+	       "resumed",
+	       "tx bytes",
+	       "rx bytes",
+	       "datagrams",
+	       "ms",
+	       "failures");
+	for (int mode = 0; mode < MODE_COUNT; mode++)
+		print_results(sModeNames[mode], &results[mode]);
+
+	// Change the address of the client in the middle of a connection
+	memset(&moveResults, 0, sizeof(moveResults));
+	moved = false;
+	if (!client_handshake(&cli, uri, &moveResults) && !client_ping(&cli))
+	{
+		client_move(&cli);
+		moved = !client_ping(&cli);
+		mbedtls_ssl_close_notify(&cli.ssl);
+	}
+	hasCid = dtls_session_has_cid(&cli.ssl);
+
+	srv.stop = true;
+	pthread_join(thread, NULL);
+
+	printf("\nConnection ID %s, the connection %s the address change (%u datagrams dropped by the server)\n",
+	       hasCid ? "negotiated" : "not negotiated",
+	       moved ? "survived" : "did not survive",
+	       srv.dropped);
+
+	// Without a Connection ID, the connection is expected to be lost
+	if (moved != hasCid)
+		failures++;
+
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -43,6 +44,7 @@
 #include "openthread/thread.h"
 
 #include "cbor.h"
+#include "zlib.h"
 
 #include "ca821x-posix-thread/posix-platform.h"
 
@@ -56,13 +58,22 @@
 	} while (0)
 #define FILENAME_SIZE (255)
 
+// Images are sent with CoAP Block2, in blocks of at most this size
+#define IMAGE_MAX_BLOCK_SZX OT_COAP_OPTION_BLOCK_SZX_512
+// The devices decompress images as they are received, with a window of this many bits,
+// so images are recompressed to only refer back this far
+#define IMAGE_WINDOW_BITS 10
+// Size of a decompressed image, 296x128 pixels
+#define IMAGE_SIZE (296 * 128 / 8)
+// Length of the ETag identifying the content of an image
+#define IMAGE_ETAG_LENGTH 8
+
 static int            isRunning;
 static otCoapResource sDiscoverResource;
 static otCoapResource sImageResource;
 static const char    *sDiscoverUri = "ca/di";
 static const char    *sImageUri    = "ca/img";
 
-static char         imageBuffer[1024] = {0};
 static otCliCommand sCliCommands[2];
 
 struct connected_device
@@ -72,13 +83,25 @@ struct connected_device
 	int            deviceID;
 	bool           isConnected;
 	struct timeval last_wakeup;
-	char          *fileName;
+	struct image  *image; // Assigned image, or NULL
+};
+
+/** An image file, compressed for the devices. Shared by all the devices it is assigned to. */
+struct image
+{
+	char    *fileName;
+	time_t   mtime;                   // Modification time of the file when it was compressed
+	uint8_t *data;                    // Compressed image
+	size_t   length;                  // Length of the compressed image
+	uint8_t  etag[IMAGE_ETAG_LENGTH]; // Hash of the decompressed image
+	int      refs;                    // Number of devices the image is assigned to
 };
 
 #define MAX_CONNECTED_DEVICES_LIST 50
 static time_t                  TIMEOUT_S                           = 600;
 static int                     num_of_connected_devices            = 0;
 static struct connected_device devices[MAX_CONNECTED_DEVICES_LIST] = {};
+static struct image            images[MAX_CONNECTED_DEVICES_LIST]  = {};
 
 otInstance *OT_INSTANCE;
 
@@ -123,6 +146,147 @@ static int getDeviceID(struct connected_device *device)
 	return device - devices;
 }
 
+/**
+ * Load a gzipped image, and recompress it so that the device can decompress it
+ * with a small window while it is being received.
+ */
+static int loadImage(struct image *image)
+{
+	static uint8_t compressed[64 * 1024];
+	uint8_t        raw[IMAGE_SIZE];
+	FILE          *fin;
+	struct stat    st;
+	size_t         filesize;
+	size_t         rawLength;
+	size_t         length;
+	uint8_t       *data;
+	uint64_t       hash   = 0xcbf29ce484222325;
+	z_stream       strm   = {0};
+	int            result = -1;
+
+	if ((fin = fopen(image->fileName, "rb")) == NULL || fstat(fileno(fin), &st) != 0)
+	{
+		printf_time("Could not open \"%s\"!\r\n", image->fileName);
+		if (fin)
+			fclose(fin);
+		return -1;
+	}
+	filesize = fread(compressed, 1, sizeof(compressed), fin);
+	fclose(fin);
+
+	// Decompress, accepting gzip or zlib
+	if (inflateInit2(&strm, 15 + 32) != Z_OK)
+		return -1;
+	strm.next_in   = compressed;
+	strm.avail_in  = filesize;
+	strm.next_out  = raw;
+	strm.avail_out = sizeof(raw);
+	result         = inflate(&strm, Z_FINISH);
+	rawLength      = sizeof(raw) - strm.avail_out;
+	inflateEnd(&strm);
+	if (result != Z_STREAM_END)
+	{
+		printf_time("\"%s\" is not a valid image!\r\n", image->fileName);
+		return -1;
+	}
+
+	// Recompress as gzip with the device's window size
+	memset(&strm, 0, sizeof(strm));
+	if (deflateInit2(&strm, Z_BEST_COMPRESSION, Z_DEFLATED, IMAGE_WINDOW_BITS + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK)
+		return -1;
+	strm.next_in   = raw;
+	strm.avail_in  = rawLength;
+	strm.next_out  = compressed;
+	strm.avail_out = sizeof(compressed);
+	result         = deflate(&strm, Z_FINISH);
+	deflateEnd(&strm);
+	if (result != Z_STREAM_END)
+		return -1;
+
+	length = sizeof(compressed) - strm.avail_out;
+	data   = malloc(length);
+	if (data == NULL)
+		return -1;
+	memcpy(data, compressed, length);
+
+	// The ETag is a hash (FNV-1a) of the pixels, so it only changes when the picture does
+	for (size_t i = 0; i < rawLength; i++) hash = (hash ^ raw[i]) * 0x100000001b3;
+
+	free(image->data);
+	image->data   = data;
+	image->length = length;
+	image->mtime  = st.st_mtime;
+	PUTBE64(hash, image->etag);
+
+	return 0;
+}
+
+/**
+ * Reload an image if its file has changed since it was last compressed.
+ */
+static void refreshImage(struct image *image)
+{
+	struct stat st;
+
+	if (stat(image->fileName, &st) != 0 || st.st_mtime == image->mtime)
+		return;
+
+	if (loadImage(image) == 0)
+		printf_time("Reloaded changed image \"%s\"\r\n", image->fileName);
+}
+
+/**
+ * Get the cached image for a file, loading it if it is not cached yet.
+ * The returned image must be released with releaseImage.
+ */
+static struct image *getImage(const char *fileName)
+{
+	struct image *image = NULL;
+
+	for (int i = 0; i < MAX_CONNECTED_DEVICES_LIST; i++)
+	{
+		if (images[i].refs && strcmp(images[i].fileName, fileName) == 0)
+		{
+			image = &images[i];
+			refreshImage(image);
+			image->refs++;
+			return image;
+		}
+		if (!images[i].refs && !image)
+			image = &images[i];
+	}
+
+	if (image == NULL)
+		return NULL;
+
+	image->fileName = strdup(fileName);
+	if (image->fileName == NULL || loadImage(image) != 0)
+	{
+		free(image->fileName);
+		image->fileName = NULL;
+		return NULL;
+	}
+	image->refs = 1;
+
+	return image;
+}
+
+static void releaseImage(struct image *image)
+{
+	if (image == NULL || --image->refs > 0)
+		return;
+
+	free(image->fileName);
+	free(image->data);
+	memset(image, 0, sizeof(*image));
+}
+
+static void clearImage(struct connected_device *device)
+{
+	releaseImage(device->image);
+	device->image = NULL;
+}
+
 static void handleDiscover(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo)
 {
 	otError      error           = OT_ERROR_NONE;
@@ -199,7 +363,7 @@ static void handleDiscover(void *aContext, otMessage *aMessage, const otMessageI
 		if ((time_now.tv_sec > last_wakeup_s + TIMEOUT_S) && last_wakeup_s != 0)
 		{
 			devices[i].isConnected = false;
-			devices[i].fileName    = "none";
+			clearImage(&devices[i]);
 			num_of_connected_devices--;
 
 			printf_time("[%x:%x:%x:%x:%x:%x:%x:%x] timed out!\r\n",
@@ -233,7 +397,7 @@ static void handleDiscover(void *aContext, otMessage *aMessage, const otMessageI
 
 		devices[i].isConnected = true;
 		memcpy(devices[i].ip, aMessageInfo->mPeerAddr.mFields.m8, 16);
-		devices[i].fileName = "none";
+		clearImage(&devices[i]);
 		num_of_connected_devices++;
 		printf_time("New device connected!\r\n");
 
@@ -312,50 +476,76 @@ exit:
 
 static void handleImageRequest(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo)
 {
-	otError     error           = OT_ERROR_NONE;
-	otMessage  *responseMessage = NULL;
-	otInstance *OT_INSTANCE     = aContext;
-	//including CBOR variables
-	uint8_t     buffer[1024] = {0};
-	CborError   err;
-	CborEncoder encoder, mapEncoder;
-
-	char                  filename[FILENAME_SIZE] = {0};
-	char                  deviceIdString[10];
-	char                  uri_query[10];
-	bool                  valid_query = false;
-	otCoapOptionIterator *iterator;
-	const otCoapOption   *option;
+	otError                  error           = OT_ERROR_NONE;
+	otMessage               *responseMessage = NULL;
+	otInstance              *OT_INSTANCE     = aContext;
+	struct connected_device *device          = NULL;
+	char                     uri_query[10]   = {0};
+	bool                     valid_query     = false;
+	uint8_t                  etag[IMAGE_ETAG_LENGTH];
+	bool                     has_etag = false;
+	otCoapOptionIterator     iterator;
+	const otCoapOption      *option;
+	uint64_t                 block2 = 0;
+	uint32_t                 blockNum;
+	otCoapBlockSzx           blockSzx = IMAGE_MAX_BLOCK_SZX;
+	size_t                   blockOffset;
+	size_t                   blockLength;
+	bool                     more;
+	int                      deviceId;
 
 	if (otCoapMessageGetCode(aMessage) != OT_COAP_CODE_GET)
 		return;
 
-	if (otCoapOptionIteratorInit(iterator, aMessage) != OT_ERROR_NONE)
+	if (otCoapOptionIteratorInit(&iterator, aMessage) != OT_ERROR_NONE)
 		return;
 
-	printf_time("Server received GET Request from [%x:%x:%x:%x:%x:%x:%x:%x]\r\n",
-	            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 0),
-	            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 2),
-	            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 4),
-	            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 6),
-	            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 8),
-	            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 10),
-	            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 12),
-	            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 14));
-
-	for (option = otCoapOptionIteratorGetFirstOption(iterator); option != NULL;
-	     option = otCoapOptionIteratorGetNextOption(iterator))
+	for (option = otCoapOptionIteratorGetFirstOption(&iterator); option != NULL;
+	     option = otCoapOptionIteratorGetNextOption(&iterator))
 	{
 		if (option->mNumber == OT_COAP_OPTION_URI_QUERY && option->mLength < sizeof(uri_query))
 		{
-			SuccessOrExit(otCoapOptionIteratorGetOptionValue(iterator, uri_query));
+			SuccessOrExit(otCoapOptionIteratorGetOptionValue(&iterator, uri_query));
 			valid_query = true;
-			break;
+		}
+		else if (option->mNumber == OT_COAP_OPTION_BLOCK2)
+		{
+			SuccessOrExit(otCoapOptionIteratorGetOptionUintValue(&iterator, &block2));
+		}
+		else if (option->mNumber == OT_COAP_OPTION_E_TAG && option->mLength == IMAGE_ETAG_LENGTH)
+		{
+			SuccessOrExit(otCoapOptionIteratorGetOptionValue(&iterator, etag));
+			has_etag = true;
 		}
 	}
 
-	if (!valid_query)
+	if (!valid_query || sscanf(uri_query, "id=%d", &deviceId) != 1)
 		return;
+	if (deviceId < 0 || deviceId >= MAX_CONNECTED_DEVICES_LIST || !devices[deviceId].isConnected)
+		return;
+	device = &devices[deviceId];
+
+	// The client may ask for smaller blocks than the server would send
+	blockNum = block2 >> 4;
+	if ((block2 & 0x07) < blockSzx)
+		blockSzx = block2 & 0x07;
+
+	if (blockNum == 0)
+	{
+		printf_time("Server received GET Request from [%x:%x:%x:%x:%x:%x:%x:%x]\r\n",
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 0),
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 2),
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 4),
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 6),
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 8),
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 10),
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 12),
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 14));
+
+		// Pick up changes to the image file before starting a new transfer
+		if (device->image)
+			refreshImage(device->image);
+	}
 
 	responseMessage = otCoapNewMessage(OT_INSTANCE, NULL);
 	if (responseMessage == NULL)
@@ -364,25 +554,7 @@ static void handleImageRequest(void *aContext, otMessage *aMessage, const otMess
 		goto exit;
 	}
 
-	int i;
-	for (i = 0; i < MAX_CONNECTED_DEVICES_LIST; i++)
-	{
-		if (!devices[i].isConnected)
-			continue;
-
-		snprintf(deviceIdString, sizeof(deviceIdString), "id=%d", devices[i].deviceID);
-		break;
-	}
-
-	if (strncmp(uri_query, deviceIdString, sizeof(uri_query)) != 0)
-		return;
-
-	if (strncmp(devices[i].fileName, "none", sizeof(devices[i].fileName)) != 0)
-	{
-		strcpy(filename, devices[i].fileName);
-		otCliOutputFormat("File Added: %s\r\n", filename);
-	}
-	else
+	if (device->image == NULL)
 	{
 		/*send response that the request was received but there are no images available.*/
 		otCliOutputFormat("No Image Available.\r\n");
@@ -393,57 +565,47 @@ static void handleImageRequest(void *aContext, otMessage *aMessage, const otMess
 		return;
 	}
 
-	FILE *fin;
-	int   filesize = 0;
-
-	if ((fin = fopen(filename, "rb")) == NULL)
+	if (blockNum == 0 && has_etag && memcmp(etag, device->image->etag, IMAGE_ETAG_LENGTH) == 0)
 	{
-		printf_time("Could not open \"%s\"!\r\n", filename);
-		error = OT_ERROR_FAILED;
-		goto exit;
+		// The device is already displaying this image, so there is nothing to send
+		otCoapMessageInitResponse(responseMessage, aMessage, OT_COAP_TYPE_NON_CONFIRMABLE, OT_COAP_CODE_VALID);
+		otCoapMessageSetToken(responseMessage, otCoapMessageGetToken(aMessage), otCoapMessageGetTokenLength(aMessage));
+		SuccessOrExit(error = otCoapMessageAppendOption(
+		                  responseMessage, OT_COAP_OPTION_E_TAG, IMAGE_ETAG_LENGTH, device->image->etag));
+		SuccessOrExit(error = otCoapSendResponse(OT_INSTANCE, responseMessage, aMessageInfo));
+		printf_time("Image titled \"%s\" is unchanged\r\n", device->image->fileName);
+		return;
 	}
 
-	fseek(fin, 0, SEEK_END);
-	filesize = ftell(fin);
-	fseek(fin, 0, SEEK_SET);
-
-	if (fread(imageBuffer, 1, sizeof(imageBuffer), fin) != filesize)
+	blockOffset = (size_t)blockNum * otCoapBlockSizeFromExponent(blockSzx);
+	if (blockOffset >= device->image->length)
 	{
-		// TODO: handle this error more gracefully, by sending a server error
-		printf_time("Archive \"%s\" too large to transmit!\r\n", filename);
-		error = OT_ERROR_FAILED;
-		fclose(fin);
-		goto exit;
+		otCoapMessageInitResponse(responseMessage, aMessage, OT_COAP_TYPE_NON_CONFIRMABLE, OT_COAP_CODE_BAD_OPTION);
+		otCoapMessageSetToken(responseMessage, otCoapMessageGetToken(aMessage), otCoapMessageGetTokenLength(aMessage));
+		SuccessOrExit(error = otCoapSendResponse(OT_INSTANCE, responseMessage, aMessageInfo));
+		return;
 	}
-
-	fclose(fin);
+	blockLength = device->image->length - blockOffset;
+	more        = blockLength > otCoapBlockSizeFromExponent(blockSzx);
+	if (more)
+		blockLength = otCoapBlockSizeFromExponent(blockSzx);
 
 	// CoAP header
 	otCoapMessageInitResponse(responseMessage, aMessage, OT_COAP_TYPE_NON_CONFIRMABLE, OT_COAP_CODE_CONTENT);
 	otCoapMessageSetToken(responseMessage, otCoapMessageGetToken(aMessage), otCoapMessageGetTokenLength(aMessage));
-
+	SuccessOrExit(error = otCoapMessageAppendOption(
+	                  responseMessage, OT_COAP_OPTION_E_TAG, IMAGE_ETAG_LENGTH, device->image->etag));
+	SuccessOrExit(error = otCoapMessageAppendContentFormatOption(responseMessage,
+	                                                             OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM));
+	SuccessOrExit(error = otCoapMessageAppendBlock2Option(responseMessage, blockNum, more, blockSzx));
 	otCoapMessageSetPayloadMarker(responseMessage);
 
-	//Initialise CBOR encoder
-	cbor_encoder_init(&encoder, buffer, sizeof(buffer), 0);
-
-	//use temp buffer instead of image buffer
-	SuccessOrExit(err = cbor_encoder_create_map(&encoder, &mapEncoder, 2));
-
-	SuccessOrExit(err = cbor_encode_text_stringz(&mapEncoder, "img"));
-	SuccessOrExit(err = cbor_encode_byte_string(&mapEncoder, imageBuffer, filesize));
-
-	SuccessOrExit(err = cbor_encode_text_stringz(&mapEncoder, "devID"));
-	SuccessOrExit(err = cbor_encode_int(&mapEncoder, devices->deviceID));
-
-	SuccessOrExit(err = cbor_encoder_close_container(&encoder, &mapEncoder));
-	size_t length = cbor_encoder_get_buffer_size(&encoder, buffer);
-
-	// CoAP Payload: contents of the image buffer
-	SuccessOrExit(error = otMessageAppend(responseMessage, buffer, length));
+	// CoAP Payload: the requested block of the compressed image
+	SuccessOrExit(error = otMessageAppend(responseMessage, device->image->data + blockOffset, blockLength));
 	SuccessOrExit(error = otCoapSendResponse(OT_INSTANCE, responseMessage, aMessageInfo));
 
-	printf_time("Sent image titled \"%s\"\r\n", filename);
+	if (!more)
+		printf_time("Sent image titled \"%s\"\r\n", device->image->fileName);
 
 exit:
 	if (error != OT_ERROR_NONE && responseMessage != NULL)
@@ -498,7 +660,7 @@ static void listConnectedDevice(void)
 			                  GETBE16(devices[i].ip + 10),
 			                  GETBE16(devices[i].ip + 12),
 			                  GETBE16(devices[i].ip + 14));
-			otCliOutputFormat("Assigned Image: %s\r\n", devices[i].fileName);
+			otCliOutputFormat("Assigned Image: %s\r\n", devices[i].image ? devices[i].image->fileName : "none");
 		}
 	}
 	if (noneConnected)
@@ -548,7 +710,7 @@ static void handle_cli_assign(void *aContext, uint8_t aArgsLength, char *aArgs[]
 		const char *gzip      = &fileLabel[len - 3];
 		int         inputId   = atoi(aArgs[0]);
 
-		bool deviceIDWithinLimits = (inputId >= 0 && inputId <= MAX_CONNECTED_DEVICES_LIST);
+		bool deviceIDWithinLimits = (inputId >= 0 && inputId < MAX_CONNECTED_DEVICES_LIST);
 
 		if (!deviceIDWithinLimits)
 		{
@@ -564,7 +726,15 @@ static void handle_cli_assign(void *aContext, uint8_t aArgsLength, char *aArgs[]
 		{
 			if (memcmp(gzip, ".gz", 3) == 0)
 			{
-				devices[inputId].fileName = fileLabel;
+				struct image *image = getImage(fileLabel);
+
+				if (image == NULL)
+				{
+					otCliOutputFormat("Error: Could not load image. Please try again.\r\n");
+					return;
+				}
+				clearImage(&devices[inputId]);
+				devices[inputId].image = image;
 				otCliOutputFormat(
 				    "File Name: %s, assigned to device with ID: %d\r\n", fileLabel, devices[inputId].deviceID);
 			}
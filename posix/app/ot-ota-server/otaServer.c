@@ -0,0 +1,595 @@
+/*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Firmware image server for the OTA client of cascoda-bm-thread. The image is
+ * served at ca/fw with CoAP block-wise transfer (Block2), in blocks of up to
+ * 1024 bytes. Every response carries the CRC32 of the image as its ETag, and its
+ * size as a Size2 option, so that the devices can resume a download and verify
+ * the image once it is stored.
+ *
+ * The image can also be sent to a realm-local multicast group, so that all the
+ * listening devices receive it from a single transmission. The blocks are POSTed
+ * to ca/fwm with non-confirmable CoAP Block1 messages, paced so that the mesh
+ * can forward each one before the next. The devices then fetch the blocks that
+ * they missed from ca/fw.
+ */
+
+#include <assert.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "openthread/cli.h"
+#include "openthread/coap.h"
+#include "openthread/instance.h"
+#include "openthread/ip6.h"
+#include "openthread/tasklet.h"
+#include "openthread/thread.h"
+
+#include "cascoda-util/cascoda_hash.h"
+#include "ca821x-posix-thread/posix-platform.h"
+#include "ca821x_endian.h"
+
+#define SuccessOrExit(aCondition) \
+	do                            \
+	{                             \
+		if ((aCondition) != 0)    \
+		{                         \
+			goto exit;            \
+		}                         \
+	} while (0)
+
+// The image is sent with CoAP Block2, in blocks of at most this size
+#define IMAGE_MAX_BLOCK_SZX OT_COAP_OPTION_BLOCK_SZX_1024
+// Length of the ETag identifying the image, its CRC32
+#define IMAGE_ETAG_LENGTH 4
+// The blocks sent to the multicast group, which must match OTA_CLIENT_MULTICAST_SZX of the devices
+#define MULTICAST_BLOCK_SZX OT_COAP_OPTION_BLOCK_SZX_1024
+// Default time between two blocks sent to the multicast group
+#define MULTICAST_DEFAULT_INTERVAL_MS 500
+
+/** The firmware image being served */
+struct image
+{
+	char    *fileName;
+	time_t   mtime;                   // Modification time of the file when it was loaded
+	uint8_t *data;                    // Content of the file
+	size_t   length;                  // Length of the file
+	uint8_t  etag[IMAGE_ETAG_LENGTH]; // CRC32 of the file
+	unsigned requests;                // Number of blocks sent
+	unsigned downloads;               // Number of times the last block was sent
+};
+
+/** Transfer of the image to a multicast group */
+struct multicast
+{
+	bool            active;
+	otIp6Address    group;
+	unsigned        intervalMs; // Time between two blocks
+	uint32_t        nextBlock;  // Number of the next block to send
+	struct timespec nextTime;   // When the next block is due
+	unsigned        sent;       // Number of blocks sent
+};
+
+static int              isRunning;
+static otCoapResource   sFirmwareResource;
+static const char      *sFirmwareUri  = "ca/fw";
+static const char      *sMulticastUri = "ca/fwm";
+static struct image     sImage;
+static struct multicast sMulticast;
+
+static otCliCommand sCliCommands[2];
+
+otInstance *OT_INSTANCE;
+
+static void printf_time(const char *format, ...)
+{
+	struct timeval tv;
+	char           timeString[40];
+	va_list        args;
+
+	gettimeofday(&tv, NULL);
+	strftime(timeString, sizeof(timeString), "%Y-%m-%d %H:%M:%S", localtime(&tv.tv_sec));
+	printf("%s - ", timeString);
+
+	va_start(args, format);
+	vprintf(format, args);
+	va_end(args);
+}
+
+/**
+ * Load the image file, replacing the image being served if it succeeds.
+ */
+static int loadImage(const char *fileName)
+{
+	FILE       *fin;
+	struct stat st;
+	uint8_t    *data;
+	char       *name;
+
+	if ((fin = fopen(fileName, "rb")) == NULL || fstat(fileno(fin), &st) != 0 || st.st_size <= 0)
+	{
+		printf_time("Could not open \"%s\"!\r\n", fileName);
+		if (fin)
+			fclose(fin);
+		return -1;
+	}
+
+	data = malloc(st.st_size);
+	name = strdup(fileName);
+	if (data == NULL || name == NULL || fread(data, 1, st.st_size, fin) != (size_t)st.st_size)
+	{
+		printf_time("Could not read \"%s\"!\r\n", fileName);
+		fclose(fin);
+		free(data);
+		free(name);
+		return -1;
+	}
+	fclose(fin);
+
+	free(sImage.fileName);
+	free(sImage.data);
+	memset(&sImage, 0, sizeof(sImage));
+	sImage.fileName = name;
+	sImage.data     = data;
+	sImage.length   = st.st_size;
+	sImage.mtime    = st.st_mtime;
+	PUTBE32(HASH_CRC32(data, sImage.length), sImage.etag);
+
+	printf_time("Serving \"%s\", %zu bytes, ETag %08x\r\n", sImage.fileName, sImage.length, GETBE32(sImage.etag));
+
+	// A multicast transfer in progress starts again with the new image
+	sMulticast.nextBlock = 0;
+	return 0;
+}
+
+/**
+ * Reload the image if its file has changed since it was loaded.
+ */
+static void refreshImage(void)
+{
+	struct stat st;
+
+	if (sImage.fileName == NULL || stat(sImage.fileName, &st) != 0 || st.st_mtime == sImage.mtime)
+		return;
+
+	loadImage(sImage.fileName);
+}
+
+static void handleFirmwareRequest(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo)
+{
+	otError              error           = OT_ERROR_NONE;
+	otMessage           *responseMessage = NULL;
+	otInstance          *OT_INSTANCE     = aContext;
+	uint8_t              etag[IMAGE_ETAG_LENGTH];
+	bool                 has_etag = false;
+	otCoapOptionIterator iterator;
+	const otCoapOption  *option;
+	uint64_t             block2 = IMAGE_MAX_BLOCK_SZX;
+	otCoapBlockSzx       blockSzx;
+	uint32_t             blockNum;
+	size_t               blockOffset;
+	size_t               blockLength;
+	bool                 more;
+
+	if (otCoapMessageGetCode(aMessage) != OT_COAP_CODE_GET)
+		return;
+
+	if (otCoapOptionIteratorInit(&iterator, aMessage) != OT_ERROR_NONE)
+		return;
+
+	for (option = otCoapOptionIteratorGetFirstOption(&iterator); option != NULL;
+	     option = otCoapOptionIteratorGetNextOption(&iterator))
+	{
+		if (option->mNumber == OT_COAP_OPTION_BLOCK2)
+		{
+			SuccessOrExit(otCoapOptionIteratorGetOptionUintValue(&iterator, &block2));
+		}
+		else if (option->mNumber == OT_COAP_OPTION_E_TAG && option->mLength == IMAGE_ETAG_LENGTH)
+		{
+			SuccessOrExit(otCoapOptionIteratorGetOptionValue(&iterator, etag));
+			has_etag = true;
+		}
+	}
+
+	// The offset of the block requested, which is answered with smaller blocks if the client asked for larger ones
+	blockSzx    = block2 & 0x07;
+	blockOffset = (size_t)(block2 >> 4) * otCoapBlockSizeFromExponent(blockSzx);
+	if (blockSzx > IMAGE_MAX_BLOCK_SZX)
+		blockSzx = IMAGE_MAX_BLOCK_SZX;
+	blockNum = blockOffset / otCoapBlockSizeFromExponent(blockSzx);
+
+	// Pick up changes to the image file before starting a new transfer
+	if (blockOffset == 0)
+		refreshImage();
+
+	responseMessage = otCoapNewMessage(OT_INSTANCE, NULL);
+	if (responseMessage == NULL)
+	{
+		error = OT_ERROR_NO_BUFS;
+		goto exit;
+	}
+
+	if (sImage.data == NULL)
+	{
+		otCoapMessageInitResponse(responseMessage, aMessage, OT_COAP_TYPE_ACKNOWLEDGMENT, OT_COAP_CODE_NOT_FOUND);
+		SuccessOrExit(error = otCoapSendResponse(OT_INSTANCE, responseMessage, aMessageInfo));
+		return;
+	}
+
+	if (blockOffset == 0 && has_etag && memcmp(etag, sImage.etag, IMAGE_ETAG_LENGTH) == 0)
+	{
+		// The device already has this image, so there is nothing to send
+		otCoapMessageInitResponse(responseMessage, aMessage, OT_COAP_TYPE_ACKNOWLEDGMENT, OT_COAP_CODE_VALID);
+		SuccessOrExit(error = otCoapMessageAppendOption(
+		                  responseMessage, OT_COAP_OPTION_E_TAG, IMAGE_ETAG_LENGTH, sImage.etag));
+		SuccessOrExit(error = otCoapSendResponse(OT_INSTANCE, responseMessage, aMessageInfo));
+		return;
+	}
+
+	if (blockOffset >= sImage.length)
+	{
+		otCoapMessageInitResponse(responseMessage, aMessage, OT_COAP_TYPE_ACKNOWLEDGMENT, OT_COAP_CODE_BAD_OPTION);
+		SuccessOrExit(error = otCoapSendResponse(OT_INSTANCE, responseMessage, aMessageInfo));
+		return;
+	}
+	blockLength = sImage.length - blockOffset;
+	more        = blockLength > otCoapBlockSizeFromExponent(blockSzx);
+	if (more)
+		blockLength = otCoapBlockSizeFromExponent(blockSzx);
+
+	if (blockOffset == 0)
+	{
+		printf_time("Sending \"%s\" to [%x:%x:%x:%x:%x:%x:%x:%x]\r\n",
+		            sImage.fileName,
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 0),
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 2),
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 4),
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 6),
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 8),
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 10),
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 12),
+		            GETBE16(aMessageInfo->mPeerAddr.mFields.m8 + 14));
+	}
+
+	// CoAP header, piggybacked on the acknowledgement
+	otCoapMessageInitResponse(responseMessage, aMessage, OT_COAP_TYPE_ACKNOWLEDGMENT, OT_COAP_CODE_CONTENT);
+	SuccessOrExit(error = otCoapMessageAppendOption(
+	                  responseMessage, OT_COAP_OPTION_E_TAG, IMAGE_ETAG_LENGTH, sImage.etag));
+	SuccessOrExit(error = otCoapMessageAppendContentFormatOption(responseMessage,
+	                                                             OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM));
+	SuccessOrExit(error = otCoapMessageAppendBlock2Option(responseMessage, blockNum, more, blockSzx));
+	SuccessOrExit(error = otCoapMessageAppendUintOption(responseMessage, OT_COAP_OPTION_SIZE2, sImage.length));
+	SuccessOrExit(error = otCoapMessageSetPayloadMarker(responseMessage));
+
+	// CoAP Payload: the requested block of the image
+	SuccessOrExit(error = otMessageAppend(responseMessage, sImage.data + blockOffset, blockLength));
+	SuccessOrExit(error = otCoapSendResponse(OT_INSTANCE, responseMessage, aMessageInfo));
+
+	sImage.requests++;
+	if (!more)
+	{
+		sImage.downloads++;
+		printf_time("Sent the last block of \"%s\"\r\n", sImage.fileName);
+	}
+
+exit:
+	if (error != OT_ERROR_NONE && responseMessage != NULL)
+	{
+		printf_time("Firmware response failed: Error %d: %s\r\n", error, otThreadErrorToString(error));
+		otMessageFree(responseMessage);
+	}
+}
+
+static uint32_t getMulticastBlockCount(void)
+{
+	uint32_t blockSize = otCoapBlockSizeFromExponent(MULTICAST_BLOCK_SZX);
+
+	return (sImage.length + blockSize - 1) / blockSize;
+}
+
+/**
+ * Send the next block of the image to the multicast group.
+ */
+static void sendMulticastBlock(void)
+{
+	otError       error   = OT_ERROR_NONE;
+	otMessage    *message = NULL;
+	otMessageInfo messageInfo;
+	size_t        blockSize   = otCoapBlockSizeFromExponent(MULTICAST_BLOCK_SZX);
+	size_t        blockOffset = (size_t)sMulticast.nextBlock * blockSize;
+	size_t        blockLength = sImage.length - blockOffset;
+	bool          more        = blockLength > blockSize;
+
+	if (more)
+		blockLength = blockSize;
+
+	message = otCoapNewMessage(OT_INSTANCE, NULL);
+	if (message == NULL)
+	{
+		error = OT_ERROR_NO_BUFS;
+		goto exit;
+	}
+
+	otCoapMessageInit(message, OT_COAP_TYPE_NON_CONFIRMABLE, OT_COAP_CODE_POST);
+	otCoapMessageGenerateToken(message, 2);
+	SuccessOrExit(error = otCoapMessageAppendOption(message, OT_COAP_OPTION_E_TAG, IMAGE_ETAG_LENGTH, sImage.etag));
+	SuccessOrExit(error = otCoapMessageAppendUriPathOptions(message, sMulticastUri));
+	SuccessOrExit(error = otCoapMessageAppendContentFormatOption(message, OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM));
+	SuccessOrExit(error = otCoapMessageAppendBlock1Option(message, sMulticast.nextBlock, more, MULTICAST_BLOCK_SZX));
+	SuccessOrExit(error = otCoapMessageAppendUintOption(message, OT_COAP_OPTION_SIZE1, sImage.length));
+	SuccessOrExit(error = otCoapMessageSetPayloadMarker(message));
+	SuccessOrExit(error = otMessageAppend(message, sImage.data + blockOffset, blockLength));
+
+	memset(&messageInfo, 0, sizeof(messageInfo));
+	messageInfo.mPeerAddr = sMulticast.group;
+	messageInfo.mPeerPort = OT_DEFAULT_COAP_PORT;
+	SuccessOrExit(error = otCoapSendRequest(OT_INSTANCE, message, &messageInfo, NULL, NULL));
+
+	sMulticast.sent++;
+	if (!more)
+	{
+		printf_time("Sent the last block of \"%s\" to the multicast group\r\n", sImage.fileName);
+		sMulticast.active = false;
+	}
+	sMulticast.nextBlock++;
+
+exit:
+	// The block is sent again at the next interval
+	if (error != OT_ERROR_NONE && message != NULL)
+		otMessageFree(message);
+	if (error != OT_ERROR_NONE)
+		printf_time("Multicast block failed: Error %d: %s\r\n", error, otThreadErrorToString(error));
+}
+
+static void addMilliseconds(struct timespec *aTime, unsigned aMs)
+{
+	aTime->tv_sec += aMs / 1000;
+	aTime->tv_nsec += (aMs % 1000) * 1000000L;
+	if (aTime->tv_nsec >= 1000000000L)
+	{
+		aTime->tv_sec++;
+		aTime->tv_nsec -= 1000000000L;
+	}
+}
+
+/**
+ * Send the next block to the multicast group if it is due.
+ */
+static void processMulticast(void)
+{
+	struct timespec now;
+
+	if (!sMulticast.active)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (now.tv_sec < sMulticast.nextTime.tv_sec ||
+	    (now.tv_sec == sMulticast.nextTime.tv_sec && now.tv_nsec < sMulticast.nextTime.tv_nsec))
+	{
+		return;
+	}
+
+	if (sImage.data == NULL || sMulticast.nextBlock >= getMulticastBlockCount())
+		sMulticast.active = false;
+	else
+		sendMulticastBlock();
+
+	// Paced from when the block was sent, so that a slow loop doesn't result in a burst of blocks
+	sMulticast.nextTime = now;
+	addMilliseconds(&sMulticast.nextTime, sMulticast.intervalMs);
+}
+
+/**
+ * Reduce the timeout of the platform loop, so that it wakes up when the next multicast block is due.
+ */
+static void updateMulticastTimeout(struct timeval *aTimeout)
+{
+	struct timespec now;
+	long long       remainingUs;
+
+	if (!sMulticast.active)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	remainingUs = (sMulticast.nextTime.tv_sec - now.tv_sec) * 1000000LL +
+	              (sMulticast.nextTime.tv_nsec - now.tv_nsec) / 1000;
+	if (remainingUs < 0)
+		remainingUs = 0;
+
+	if (remainingUs < aTimeout->tv_sec * 1000000LL + aTimeout->tv_usec)
+	{
+		aTimeout->tv_sec  = remainingUs / 1000000;
+		aTimeout->tv_usec = remainingUs % 1000000;
+	}
+}
+
+static void registerCoapResources(otInstance *aInstance)
+{
+	otError error = OT_ERROR_NONE;
+
+	SuccessOrExit(error = otCoapStart(aInstance, OT_DEFAULT_COAP_PORT));
+
+	memset(&sFirmwareResource, 0, sizeof(sFirmwareResource));
+	sFirmwareResource.mUriPath = sFirmwareUri;
+	sFirmwareResource.mContext = aInstance;
+	sFirmwareResource.mHandler = &handleFirmwareRequest;
+
+	otCoapAddResource(aInstance, &sFirmwareResource);
+
+exit:
+	assert(error == OT_ERROR_NONE);
+	return;
+}
+
+static void handle_cli_image(void *aContext, uint8_t aArgsLength, char *aArgs[])
+{
+	(void)aContext;
+
+	if (aArgsLength == 1)
+	{
+		if (loadImage(aArgs[0]) != 0)
+			otCliOutputFormat("Error: Could not load image. Please try again.\r\n");
+		return;
+	}
+	if (aArgsLength != 0)
+	{
+		otCliOutputFormat("Parse error, usage: image [firmware.bin]\r\n");
+		return;
+	}
+
+	if (sImage.data == NULL)
+	{
+		otCliOutputFormat("No image loaded.\r\n");
+		return;
+	}
+	otCliOutputFormat("Image: %s, %zu bytes, ETag %08x\r\n", sImage.fileName, sImage.length, GETBE32(sImage.etag));
+	otCliOutputFormat("Blocks sent: %u, complete downloads: %u\r\n", sImage.requests, sImage.downloads);
+}
+
+static void handle_cli_multicast(void *aContext, uint8_t aArgsLength, char *aArgs[])
+{
+	unsigned     intervalMs = MULTICAST_DEFAULT_INTERVAL_MS;
+	otIp6Address group;
+	char        *end;
+
+	(void)aContext;
+
+	if (aArgsLength == 0)
+	{
+		otCliOutputFormat("Multicast: %s, block %u of %u, %u blocks sent\r\n",
+		                  sMulticast.active ? "sending" : "stopped",
+		                  sMulticast.nextBlock,
+		                  getMulticastBlockCount(),
+		                  sMulticast.sent);
+		return;
+	}
+
+	if (aArgsLength == 1 && strcmp(aArgs[0], "stop") == 0)
+	{
+		sMulticast.active = false;
+		return;
+	}
+
+	if (strcmp(aArgs[0], "start") != 0 || aArgsLength > 3)
+		goto usage;
+
+	if (aArgsLength > 1)
+	{
+		intervalMs = strtoul(aArgs[1], &end, 0);
+		if (*end != '\0' || intervalMs == 0)
+			goto usage;
+	}
+
+	otIp6AddressFromString("ff03::1", &group);
+	if (aArgsLength > 2 && otIp6AddressFromString(aArgs[2], &group) != OT_ERROR_NONE)
+		goto usage;
+
+	refreshImage();
+	if (sImage.data == NULL)
+	{
+		otCliOutputFormat("No image loaded.\r\n");
+		return;
+	}
+
+	sMulticast.active     = true;
+	sMulticast.group      = group;
+	sMulticast.intervalMs = intervalMs;
+	sMulticast.nextBlock  = 0;
+	clock_gettime(CLOCK_MONOTONIC, &sMulticast.nextTime);
+	otCliOutputFormat("Sending %u blocks, one every %u ms\r\n", getMulticastBlockCount(), intervalMs);
+	return;
+
+usage:
+	otCliOutputFormat("Parse error, usage: multicast [start [interval ms] [group address] | stop]\r\n");
+}
+
+static void init_ota_commands(otInstance *aInstance)
+{
+	sCliCommands[0].mCommand = &handle_cli_image;
+	sCliCommands[0].mName    = "image";
+	sCliCommands[1].mCommand = &handle_cli_multicast;
+	sCliCommands[1].mName    = "multicast";
+
+	otCliSetUserCommands(sCliCommands, 2, aInstance);
+}
+
+static void quit(int sig)
+{
+	(void)sig;
+	isRunning = 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct timeval timeout;
+
+	printf_time("Thread OTA Server %s initialising...\r\n", ca821x_get_version());
+
+	if (argc > 1)
+		NODE_ID = atoi(argv[1]);
+	else
+		NODE_ID = 598;
+
+	posixPlatformSetOrigArgs(argc, argv);
+	while (posixPlatformInit() < 0) sleep(1);
+	OT_INSTANCE = otInstanceInitSingle();
+	otAppCliInit(OT_INSTANCE);
+
+	isRunning = 1;
+	signal(SIGINT, quit);
+
+	otIp6SetEnabled(OT_INSTANCE, true);
+	registerCoapResources(OT_INSTANCE);
+	init_ota_commands(OT_INSTANCE);
+
+	if (argc > 2)
+		loadImage(argv[2]);
+
+	printf_time("Initialisation complete.\r\n");
+
+	while (isRunning)
+	{
+		otTaskletsProcess(OT_INSTANCE);
+		posixPlatformProcessDriversQuick(OT_INSTANCE);
+		processMulticast();
+
+		posixPlatformGetTimeout(OT_INSTANCE, &timeout);
+		updateMulticastTimeout(&timeout);
+		posixPlatformSleep(OT_INSTANCE, &timeout);
+	}
+
+	return 0;
+}
@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 #include <termios.h>
 #include <unistd.h>
 
@@ -24,16 +25,57 @@ int   unlockpt(int fd);
 char *ptsname(int fd);
 #endif // OPENTHREAD_TARGET_LINUX
 
+// Default number of frames from the device that can wait to be written to the pty
+#define WRITE_QUEUE_DEFAULT_DEPTH 32
+// Maximum number of frames written to the pty with a single writev()
+#define WRITE_BATCH_MAX 16
+
+/** What the dispatch thread does with a frame from the device when the write queue is full */
+enum queue_policy
+{
+	QUEUE_POLICY_BLOCK,       //!< Wait for the pty reader, which stalls the upstream dispatch but loses nothing
+	QUEUE_POLICY_DROP_NEWEST, //!< Discard the new frame
+	QUEUE_POLICY_DROP_OLDEST, //!< Discard the oldest frame that isn't being written
+};
+
+/** A frame from the device, waiting to be written to the pty */
+struct write_frame
+{
+	uint8_t data[255];
+	uint8_t length;
+};
+
+/** Counters of the write queue, printed on SIGUSR1 and at exit */
+struct write_stats
+{
+	unsigned long queued;   //!< Frames added to the queue
+	unsigned long written;  //!< Frames completely written to the pty
+	unsigned long bytes;    //!< Bytes written to the pty
+	unsigned long writes;   //!< Calls to writev()
+	unsigned long dropped;  //!< Frames discarded because the queue was full
+	unsigned long stalls;   //!< Times the dispatch thread waited because the queue was full
+	unsigned long maxCount; //!< Most frames queued at once
+};
+
 static struct ca821x_dev  sDeviceRef;
 static struct ca821x_dev *pDeviceRef;
 
 static uint8_t s_receive_buffer[128];
-static uint8_t s_write_buffer[255];
-static size_t  s_write_length;
-static size_t  s_write_offset;
 static int     s_in_fd;
 static int     s_out_fd;
 
+// Ring of frames waiting to be written to the pty, guarded by s_write_mutex
+static struct write_frame *s_write_queue;
+static size_t              s_write_depth = WRITE_QUEUE_DEFAULT_DEPTH;
+static size_t              s_write_head;     //!< Index of the oldest frame
+static size_t              s_write_count;    //!< Number of frames queued
+static size_t              s_write_offset;   //!< Bytes of the oldest frame already written
+static size_t              s_write_inflight; //!< Frames being written by writev(), which must not be dropped
+static enum queue_policy   s_queue_policy = QUEUE_POLICY_BLOCK;
+static struct write_stats  s_write_stats;
+
+static volatile sig_atomic_t s_print_stats;
+
 static int selfpipe[2];
 
 static uint8_t s_enabled = false;
@@ -191,20 +233,63 @@ static ca_error handle_evbme_message(struct EVBME_Message *params, struct ca821x
 	return CA_ERROR_SUCCESS;
 }
 
+static struct write_frame *get_queued_frame(size_t position)
+{
+	return &s_write_queue[(s_write_head + position) % s_write_depth];
+}
+
+/* Make space in the full write queue, according to the policy. Returns false if the new frame must be dropped.
+ * Must be called with s_write_mutex held.
+ */
+static bool make_queue_space(void)
+{
+	// Frames being written, and a frame that was partly written, must stay in the queue
+	size_t keep = s_write_inflight ? s_write_inflight : (s_write_offset ? 1 : 0);
+
+	switch (s_queue_policy)
+	{
+	case QUEUE_POLICY_BLOCK:
+		s_write_stats.stalls++;
+		while (s_write_count == s_write_depth) pthread_cond_wait(&s_write_cond, &s_write_mutex);
+		return true;
+	case QUEUE_POLICY_DROP_OLDEST:
+		if (keep == s_write_count)
+			break;
+		for (size_t i = keep; i + 1 < s_write_count; i++) *get_queued_frame(i) = *get_queued_frame(i + 1);
+		s_write_count--;
+		s_write_stats.dropped++;
+		return true;
+	case QUEUE_POLICY_DROP_NEWEST:
+		break;
+	}
+	s_write_stats.dropped++;
+	return false;
+}
+
 static ca_error handle_user_command(const uint8_t *buf, size_t len, struct ca821x_dev *pDeviceRef)
 {
 	ca_error error = CA_ERROR_NOT_HANDLED;
 
 	if (buf[0] == 0xB3)
 	{
+		struct write_frame *frame;
+
 		pthread_mutex_lock(&s_write_mutex);
 
-		write(selfpipe[1], "a", 1);
-		while (s_write_length) pthread_cond_wait(&s_write_cond, &s_write_mutex);
+		if (s_write_count < s_write_depth || make_queue_space())
+		{
+			frame         = get_queued_frame(s_write_count);
+			frame->length = len - 2;
+			memcpy(frame->data, buf + 2, frame->length);
 
-		s_write_length = len - 2;
-		s_write_offset = 0;
-		memcpy(s_write_buffer, buf + 2, s_write_length);
+			// Wake the poll thread, so that it waits for the pty to be writable
+			if (s_write_count++ == 0)
+				write(selfpipe[1], "a", 1);
+
+			s_write_stats.queued++;
+			if (s_write_count > s_write_stats.maxCount)
+				s_write_stats.maxCount = s_write_count;
+		}
 
 		pthread_mutex_unlock(&s_write_mutex);
 		error = CA_ERROR_SUCCESS;
@@ -213,13 +298,89 @@ static ca_error handle_user_command(const uint8_t *buf, size_t len, struct ca821
 	return error;
 }
 
+/* Write as many queued frames as possible to the pty, with a single writev() */
+static void write_queued_frames(void)
+{
+	struct iovec iov[WRITE_BATCH_MAX];
+	int          iovcnt = 0;
+	ssize_t      rval;
+
+	pthread_mutex_lock(&s_write_mutex);
+	for (size_t i = 0; i < s_write_count && iovcnt < WRITE_BATCH_MAX; i++)
+	{
+		struct write_frame *frame  = get_queued_frame(i);
+		size_t              offset = i ? 0 : s_write_offset;
+
+		iov[iovcnt].iov_base = frame->data + offset;
+		iov[iovcnt].iov_len  = frame->length - offset;
+		iovcnt++;
+	}
+	s_write_inflight = iovcnt;
+	pthread_mutex_unlock(&s_write_mutex);
+
+	// The dispatch thread can keep queueing frames while a slow reader blocks this
+	rval = writev(s_out_fd, iov, iovcnt);
+
+	if (rval < 0)
+	{
+		perror("write");
+		exit(EXIT_FAILURE);
+	}
+
+	pthread_mutex_lock(&s_write_mutex);
+	s_write_inflight = 0;
+	s_write_stats.writes++;
+	s_write_stats.bytes += rval;
+	while (s_write_count && rval >= (ssize_t)(get_queued_frame(0)->length - s_write_offset))
+	{
+		rval -= get_queued_frame(0)->length - s_write_offset;
+		s_write_head   = (s_write_head + 1) % s_write_depth;
+		s_write_offset = 0;
+		s_write_count--;
+		s_write_stats.written++;
+
+		// Allow next message to be loaded
+		pthread_cond_signal(&s_write_cond);
+	}
+	s_write_offset += rval;
+	pthread_mutex_unlock(&s_write_mutex);
+}
+
+static void print_stats(void)
+{
+	struct write_stats stats;
+
+	pthread_mutex_lock(&s_write_mutex);
+	stats = s_write_stats;
+	pthread_mutex_unlock(&s_write_mutex);
+
+	fprintf(stderr,
+	        "Write queue: %lu frames queued, %lu written (%lu bytes in %lu writes), %lu dropped, %lu stalls, "
+	        "at most %lu/%zu queued\r\n",
+	        stats.queued,
+	        stats.written,
+	        stats.bytes,
+	        stats.writes,
+	        stats.dropped,
+	        stats.stalls,
+	        stats.maxCount,
+	        s_write_depth);
+}
+
+static void handle_sigusr1(int sig)
+{
+	(void)sig;
+	s_print_stats = true;
+	write(selfpipe[1], "s", 1);
+}
+
 void process_io(void)
 {
 	ssize_t   rval;
 	uint8_t   junkBuf;
 	const int error_flags = POLLERR | POLLNVAL | POLLHUP;
 	pthread_mutex_lock(&s_write_mutex);
-	const int out_flag = (s_write_length > 0) ? POLLOUT : 0;
+	const int out_flag = (s_write_count > 0) ? POLLOUT : 0;
 	pthread_mutex_unlock(&s_write_mutex);
 	struct pollfd pollfd[] = {
 	    {s_in_fd, POLLIN | error_flags, 0},
@@ -232,12 +393,18 @@ void process_io(void)
 	rval = poll(pollfd, sizeof(pollfd) / sizeof(*pollfd), -1);
 	read(selfpipe[0], &junkBuf, 1);
 
-	if (rval < 0)
+	if (rval < 0 && errno != EINTR)
 	{
 		perror("poll");
 		exit(EXIT_FAILURE);
 	}
 
+	if (s_print_stats)
+	{
+		s_print_stats = false;
+		print_stats();
+	}
+
 	if (rval > 0)
 	{
 		if ((pollfd[0].revents & error_flags) != 0)
@@ -267,44 +434,75 @@ void process_io(void)
 			exchange_user_command(0xB2, (uint8_t)rval, s_receive_buffer, pDeviceRef);
 		}
 
-		pthread_mutex_lock(&s_write_mutex);
-		if ((s_write_length > 0) && (pollfd[1].revents & POLLOUT))
-		{
-			rval = write(s_out_fd, s_write_buffer + s_write_offset, s_write_length);
+		if (pollfd[1].revents & POLLOUT)
+			write_queued_frames();
+	}
+}
 
-			if (rval <= 0)
-			{
-				perror("write");
-				exit(EXIT_FAILURE);
-			}
+static void usage(const char *exec_name)
+{
+	fprintf(stderr, "Usage: %s [-q DEPTH] [-p block|drop-newest|drop-oldest] [SERIALNO]\n", exec_name);
+	fprintf(stderr, "\tBridge the serial application of a Chili to stdin and stdout.\n\n");
+	fprintf(stderr,
+	        "\t-q DEPTH   Frames from the device that can wait to be written (default %d)\n",
+	        WRITE_QUEUE_DEFAULT_DEPTH);
+	fprintf(stderr, "\t-p POLICY  What to do with a frame from the device when the queue is full (default block)\n");
+	fprintf(stderr, "\t           block stalls the device until there is space, the others drop a frame\n");
+	fprintf(stderr, "\tThe counters of the queue are printed to stderr on SIGUSR1 and at exit.\n");
+}
 
-			s_write_offset += rval;
-			s_write_length -= rval;
+int main(int argc, char *argv[])
+{
+	union ca821x_util_init_extra_arg arg = {.generic = NULL};
+	int                              opt;
 
-			if (s_write_length == 0)
+	while ((opt = getopt(argc, argv, "q:p:h")) != -1)
+	{
+		switch (opt)
+		{
+		case 'q':
+			s_write_depth = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			if (strcmp(optarg, "block") == 0)
+				s_queue_policy = QUEUE_POLICY_BLOCK;
+			else if (strcmp(optarg, "drop-newest") == 0)
+				s_queue_policy = QUEUE_POLICY_DROP_NEWEST;
+			else if (strcmp(optarg, "drop-oldest") == 0)
+				s_queue_policy = QUEUE_POLICY_DROP_OLDEST;
+			else
 			{
-				// Allow next message to be loaded;
-				pthread_cond_signal(&s_write_cond);
+				usage(argv[0]);
+				return -1;
 			}
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : -1;
 		}
-		pthread_mutex_unlock(&s_write_mutex);
 	}
-}
-
-int main(int argc, char *argv[])
-{
-	union ca821x_util_init_extra_arg arg = {.generic = NULL};
-	if (argc > 1)
+	if (s_write_depth < 1 || s_write_depth > 4096 || argc - optind > 1)
 	{
-		arg.serial_num = argv[1];
+		usage(argv[0]);
+		return -1;
+	}
+	if (optind < argc)
+	{
+		arg.serial_num = argv[optind];
 	}
 
+	s_write_queue = calloc(s_write_depth, sizeof(*s_write_queue));
+	if (!s_write_queue)
+		return -1;
+
 	pDeviceRef = &sDeviceRef;
 	while (ca821x_util_init(pDeviceRef, NULL, arg))
 	{
 		return -1;
 	}
 	configure_io();
+	signal(SIGUSR1, handle_sigusr1);
+	atexit(print_stats);
 
 	if (EVBME_CheckVersion(NULL, pDeviceRef) != CA_ERROR_SUCCESS)
 		exit(1);
@@ -0,0 +1,531 @@
+/*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file
+ * Buffered capture writer for the sniffer.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "capture-writer.h"
+
+/** Maximum length of a generated capture file name */
+#define CAPTURE_MAX_PATH 512
+
+#if defined(_WIN32)
+#define CAPTURE_FD_INVALID INVALID_HANDLE_VALUE
+#else
+#define CAPTURE_FD_INVALID (-1)
+#endif
+
+/** One contiguous region of the ring, to be written out in a single vectored write */
+struct capture_segment
+{
+	const uint8_t *data;
+	size_t         len;
+};
+
+static struct capture_writer_config sConfig;
+static struct capture_writer_stats  sStats;
+
+static pthread_mutex_t sRingMutex  = PTHREAD_MUTEX_INITIALIZER; //!< Protects the ring state and stats
+static pthread_mutex_t sFlushMutex = PTHREAD_MUTEX_INITIALIZER; //!< Serialises flushes to the output
+static pthread_cond_t  sFlushCond  = PTHREAD_COND_INITIALIZER;  //!< Signalled when the flush threshold is reached
+
+static uint8_t *sRing;     //!< Ring buffer storage
+static size_t   sRingTail; //!< Offset of the oldest buffered byte
+static size_t   sRingUsed; //!< Number of buffered bytes
+
+static uint8_t *sHeader;        //!< Header to write at the start of each file/stream
+static size_t   sHeaderLen;     //!< Length of sHeader
+static bool     sHeaderPending; //!< The header must be written before any more records
+static size_t   sHeaderSent;    //!< Bytes of the pending header that have already been written
+
+static capture_fd_t sOutput = CAPTURE_FD_INVALID; //!< Current output file or stream
+static bool         sOwnOutput;                   //!< sOutput is a capture file owned by the writer
+static uint64_t     sFileBytes;                   //!< Bytes written to the current capture file
+static time_t       sFileOpened;                  //!< Monotonic time at which the current capture file was opened
+static char       **sFileNames;                   //!< Names of kept capture files, for rotate_files
+static uint32_t     sFileNameIndex;               //!< Next slot in sFileNames to use
+
+/**
+ * Get the monotonic time in seconds.
+ */
+static time_t monotonic_seconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec;
+}
+
+/**
+ * Is file rotation enabled?
+ */
+static bool rotation_enabled(void)
+{
+	return sConfig.file_path && (sConfig.rotate_bytes || sConfig.rotate_seconds);
+}
+
+#if defined(_WIN32)
+static capture_fd_t platform_open(const char *path)
+{
+	return CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+}
+
+static void platform_close(capture_fd_t fd)
+{
+	CloseHandle(fd);
+}
+
+static ca_error platform_writev(const struct capture_segment *segs, int count, size_t *total)
+{
+	*total = 0;
+	for (int i = 0; i < count; i++)
+	{
+		const uint8_t *data = segs[i].data;
+		size_t         len  = segs[i].len;
+
+		while (len)
+		{
+			DWORD written = 0;
+
+			if (!WriteFile(sOutput, data, (DWORD)len, &written, NULL) || written == 0)
+				return CA_ERROR_FAIL;
+			data += written;
+			len -= written;
+			*total += written;
+		}
+	}
+	FlushFileBuffers(sOutput);
+	return CA_ERROR_SUCCESS;
+}
+#else
+static capture_fd_t platform_open(const char *path)
+{
+	return open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+static void platform_close(capture_fd_t fd)
+{
+	close(fd);
+}
+
+static ca_error platform_writev(const struct capture_segment *segs, int count, size_t *total)
+{
+	struct iovec iov[3];
+	int          iovcnt = 0;
+
+	*total = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (!segs[i].len)
+			continue;
+		iov[iovcnt].iov_base = (void *)segs[i].data;
+		iov[iovcnt].iov_len  = segs[i].len;
+		iovcnt++;
+	}
+
+	while (iovcnt)
+	{
+		ssize_t written = writev(sOutput, iov, iovcnt);
+
+		if (written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return CA_ERROR_FAIL;
+		}
+		*total += written;
+
+		// Handle partial writes, which are common on pipes
+		struct iovec *cur = iov;
+		while (iovcnt && (size_t)written >= cur->iov_len)
+		{
+			written -= cur->iov_len;
+			cur++;
+			iovcnt--;
+		}
+		if (iovcnt)
+		{
+			cur->iov_base = (uint8_t *)cur->iov_base + written;
+			cur->iov_len -= written;
+		}
+		memmove(iov, cur, iovcnt * sizeof(*iov));
+	}
+	return CA_ERROR_SUCCESS;
+}
+#endif
+
+/**
+ * Build the name of the next capture file. With rotation enabled, a sequence number and
+ * timestamp are inserted before the file extension, eg. capture_00001_20240101120000.pcap
+ */
+static void make_file_name(char *buf, size_t maxlen)
+{
+	const char *path = sConfig.file_path;
+	const char *ext;
+	const char *sep;
+	char        timeString[20];
+	time_t      now = time(NULL);
+
+	if (!rotation_enabled())
+	{
+		snprintf(buf, maxlen, "%s", path);
+		return;
+	}
+
+	strftime(timeString, sizeof(timeString), "%Y%m%d%H%M%S", localtime(&now));
+	ext = strrchr(path, '.');
+	sep = strrchr(path, '/');
+	if (!sep)
+		sep = strrchr(path, '\\');
+	if (!ext || (sep && ext < sep))
+		ext = path + strlen(path);
+
+	snprintf(buf, maxlen, "%.*s_%05u_%s%s", (int)(ext - path), path, sStats.files + 1, timeString, ext);
+}
+
+/**
+ * Close the current capture file (if any) and open the next one, deleting the oldest file if
+ * more than rotate_files would be kept.
+ */
+static ca_error open_next_file(void)
+{
+	char name[CAPTURE_MAX_PATH];
+
+	if (sOwnOutput && sOutput != CAPTURE_FD_INVALID)
+		platform_close(sOutput);
+	sOutput    = CAPTURE_FD_INVALID;
+	sOwnOutput = false;
+
+	make_file_name(name, sizeof(name));
+
+	if (sFileNames)
+	{
+		char **slot = &sFileNames[sFileNameIndex];
+
+		if (*slot)
+		{
+			remove(*slot);
+			free(*slot);
+		}
+		*slot = malloc(strlen(name) + 1);
+		if (*slot)
+			strcpy(*slot, name);
+		sFileNameIndex = (sFileNameIndex + 1) % sConfig.rotate_files;
+	}
+
+	sOutput = platform_open(name);
+	if (sOutput == CAPTURE_FD_INVALID)
+	{
+		fprintf(stderr, "Failed to open capture file %s\n", name);
+		return CA_ERROR_FAIL;
+	}
+
+	sOwnOutput     = true;
+	sFileBytes     = 0;
+	sFileOpened    = monotonic_seconds();
+	sHeaderPending = true;
+	sHeaderSent    = 0;
+	pthread_mutex_lock(&sRingMutex);
+	sStats.files++;
+	pthread_mutex_unlock(&sRingMutex);
+	return CA_ERROR_SUCCESS;
+}
+
+/**
+ * Check whether the current capture file has reached its size or age limit.
+ */
+static bool rotation_due(void)
+{
+	if (!rotation_enabled() || !sOwnOutput)
+		return false;
+	if (sConfig.rotate_bytes && sFileBytes >= sConfig.rotate_bytes)
+		return true;
+	if (sConfig.rotate_seconds && (monotonic_seconds() - sFileOpened) >= (time_t)sConfig.rotate_seconds)
+		return true;
+	return false;
+}
+
+/**
+ * Write out everything that is currently in the ring. Must be called with sFlushMutex held.
+ */
+static void flush_locked(void)
+{
+	struct capture_segment segs[3];
+	int                    count = 0;
+	size_t                 used, tail, first, written, header;
+	ca_error               error;
+
+	if (rotation_due())
+		open_next_file();
+
+	if (sOutput == CAPTURE_FD_INVALID)
+		return;
+
+	pthread_mutex_lock(&sRingMutex);
+	used = sRingUsed;
+	tail = sRingTail;
+	pthread_mutex_unlock(&sRingMutex);
+
+	if (!used && !sHeaderPending)
+		return;
+
+	// Records are only ever appended by producers, so the snapshot region stays valid while unlocked
+	header = sHeaderPending ? sHeaderLen - sHeaderSent : 0;
+	if (header)
+	{
+		segs[count].data = sHeader + sHeaderSent;
+		segs[count].len  = header;
+		count++;
+	}
+	first            = sConfig.buffer_size - tail;
+	first            = (used < first) ? used : first;
+	segs[count].data = sRing + tail;
+	segs[count].len  = first;
+	count++;
+	segs[count].data = sRing;
+	segs[count].len  = used - first;
+	count++;
+
+	error = platform_writev(segs, count, &written);
+	if (error && !sOwnOutput && sConfig.stream_error_callback)
+	{
+		// Stream broken, the callback provides a new one and the header and records are rewritten to it
+		sOutput        = sConfig.stream_error_callback();
+		sHeaderPending = true;
+		sHeaderSent    = 0;
+		return;
+	}
+
+	// Whatever made it out is consumed even on failure, so that the next flush does not write it again
+	if (written < header)
+	{
+		sHeaderSent += written;
+		return;
+	}
+	written -= header;
+	sHeaderPending = false;
+	sHeaderSent    = 0;
+	sFileBytes += written;
+	pthread_mutex_lock(&sRingMutex);
+	sRingTail = (tail + written) % sConfig.buffer_size;
+	sRingUsed -= written;
+	sStats.bytes += written;
+	if (!error)
+		sStats.flushes++;
+	pthread_mutex_unlock(&sRingMutex);
+}
+
+ca_error capture_writer_init(const struct capture_writer_config *config)
+{
+	if (!config->buffer_size || config->flush_threshold > config->buffer_size)
+		return CA_ERROR_INVALID_ARGS;
+	if ((config->rotate_bytes || config->rotate_seconds || config->rotate_files) && !config->file_path)
+		return CA_ERROR_INVALID_ARGS;
+
+	sConfig = *config;
+	memset(&sStats, 0, sizeof(sStats));
+	sRingTail = 0;
+	sRingUsed = 0;
+
+	sRing = malloc(sConfig.buffer_size);
+	if (!sRing)
+		return CA_ERROR_NO_BUFFER;
+
+	if (rotation_enabled() && sConfig.rotate_files)
+	{
+		sFileNames     = calloc(sConfig.rotate_files, sizeof(*sFileNames));
+		sFileNameIndex = 0;
+		if (!sFileNames)
+			return CA_ERROR_NO_BUFFER;
+	}
+
+	if (sConfig.file_path)
+		return open_next_file();
+
+	return CA_ERROR_SUCCESS;
+}
+
+void capture_writer_deinit(void)
+{
+	capture_writer_flush();
+
+	pthread_mutex_lock(&sFlushMutex);
+	if (sOwnOutput && sOutput != CAPTURE_FD_INVALID)
+		platform_close(sOutput);
+	sOutput    = CAPTURE_FD_INVALID;
+	sOwnOutput = false;
+
+	if (sFileNames)
+	{
+		for (uint32_t i = 0; i < sConfig.rotate_files; i++) free(sFileNames[i]);
+		free(sFileNames);
+		sFileNames = NULL;
+	}
+
+	pthread_mutex_lock(&sRingMutex);
+	free(sRing);
+	sRing = NULL;
+	free(sHeader);
+	sHeader    = NULL;
+	sHeaderLen = 0;
+	pthread_mutex_unlock(&sRingMutex);
+	pthread_mutex_unlock(&sFlushMutex);
+}
+
+void capture_writer_set_stream(capture_fd_t fd)
+{
+	pthread_mutex_lock(&sFlushMutex);
+	sOutput        = fd;
+	sOwnOutput     = false;
+	sHeaderPending = true;
+	sHeaderSent    = 0;
+	pthread_mutex_unlock(&sFlushMutex);
+}
+
+ca_error capture_writer_set_header(const void *hdr, size_t len)
+{
+	uint8_t *copy = malloc(len);
+
+	if (!copy)
+		return CA_ERROR_NO_BUFFER;
+	memcpy(copy, hdr, len);
+
+	pthread_mutex_lock(&sFlushMutex);
+	free(sHeader);
+	sHeader        = copy;
+	sHeaderLen     = len;
+	sHeaderPending = true;
+	sHeaderSent    = 0;
+	flush_locked();
+	pthread_mutex_unlock(&sFlushMutex);
+
+	return CA_ERROR_SUCCESS;
+}
+
+ca_error capture_writer_record(const struct capture_part *parts, size_t count)
+{
+	ca_error error = CA_ERROR_SUCCESS;
+	size_t   len   = 0;
+	size_t   head;
+
+	if (count > CAPTURE_MAX_PARTS)
+		return CA_ERROR_INVALID_ARGS;
+
+	for (size_t i = 0; i < count; i++) len += parts[i].len;
+
+	pthread_mutex_lock(&sRingMutex);
+	if (!sRing || len > sConfig.buffer_size - sRingUsed)
+	{
+		sStats.dropped++;
+		error = CA_ERROR_NO_BUFFER;
+		goto exit;
+	}
+
+	head = (sRingTail + sRingUsed) % sConfig.buffer_size;
+	for (size_t i = 0; i < count; i++)
+	{
+		const uint8_t *data = parts[i].data;
+		size_t         rem  = parts[i].len;
+
+		while (rem)
+		{
+			size_t chunk = sConfig.buffer_size - head;
+
+			chunk = (rem < chunk) ? rem : chunk;
+			memcpy(sRing + head, data, chunk);
+			head = (head + chunk) % sConfig.buffer_size;
+			data += chunk;
+			rem -= chunk;
+		}
+	}
+
+	sRingUsed += len;
+	sStats.records++;
+	if (sRingUsed > sStats.high_watermark)
+		sStats.high_watermark = sRingUsed;
+	if (sRingUsed >= sConfig.flush_threshold)
+		pthread_cond_signal(&sFlushCond);
+
+exit:
+	pthread_mutex_unlock(&sRingMutex);
+	return error;
+}
+
+void capture_writer_process(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += sConfig.flush_period_ms / 1000;
+	ts.tv_nsec += (sConfig.flush_period_ms % 1000) * 1000000L;
+	if (ts.tv_nsec >= 1000000000L)
+	{
+		ts.tv_nsec -= 1000000000L;
+		ts.tv_sec += 1;
+	}
+
+	pthread_mutex_lock(&sRingMutex);
+	while (sRingUsed < sConfig.flush_threshold)
+	{
+		if (pthread_cond_timedwait(&sFlushCond, &sRingMutex, &ts) == ETIMEDOUT)
+			break;
+	}
+	pthread_mutex_unlock(&sRingMutex);
+
+	capture_writer_flush();
+}
+
+void capture_writer_flush(void)
+{
+	pthread_mutex_lock(&sFlushMutex);
+	flush_locked();
+	pthread_mutex_unlock(&sFlushMutex);
+}
+
+void capture_writer_get_stats(struct capture_writer_stats *stats)
+{
+	pthread_mutex_lock(&sRingMutex);
+	*stats = sStats;
+	pthread_mutex_unlock(&sRingMutex);
+}
@@ -0,0 +1,149 @@
+/*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file
+ * Buffered capture writer for the sniffer.
+ *
+ * Capture records are appended to a ring buffer by the upstream dispatch thread, and written out
+ * in large vectored writes by the thread calling capture_writer_process(). If the output stalls
+ * and the ring fills up, new records are dropped (and counted) rather than blocking the exchange.
+ * When writing to a file, the output can be rotated by size or duration.
+ */
+
+#ifndef CAPTURE_WRITER_H
+#define CAPTURE_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
+
+#include "ca821x_error.h"
+
+#if defined(_WIN32)
+typedef HANDLE capture_fd_t;
+#else
+typedef int capture_fd_t;
+#endif
+
+/** Maximum number of parts that a single record can be made of */
+#define CAPTURE_MAX_PARTS 4
+
+/** One contiguous part of a capture record */
+struct capture_part
+{
+	const void *data; //!< Pointer to the data of this part
+	size_t      len;  //!< Length of the data in bytes
+};
+
+/** Configuration of the capture writer */
+struct capture_writer_config
+{
+	size_t      buffer_size;     //!< Size of the capture ring buffer in bytes
+	size_t      flush_threshold; //!< Number of buffered bytes that triggers a flush before the flush period
+	uint32_t    flush_period_ms; //!< Maximum time that a record is buffered before it is written
+	const char *file_path;       //!< Capture file path, or NULL to write to the stream set with capture_writer_set_stream
+	uint64_t    rotate_bytes;    //!< Start a new file once the current one exceeds this size (0 to disable)
+	uint32_t    rotate_seconds;  //!< Start a new file once the current one is this old (0 to disable)
+	uint32_t    rotate_files;    //!< Number of rotated files to keep, older files are deleted (0 to keep all)
+	/** Called when writing to the stream failed. Returns the replacement stream to write to. */
+	capture_fd_t (*stream_error_callback)(void);
+};
+
+/** Statistics of the capture writer */
+struct capture_writer_stats
+{
+	uint64_t records;        //!< Number of records accepted into the buffer
+	uint64_t bytes;          //!< Number of bytes written to the output
+	uint32_t dropped;        //!< Number of records dropped because the buffer was full
+	uint32_t flushes;        //!< Number of flushes to the output
+	uint32_t files;          //!< Number of capture files opened
+	size_t   high_watermark; //!< Highest number of bytes buffered at once
+};
+
+/**
+ * Initialise the capture writer. If a file path is configured, the first capture file is opened.
+ * @param config Configuration of the writer, copied internally.
+ * @retval CA_ERROR_SUCCESS  Writer initialised
+ * @retval CA_ERROR_INVALID_ARGS  Invalid configuration
+ * @retval CA_ERROR_NO_BUFFER  Failed to allocate the ring buffer
+ * @retval CA_ERROR_FAIL  Failed to open the capture file
+ */
+ca_error capture_writer_init(const struct capture_writer_config *config);
+
+/**
+ * Flush all buffered records, close the output and free the ring buffer.
+ */
+void capture_writer_deinit(void);
+
+/**
+ * Set the stream to write to when not writing to a file. The file header is written to it
+ * before the next record.
+ * @param fd The output stream
+ */
+void capture_writer_set_stream(capture_fd_t fd);
+
+/**
+ * Set the header that must begin every output file or stream (eg. the pcap global header). It
+ * is written immediately, and again whenever the file is rotated or the stream is replaced.
+ * @param hdr Pointer to the header, copied internally
+ * @param len Length of the header in bytes
+ * @return Status of the operation
+ */
+ca_error capture_writer_set_header(const void *hdr, size_t len);
+
+/**
+ * Append one record to the capture buffer. The record is either buffered entirely or dropped.
+ * Safe to call from any thread.
+ * @param parts Array of parts that make up the record, concatenated in order
+ * @param count Number of parts (max CAPTURE_MAX_PARTS)
+ * @retval CA_ERROR_SUCCESS  Record buffered
+ * @retval CA_ERROR_NO_BUFFER  Buffer full, record dropped
+ */
+ca_error capture_writer_record(const struct capture_part *parts, size_t count);
+
+/**
+ * Wait until the flush threshold is reached or the flush period has passed, and then write out
+ * the buffered records. Intended to be called in a loop by a thread dedicated to output.
+ */
+void capture_writer_process(void);
+
+/**
+ * Write out all buffered records now.
+ */
+void capture_writer_flush(void);
+
+/**
+ * Get a snapshot of the writer statistics.
+ * @param[out] stats Pointer to structure to fill
+ */
+void capture_writer_get_stats(struct capture_writer_stats *stats);
+
+#endif // CAPTURE_WRITER_H
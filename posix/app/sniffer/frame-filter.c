@@ -0,0 +1,411 @@
+/*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file
+ * 802.15.4 MAC header parsing and frame filtering for the sniffer.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame-filter.h"
+
+/** Frame control field bits */
+#define FCF_FRAME_TYPE_MASK 0x0007
+#define FCF_SECURITY 0x0008
+#define FCF_PANID_COMPRESSION 0x0040
+#define FCF_SEQ_SUPPRESSION 0x0100
+#define FCF_DST_MODE_SHIFT 10
+#define FCF_VERSION_SHIFT 12
+#define FCF_SRC_MODE_SHIFT 14
+
+#define FRAME_VERSION_2015 2
+#define FRAME_TYPE_MULTIPURPOSE 5
+
+/** Mapping of field names to fields */
+static const struct
+{
+	const char *name;
+	uint8_t     field;
+} sFieldNames[] = {
+    {"type", FRAME_FIELD_TYPE},
+    {"pan", FRAME_FIELD_PAN},
+    {"src", FRAME_FIELD_SRC},
+    {"dst", FRAME_FIELD_DST},
+    {"addr", FRAME_FIELD_ADDR},
+    {"secured", FRAME_FIELD_SECURED},
+    {"len", FRAME_FIELD_LEN},
+    {"rssi", FRAME_FIELD_RSSI},
+    {"lqi", FRAME_FIELD_LQI},
+    {"channel", FRAME_FIELD_CHANNEL},
+};
+
+/** Mapping of frame type names to frame types */
+static const char *sTypeNames[] = {"beacon", "data", "ack", "cmd"};
+
+/** Operators, longest first so that "<=" is matched before "<" */
+static const struct
+{
+	const char *text;
+	uint8_t     op;
+} sOps[] = {
+    {"<=", FRAME_OP_LE},
+    {">=", FRAME_OP_GE},
+    {"!=", FRAME_OP_NE},
+    {"==", FRAME_OP_EQ},
+    {"=", FRAME_OP_EQ},
+    {"<", FRAME_OP_LT},
+    {">", FRAME_OP_GT},
+};
+
+/**
+ * Get the length in bytes of an address with the given addressing mode.
+ */
+static uint8_t addr_len(uint8_t mode)
+{
+	return (mode == FRAME_ADDR_EXT) ? 8 : (mode == FRAME_ADDR_SHORT) ? 2 : 0;
+}
+
+/**
+ * Read a little-endian address of the given mode from a frame.
+ * @return Number of bytes consumed
+ */
+static uint8_t read_addr(const uint8_t *buf, uint8_t mode, uint64_t *addr)
+{
+	uint8_t len = addr_len(mode);
+
+	*addr = 0;
+	for (int i = len - 1; i >= 0; i--) *addr = (*addr << 8) | buf[i];
+	return len;
+}
+
+/**
+ * Work out which PAN IDs are present in a frame, from the addressing modes and PAN ID compression.
+ * See IEEE 802.15.4-2015 section 7.2.1.5 (and earlier versions, where compression is simpler).
+ */
+static void get_pan_presence(uint8_t version, uint8_t dst_mode, uint8_t src_mode, bool comp, bool *dst, bool *src)
+{
+	if (version < FRAME_VERSION_2015)
+	{
+		*dst = (dst_mode != FRAME_ADDR_NONE);
+		*src = (src_mode != FRAME_ADDR_NONE) && !comp;
+		return;
+	}
+
+	if (dst_mode == FRAME_ADDR_NONE && src_mode == FRAME_ADDR_NONE)
+	{
+		*dst = comp;
+		*src = false;
+	}
+	else if (dst_mode == FRAME_ADDR_NONE)
+	{
+		*dst = false;
+		*src = !comp;
+	}
+	else if (src_mode == FRAME_ADDR_NONE || (dst_mode == FRAME_ADDR_EXT && src_mode == FRAME_ADDR_EXT))
+	{
+		*dst = !comp;
+		*src = false;
+	}
+	else
+	{
+		*dst = true;
+		*src = !comp;
+	}
+}
+
+void frame_parse(struct frame_info *info, const uint8_t *psdu, uint8_t len, uint8_t ed, uint8_t cs, uint8_t channel)
+{
+	const uint8_t *end = psdu + len - 2; //Exclude FCS
+	const uint8_t *ptr = psdu;
+	uint16_t       fcf;
+	uint8_t        version;
+	bool           dst_pan, src_pan;
+	uint64_t       pan;
+
+	memset(info, 0, sizeof(*info));
+	info->length  = len;
+	info->rssi    = ((int16_t)ed - 256) / 2;
+	info->lqi     = cs;
+	info->channel = channel;
+
+	if (len < 5)
+		return;
+
+	fcf              = psdu[0] | (psdu[1] << 8);
+	info->frame_type = fcf & FCF_FRAME_TYPE_MASK;
+	if (info->frame_type == FRAME_TYPE_MULTIPURPOSE)
+		return; //Different frame control format, not supported
+	info->secured  = (fcf & FCF_SECURITY) != 0;
+	info->dst_mode = (fcf >> FCF_DST_MODE_SHIFT) & 0x03;
+	info->src_mode = (fcf >> FCF_SRC_MODE_SHIFT) & 0x03;
+	version        = (fcf >> FCF_VERSION_SHIFT) & 0x03;
+	ptr += 2;
+
+	if (!(version == FRAME_VERSION_2015 && (fcf & FCF_SEQ_SUPPRESSION)))
+		ptr++; //Sequence number
+
+	get_pan_presence(version, info->dst_mode, info->src_mode, fcf & FCF_PANID_COMPRESSION, &dst_pan, &src_pan);
+
+	if (dst_pan)
+	{
+		if (ptr + 2 > end)
+			return;
+		ptr += read_addr(ptr, FRAME_ADDR_SHORT, &pan);
+		info->pan     = pan;
+		info->has_pan = true;
+	}
+	if (ptr + addr_len(info->dst_mode) > end)
+		return;
+	ptr += read_addr(ptr, info->dst_mode, &info->dst_addr);
+
+	if (src_pan)
+	{
+		if (ptr + 2 > end)
+			return;
+		ptr += read_addr(ptr, FRAME_ADDR_SHORT, &pan);
+		if (!info->has_pan)
+		{
+			info->pan     = pan;
+			info->has_pan = true;
+		}
+	}
+	if (ptr + addr_len(info->src_mode) > end)
+		return;
+	read_addr(ptr, info->src_mode, &info->src_addr);
+
+	info->valid = true;
+}
+
+/**
+ * Parse the value of a term for the given field.
+ * @return Status of the operation
+ */
+static ca_error parse_value(struct frame_term *term, const char *text, size_t len)
+{
+	char  buf[32];
+	char *end;
+
+	if (!len || len >= sizeof(buf))
+		return CA_ERROR_INVALID_ARGS;
+	memcpy(buf, text, len);
+	buf[len] = '\0';
+
+	if (term->field == FRAME_FIELD_TYPE)
+	{
+		for (size_t i = 0; i < sizeof(sTypeNames) / sizeof(sTypeNames[0]); i++)
+		{
+			if (strcmp(buf, sTypeNames[i]) == 0)
+			{
+				term->value = i;
+				return CA_ERROR_SUCCESS;
+			}
+		}
+	}
+	else if (term->field == FRAME_FIELD_SRC || term->field == FRAME_FIELD_DST || term->field == FRAME_FIELD_ADDR)
+	{
+		char   hex[17];
+		size_t digits = 0;
+
+		//Addresses are hex, optionally with 0x prefix or ':' separators. More than 4 digits is an extended address.
+		if (strncmp(buf, "0x", 2) == 0)
+			memmove(buf, buf + 2, len - 1);
+		for (char *c = buf; *c; c++)
+		{
+			if (*c == ':')
+				continue;
+			if (!isxdigit((unsigned char)*c) || digits >= 16)
+				return CA_ERROR_INVALID_ARGS;
+			hex[digits++] = *c;
+		}
+		hex[digits]     = '\0';
+		term->addr_mode = (digits > 4) ? FRAME_ADDR_EXT : FRAME_ADDR_SHORT;
+		term->value     = (int64_t)strtoull(hex, NULL, 16);
+		return digits ? CA_ERROR_SUCCESS : CA_ERROR_INVALID_ARGS;
+	}
+
+	term->value = strtoll(buf, &end, 0);
+	return (*end == '\0') ? CA_ERROR_SUCCESS : CA_ERROR_INVALID_ARGS;
+}
+
+/**
+ * Compile a single term, such as "len>=20".
+ * @return Status of the operation
+ */
+static ca_error parse_term(struct frame_term *term, const char *text, size_t len)
+{
+	size_t name_len = 0;
+	size_t op_len   = 0;
+	size_t i;
+
+	while (name_len < len && isalpha((unsigned char)text[name_len])) name_len++;
+
+	for (i = 0; i < sizeof(sFieldNames) / sizeof(sFieldNames[0]); i++)
+	{
+		if (strlen(sFieldNames[i].name) == name_len && strncmp(text, sFieldNames[i].name, name_len) == 0)
+			break;
+	}
+	if (i == sizeof(sFieldNames) / sizeof(sFieldNames[0]))
+		return CA_ERROR_INVALID_ARGS;
+	term->field = sFieldNames[i].field;
+
+	for (i = 0; i < sizeof(sOps) / sizeof(sOps[0]); i++)
+	{
+		op_len = strlen(sOps[i].text);
+		if (len - name_len >= op_len && strncmp(text + name_len, sOps[i].text, op_len) == 0)
+			break;
+	}
+	if (i == sizeof(sOps) / sizeof(sOps[0]))
+		return CA_ERROR_INVALID_ARGS;
+	term->op = sOps[i].op;
+
+	//Addresses have no order, so only equality can be tested
+	if ((term->field == FRAME_FIELD_SRC || term->field == FRAME_FIELD_DST || term->field == FRAME_FIELD_ADDR) &&
+	    term->op != FRAME_OP_EQ && term->op != FRAME_OP_NE)
+	{
+		fprintf(stderr, "Invalid filter term '%.*s', addresses can only be compared with = or !=\n", (int)len, text);
+		return CA_ERROR_INVALID_ARGS;
+	}
+
+	return parse_value(term, text + name_len + op_len, len - name_len - op_len);
+}
+
+ca_error frame_filter_add(struct frame_filter *filter, const char *expr)
+{
+	struct frame_expr *fexpr;
+
+	if (filter->num_exprs >= FRAME_FILTER_MAX_EXPRS)
+		return CA_ERROR_NO_BUFFER;
+	fexpr = &filter->exprs[filter->num_exprs];
+	memset(fexpr, 0, sizeof(*fexpr));
+
+	while (*expr)
+	{
+		const char *comma = strchr(expr, ',');
+		size_t      len   = comma ? (size_t)(comma - expr) : strlen(expr);
+
+		if (fexpr->num_terms >= FRAME_FILTER_MAX_TERMS)
+			return CA_ERROR_NO_BUFFER;
+		if (parse_term(&fexpr->terms[fexpr->num_terms], expr, len))
+			return CA_ERROR_INVALID_ARGS;
+		fexpr->num_terms++;
+		expr += len + (comma ? 1 : 0);
+	}
+
+	if (!fexpr->num_terms)
+		return CA_ERROR_INVALID_ARGS;
+	filter->num_exprs++;
+	return CA_ERROR_SUCCESS;
+}
+
+/**
+ * Compare a frame value against a term.
+ */
+static bool compare(uint8_t op, int64_t a, int64_t b)
+{
+	switch (op)
+	{
+	case FRAME_OP_EQ:
+		return a == b;
+	case FRAME_OP_NE:
+		return a != b;
+	case FRAME_OP_LT:
+		return a < b;
+	case FRAME_OP_LE:
+		return a <= b;
+	case FRAME_OP_GT:
+		return a > b;
+	case FRAME_OP_GE:
+		return a >= b;
+	}
+	return false;
+}
+
+/**
+ * Check whether an address of a frame matches an address term, which can only be == or != (see parse_term).
+ */
+static bool match_addr(const struct frame_term *term, uint8_t mode, uint64_t addr)
+{
+	bool equal = (mode == term->addr_mode) && ((int64_t)addr == term->value);
+
+	return (term->op == FRAME_OP_NE) ? !equal : equal;
+}
+
+/**
+ * Check whether a frame matches a single term.
+ */
+static bool match_term(const struct frame_term *term, const struct frame_info *info)
+{
+	switch (term->field)
+	{
+	case FRAME_FIELD_TYPE:
+		return info->valid && compare(term->op, info->frame_type, term->value);
+	case FRAME_FIELD_PAN:
+		return info->has_pan && compare(term->op, info->pan, term->value);
+	case FRAME_FIELD_SRC:
+		return info->valid && match_addr(term, info->src_mode, info->src_addr);
+	case FRAME_FIELD_DST:
+		return info->valid && match_addr(term, info->dst_mode, info->dst_addr);
+	case FRAME_FIELD_ADDR:
+		if (!info->valid)
+			return false;
+		if (term->op == FRAME_OP_NE)
+			return match_addr(term, info->src_mode, info->src_addr) && match_addr(term, info->dst_mode, info->dst_addr);
+		return match_addr(term, info->src_mode, info->src_addr) || match_addr(term, info->dst_mode, info->dst_addr);
+	case FRAME_FIELD_SECURED:
+		return info->valid && compare(term->op, info->secured, term->value);
+	case FRAME_FIELD_LEN:
+		return compare(term->op, info->length, term->value);
+	case FRAME_FIELD_RSSI:
+		return compare(term->op, info->rssi, term->value);
+	case FRAME_FIELD_LQI:
+		return compare(term->op, info->lqi, term->value);
+	case FRAME_FIELD_CHANNEL:
+		return compare(term->op, info->channel, term->value);
+	}
+	return false;
+}
+
+bool frame_filter_match(const struct frame_filter *filter, const struct frame_info *info)
+{
+	if (!filter->num_exprs)
+		return true;
+
+	for (uint8_t i = 0; i < filter->num_exprs; i++)
+	{
+		const struct frame_expr *expr  = &filter->exprs[i];
+		bool                     match = true;
+
+		for (uint8_t j = 0; j < expr->num_terms && match; j++) match = match_term(&expr->terms[j], info);
+		if (match)
+			return true;
+	}
+	return false;
+}
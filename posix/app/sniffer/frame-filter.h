@@ -0,0 +1,155 @@
+/*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file
+ * 802.15.4 MAC header parsing and frame filtering for the sniffer.
+ *
+ * A filter is compiled once from text expressions, such as "type=data,pan=0xface,rssi>-70".
+ * The terms of one expression must all match (AND), and a frame passes the filter if any of
+ * the compiled expressions match (OR).
+ */
+
+#ifndef FRAME_FILTER_H
+#define FRAME_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ca821x_error.h"
+
+/** Maximum number of expressions in a filter */
+#define FRAME_FILTER_MAX_EXPRS 8
+/** Maximum number of terms in one filter expression */
+#define FRAME_FILTER_MAX_TERMS 8
+
+/** 802.15.4 addressing modes */
+enum frame_addr_mode
+{
+	FRAME_ADDR_NONE  = 0,
+	FRAME_ADDR_SHORT = 2,
+	FRAME_ADDR_EXT   = 3,
+};
+
+/** Information extracted from a received frame */
+struct frame_info
+{
+	bool     valid;      //!< The MAC header could be parsed
+	uint8_t  frame_type; //!< Frame type (0 beacon, 1 data, 2 ack, 3 command...)
+	bool     secured;    //!< Security enabled bit
+	uint8_t  dst_mode;   //!< Destination addressing mode (enum frame_addr_mode)
+	uint8_t  src_mode;   //!< Source addressing mode (enum frame_addr_mode)
+	bool     has_pan;    //!< Whether a PAN ID is present
+	uint16_t pan;        //!< Destination PAN ID, or source PAN ID if there is no destination PAN ID
+	uint64_t dst_addr;   //!< Destination address
+	uint64_t src_addr;   //!< Source address
+	uint8_t  length;     //!< PSDU length, including FCS
+	int16_t  rssi;       //!< Received signal strength in dBm
+	uint8_t  lqi;        //!< Link quality indication
+	uint8_t  channel;    //!< Channel the frame was received on
+};
+
+/** Fields that can be filtered on */
+enum frame_field
+{
+	FRAME_FIELD_TYPE,
+	FRAME_FIELD_PAN,
+	FRAME_FIELD_SRC,
+	FRAME_FIELD_DST,
+	FRAME_FIELD_ADDR, //!< Either source or destination address
+	FRAME_FIELD_SECURED,
+	FRAME_FIELD_LEN,
+	FRAME_FIELD_RSSI,
+	FRAME_FIELD_LQI,
+	FRAME_FIELD_CHANNEL,
+};
+
+/** Comparison operators */
+enum frame_op
+{
+	FRAME_OP_EQ,
+	FRAME_OP_NE,
+	FRAME_OP_LT,
+	FRAME_OP_LE,
+	FRAME_OP_GT,
+	FRAME_OP_GE,
+};
+
+/** One compiled filter term, eg. "len>=20" */
+struct frame_term
+{
+	uint8_t field;     //!< enum frame_field
+	uint8_t op;        //!< enum frame_op
+	uint8_t addr_mode; //!< For address fields, the addressing mode of value
+	int64_t value;     //!< Value to compare against
+};
+
+/** One compiled filter expression, all terms must match */
+struct frame_expr
+{
+	uint8_t           num_terms;
+	struct frame_term terms[FRAME_FILTER_MAX_TERMS];
+};
+
+/** A compiled filter, any expression must match. An empty filter matches everything. */
+struct frame_filter
+{
+	uint8_t           num_exprs;
+	struct frame_expr exprs[FRAME_FILTER_MAX_EXPRS];
+};
+
+/**
+ * Parse the MAC header of a received frame.
+ * @param[out] info Information extracted from the frame
+ * @param psdu The received PSDU, including FCS
+ * @param len Length of the PSDU
+ * @param ed ED/RSSI value reported by the device
+ * @param cs CS/LQI value reported by the device
+ * @param channel Channel the frame was received on
+ */
+void frame_parse(struct frame_info *info, const uint8_t *psdu, uint8_t len, uint8_t ed, uint8_t cs, uint8_t channel);
+
+/**
+ * Compile a filter expression and add it to a filter.
+ * @param filter The filter to add to
+ * @param expr Expression text, a comma-separated list of terms such as "type=data,rssi>-70"
+ * @retval CA_ERROR_SUCCESS  Expression added
+ * @retval CA_ERROR_INVALID_ARGS  Expression could not be parsed, or compares an address with < <= > or >=, which
+ *                                is also reported on stderr
+ * @retval CA_ERROR_NO_BUFFER  Too many expressions or terms
+ */
+ca_error frame_filter_add(struct frame_filter *filter, const char *expr);
+
+/**
+ * Check whether a frame passes a filter.
+ * @param filter The compiled filter
+ * @param info The parsed frame
+ * @return true if the frame passes the filter
+ */
+bool frame_filter_match(const struct frame_filter *filter, const struct frame_info *info);
+
+#endif // FRAME_FILTER_H
@@ -0,0 +1,287 @@
+/*
+ *  Copyright (c) 2026, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file
+ * Live traffic statistics for the sniffer, as an alternative to writing a capture.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "frame-stats.h"
+
+/** Size of the address table, must be a power of 2 */
+#define STATS_ADDR_TABLE_SIZE 512
+/** Lowest RSSI histogram bin, frames below are counted in the first bin */
+#define STATS_RSSI_MIN -100
+/** Width of an RSSI histogram bin in dB */
+#define STATS_RSSI_STEP 5
+/** Number of RSSI histogram bins */
+#define STATS_RSSI_BINS 16
+/** Number of LQI histogram bins, evenly dividing 0-255 */
+#define STATS_LQI_BINS 8
+/** Duration of one octet at 250kbit/s O-QPSK, in microseconds */
+#define STATS_OCTET_US 32
+/** Length of the synchronisation header and PHY header in octets */
+#define STATS_SHR_PHR_LEN 6
+/** Width of the histogram bars */
+#define STATS_BAR_WIDTH 40
+
+/** Packet and byte counts for one source address */
+struct addr_stats
+{
+	uint64_t addr;    //!< Source address
+	uint16_t pan;     //!< PAN ID of the frames, or 0xFFFF if none
+	uint8_t  mode;    //!< Addressing mode of addr, FRAME_ADDR_NONE if the slot is empty
+	uint32_t packets; //!< Number of frames sent by this address
+	uint64_t bytes;   //!< Number of bytes sent by this address
+};
+
+/** Counts for one channel */
+struct channel_stats
+{
+	uint32_t packets;  //!< Total number of frames
+	uint64_t bytes;    //!< Total number of bytes
+	uint64_t airtime;  //!< Airtime used in the current interval, in microseconds
+	uint32_t interval; //!< Number of frames in the current interval
+};
+
+static pthread_mutex_t      sStatsMutex = PTHREAD_MUTEX_INITIALIZER; //!< Protects all statistics
+static struct addr_stats    sAddrs[STATS_ADDR_TABLE_SIZE];           //!< Open-addressed table of source addresses
+static uint32_t             sNumAddrs;                               //!< Number of used slots in sAddrs
+static uint32_t             sAddrOverflow;                           //!< Frames not counted because sAddrs was full
+static uint32_t             sNoAddr;                                 //!< Frames without a source address
+static struct channel_stats sChannels[27];                           //!< Per-channel counts, indexed by channel
+static uint32_t             sRssiHist[STATS_RSSI_BINS];              //!< RSSI histogram
+static uint32_t             sLqiHist[STATS_LQI_BINS];                //!< LQI histogram
+static uint32_t             sTotal;                                  //!< Total number of frames
+static struct timespec      sIntervalStart;                          //!< Start of the current interval
+
+/**
+ * Find the table slot of an address, or an empty slot where it can be inserted.
+ * @return Pointer to the slot, or NULL if the table is full
+ */
+static struct addr_stats *find_addr(uint8_t mode, uint16_t pan, uint64_t addr)
+{
+	uint32_t hash = (uint32_t)(addr ^ (addr >> 32)) * 2654435761u ^ pan ^ mode;
+
+	for (uint32_t i = 0; i < STATS_ADDR_TABLE_SIZE; i++)
+	{
+		struct addr_stats *slot = &sAddrs[(hash + i) & (STATS_ADDR_TABLE_SIZE - 1)];
+
+		if (slot->mode == FRAME_ADDR_NONE || (slot->mode == mode && slot->pan == pan && slot->addr == addr))
+			return slot;
+	}
+	return NULL;
+}
+
+void frame_stats_init(void)
+{
+	pthread_mutex_lock(&sStatsMutex);
+	clock_gettime(CLOCK_MONOTONIC, &sIntervalStart);
+	pthread_mutex_unlock(&sStatsMutex);
+}
+
+void frame_stats_add(const struct frame_info *info)
+{
+	int bin;
+
+	pthread_mutex_lock(&sStatsMutex);
+	sTotal++;
+
+	if (info->valid && info->src_mode != FRAME_ADDR_NONE)
+	{
+		uint16_t           pan  = info->has_pan ? info->pan : 0xFFFF;
+		struct addr_stats *slot = find_addr(info->src_mode, pan, info->src_addr);
+
+		if (!slot || (slot->mode == FRAME_ADDR_NONE && sNumAddrs >= STATS_ADDR_TABLE_SIZE * 3 / 4))
+		{
+			//Keep the table sparse enough that probing stays short
+			sAddrOverflow++;
+		}
+		else
+		{
+			if (slot->mode == FRAME_ADDR_NONE)
+			{
+				slot->mode = info->src_mode;
+				slot->pan  = pan;
+				slot->addr = info->src_addr;
+				sNumAddrs++;
+			}
+			slot->packets++;
+			slot->bytes += info->length;
+		}
+	}
+	else
+	{
+		sNoAddr++;
+	}
+
+	if (info->channel < sizeof(sChannels) / sizeof(sChannels[0]))
+	{
+		struct channel_stats *ch = &sChannels[info->channel];
+
+		ch->packets++;
+		ch->interval++;
+		ch->bytes += info->length;
+		ch->airtime += (info->length + STATS_SHR_PHR_LEN) * STATS_OCTET_US;
+	}
+
+	bin = (info->rssi - STATS_RSSI_MIN) / STATS_RSSI_STEP;
+	if (bin < 0)
+		bin = 0;
+	if (bin >= STATS_RSSI_BINS)
+		bin = STATS_RSSI_BINS - 1;
+	sRssiHist[bin]++;
+	sLqiHist[info->lqi * STATS_LQI_BINS / 256]++;
+	pthread_mutex_unlock(&sStatsMutex);
+}
+
+/**
+ * Compare two address table entries, by descending packet count.
+ */
+static int compare_addrs(const void *a, const void *b)
+{
+	const struct addr_stats *x = a;
+	const struct addr_stats *y = b;
+
+	return (x->packets < y->packets) - (x->packets > y->packets);
+}
+
+/**
+ * Print one histogram line, with a bar scaled to the largest bin.
+ */
+static void print_bar(FILE *out, const char *label, uint32_t count, uint32_t max)
+{
+	int width = max ? (int)((uint64_t)count * STATS_BAR_WIDTH / max) : 0;
+
+	fprintf(out, "  %-12s %8u |%.*s\n", label, count, width, "########################################");
+}
+
+/**
+ * Print a 802.15.4 address in the same form that the filter accepts.
+ */
+static void print_addr(FILE *out, uint8_t mode, uint64_t addr)
+{
+	if (mode == FRAME_ADDR_EXT)
+		fprintf(out, "%016llx", (unsigned long long)addr);
+	else
+		fprintf(out, "%04x            ", (unsigned int)addr);
+}
+
+void frame_stats_print(FILE *out, unsigned int top_addrs)
+{
+	struct addr_stats *sorted;
+	struct timespec    now;
+	uint64_t           interval_us;
+	uint32_t           max;
+	uint32_t           count = 0;
+	char               label[16];
+
+	pthread_mutex_lock(&sStatsMutex);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	interval_us = (uint64_t)(now.tv_sec - sIntervalStart.tv_sec) * 1000000 +
+	              ((int64_t)now.tv_nsec - sIntervalStart.tv_nsec) / 1000;
+
+	fprintf(out, "\n===== Sniffer statistics: %u frames =====\n", sTotal);
+
+	fprintf(out, "Channel  Frames      Bytes  Interval  Utilisation\n");
+	for (uint8_t i = 0; i < sizeof(sChannels) / sizeof(sChannels[0]); i++)
+	{
+		struct channel_stats *ch = &sChannels[i];
+
+		if (!ch->packets)
+			continue;
+		fprintf(out,
+		        "%7u %7u %10llu %9u %11.1f%%\n",
+		        i,
+		        ch->packets,
+		        (unsigned long long)ch->bytes,
+		        ch->interval,
+		        interval_us ? 100.0 * ch->airtime / interval_us : 0.0);
+		ch->airtime  = 0;
+		ch->interval = 0;
+	}
+	sIntervalStart = now;
+
+	//Sort a copy, so that the table itself keeps its hash order
+	sorted = malloc(sizeof(sAddrs));
+	if (sorted)
+	{
+		for (uint32_t i = 0; i < STATS_ADDR_TABLE_SIZE; i++)
+		{
+			if (sAddrs[i].mode != FRAME_ADDR_NONE)
+				sorted[count++] = sAddrs[i];
+		}
+		qsort(sorted, count, sizeof(*sorted), compare_addrs);
+
+		fprintf(out, "Source address    PAN   Frames      Bytes\n");
+		for (uint32_t i = 0; i < count && i < top_addrs; i++)
+		{
+			print_addr(out, sorted[i].mode, sorted[i].addr);
+			fprintf(out, "  %04x %7u %10llu\n", sorted[i].pan, sorted[i].packets, (unsigned long long)sorted[i].bytes);
+		}
+		if (count > top_addrs)
+			fprintf(out, "(%u more addresses)\n", count - top_addrs);
+		free(sorted);
+	}
+	if (sNoAddr)
+		fprintf(out, "(%u frames without source address)\n", sNoAddr);
+	if (sAddrOverflow)
+		fprintf(out, "(%u frames from untracked addresses, table full)\n", sAddrOverflow);
+
+	fprintf(out, "RSSI (dBm):\n");
+	max = 0;
+	for (int i = 0; i < STATS_RSSI_BINS; i++) max = (sRssiHist[i] > max) ? sRssiHist[i] : max;
+	for (int i = 0; i < STATS_RSSI_BINS; i++)
+	{
+		int lo = STATS_RSSI_MIN + i * STATS_RSSI_STEP;
+
+		if (i == 0)
+			snprintf(label, sizeof(label), "< %d", lo + STATS_RSSI_STEP);
+		else if (i == STATS_RSSI_BINS - 1)
+			snprintf(label, sizeof(label), ">= %d", lo);
+		else
+			snprintf(label, sizeof(label), "%d..%d", lo, lo + STATS_RSSI_STEP - 1);
+		print_bar(out, label, sRssiHist[i], max);
+	}
+
+	fprintf(out, "LQI:\n");
+	max = 0;
+	for (int i = 0; i < STATS_LQI_BINS; i++) max = (sLqiHist[i] > max) ? sLqiHist[i] : max;
+	for (int i = 0; i < STATS_LQI_BINS; i++)
+	{
+		snprintf(label, sizeof(label), "%d..%d", i * 256 / STATS_LQI_BINS, (i + 1) * 256 / STATS_LQI_BINS - 1);
+		print_bar(out, label, sLqiHist[i], max);
+	}
+	fflush(out);
+	pthread_mutex_unlock(&sStatsMutex);
+}
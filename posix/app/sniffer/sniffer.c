@@ -27,7 +27,7 @@
  */
 /**
  * @file
- * Sniffer implementation for capturing 802.15.4 packets on a given channel.
+ * Sniffer implementation for capturing 802.15.4 packets on one or more channels.
  */
 #if defined(_WIN32)
 #include <Windows.h>
@@ -39,6 +39,7 @@
 
 #include <assert.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -50,7 +51,10 @@
 
 #include "ca821x-posix/ca821x-posix-evbme.h"
 #include "ca821x-posix/ca821x-posix.h"
+#include "capture-writer.h"
 #include "evbme_messages.h"
+#include "frame-filter.h"
+#include "frame-stats.h"
 
 #if _WIN32
 #define DEFAULT_PIPE "\\\\.\\pipe\\cascoda_"
@@ -58,6 +62,24 @@
 #define DEFAULT_PIPE "/tmp/cascoda_"
 #endif
 
+/** Default size of the capture buffer in kB */
+#define DEFAULT_BUFFER_KB 1024
+/** Buffered byte count at which the capture is flushed early */
+#define FLUSH_THRESHOLD (64 * 1024)
+/** Maximum time in ms that a captured packet is buffered before being written out */
+#define FLUSH_PERIOD_MS 100
+
+/** Number of busiest addresses listed in each statistics report */
+#define STATS_TOP_ADDRS 20
+
+/** Maximum number of devices that can sniff simultaneously, one channel each */
+#define MAX_DEVICES 16
+
+/** Offset jump in us after which the device timestamp calibration is restarted (eg. device reset) */
+#define TS_RESYNC_US 1000000
+/** Max drift allowed between the device and host clocks, as a divisor of elapsed time (100ppm) */
+#define TS_DRIFT_DIVISOR 10000
+
 /**
  * parameter structures which have been duplicated from mac_messages.h to be able to handle all devices
  */
@@ -89,7 +111,29 @@ typedef enum ca_device_type
 	DEV_CA8212  = 3
 } ca_device_type;
 
-ca_device_type DeviceType = DEV_UNKNOWN;
+/**
+ * State of one sniffing device
+ */
+struct sniffer_dev
+{
+	struct ca821x_dev dev;          //!< Cascoda device reference
+	ca_device_type    type;         //!< Device type, read at startup
+	uint8_t           channel;      //!< Channel this device is sniffing on
+	uint32_t          interface_id; //!< Index of the pcapng interface of this device
+	const char       *serial;       //!< Serial number of the device to use, or NULL for any
+
+	/* Calibration of the device timestamps against the host clock (CA-8212 only) */
+	bool     ts_calibrated;   //!< Whether ts_offset_us is valid
+	int64_t  ts_offset_us;    //!< Host time minus device time, in us
+	uint64_t ts_last_host_us; //!< Host time of the last calibration update
+	uint32_t ts_last_raw;     //!< Last raw device timestamp, to detect counter wrap
+	uint64_t ts_wraps;        //!< Number of times the device timestamp counter has wrapped
+};
+
+/** All devices in use, one per sniffed channel */
+struct sniffer_dev devices[MAX_DEVICES];
+/** Number of devices in use */
+uint8_t num_devices = 0;
 
 /**
  * Pcap link types, see https://www.tcpdump.org/linktypes.html
@@ -105,10 +149,11 @@ uint32_t link_type = LINKTYPE_IEEE802_15_4_TAP;
  */
 #define MAX_HEADER_LEN 512
 #define HEADER_LEN_ETH 14;
-#define HEADER_LEN_TAP 28;
+#define HEADER_LEN_TAP 36;
 
 #define HEADER_POSITION_RSSI 16
 #define HEADER_POSITION_LQI 24
+#define HEADER_POSITION_CHANNEL 32
 
 /**
  * headers for encapsulating IEEE802.15.4 frames for pcap.
@@ -132,7 +177,7 @@ uint8_t ethernet_header[] = {0xff, // dst
 
 uint8_t tap_header[] = {0x00, // version
                         0x00, // reserved
-                        0x1C, // length
+                        0x24, // length
                         0x00,
                         0x00, // FCS TLV
                         0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00,
@@ -143,6 +188,10 @@ uint8_t tap_header[] = {0x00, // version
                         0x0A, // LQI TLV
                         0x00, 0x01, 0x00,
                         0x00, // LQI TLV value
+                        0x00, 0x00, 0x00,
+                        0x03, // Channel TLV
+                        0x00, 0x03, 0x00,
+                        0x00, // Channel TLV value
                         0x00, 0x00, 0x00};
 
 /**
@@ -173,17 +222,75 @@ typedef struct pcaprec_hdr_s
 ca_static_assert(sizeof(pcap_hdr_t) == 24);    //pcap_hdr_t_not_packed
 ca_static_assert(sizeof(pcaprec_hdr_t) == 16); //pcaprec_hdr_t_not_packed
 
+/**
+ * Pcapng block types and options, see https://www.ietf.org/archive/id/draft-ietf-opsawg-pcapng-01.html
+ */
+#define PCAPNG_BLOCK_SHB 0x0A0D0D0A
+#define PCAPNG_BLOCK_IDB 0x00000001
+#define PCAPNG_BLOCK_EPB 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define PCAPNG_OPT_ENDOFOPT 0
+#define PCAPNG_OPT_IF_NAME 2
+#define PCAPNG_OPT_IF_TSRESOL 9
+
+/** Maximum length of the pcapng header, a section header block and an interface block per device */
+#define PCAPNG_MAX_HEADER_LEN (32 + (MAX_DEVICES * 48))
+
+/**
+ * Pcapng section header block, without options
+ */
+typedef struct pcapng_shb_s
+{
+	uint32_t block_type;       ///< PCAPNG_BLOCK_SHB
+	uint32_t block_len;        ///< total block length
+	uint32_t byte_order_magic; ///< PCAPNG_BYTE_ORDER_MAGIC
+	uint16_t version_major;    ///< major version number
+	uint16_t version_minor;    ///< minor version number
+	uint32_t section_len[2];   ///< section length, all ones if unspecified
+} pcapng_shb_t;
+
+/**
+ * Pcapng interface description block, without options
+ */
+typedef struct pcapng_idb_s
+{
+	uint32_t block_type; ///< PCAPNG_BLOCK_IDB
+	uint32_t block_len;  ///< total block length
+	uint16_t link_type;  ///< data link type
+	uint16_t reserved;   ///< reserved, zero
+	uint32_t snaplen;    ///< max length of captured packets, in octets
+} pcapng_idb_t;
+
+/**
+ * Pcapng enhanced packet block, without packet data and options
+ */
+typedef struct pcapng_epb_s
+{
+	uint32_t block_type;   ///< PCAPNG_BLOCK_EPB
+	uint32_t block_len;    ///< total block length
+	uint32_t interface_id; ///< index of the interface the packet was captured on
+	uint32_t ts_high;      ///< upper 32 bits of the timestamp
+	uint32_t ts_low;       ///< lower 32 bits of the timestamp
+	uint32_t cap_len;      ///< number of octets of packet saved in file
+	uint32_t orig_len;     ///< actual length of packet
+} pcapng_epb_t;
+
+ca_static_assert(sizeof(pcapng_shb_t) == 24); //pcapng_shb_t_not_packed
+ca_static_assert(sizeof(pcapng_idb_t) == 16); //pcapng_idb_t_not_packed
+ca_static_assert(sizeof(pcapng_epb_t) == 28); //pcapng_epb_t_not_packed
+
 /**
  * Output mode for formatting printed data
  */
 enum
 {
 	OUT_MODE_HEX,  //!< Print in hex
-	OUT_MODE_PCAP, //!< Print binary pcap format
+	OUT_MODE_PCAP,  //!< Print binary pcap format
+	OUT_MODE_STATS, //!< Only collect and periodically print statistics
 } out_mode = OUT_MODE_HEX;
 
-/** static cascoda device reference */
-struct ca821x_dev sDeviceRef;
+/** Output pcapng instead of pcap, required when sniffing on several channels */
+bool use_pcapng = false;
 
 #if defined(_WIN32)
 HANDLE        output;
@@ -196,8 +303,6 @@ FILE           *output;
 
 /** Enable logging of extra info to stderr in pcap mode */
 bool debugMode = false;
-/** Channel we are sniffing on */
-uint8_t channel = 0;
 /** Static storage for default pipe name */
 char default_pipe[30];
 /** Pointer to dynamic pipe name. */
@@ -208,20 +313,20 @@ char *dPipeName = NULL; //Dynamic memory
 */
 uint32_t time_till_new_capture = 0;
 
-/**
- * Platform abstraction function to flush the output, causing data to be written now.
- */
-static void ca_flush(void);
+/** Configuration of the buffered pcap writer */
+struct capture_writer_config writer_config = {
+    .buffer_size     = DEFAULT_BUFFER_KB * 1024,
+    .flush_threshold = FLUSH_THRESHOLD,
+    .flush_period_ms = FLUSH_PERIOD_MS,
+};
 
-/**
- * Platform abstraction function to write a buffer to output.
- * @param buf Buffer to write
- * @param len Length of the buffer to write.
- * @return Error code
- * @retval CA_ERROR_SUCCESS  Successful write
- * @retval CA_ERROR_FAIL  Write failed.
- */
-static ca_error ca_write(const void *buf, size_t len);
+/** Compiled capture filter, frames that don't match are discarded before any output */
+struct frame_filter filter;
+/** Period in seconds between statistics reports in statistics mode */
+unsigned int stats_interval;
+
+/** Set by the signal handler to request a clean exit, so that buffered packets are written out */
+static volatile sig_atomic_t exit_requested = false;
 
 /**
  * Platform abstraction function to print a format string to the correct output.
@@ -257,6 +362,11 @@ static char *getDefaultWiresharkPath(void);
  */
 static void start_wireshark(const char *wspath, const char *outpath);
 
+/**
+ * Platform abstraction function to get the current output as a stream for the capture writer.
+ */
+static capture_fd_t get_output_stream(void);
+
 /**
  * Platform abstraction function to register the start time of the program.
  */
@@ -272,9 +382,9 @@ static void fillTimestampFromOS(pcaprec_hdr_t *pcapHeader);
 /**
  * Platform abstraction function to fill in the timing information for the pcap header from MAC
  * @param pcapHeader A pointer to the pcap header to be filled.
- * @param params A pointer to the received PCPS indication
+ * @param timestamp A pointer to the 4 byte timestamp of the received PCPS indication
  */
-static void fillTimestampFromMAC(pcaprec_hdr_t *pcapHeader, struct PCPS_DATA_indication_pset_8212 *params);
+static void fillTimestampFromMAC(pcaprec_hdr_t *pcapHeader, const uint8_t *timestamp);
 
 /**
  * Platform abstraction function to configure the default system output.
@@ -298,10 +408,30 @@ static void fillRSSITap(uint8_t ed);
  */
 static void fillLQITap(uint8_t cs);
 
+/**
+ * fills in channel value for LINKTYPE_IEEE802_15_4_TAP.
+ * @param channel channel the frame was received on
+ */
+static void fillChannelTap(uint8_t channel);
+
 /**
  * reads the device version (note that CASCODA_CA_VER should not be used outside baremetal)
  */
-static void GetDeviceVersion(struct ca821x_dev *pDeviceRef);
+static void GetDeviceVersion(struct sniffer_dev *sdev);
+
+/**
+ * Fill a buffer with the sniffed channels separated by underscores, for naming capture files.
+ * @param buf Buffer to fill
+ * @param len Length of the buffer
+ */
+static void getChannelString(char *buf, size_t len)
+{
+	size_t pos = 0;
+
+	buf[0] = '\0';
+	for (int i = 0; i < num_devices && pos < len; i++)
+		pos += snprintf(buf + pos, len - pos, i ? "_%d" : "%d", devices[i].channel);
+}
 
 /**
  * Helper function to print the help information to stderr.
@@ -315,16 +445,29 @@ static void displayHelp()
 #else  //posix
     fprintf(stderr, "sniffer ");
 #endif // _WIN32
-	fprintf(stderr, "[OPTIONS] CHANNEL\n");
+	fprintf(stderr, "[OPTIONS] CHANNEL [CHANNEL...]\n");
 	fprintf(stderr, "\tPrint all received packets on channel (11-26)\n\n");
 	fprintf(stderr, "DESCRIPTION\n");
-	fprintf(stderr, "\tSniffer program to use the CA-8211 to capture packets on a channel.\n\n");
+	fprintf(stderr, "\tSniffer program to use the CA-8211 to capture packets on a channel.\n");
+	fprintf(stderr, "\tIf several channels are given, one device is used per channel and the\n");
+	fprintf(stderr, "\tcaptures are merged into a single pcapng output.\n\n");
 	fprintf(stderr, "\t-b [DURATION]    Ring-buffer mode. Wireshark will save and start a new capture\n");
 	fprintf(stderr, "\t                 every number of seconds specified by the DURATION argument.\n");
 	fprintf(stderr, "\t                 Note: This HAS to be used in conjunction with -o, to specify\n");
 	fprintf(stderr, "\t                 the output directory path where the pcap files will be created.\n\n");
+	fprintf(stderr, "\t-B [SIZE]        Size of the capture buffer in kB (default %d). Packets are\n", DEFAULT_BUFFER_KB);
+	fprintf(stderr, "\t                 dropped and counted if the output stalls for long enough to fill it.\n\n");
 	fprintf(stderr, "\t-d               Debug mode, print verbose information to stderr.\n\n");
 	fprintf(stderr, "\t-e               Use PCap datalink type ETHERNET (default is IEEE802_15_4_TAP).\n\n");
+	fprintf(stderr, "\t-f [FILE]        Write the pcap capture directly to FILE. Implies -p.\n\n");
+	fprintf(stderr, "\t-F [EXPR]        Only output packets matching the filter expression EXPR, a comma\n");
+	fprintf(stderr, "\t                 separated list of terms that must all match, eg. type=data,rssi>-70\n");
+	fprintf(stderr, "\t                 Fields: type (beacon/data/ack/cmd), pan, src, dst, addr, secured,\n");
+	fprintf(stderr, "\t                 len, rssi, lqi, channel. Operators: = != < <= > >=, only = and !=\n");
+	fprintf(stderr, "\t                 for the addresses src, dst and addr.\n");
+	fprintf(stderr, "\t                 Can be given several times, packets matching any EXPR are output.\n\n");
+	fprintf(stderr, "\t-g               Use the pcapng format instead of pcap, with host-aligned\n");
+	fprintf(stderr, "\t                 timestamps. Always used when sniffing on several channels.\n\n");
 	fprintf(stderr,
 	        "\t-i               Use PCap datalink type IEEE802_15_4_WITHFCS (default is IEEE802_15_4_TAP).\n\n");
 	fprintf(stderr, "\t-o [PATH]        If provided, wireshark will save the current capture in the output\n");
@@ -336,8 +479,17 @@ static void displayHelp()
 	fprintf(stderr, "\t-p               PCap mode, output pcap data instead of descriptive hex\n");
 	fprintf(stderr, "\t                 dump. If this is used in conjunction with pipes, can be\n");
 	fprintf(stderr, "\t                 used to stream to wireshark\n\n");
+	fprintf(stderr, "\t-r [RULE]        Rotate the capture file set with -f. RULE is one of:\n");
+	fprintf(stderr, "\t                 filesize:KB - start a new file after KB kilobytes,\n");
+	fprintf(stderr, "\t                 duration:S  - start a new file every S seconds,\n");
+	fprintf(stderr, "\t                 files:N     - only keep the N most recent files.\n");
+	fprintf(stderr, "\t                 Can be given several times, eg. -r filesize:10000 -r files:10\n\n");
+	fprintf(stderr, "\t-S [INTERVAL]    Statistics mode. Instead of outputting packets, print per-address\n");
+	fprintf(stderr, "\t                 counts, RSSI/LQI histograms and channel utilisation every INTERVAL\n");
+	fprintf(stderr, "\t                 seconds. Can be combined with -F.\n\n");
 	fprintf(stderr, "\t-s [SERIALNO]    This application will use the sniffer with the serial number specified.\n");
-	fprintf(stderr, "\t                 If not specified, the first sniffer detected will be used.\n\n");
+	fprintf(stderr, "\t                 If not specified, the first sniffer detected will be used.\n");
+	fprintf(stderr, "\t                 Can be given once per channel, in the same order as the channels.\n\n");
 	fprintf(stderr, "\t-w               Open WireShark to process the packet capture. Implies -p\n");
 	fprintf(stderr, "\t                 and -n (random name for pipe if not provided separately).\n\n");
 	fprintf(stderr, "\t-W [PATH]        Open WireShark at the path to process the packet capture.\n");
@@ -345,11 +497,6 @@ static void displayHelp()
 }
 
 #if defined(_WIN32) //Windows abstraction
-static void ca_flush(void)
-{
-	FlushFileBuffers(output);
-}
-
 static ca_error ca_write(const void *buf, size_t len)
 {
 	DWORD    bytesWritten = 0;
@@ -428,6 +575,11 @@ static void open_pipe(char *name)
 		fprintf(stderr, "Failed to connect to pipe as server.\n");
 }
 
+static capture_fd_t get_output_stream(void)
+{
+	return output;
+}
+
 static char *getDefaultWiresharkPath(void)
 {
 	char        progPath[] = "\\Wireshark\\Wireshark.exe";
@@ -451,13 +603,15 @@ static void start_wireshark(const char *wspath, const char *outpath)
 	char                args[arglen];
 	char                savePath[MAX_PATH];
 	char                saveSuffix[MAX_PATH];
+	char                channels[100];
 	STARTUPINFO         StartupInfo;
 	PROCESS_INFORMATION ProcessInfo;
 
 	if (outpath)
 	{
+		getChannelString(channels, sizeof(channels));
 		strcpy(savePath, outpath);
-		snprintf(saveSuffix, MAX_PATH, "\\ch_%d.pcapng", channel);
+		snprintf(saveSuffix, MAX_PATH, "\\ch_%s.pcapng", channels);
 		strcat(savePath, saveSuffix);
 	}
 
@@ -556,11 +710,6 @@ static struct timespec timeSub(const struct timespec *t1, const struct timespec
 	return curTime;
 }
 
-static void ca_flush(void)
-{
-	fflush(output);
-}
-
 static void ca_print(const char *format, ...)
 {
 	va_list va_args;
@@ -569,12 +718,6 @@ static void ca_print(const char *format, ...)
 	va_end(va_args);
 }
 
-static ca_error ca_write(const void *buf, size_t len)
-{
-	write(fileno(output), buf, len);
-	return CA_ERROR_SUCCESS;
-}
-
 static void clean_pipe(void)
 {
 	fclose(output);
@@ -621,6 +764,11 @@ static void open_pipe(char *name)
 	}
 }
 
+static capture_fd_t get_output_stream(void)
+{
+	return fileno(output);
+}
+
 static char *getDefaultWiresharkPath(void)
 {
 	return "wireshark";
@@ -634,14 +782,16 @@ static void start_wireshark(const char *wspath, const char *outpath)
 		int  rval;
 		char savePath[200];
 		char saveSuffix[200];
+		char channels[100];
 		// We are in the child process, execute the command
 		int  cmdlen = strlen(wspath) + strlen(dPipeName) + 200;
 		char buffer[cmdlen];
 
 		if (outpath)
 		{
+			getChannelString(channels, sizeof(channels));
 			strcpy(savePath, outpath);
-			snprintf(saveSuffix, 200, "\\ch_%d.pcapng", channel);
+			snprintf(saveSuffix, 200, "\\ch_%s.pcapng", channels);
 			strcat(savePath, saveSuffix);
 		}
 
@@ -700,10 +850,10 @@ static void io_raw(void)
 }
 #endif //End of posix abstraction
 
-static void fillTimestampFromMAC(pcaprec_hdr_t *pcapHeader, struct PCPS_DATA_indication_pset_8212 *params)
+static void fillTimestampFromMAC(pcaprec_hdr_t *pcapHeader, const uint8_t *timestamp)
 {
 	const uint64_t micros = 1000000;
-	uint32_t       ts     = GETLE32(params->Timestamp); // timestamp in symbols
+	uint32_t       ts     = GETLE32(timestamp); // timestamp in symbols
 	uint64_t       ts_us  = (uint64_t)ts * aSymbolPeriod_us;
 	uint64_t       ts_s   = ts_us / micros;
 
@@ -711,6 +861,149 @@ static void fillTimestampFromMAC(pcaprec_hdr_t *pcapHeader, struct PCPS_DATA_ind
 	pcapHeader->ts_usec = (uint32_t)(ts_us - (ts_s * micros));
 }
 
+/**
+ * Get the host time in us since the epoch. This is based on a monotonic clock, so it is not
+ * affected by changes to the system time after startup.
+ * @return Host time in us
+ */
+static uint64_t getHostTimeUs(void)
+{
+	static struct timespec base_real, base_mono;
+	static bool            initialised = false;
+	struct timespec        now;
+	int64_t                elapsed_us;
+
+	if (!initialised)
+	{
+		clock_gettime(CLOCK_REALTIME, &base_real);
+		clock_gettime(CLOCK_MONOTONIC, &base_mono);
+		initialised = true;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed_us = (int64_t)(now.tv_sec - base_mono.tv_sec) * 1000000 + (now.tv_nsec - base_mono.tv_nsec) / 1000;
+	return (uint64_t)base_real.tv_sec * 1000000 + base_real.tv_nsec / 1000 + elapsed_us;
+}
+
+/**
+ * Get the host-aligned timestamp of a received packet. If the device provides a timestamp, it is
+ * converted to host time using a per-device offset. The offset is calibrated from the smallest
+ * observed difference between host and device time (as reception delay is never negative), and
+ * is allowed to rise slowly to track drift between the two clocks.
+ * @param sdev The device that received the packet
+ * @param timestamp The 4 byte device timestamp in symbols, or NULL if not available
+ * @return Packet timestamp in us since the epoch
+ */
+static uint64_t getPacketTimeUs(struct sniffer_dev *sdev, const uint8_t *timestamp)
+{
+	uint64_t host_us = getHostTimeUs();
+	uint64_t dev_us;
+	uint32_t raw;
+	int64_t  observed, max_offset;
+
+	if (!timestamp)
+		return host_us;
+
+	raw = GETLE32(timestamp);
+	if (sdev->ts_calibrated && raw < sdev->ts_last_raw)
+		sdev->ts_wraps++;
+	sdev->ts_last_raw = raw;
+
+	dev_us   = ((sdev->ts_wraps << 32) + raw) * aSymbolPeriod_us;
+	observed = (int64_t)(host_us - dev_us);
+
+	if (!sdev->ts_calibrated || llabs(observed - sdev->ts_offset_us) > TS_RESYNC_US)
+	{
+		//First packet, or the device timestamp has jumped (eg. after a reset), so restart calibration
+		if (sdev->ts_calibrated && debugMode)
+			fprintf(stderr, "Timestamp calibration restarted on channel %d\n", sdev->channel);
+		sdev->ts_offset_us  = observed;
+		sdev->ts_calibrated = true;
+	}
+	else
+	{
+		max_offset         = sdev->ts_offset_us + (int64_t)(host_us - sdev->ts_last_host_us) / TS_DRIFT_DIVISOR;
+		sdev->ts_offset_us = (observed < max_offset) ? observed : max_offset;
+	}
+	sdev->ts_last_host_us = host_us;
+
+	return dev_us + sdev->ts_offset_us;
+}
+
+/**
+ * Append a pcapng option to a block being built.
+ * @param buf Buffer to append to
+ * @param len Current length of buf, updated with the appended option
+ * @param code Option code
+ * @param value Option value
+ * @param vlen Length of the value (padded to 32 bits in the output)
+ */
+static void appendPcapngOption(uint8_t *buf, size_t *len, uint16_t code, const void *value, uint16_t vlen)
+{
+	uint16_t padded = (vlen + 3) & ~3;
+
+	memcpy(buf + *len, &code, sizeof(code));
+	memcpy(buf + *len + 2, &vlen, sizeof(vlen));
+	memset(buf + *len + 4, 0, padded);
+	memcpy(buf + *len + 4, value, vlen);
+	*len += 4 + padded;
+}
+
+/**
+ * Parse a capture file rotation rule, as given to the '-r' option.
+ * @param rule The rule string, eg. "filesize:1000"
+ * @return Status of the operation
+ */
+static ca_error parseRotateRule(const char *rule)
+{
+	const char *value = strchr(rule, ':');
+	long        num;
+
+	if (!value || (num = atol(value + 1)) <= 0)
+		return CA_ERROR_INVALID_ARGS;
+
+	if (strncmp(rule, "filesize:", 9) == 0)
+		writer_config.rotate_bytes = (uint64_t)num * 1024;
+	else if (strncmp(rule, "duration:", 9) == 0)
+		writer_config.rotate_seconds = num;
+	else if (strncmp(rule, "files:", 6) == 0)
+		writer_config.rotate_files = num;
+	else
+		return CA_ERROR_INVALID_ARGS;
+
+	return CA_ERROR_SUCCESS;
+}
+
+/**
+ * Signal handler, requesting the main loop to write out buffered packets and exit.
+ */
+static void handleExitSignal(int sig)
+{
+	(void)sig;
+	exit_requested = true;
+}
+
+/**
+ * Write out the buffered capture and report writer statistics at exit.
+ */
+static void closeCapture(void)
+{
+	struct capture_writer_stats stats;
+
+	capture_writer_deinit();
+	capture_writer_get_stats(&stats);
+	if (debugMode || stats.dropped)
+	{
+		fprintf(stderr,
+		        "Captured %llu packets, %llu bytes in %u writes, dropped %u packets, buffer high watermark %u bytes.\n",
+		        (unsigned long long)stats.records,
+		        (unsigned long long)stats.bytes,
+		        stats.flushes,
+		        stats.dropped,
+		        (unsigned)stats.high_watermark);
+	}
+}
+
 /**
  * Helper function to print the system time to the given output.
  * @param out  The FILE* to print to, or NULL to use default output.
@@ -731,11 +1024,61 @@ static void printTime(FILE *out)
 		ca_print("%s.%03d ", timeString, ts.tv_nsec / 1000000);
 }
 
+/**
+ * Print the pcapng header to default output, with one interface per sniffed channel.
+ */
+static void printPcapngHeader(void)
+{
+	uint8_t      buf[PCAPNG_MAX_HEADER_LEN];
+	size_t       len = 0;
+	pcapng_shb_t shb = {
+	    PCAPNG_BLOCK_SHB,
+	    sizeof(pcapng_shb_t) + 4,
+	    PCAPNG_BYTE_ORDER_MAGIC,
+	    1,                        //Major version
+	    0,                        //Minor version
+	    {0xFFFFFFFF, 0xFFFFFFFF}, //Section length (unspecified)
+	};
+
+	memcpy(buf, &shb, sizeof(shb));
+	memcpy(buf + sizeof(shb), &shb.block_len, 4);
+	len = shb.block_len;
+
+	for (int i = 0; i < num_devices; i++)
+	{
+		pcapng_idb_t idb      = {PCAPNG_BLOCK_IDB, 0, link_type, 0, 300};
+		size_t       start    = len;
+		uint8_t      tsresol  = 6; //Microsecond resolution
+		uint32_t     zero     = 0;
+		char         name[16] = {0};
+
+		len += sizeof(idb);
+		snprintf(name, sizeof(name), "ch%d", devices[i].channel);
+		appendPcapngOption(buf, &len, PCAPNG_OPT_IF_NAME, name, strlen(name));
+		appendPcapngOption(buf, &len, PCAPNG_OPT_IF_TSRESOL, &tsresol, 1);
+		memcpy(buf + len, &zero, 4); //opt_endofopt
+		len += 4;
+
+		idb.block_len = (len + 4) - start;
+		memcpy(buf + start, &idb, sizeof(idb));
+		memcpy(buf + len, &idb.block_len, 4);
+		len += 4;
+	}
+
+	capture_writer_set_header(buf, len);
+}
+
 /**
  * Print the pcap header to default output.
  */
 static void printPcapHeader(void)
 {
+	if (use_pcapng)
+	{
+		printPcapngHeader();
+		return;
+	}
+
 	pcap_hdr_t hdr = {
 	    0xa1b2c3d4, //Magic pcap number
 	    2,          //Major version
@@ -746,17 +1089,18 @@ static void printPcapHeader(void)
 	    link_type,  //Network
 	};
 
-	ca_write(&hdr, sizeof(hdr));
-	ca_flush();
+	capture_writer_set_header(&hdr, sizeof(hdr));
 }
 
 /**
  * Reset and initialise the radio for sniffing.
  * @param from_startup initialise from startup when 1, re-initialisation only when 0.
- * @param pDeviceRef cascoda device reference.
+ * @param sdev sniffing device.
  */
-static void initialiseRadio(uint8_t from_startup, struct ca821x_dev *pDeviceRef)
+static void initialiseRadio(uint8_t from_startup, struct sniffer_dev *sdev)
 {
+	struct ca821x_dev *pDeviceRef = &sdev->dev;
+
 	if (from_startup)
 	{
 		ca_error status;
@@ -766,16 +1110,16 @@ static void initialiseRadio(uint8_t from_startup, struct ca821x_dev *pDeviceRef)
 			fprintf(stderr, "Failed to connect, status %02X\n", status);
 			exit(EXIT_FAILURE);
 		}
-		GetDeviceVersion(pDeviceRef);
+		GetDeviceVersion(sdev);
 	}
 	MLME_RESET_request_sync(1, pDeviceRef);
 
-	if (DeviceType == DEV_CA8210) /* TDME interface */
+	if (sdev->type == DEV_CA8210) /* TDME interface */
 	{
 		//Reset test mode
 		TDME_TESTMODE_request_sync(TDME_TEST_OFF, pDeviceRef);
 		// Set current channel to selected
-		TDME_SET_request_sync(TDME_CHANNEL, 1, &channel, pDeviceRef);
+		TDME_SET_request_sync(TDME_CHANNEL, 1, &sdev->channel, pDeviceRef);
 		//Enable receiving FCS field
 		uint8_t macCfg = 0;
 		TDME_GETSFR_request_sync(0, 0xD9, &macCfg, pDeviceRef);
@@ -790,7 +1134,7 @@ static void initialiseRadio(uint8_t from_startup, struct ca821x_dev *pDeviceRef)
 		//Set RxMode to PCPS
 		HWME_SET_request_sync(HWME_RXMODE, 1, &att, pDeviceRef);
 		//Set current channel to selected
-		MLME_SET_request_sync(phyCurrentChannel, 0, 1, &channel, pDeviceRef);
+		MLME_SET_request_sync(phyCurrentChannel, 0, 1, &sdev->channel, pDeviceRef);
 		//Enable promiscuous mode, to receive all frames
 		att = 1;
 		MLME_SET_request_sync(macPromiscuousMode, 0, 1, &att, pDeviceRef);
@@ -800,7 +1144,7 @@ static void initialiseRadio(uint8_t from_startup, struct ca821x_dev *pDeviceRef)
 		macCfg |= 0x10;
 		TDME_SETSFR_request_sync(0, 0xD9, macCfg, pDeviceRef);
 		//Set Rx enabled
-		if (DeviceType == DEV_CA8212)
+		if (sdev->type == DEV_CA8212)
 		{
 			//Set LQI limit to 0
 			att = 0;
@@ -811,16 +1155,36 @@ static void initialiseRadio(uint8_t from_startup, struct ca821x_dev *pDeviceRef)
 	}
 }
 
+/**
+ * Capture writer callback for when writing to the output stream fails.
+ * @return The new output stream
+ */
+static capture_fd_t handleStreamError(void)
+{
+	if (dPipeName)
+	{
+		//There has been an issue with writing, pipe probably disconnected at other end.
+		//Try to reconnect.
+		open_pipe(dPipeName); //Blocking call to re-open the pipe
+		for (int i = 0; i < num_devices; i++)
+			initialiseRadio(0, &devices[i]); //Reinitialise radios
+	}
+	return get_output_stream();
+}
+
 /**
  * Output packet in Hex Mode
+ * @param sdev device that received the packet
  * @param payload pointer to payload
  * @param length payload length
  * @param cs CS/LQI value
  * @param ed ED/RSSI value
  */
-static void OutputHex(uint8_t *payload, uint8_t length, uint8_t cs, uint8_t ed)
+static void OutputHex(struct sniffer_dev *sdev, uint8_t *payload, uint8_t length, uint8_t cs, uint8_t ed)
 {
 	printTime(NULL);
+	if (num_devices > 1)
+		ca_print("Ch %d ", sdev->channel);
 	ca_print("Rx len %d, CS: %d, ED: %d >", length, cs, ed);
 	for (int i = 0; i < length; i++)
 	{
@@ -831,14 +1195,17 @@ static void OutputHex(uint8_t *payload, uint8_t length, uint8_t cs, uint8_t ed)
 
 /**
  * Output packet in Debug Mode
+ * @param sdev device that received the packet
  * @param payload pointer to payload
  * @param length payload length
  * @param cs CS/LQI value
  * @param ed ED/RSSI value
  */
-static void OutputDebug(uint8_t *payload, uint8_t length, uint8_t cs, uint8_t ed)
+static void OutputDebug(struct sniffer_dev *sdev, uint8_t *payload, uint8_t length, uint8_t cs, uint8_t ed)
 {
 	printTime(stderr);
+	if (num_devices > 1)
+		fprintf(stderr, "Ch %d ", sdev->channel);
 	fprintf(stderr, "Rx len %d, CS: %d, ED: %d >", length, cs, ed);
 	for (int i = 0; i < length; i++)
 	{
@@ -848,24 +1215,25 @@ static void OutputDebug(uint8_t *payload, uint8_t length, uint8_t cs, uint8_t ed
 }
 
 /**
- * Output packet in PCap Mode
- * @param payload pointer to the pcap header
+ * Output packet in PCap Mode. The record is buffered by the capture writer, and written out
+ * by the main thread.
+ * @param sdev device that received the packet
  * @param payload pointer to payload
  * @param length payload length
  * @param cs CS/LQI value
  * @param ed ED/RSSI value
- * @param pDeviceRef cascoda device reference.
+ * @param timestamp pointer to the 4 byte device timestamp, or NULL if the device has none
  */
-static void OutputPcap(pcaprec_hdr_t     *hdr,
-                       uint8_t           *payload,
-                       uint8_t            length,
-                       uint8_t            cs,
-                       uint8_t            ed,
-                       struct ca821x_dev *pDeviceRef)
+static void OutputPcap(struct sniffer_dev *sdev,
+                       uint8_t            *payload,
+                       uint8_t             length,
+                       uint8_t             cs,
+                       uint8_t             ed,
+                       const uint8_t      *timestamp)
 {
-	ca_error error = CA_ERROR_SUCCESS;
 	uint8_t  pkt_header[MAX_HEADER_LEN];
 	uint32_t header_len = 0;
+	uint32_t record_len;
 
 	if (link_type == LINKTYPE_ETHERNET)
 	{
@@ -876,6 +1244,7 @@ static void OutputPcap(pcaprec_hdr_t     *hdr,
 	{
 		fillRSSITap(ed);
 		fillLQITap(cs);
+		fillChannelTap(sdev->channel);
 		header_len = HEADER_LEN_TAP;
 		memcpy(pkt_header, tap_header, header_len);
 	}
@@ -884,21 +1253,51 @@ static void OutputPcap(pcaprec_hdr_t     *hdr,
 		header_len = 0;
 	}
 
-	hdr->incl_len = length + header_len;
-	hdr->orig_len = length + header_len;
+	record_len = length + header_len;
 
-	error |= ca_write(hdr, sizeof(pcaprec_hdr_t));
-	error |= ca_write(&pkt_header, header_len);
-	error |= ca_write(payload, length);
-	ca_flush();
-
-	if (error && dPipeName)
+	if (use_pcapng)
 	{
-		//There has been an issue with writing, pipe probably disconnected at other end.
-		//Try to reconnect.
-		open_pipe(dPipeName);           //Blocking call to re-open the pipe
-		printPcapHeader();              //Print the pcap header so connection is valid
-		initialiseRadio(0, pDeviceRef); //Reinitialise radio
+		uint64_t     ts_us      = getPacketTimeUs(sdev, timestamp);
+		uint32_t     pad_len    = ((record_len + 3) & ~3) - record_len;
+		uint8_t      trailer[8] = {0};
+		pcapng_epb_t epb;
+
+		epb.block_type   = PCAPNG_BLOCK_EPB;
+		epb.block_len    = sizeof(pcapng_epb_t) + record_len + pad_len + 4;
+		epb.interface_id = sdev->interface_id;
+		epb.ts_high      = (uint32_t)(ts_us >> 32);
+		epb.ts_low       = (uint32_t)ts_us;
+		epb.cap_len      = record_len;
+		epb.orig_len     = record_len;
+		memcpy(trailer + pad_len, &epb.block_len, 4);
+
+		struct capture_part parts[] = {
+		    {&epb, sizeof(epb)},
+		    {pkt_header, header_len},
+		    {payload, length},
+		    {trailer, pad_len + 4},
+		};
+
+		if (capture_writer_record(parts, 4) && debugMode)
+			fprintf(stderr, "Capture buffer full, packet dropped.\n");
+	}
+	else
+	{
+		pcaprec_hdr_t hdr = {0, 0, record_len, record_len};
+
+		if (timestamp)
+			fillTimestampFromMAC(&hdr, timestamp);
+		else
+			fillTimestampFromOS(&hdr);
+
+		struct capture_part parts[] = {
+		    {&hdr, sizeof(pcaprec_hdr_t)},
+		    {pkt_header, header_len},
+		    {payload, length},
+		};
+
+		if (capture_writer_record(parts, 3) && debugMode)
+			fprintf(stderr, "Capture buffer full, packet dropped.\n");
 	}
 }
 
@@ -915,28 +1314,62 @@ static ca_error handleEvbmeMessage(struct EVBME_Message *params, struct ca821x_d
 }
 
 /**
- * Callback for handling CA8211 PCPS data indications for received 802.15.4 frames
- * @param params  PCPS Data indication struct
- * @param pDeviceRef  Cascoda device reference
- * @return CA_ERROR_SUCCESS
+ * Process a received frame: parse it once, apply the capture filter and pass it to the output.
+ * @param sdev device that received the packet
+ * @param payload pointer to payload
+ * @param length payload length
+ * @param cs CS/LQI value
+ * @param ed ED/RSSI value
+ * @param timestamp pointer to the 4 byte device timestamp, or NULL if the device has none
  */
-static ca_error handlePcpsDataIndication8211(struct PCPS_DATA_indication_pset_8211 *params,
-                                             struct ca821x_dev                     *pDeviceRef)
+static void handleFrame(struct sniffer_dev *sdev,
+                        uint8_t            *payload,
+                        uint8_t             length,
+                        uint8_t             cs,
+                        uint8_t             ed,
+                        const uint8_t      *timestamp)
 {
+	struct frame_info info;
+
+	if (filter.num_exprs || out_mode == OUT_MODE_STATS)
+	{
+		frame_parse(&info, payload, length, ed, cs, sdev->channel);
+		if (!frame_filter_match(&filter, &info))
+			return;
+	}
+
 	if (out_mode == OUT_MODE_HEX)
 	{
-		OutputHex(params->Psdu, params->PsduLength, params->CS, params->ED);
+		OutputHex(sdev, payload, length, cs, ed);
 	}
 	else if (out_mode == OUT_MODE_PCAP)
 	{
-		pcaprec_hdr_t hdr = {0, 0, 0, 0};
-		fillTimestampFromOS(&hdr);
-		OutputPcap(&hdr, params->Psdu, params->PsduLength, params->CS, params->ED, pDeviceRef);
+		OutputPcap(sdev, payload, length, cs, ed, timestamp);
 		if (debugMode)
 		{
-			OutputDebug(params->Psdu, params->PsduLength, params->CS, params->ED);
+			OutputDebug(sdev, payload, length, cs, ed);
 		}
 	}
+	else if (out_mode == OUT_MODE_STATS)
+	{
+		frame_stats_add(&info);
+		if (debugMode)
+		{
+			OutputDebug(sdev, payload, length, cs, ed);
+		}
+	}
+}
+
+/**
+ * Callback for handling CA8211 PCPS data indications for received 802.15.4 frames
+ * @param params  PCPS Data indication struct
+ * @param pDeviceRef  Cascoda device reference
+ * @return CA_ERROR_SUCCESS
+ */
+static ca_error handlePcpsDataIndication8211(struct PCPS_DATA_indication_pset_8211 *params,
+                                             struct ca821x_dev                     *pDeviceRef)
+{
+	handleFrame(pDeviceRef->context, params->Psdu, params->PsduLength, params->CS, params->ED, NULL);
 	return CA_ERROR_SUCCESS;
 }
 
@@ -949,20 +1382,7 @@ static ca_error handlePcpsDataIndication8211(struct PCPS_DATA_indication_pset_82
 static ca_error handlePcpsDataIndication8212(struct PCPS_DATA_indication_pset_8212 *params,
                                              struct ca821x_dev                     *pDeviceRef)
 {
-	if (out_mode == OUT_MODE_HEX)
-	{
-		OutputHex(params->Psdu, params->PsduLength, params->CS, params->ED);
-	}
-	else if (out_mode == OUT_MODE_PCAP)
-	{
-		pcaprec_hdr_t hdr = {0, 0, 0, 0};
-		fillTimestampFromMAC(&hdr, params);
-		OutputPcap(&hdr, params->Psdu, params->PsduLength, params->CS, params->ED, pDeviceRef);
-		if (debugMode)
-		{
-			OutputDebug(params->Psdu, params->PsduLength, params->CS, params->ED);
-		}
-	}
+	handleFrame(pDeviceRef->context, params->Psdu, params->PsduLength, params->CS, params->ED, params->Timestamp);
 	return CA_ERROR_SUCCESS;
 }
 
@@ -974,9 +1394,11 @@ static ca_error handlePcpsDataIndication8212(struct PCPS_DATA_indication_pset_82
  */
 static ca_error handleAndSwitchPcpsDataIndication(const struct MAC_Message *msg, struct ca821x_dev *pDeviceRef)
 {
+	struct sniffer_dev *sdev = pDeviceRef->context;
+
 	if (msg->CommandId == SPI_PCPS_DATA_INDICATION)
 	{
-		if (DeviceType == DEV_CA8212)
+		if (sdev->type == DEV_CA8212)
 			handlePcpsDataIndication8212((struct PCPS_DATA_indication_pset_8212 *)(msg->PData.Payload), pDeviceRef);
 		else
 			handlePcpsDataIndication8211((struct PCPS_DATA_indication_pset_8211 *)(msg->PData.Payload), pDeviceRef);
@@ -995,29 +1417,12 @@ static ca_error handleTdmeRxpktIndication(struct TDME_RXPKT_indication_pset *par
 {
 	if (!params->Status) /* handle only packets without any errors */
 	{
-		if (out_mode == OUT_MODE_HEX)
-		{
-			OutputHex(
-			    params->TestPacketData, params->TestPacketLength, params->TestPacketCSValue, params->TestPacketEDValue);
-		}
-		else if (out_mode == OUT_MODE_PCAP)
-		{
-			pcaprec_hdr_t hdr = {0, 0, 0, 0};
-			fillTimestampFromOS(&hdr);
-			OutputPcap(&hdr,
-			           params->TestPacketData,
-			           params->TestPacketLength,
-			           params->TestPacketCSValue,
-			           params->TestPacketEDValue,
-			           pDeviceRef);
-			if (debugMode)
-			{
-				OutputDebug(params->TestPacketData,
-				            params->TestPacketLength,
-				            params->TestPacketCSValue,
-				            params->TestPacketEDValue);
-			}
-		}
+		handleFrame(pDeviceRef->context,
+		            params->TestPacketData,
+		            params->TestPacketLength,
+		            params->TestPacketCSValue,
+		            params->TestPacketEDValue,
+		            NULL);
 	} // !params->Status
 	return CA_ERROR_SUCCESS;
 }
@@ -1045,8 +1450,17 @@ static void fillLQITap(uint8_t cs)
 	tap_header[HEADER_POSITION_LQI] = cs;
 }
 
-static void GetDeviceVersion(struct ca821x_dev *pDeviceRef)
+static void fillChannelTap(uint8_t channel)
 {
+	/* 16-bit channel number, followed by channel page 0 */
+	tap_header[HEADER_POSITION_CHANNEL]     = channel;
+	tap_header[HEADER_POSITION_CHANNEL + 1] = 0;
+	tap_header[HEADER_POSITION_CHANNEL + 2] = 0;
+}
+
+static void GetDeviceVersion(struct sniffer_dev *sdev)
+{
+	ca_device_type type = DEV_UNKNOWN;
 	struct hwme_chipid
 	{
 		uint8_t hw_version; // hardware version / pid
@@ -1056,22 +1470,21 @@ static void GetDeviceVersion(struct ca821x_dev *pDeviceRef)
 	uint8_t            attlen;
 	uint8_t            status;
 
-	status = HWME_GET_request_sync(HWME_CHIPID, &attlen, (uint8_t *)&chipid, pDeviceRef);
+	status = HWME_GET_request_sync(HWME_CHIPID, &attlen, (uint8_t *)&chipid, &sdev->dev);
 	if (status)
 	{
 		fprintf(stderr, "GetDeviceVersion Status: %02X\n", status);
 		exit(EXIT_FAILURE);
 	}
 	if ((chipid.hw_version == 1) && (chipid.fw_version <= 2))
-		DeviceType = DEV_CA8210;
+		type = DEV_CA8210;
 	else if ((chipid.hw_version == 1) && (chipid.fw_version == 3))
-		DeviceType = DEV_CA8211;
+		type = DEV_CA8211;
 	else if (chipid.hw_version == 2)
-		DeviceType = DEV_CA8212;
-	else
-		DeviceType = DEV_UNKNOWN;
+		type = DEV_CA8212;
 
-	if (DeviceType == DEV_UNKNOWN)
+	sdev->type = type;
+	if (type == DEV_UNKNOWN)
 	{
 		fprintf(stderr, "unknown sniffing device (%u.%u)\n", chipid.hw_version, chipid.fw_version);
 		exit(EXIT_FAILURE);
@@ -1080,13 +1493,11 @@ static void GetDeviceVersion(struct ca821x_dev *pDeviceRef)
 
 int main(int argc, char *argv[])
 {
-	struct ca821x_dev *pDeviceRef    = &(sDeviceRef);
-	ca_error           error         = CA_ERROR_SUCCESS;
-	char              *pipeName      = NULL;
-	char              *wiresharkPath = NULL;
-	char              *outputDirPath = NULL;
-
-	union ca821x_util_init_extra_arg sniffer_arg = {.generic = NULL};
+	ca_error error         = CA_ERROR_SUCCESS;
+	char    *pipeName      = NULL;
+	char    *wiresharkPath = NULL;
+	char    *outputDirPath = NULL;
+	int      num_serials   = 0;
 
 	configure_io();
 	snprintf(default_pipe, sizeof(default_pipe), DEFAULT_PIPE "%x", getpid());
@@ -1137,7 +1548,17 @@ int main(int argc, char *argv[])
 		}
 		else if (strcmp(argv[i], "-s") == 0)
 		{
-			sniffer_arg.generic = argv[++i];
+			if (++i >= argc || num_serials >= MAX_DEVICES)
+			{
+				fprintf(stderr, "'-s' option requires serial number argument, once per channel.\n");
+				error = CA_ERROR_INVALID_ARGS;
+				break;
+			}
+			devices[num_serials++].serial = argv[i];
+		}
+		else if (strcmp(argv[i], "-g") == 0)
+		{
+			use_pcapng = true;
 		}
 		else if (strcmp(argv[i], "-e") == 0)
 		{
@@ -1157,6 +1578,57 @@ int main(int argc, char *argv[])
 			}
 			time_till_new_capture = atoi(argv[i]);
 		}
+		else if (strcmp(argv[i], "-f") == 0)
+		{
+			if (++i >= argc)
+			{
+				fprintf(stderr, "'-f' option requires filename argument.\n");
+				error = CA_ERROR_INVALID_ARGS;
+				break;
+			}
+			writer_config.file_path = argv[i];
+			out_mode                = OUT_MODE_PCAP;
+		}
+		else if (strcmp(argv[i], "-r") == 0)
+		{
+			if (++i >= argc || parseRotateRule(argv[i]))
+			{
+				fprintf(stderr, "'-r' option requires filesize:KB, duration:S or files:N argument.\n");
+				error = CA_ERROR_INVALID_ARGS;
+				break;
+			}
+		}
+		else if (strcmp(argv[i], "-B") == 0)
+		{
+			if (++i >= argc || atoi(argv[i]) <= 0)
+			{
+				fprintf(stderr, "'-B' option requires buffer size (kB) argument.\n");
+				error = CA_ERROR_INVALID_ARGS;
+				break;
+			}
+			writer_config.buffer_size = (size_t)atoi(argv[i]) * 1024;
+			if (writer_config.flush_threshold > writer_config.buffer_size / 2)
+				writer_config.flush_threshold = writer_config.buffer_size / 2;
+		}
+		else if (strcmp(argv[i], "-F") == 0)
+		{
+			if (++i >= argc || frame_filter_add(&filter, argv[i]))
+			{
+				fprintf(stderr, "'-F' option requires a valid filter expression argument.\n");
+				error = CA_ERROR_INVALID_ARGS;
+				break;
+			}
+		}
+		else if (strcmp(argv[i], "-S") == 0)
+		{
+			if (++i >= argc || atoi(argv[i]) <= 0)
+			{
+				fprintf(stderr, "'-S' option requires interval (s) argument.\n");
+				error = CA_ERROR_INVALID_ARGS;
+				break;
+			}
+			stats_interval = atoi(argv[i]);
+		}
 		else if (strcmp(argv[i], "-o") == 0)
 		{
 			if (++i >= argc)
@@ -1170,7 +1642,15 @@ int main(int argc, char *argv[])
 		}
 		else if (temp >= 11 && temp <= 26)
 		{
-			channel = temp;
+			if (num_devices >= MAX_DEVICES)
+			{
+				fprintf(stderr, "Too many channels, maximum is %d.\n", MAX_DEVICES);
+				error = CA_ERROR_INVALID_ARGS;
+				break;
+			}
+			devices[num_devices].channel      = temp;
+			devices[num_devices].interface_id = num_devices;
+			num_devices++;
 		}
 		else
 		{
@@ -1179,14 +1659,29 @@ int main(int argc, char *argv[])
 		}
 	} //End argument processing.
 
-	if (error || !channel)
+	if (error || !num_devices || num_serials > num_devices)
 	{
 		fprintf(stderr, "Invalid arguments detected.\n");
 		displayHelp();
 		exit(EXIT_FAILURE);
 	}
 
-	if (out_mode == OUT_MODE_PCAP && isatty(fileno(stdout)) && !pipeName)
+	if (stats_interval)
+	{
+		if (out_mode == OUT_MODE_PCAP)
+		{
+			fprintf(stderr, "Statistics mode (-S) does not write a capture, it cannot be used with pcap output.\n");
+			displayHelp();
+			exit(EXIT_FAILURE);
+		}
+		out_mode = OUT_MODE_STATS;
+	}
+
+	//A pcap file can only describe a single interface
+	if (num_devices > 1)
+		use_pcapng = true;
+
+	if (out_mode == OUT_MODE_PCAP && isatty(fileno(stdout)) && !pipeName && !writer_config.file_path)
 	{
 		fprintf(stderr, "Out mode is pcap, but stdout is tty - redirect to file or pipe!\n");
 		displayHelp();
@@ -1200,6 +1695,21 @@ int main(int argc, char *argv[])
 		exit(EXIT_FAILURE);
 	}
 
+	if ((writer_config.rotate_bytes || writer_config.rotate_seconds || writer_config.rotate_files) &&
+	    !writer_config.file_path)
+	{
+		fprintf(stderr, "You have to provide an output file with -f when using capture file rotation.\n");
+		displayHelp();
+		exit(EXIT_FAILURE);
+	}
+
+	if (writer_config.file_path && pipeName)
+	{
+		fprintf(stderr, "Output to a file (-f) and to a pipe (-n, -w) cannot be combined.\n");
+		displayHelp();
+		exit(EXIT_FAILURE);
+	}
+
 	if (pipeName)
 	{
 		create_pipe(pipeName);
@@ -1216,41 +1726,81 @@ int main(int argc, char *argv[])
 	}
 
 	fprintf(stderr, "Initialising ca821x_api.\n");
-	while (ca821x_util_init(pDeviceRef, NULL, sniffer_arg))
+	for (int i = 0; i < num_devices; i++)
 	{
-		sleep(1); //Wait while there isn't a device available to connect
-		fprintf(stderr, ".");
+		union ca821x_util_init_extra_arg sniffer_arg = {.generic = (void *)devices[i].serial};
+
+		while (ca821x_util_init(&devices[i].dev, NULL, sniffer_arg))
+		{
+			sleep(1); //Wait while there isn't a device available to connect
+			fprintf(stderr, ".");
+		}
+		devices[i].dev.context = &devices[i];
 	}
 
 	setStartTime();
 	if (out_mode == OUT_MODE_PCAP)
 	{
 		io_raw();
+		writer_config.stream_error_callback = &handleStreamError;
+		if (capture_writer_init(&writer_config))
+		{
+			fprintf(stderr, "Failed to initialise the capture writer.\n");
+			exit(EXIT_FAILURE);
+		}
+		if (!writer_config.file_path)
+			capture_writer_set_stream(get_output_stream());
+		atexit(closeCapture);
+		signal(SIGINT, handleExitSignal);
+		signal(SIGTERM, handleExitSignal);
 		printPcapHeader();
 	}
-
-	initialiseRadio(1, pDeviceRef);
-
-	//Register callbacks for async messages
-	if (DeviceType == DEV_CA8210)
+	else if (out_mode == OUT_MODE_STATS)
 	{
-		pDeviceRef->callbacks.TDME_RXPKT_indication = &handleTdmeRxpktIndication;
+		frame_stats_init();
+		signal(SIGINT, handleExitSignal);
+		signal(SIGTERM, handleExitSignal);
 	}
-	else
+
+	for (int i = 0; i < num_devices; i++)
 	{
-		/* can't use pDeviceRef->callbacks.PCPS_DATA_indication as params differ between 8211 and 8212 */
-		/* so have to use generic callback to get MAC_Message and then dissect */
-		pDeviceRef->callbacks.generic_dispatch = &handleAndSwitchPcpsDataIndication;
-	}
+		struct ca821x_dev *pDeviceRef = &devices[i].dev;
+
+		initialiseRadio(1, &devices[i]);
+
+		//Register callbacks for async messages
+		if (devices[i].type == DEV_CA8210)
+		{
+			pDeviceRef->callbacks.TDME_RXPKT_indication = &handleTdmeRxpktIndication;
+		}
+		else
+		{
+			/* can't use pDeviceRef->callbacks.PCPS_DATA_indication as params differ between 8211 and 8212 */
+			/* so have to use generic callback to get MAC_Message and then dissect */
+			pDeviceRef->callbacks.generic_dispatch = &handleAndSwitchPcpsDataIndication;
+		}
 
-	EVBME_GetCallbackStruct(pDeviceRef)->EVBME_MESSAGE_indication = &handleEvbmeMessage;
+		EVBME_GetCallbackStruct(pDeviceRef)->EVBME_MESSAGE_indication = &handleEvbmeMessage;
+	}
 	ca821x_util_start_upstream_dispatch_worker();
 
 	fprintf(stderr, "\r\nInitialised.\r\n\n");
 
-	while (1)
+	while (!exit_requested)
 	{
-		sleep(1);
+		if (out_mode == OUT_MODE_PCAP)
+		{
+			capture_writer_process();
+		}
+		else if (out_mode == OUT_MODE_STATS)
+		{
+			for (unsigned int s = 0; s < stats_interval && !exit_requested; s++) sleep(1);
+			frame_stats_print(stdout, STATS_TOP_ADDRS);
+		}
+		else
+		{
+			sleep(1);
+		}
 	}
 	return 0;
 }
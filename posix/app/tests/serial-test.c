@@ -30,6 +30,7 @@
  */
 
 #include <math.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -72,7 +73,7 @@ LARGE_INTEGER *end;
 static void displayHelp()
 {
 	printf("\n===== How to use the command =====\n");
-	printf("\nThere are 3 ways to type the command:\n\n");
+	printf("\nThere are 4 ways to type the command:\n\n");
 
 #ifndef _WIN32
 	printf("1. serial-test\n");
@@ -105,6 +106,14 @@ static void displayHelp()
 	printf("\t<arg4> - Delay (in ms) between each message sent to the Chili module.\n");
 	printf("\t<arg5> - Additional length (in bytes) to add the default 1-byte message sent to the Chili module.\n");
 	printf("\t<arg6> - Length (in bytes) of each indication sent by the Chili module.\n\n");
+
+#ifndef _WIN32
+	printf("4. serial-test ");
+// POSIX
+#elif defined(_WIN32)
+	printf("4. serial-test.exe ");
+#endif // _WIN32
+	printf("-h - Benchmark the link with a sweep of message sizes and loads, and print the options.\n\n");
 }
 
 static void getStartTime(int index)
@@ -377,18 +386,615 @@ static void displayEvbme(struct ca821x_dev *pDeviceRef)
 
 static void initialise_ca821x(struct ca821x_dev *pDeviceRef)
 {
-	printf("Initialising.");
+	fprintf(stderr, "Initialising.");
 	while (ca821x_util_init(pDeviceRef, NULL, (union ca821x_util_init_extra_arg){NULL}))
 	{
 		sleep(1); //Wait while there isn't a device available to connect
-		printf(".");
+		fprintf(stderr, ".");
 	}
 	//Register callbacks for async messages
 	EVBME_GetCallbackStruct(pDeviceRef)->EVBME_MESSAGE_indication = &handleEvbmeMessage;
 	EVBME_GetCallbackStruct(pDeviceRef)->EVBME_COMM_indication    = &handleCommIndication;
 	ca821x_util_start_upstream_dispatch_worker();
 
-	printf("\r\nInitialised.\r\n\n");
+	fprintf(stderr, "\r\nInitialised.\r\n\n");
+}
+
+/*
+ * Link benchmark. Each point of the sweep sends a number of COMM_CHECK requests, and measures the round trip time
+ * to the first and the last indication of each request. Closed loop points keep a window of requests in flight,
+ * which measures the sustained rate of the link when the window is large enough. Open loop points send requests at
+ * a fixed rate whatever the responses, which measures the latency under a given load.
+ */
+#define BENCH_MAX_VALUES 8      //!< Maximum number of values in each list of the sweep
+#define BENCH_DEFAULT_COUNT 200 //!< Default number of requests sent for each point
+#define BENCH_TIMEOUT_MS 1000   //!< Time to wait for the indications of a request before counting it as lost
+#define BENCH_SETTLE_MS 100     //!< Time for late indications to arrive, before a point ends or a lost handle is reused
+#define BENCH_HEADER_LEN 2      //!< Command ID and length of each EVBME message
+#define BENCH_MAX_PAYLOAD 250   //!< Largest additional length of a request that fits in an EVBME message
+#define BENCH_MAX_IND_SIZE 253  //!< Largest indication that fits in an EVBME message
+
+/** Values swept by the benchmark */
+struct bench_list
+{
+	unsigned values[BENCH_MAX_VALUES];
+	int      count;
+};
+
+/** A COMM_CHECK request of the running point, by handle */
+struct bench_request
+{
+	uint64_t sent;        //!< Time the request was sent [us]
+	uint64_t expired;     //!< Time the request was counted as lost [us], 0 if it was not
+	uint8_t  received;    //!< Indications received so far
+	bool     outstanding; //!< Still waiting for indications
+};
+
+/** Parameters and results of a point of the sweep */
+struct bench_point
+{
+	unsigned payloadLen, indCount, indSize;
+	unsigned window; //!< Requests in flight for closed loop, 0 for open loop
+	unsigned rate;   //!< Requests per second for open loop, 0 for closed loop
+
+	uint32_t  sent, completed, lost, late, indications;
+	uint64_t  txBytes, rxBytes;
+	double    seconds;
+	uint32_t *rttFirst, *rttLast; //!< Sorted round trip times of the first and last indications [us]
+	uint32_t  firstCount;         //!< Number of requests that received at least one indication
+};
+
+static pthread_mutex_t      sBenchMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t       sBenchCond  = PTHREAD_COND_INITIALIZER;
+static struct bench_request sBenchRequests[256];
+static struct bench_point  *sBenchPoint; //!< Point being measured, guarded by sBenchMutex
+static uint32_t             sOutstanding;
+static uint64_t             sLastRx;
+static uint8_t              sNextHandle;
+
+static uint64_t getTimeUs(void)
+{
+#ifndef _WIN32
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+	{
+		perror("clock gettime");
+		exit(EXIT_FAILURE);
+	}
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+// POSIX
+#elif defined(_WIN32)
+	LARGE_INTEGER count;
+
+	if (QueryPerformanceCounter(&count) == 0)
+	{
+		perror("QueryPerformanceTimer");
+		exit(EXIT_FAILURE);
+	}
+	return (count.QuadPart / frequency.QuadPart) * 1000000 +
+	       (count.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#endif // _WIN32
+}
+
+static void sleepUs(uint64_t us)
+{
+	struct timespec ts = {us / 1000000, (us % 1000000) * 1000};
+
+	nanosleep(&ts, NULL);
+}
+
+/* Wait for an indication, or for ms milliseconds. Must be called with sBenchMutex held. */
+static void waitIndication(uint32_t ms)
+{
+	struct timespec deadline;
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_nsec += (ms % 1000) * 1000000L;
+	deadline.tv_sec += ms / 1000 + deadline.tv_nsec / 1000000000L;
+	deadline.tv_nsec %= 1000000000L;
+	pthread_cond_timedwait(&sBenchCond, &sBenchMutex, &deadline);
+}
+
+static ca_error handleBenchIndication(struct EVBME_Message *params, struct ca821x_dev *pDeviceRef)
+{
+	struct bench_request *request = &sBenchRequests[params->EVBME.COMM_indication.mHandle];
+	struct bench_point   *point;
+	uint64_t              now = getTimeUs();
+	(void)pDeviceRef;
+
+	pthread_mutex_lock(&sBenchMutex);
+	point = sBenchPoint;
+	if (!point || !request->outstanding)
+	{
+		// After its request timed out, or from a previous point
+		if (point)
+			point->late++;
+		goto exit;
+	}
+
+	point->indications++;
+	point->rxBytes += BENCH_HEADER_LEN + params->mLen;
+	sLastRx = now;
+	if (request->received++ == 0)
+		point->rttFirst[point->firstCount++] = now - request->sent;
+	if (request->received == point->indCount)
+	{
+		request->outstanding               = false;
+		point->rttLast[point->completed++] = now - request->sent;
+		sOutstanding--;
+		pthread_cond_signal(&sBenchCond);
+	}
+
+exit:
+	pthread_mutex_unlock(&sBenchMutex);
+	return CA_ERROR_SUCCESS;
+}
+
+/* Give up on the requests that are waiting for too long. Must be called with sBenchMutex held. */
+static void expireRequests(uint64_t now)
+{
+	for (int i = 0; i < 256; i++)
+	{
+		struct bench_request *request = &sBenchRequests[i];
+
+		if (request->outstanding && now - request->sent > BENCH_TIMEOUT_MS * 1000)
+		{
+			request->outstanding = false;
+			request->expired     = now;
+			sBenchPoint->lost++;
+			sOutstanding--;
+		}
+	}
+}
+
+/* Wait until at most limit requests are in flight. Must be called with sBenchMutex held. */
+static void waitOutstanding(uint32_t limit)
+{
+	while (sOutstanding > limit)
+	{
+		waitIndication(10);
+		expireRequests(getTimeUs());
+	}
+}
+
+/*
+ * Get the next handle that can be reused, waiting until there is one. The indications only carry the handle, so the
+ * handle of a lost request is kept for BENCH_SETTLE_MS, for its late indications to be counted as late rather than
+ * as those of the next request. Must be called with sBenchMutex held.
+ */
+static uint8_t getFreeHandle(void)
+{
+	while (1)
+	{
+		uint64_t now = getTimeUs();
+
+		for (int i = 0; i < 256; i++)
+		{
+			uint8_t               handle  = sNextHandle++;
+			struct bench_request *request = &sBenchRequests[handle];
+
+			if (!request->outstanding && (!request->expired || now - request->expired > BENCH_SETTLE_MS * 1000))
+				return handle;
+		}
+
+		// Open loop with more requests in flight than handles
+		waitIndication(10);
+		expireRequests(getTimeUs());
+	}
+}
+
+static ca_error sendBenchRequest(struct bench_point *point, struct ca821x_dev *pDeviceRef)
+{
+	struct bench_request *request;
+	uint8_t               handle;
+	ca_error              status;
+
+	pthread_mutex_lock(&sBenchMutex);
+	handle               = getFreeHandle();
+	request              = &sBenchRequests[handle];
+	request->sent        = getTimeUs();
+	request->expired     = 0;
+	request->received    = 0;
+	request->outstanding = true;
+	sOutstanding++;
+	pthread_mutex_unlock(&sBenchMutex);
+
+	status = EVBME_COMM_CHECK_request(handle, 0, point->indCount, point->indSize, point->payloadLen, pDeviceRef);
+
+	pthread_mutex_lock(&sBenchMutex);
+	if (status)
+	{
+		request->outstanding = false;
+		sOutstanding--;
+	}
+	else
+	{
+		point->sent++;
+		point->txBytes += BENCH_HEADER_LEN + sizeof(struct EVBME_COMM_CHECK_request) + point->payloadLen;
+	}
+	pthread_mutex_unlock(&sBenchMutex);
+	return status;
+}
+
+static int compareU32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Nearest rank percentile of sorted values */
+static uint32_t getPercentile(const uint32_t *values, uint32_t count, unsigned percent)
+{
+	uint32_t rank = ((uint64_t)count * percent + 99) / 100;
+
+	if (!count)
+		return 0;
+	return values[rank ? rank - 1 : 0];
+}
+
+static ca_error runBenchPoint(struct bench_point *point, uint32_t requests, struct ca821x_dev *pDeviceRef)
+{
+	uint64_t start, end, next;
+	ca_error status = CA_ERROR_SUCCESS;
+
+	pthread_mutex_lock(&sBenchMutex);
+	memset(sBenchRequests, 0, sizeof(sBenchRequests));
+	sOutstanding = 0;
+	sLastRx      = 0;
+	sBenchPoint  = point;
+	pthread_mutex_unlock(&sBenchMutex);
+
+	start = next = getTimeUs();
+	for (uint32_t i = 0; i < requests && !status; i++)
+	{
+		if (point->window)
+		{
+			pthread_mutex_lock(&sBenchMutex);
+			waitOutstanding(point->window - 1);
+			pthread_mutex_unlock(&sBenchMutex);
+		}
+		else
+		{
+			uint64_t now = getTimeUs();
+
+			// Don't send the requests that fell behind schedule in a burst
+			if (next > now)
+				sleepUs(next - now);
+			next += 1000000 / point->rate;
+			pthread_mutex_lock(&sBenchMutex);
+			expireRequests(getTimeUs());
+			pthread_mutex_unlock(&sBenchMutex);
+		}
+		status = sendBenchRequest(point, pDeviceRef);
+	}
+	end = getTimeUs();
+
+	pthread_mutex_lock(&sBenchMutex);
+	waitOutstanding(0);
+	if (sLastRx > end)
+		end = sLastRx;
+	pthread_mutex_unlock(&sBenchMutex);
+
+	// Let the late indications arrive before the next point starts
+	sleepUs(BENCH_SETTLE_MS * 1000);
+	pthread_mutex_lock(&sBenchMutex);
+	sBenchPoint = NULL;
+	pthread_mutex_unlock(&sBenchMutex);
+
+	point->seconds = (end - start) / 1e6;
+	qsort(point->rttFirst, point->firstCount, sizeof(uint32_t), compareU32);
+	qsort(point->rttLast, point->completed, sizeof(uint32_t), compareU32);
+	return status;
+}
+
+/* Frames per second through the link, in both directions */
+static double getFrameRate(const struct bench_point *point)
+{
+	return point->seconds > 0 ? (point->sent + point->indications) / point->seconds : 0;
+}
+
+/* EVBME message bytes per second through the link, in both directions, without the framing of the exchange */
+static double getByteRate(const struct bench_point *point)
+{
+	return point->seconds > 0 ? (point->txBytes + point->rxBytes) / point->seconds : 0;
+}
+
+static void printBenchCsvHeader(FILE *out)
+{
+	fprintf(out,
+	        "link,mode,window,rate,payload_len,ind_count,ind_size,requests,completed,lost,late,duration_s,"
+	        "tx_frames_per_s,rx_frames_per_s,tx_bytes_per_s,rx_bytes_per_s,"
+	        "rtt_first_p50_us,rtt_first_p90_us,rtt_first_p99_us,rtt_first_max_us,"
+	        "rtt_last_p50_us,rtt_last_p90_us,rtt_last_p99_us,rtt_last_max_us\n");
+}
+
+static void printBenchCsv(FILE *out, const char *link, const struct bench_point *point)
+{
+	fprintf(out,
+	        "%s,%s,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.3f,%.1f,%.1f,%.0f,%.0f,%u,%u,%u,%u,%u,%u,%u,%u\n",
+	        link,
+	        point->window ? "closed" : "open",
+	        point->window,
+	        point->rate,
+	        point->payloadLen,
+	        point->indCount,
+	        point->indSize,
+	        point->sent,
+	        point->completed,
+	        point->lost,
+	        point->late,
+	        point->seconds,
+	        point->sent / point->seconds,
+	        point->indications / point->seconds,
+	        point->txBytes / point->seconds,
+	        point->rxBytes / point->seconds,
+	        getPercentile(point->rttFirst, point->firstCount, 50),
+	        getPercentile(point->rttFirst, point->firstCount, 90),
+	        getPercentile(point->rttFirst, point->firstCount, 99),
+	        getPercentile(point->rttFirst, point->firstCount, 100),
+	        getPercentile(point->rttLast, point->completed, 50),
+	        getPercentile(point->rttLast, point->completed, 90),
+	        getPercentile(point->rttLast, point->completed, 99),
+	        getPercentile(point->rttLast, point->completed, 100));
+}
+
+static void printRttJson(FILE *out, const uint32_t *values, uint32_t count)
+{
+	fprintf(out,
+	        "{\"count\": %u, \"p50\": %u, \"p90\": %u, \"p99\": %u, \"max\": %u}",
+	        count,
+	        getPercentile(values, count, 50),
+	        getPercentile(values, count, 90),
+	        getPercentile(values, count, 99),
+	        getPercentile(values, count, 100));
+}
+
+static void printBenchJson(FILE *out, const struct bench_point *point)
+{
+	fprintf(out,
+	        "    {\"mode\": \"%s\", \"window\": %u, \"rate\": %u, \"payload_len\": %u, \"ind_count\": %u, "
+	        "\"ind_size\": %u, \"requests\": %u, \"completed\": %u, \"lost\": %u, \"late\": %u, \"duration_s\": %.3f, "
+	        "\"tx_frames_per_s\": %.1f, \"rx_frames_per_s\": %.1f, \"tx_bytes_per_s\": %.0f, \"rx_bytes_per_s\": %.0f, "
+	        "\"rtt_first_us\": ",
+	        point->window ? "closed" : "open",
+	        point->window,
+	        point->rate,
+	        point->payloadLen,
+	        point->indCount,
+	        point->indSize,
+	        point->sent,
+	        point->completed,
+	        point->lost,
+	        point->late,
+	        point->seconds,
+	        point->sent / point->seconds,
+	        point->indications / point->seconds,
+	        point->txBytes / point->seconds,
+	        point->rxBytes / point->seconds);
+	printRttJson(out, point->rttFirst, point->firstCount);
+	fprintf(out, ", \"rtt_last_us\": ");
+	printRttJson(out, point->rttLast, point->completed);
+	fprintf(out, "}");
+}
+
+/* Name of the link, eg. "uart-115200". The baud rate is only known when CASCODA_UART lists a single device. */
+static void getLinkName(char *name, size_t len, struct ca821x_dev *pDeviceRef)
+{
+	struct ca821x_exchange_base *base = pDeviceRef->exchange_context;
+	const char                  *uart = getenv("CASCODA_UART");
+
+	switch (base->exchange_type)
+	{
+	case ca821x_exchange_kernel:
+		snprintf(name, len, "kernel");
+		break;
+	case ca821x_exchange_usb:
+		snprintf(name, len, "usb");
+		break;
+	case ca821x_exchange_uart:
+		if (uart && !strchr(uart, ':') && strchr(uart, ','))
+			snprintf(name, len, "uart-%d", atoi(strchr(uart, ',') + 1));
+		else
+			snprintf(name, len, "uart");
+		break;
+	default:
+		snprintf(name, len, "unknown");
+		break;
+	}
+}
+
+/* Parse a comma separated list of values between min and max */
+static int parseList(struct bench_list *list, const char *str, unsigned min, unsigned max)
+{
+	char *end;
+
+	list->count = 0;
+	do
+	{
+		unsigned long value = strtoul(str, &end, 0);
+
+		if (end == str || value < min || value > max || list->count == BENCH_MAX_VALUES)
+			return -1;
+		list->values[list->count++] = value;
+		str                         = end + 1;
+	} while (*end == ',');
+
+	return *end ? -1 : 0;
+}
+
+static void benchUsage(const char *exec_name)
+{
+	fprintf(stderr, "Usage: %s [-s SIZES] [-n COUNTS] [-i SIZES] [-w WINDOWS] [-r RATES] [-c COUNT] ", exec_name);
+	fprintf(stderr, "[-f csv|json] [-o FILE] [-L LINK]\n");
+	fprintf(stderr, "\tBenchmark the link to the Chili module, sweeping over every combination of the lists.\n\n");
+	fprintf(stderr,
+	        "\t-s SIZES    Additional lengths of the requests, 0-%d bytes (default 0,50,100)\n",
+	        BENCH_MAX_PAYLOAD);
+	fprintf(stderr, "\t-n COUNTS   Numbers of indications sent for each request, 1-255 (default 1,8)\n");
+	fprintf(stderr, "\t-i SIZES    Sizes of the indications, 1-%d bytes (default 1,64,128)\n", BENCH_MAX_IND_SIZE);
+	fprintf(stderr, "\t-w WINDOWS  Requests in flight for the closed loop points, 1-255 (default 1,4)\n");
+	fprintf(stderr, "\t-r RATES    Requests per second for the open loop points (default none)\n");
+	fprintf(stderr, "\t-c COUNT    Requests sent for each point (default %d)\n", BENCH_DEFAULT_COUNT);
+	fprintf(stderr, "\t-f FORMAT   Format of the report, csv or json (default json)\n");
+	fprintf(stderr, "\t-o FILE     Write the report to FILE\n");
+	fprintf(stderr, "\t-L LINK     Name of the link in the report, eg. uart-1000000 (default from the exchange)\n");
+	fprintf(stderr, "\t(note: lists are comma separated, eg. -s 0,25,50)\n");
+}
+
+static int runBenchmark(int argc, char *argv[])
+{
+	struct ca821x_dev *pDeviceRef = &(sDeviceRef);
+	struct bench_list  sizes = {{0, 50, 100}, 3}, counts = {{1, 8}, 2}, indSizes = {{1, 64, 128}, 3};
+	struct bench_list  windows = {{1, 4}, 2}, rates = {{0}, 0};
+	double             maxFrames = 0, maxBytes = 0;
+	unsigned long      requests = BENCH_DEFAULT_COUNT;
+	const char        *format = "json", *outPath = NULL, *link = NULL;
+	char               linkName[32];
+	FILE              *out = stdout;
+	int                opt, numPoints = 0, totalPoints;
+	bool               json, first = true;
+	ca_error           status = CA_ERROR_SUCCESS;
+
+	while ((opt = getopt(argc, argv, "s:n:i:w:r:c:f:o:L:h")) != -1)
+	{
+		int rval = 0;
+
+		switch (opt)
+		{
+		case 's':
+			rval = parseList(&sizes, optarg, 0, BENCH_MAX_PAYLOAD);
+			break;
+		case 'n':
+			rval = parseList(&counts, optarg, 1, 255);
+			break;
+		case 'i':
+			rval = parseList(&indSizes, optarg, 1, BENCH_MAX_IND_SIZE);
+			break;
+		case 'w':
+			// -w "" leaves only the open loop points
+			windows.count = 0;
+			if (*optarg)
+				rval = parseList(&windows, optarg, 1, 255);
+			break;
+		case 'r':
+			rval = parseList(&rates, optarg, 1, 1000000);
+			break;
+		case 'c':
+			requests = strtoul(optarg, NULL, 0);
+			break;
+		case 'f':
+			format = optarg;
+			break;
+		case 'o':
+			outPath = optarg;
+			break;
+		case 'L':
+			link = optarg;
+			break;
+		default:
+			benchUsage(argv[0]);
+			return opt == 'h' ? 0 : -1;
+		}
+		if (rval)
+		{
+			fprintf(stderr, "Invalid list for -%c: %s\n", opt, optarg);
+			return -1;
+		}
+	}
+	json = strcmp(format, "json") == 0;
+	if (optind < argc || requests < 1 || requests > 1000000 || (!json && strcmp(format, "csv") != 0) ||
+	    !(windows.count + rates.count))
+	{
+		benchUsage(argv[0]);
+		return -1;
+	}
+
+	initialise_ca821x(pDeviceRef);
+	EVBME_GetCallbackStruct(pDeviceRef)->EVBME_COMM_indication = &handleBenchIndication;
+	if (!link)
+	{
+		getLinkName(linkName, sizeof(linkName), pDeviceRef);
+		link = linkName;
+	}
+
+	if (outPath && (out = fopen(outPath, "w")) == NULL)
+	{
+		perror(outPath);
+		return -1;
+	}
+
+	if (json)
+		fprintf(out, "{\n  \"link\": \"%s\",\n  \"requests_per_point\": %lu,\n  \"points\": [\n", link, requests);
+	else
+		printBenchCsvHeader(out);
+
+	totalPoints = sizes.count * counts.count * indSizes.count * (windows.count + rates.count);
+	for (int s = 0; s < sizes.count && !status; s++)
+	{
+		for (int n = 0; n < counts.count && !status; n++)
+		{
+			for (int i = 0; i < indSizes.count && !status; i++)
+			{
+				for (int l = 0; l < windows.count + rates.count && !status; l++)
+				{
+					struct bench_point point = {0};
+
+					point.payloadLen = sizes.values[s];
+					point.indCount   = counts.values[n];
+					point.indSize    = indSizes.values[i];
+					point.window     = l < windows.count ? windows.values[l] : 0;
+					point.rate       = l < windows.count ? 0 : rates.values[l - windows.count];
+					point.rttFirst   = malloc(sizeof(uint32_t) * requests);
+					point.rttLast    = malloc(sizeof(uint32_t) * requests);
+
+					fprintf(stderr, "\rPoint %d/%d", ++numPoints, totalPoints);
+					status = runBenchPoint(&point, requests, pDeviceRef);
+					if (status)
+						fprintf(stderr, "\nFailed to send a request: %s\n", ca_error_str(status));
+
+					if (json)
+					{
+						fprintf(out, first ? "" : ",\n");
+						printBenchJson(out, &point);
+					}
+					else
+					{
+						printBenchCsv(out, link, &point);
+					}
+					first = false;
+
+					// The sustained rate is the best one that the link delivered without loss
+					if (!point.lost && point.seconds > 0)
+					{
+						maxFrames = fmax(maxFrames, getFrameRate(&point));
+						maxBytes  = fmax(maxBytes, getByteRate(&point));
+					}
+					free(point.rttFirst);
+					free(point.rttLast);
+				}
+			}
+		}
+	}
+	fprintf(stderr, "\n");
+
+	if (json)
+	{
+		fprintf(out,
+		        "\n  ],\n  \"max_sustained\": {\"frames_per_s\": %.1f, \"bytes_per_s\": %.0f}\n}\n",
+		        maxFrames,
+		        maxBytes);
+	}
+	fprintf(stderr,
+	        "Maximum sustained on %s: %.1f frames/s, %.0f bytes/s\n",
+	        link,
+	        maxFrames,
+	        maxBytes);
+
+	if (out != stdout)
+		fclose(out);
+	return status ? -1 : 0;
 }
 
 int main(int argc, char *argv[])
@@ -402,6 +1008,18 @@ int main(int argc, char *argv[])
 	int                             waitForResult = 0;
 	size_t                          additionalLength;
 
+#if defined(_WIN32)
+	if (QueryPerformanceFrequency(&frequency) == 0)
+	{
+		perror("QueryPerformanceFrequency");
+		exit(EXIT_FAILURE);
+	}
+#endif // _WIN32
+
+	// Options select the benchmark, so that the positional arguments keep working
+	if (argc > 1 && argv[1][0] == '-')
+		return runBenchmark(argc, argv);
+
 	if (argc < 2)
 	{
 		printf("Too few arguments for test - entering EVBME mode\n");
@@ -417,14 +1035,6 @@ int main(int argc, char *argv[])
 		exit(EXIT_FAILURE);
 	}
 
-#if defined(_WIN32)
-	if (QueryPerformanceFrequency(&frequency) == 0)
-	{
-		perror("QueryPerformanceFrequency");
-		exit(EXIT_FAILURE);
-	}
-#endif // _WIN32
-
 	numberOfMessagesSent = atoi(argv[1]);
 
 	start = malloc(sizeof(*start) * numberOfMessagesSent);
@@ -3,6 +3,7 @@
 #include <assert.h>
 #include <pthread.h>
 #include <signal.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -48,14 +49,23 @@
 #define ONE_DIRECTION 0
 #define INSERT_SYNC (getRand(0, 0))
 #define INDIRECT 1
+#define INDIRECT_PERCENT 83 //Percentage of the frames to node 0 that are sent indirect
 #define INDIRECTJUNK 0
 #define USELONGADDR (getRand(0, 0))
 #define ACKREQ (getRand(1, 1))
 #define NUMRETRIES 4
 
-#define HISTORY_LENGTH 200
+#define HISTORY_LENGTH 1024
 #define MSDU_HISTORY 100
 
+#define MAX_BENCH_MSDU_LEN 116 //Largest MSDU of a frame with short addresses and no security
+#define DRAIN_SECONDS 3        //Time for the frames in flight to arrive at the end of a benchmark
+#define BENCH_DEFAULT_RATE 150 //Requests per second of each device in a benchmark, unless set with -r
+
+/* Latency histograms, with 16 buckets per power of two microseconds, so within about 6% */
+#define HIST_SUB_BITS 4
+#define HIST_BUCKETS ((32 - HIST_SUB_BITS + 1) << HIST_SUB_BITS)
+
 #define M_MSDU_LENGTH (getRand(MIN_MSDU_LEN, MAX_MSDU_LEN))
 
 static struct SecSpec sSecSpec = {0};
@@ -64,6 +74,29 @@ static struct SecSpec sSecSpec = {0};
 #define STATUS_ACKNOWLEDGED (1 << 1)
 #define STATUS_REPEATED (1 << 2)
 #define STATUS_CONFIRMED (1 << 3)
+#define STATUS_INDIRECT (1 << 4)
+
+struct histogram
+{
+	uint32_t buckets[HIST_BUCKETS];
+	uint64_t count, sum, max; //[us]
+};
+
+enum latency_type
+{
+	LATENCY_CONFIRM_DIRECT,
+	LATENCY_CONFIRM_INDIRECT,
+	LATENCY_INDICATION_DIRECT,
+	LATENCY_INDICATION_INDIRECT,
+	LATENCY_TYPES
+};
+
+static const char *sLatencyNames[LATENCY_TYPES] = {
+    "confirm_direct",
+    "confirm_indirect",
+    "indication_direct",
+    "indication_indirect",
+};
 
 struct inst_priv
 {
@@ -81,26 +114,53 @@ struct inst_priv
 	uint32_t          mExpectedData[HISTORY_LENGTH];
 	uint8_t           mExpectedStatus[HISTORY_LENGTH];
 	struct inst_priv *mExpectedSource[HISTORY_LENGTH];
+	struct timespec   mExpectedTime[HISTORY_LENGTH];
+	uint8_t           mExpectedLength[HISTORY_LENGTH];
 	size_t            mExpectedIndex;
 
 	size_t  idIndex;
 	uint8_t mMsduHandles[MSDU_HISTORY];
 	size_t  prevExpectedId[MSDU_HISTORY];
 
-	uint8_t msdu[MAX_MSDU_LEN];
+	//Time of the data requests, by MSDU handle, and whether they were indirect
+	struct timespec mRequestTime[256];
+	uint8_t         mRequestIndirect[256];
+
+	uint8_t msdu[MAX_BENCH_MSDU_LEN];
 
 	unsigned int mTx, mSourced, mRx, mAckRemote, mErr, mRestarts, mBadRx, mBadTx, mCAF, mNack, mRepeats, mMissed,
 	    mUnexpected, mMissedAcked, mAckLost, mTO, mBackoff, mConfirmLost, mConfirmDup;
+
+	//Benchmark counters: data requests sent, and the ones that arrived (once) with their MSDU bytes
+	unsigned int mRequested, mDelivered;
+	uint64_t     mDeliveredBytes;
 };
 
 int              numInsts;
 struct inst_priv insts[MAX_INSTANCES] = {};
 
+/* Traffic, set from the command line */
+static long sTxPeriodNs      = 0; //0 for TX_PERIOD
+static int  sMsduLength      = 0; //0 for M_MSDU_LENGTH
+static int  sIndirectPercent = INDIRECT ? INDIRECT_PERCENT : 0;
+
+/* Benchmark mode */
+static int              sBenchSeconds = 0; //0 to draw the live table instead
+static const char      *sJsonPath     = NULL;
+static volatile bool    sDraining     = false;
+static struct histogram sLatency[LATENCY_TYPES];
+
 pthread_mutex_t out_mutex  = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t rand_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 void initInst(struct inst_priv *cur);
 
+/* Stream for the progress messages, which must not be mixed with the JSON summary of a benchmark on stdout */
+static FILE *statusOut(void)
+{
+	return sBenchSeconds ? stderr : stdout;
+}
+
 static int getRand(int min, int max)
 {
 	int rval;
@@ -112,6 +172,77 @@ static int getRand(int min, int max)
 	return rval;
 }
 
+static struct timespec getTxPeriod(void)
+{
+	if (sTxPeriodNs)
+		return (struct timespec){sTxPeriodNs / 1000000000L, sTxPeriodNs % 1000000000L};
+	return TX_PERIOD;
+}
+
+static uint8_t getMsduLength(void)
+{
+	if (sMsduLength)
+		return sMsduLength;
+	return M_MSDU_LENGTH;
+}
+
+static uint32_t elapsedUs(const struct timespec *start, const struct timespec *end)
+{
+	int64_t us = (int64_t)(end->tv_sec - start->tv_sec) * 1000000 + (end->tv_nsec - start->tv_nsec) / 1000;
+
+	if (us < 0)
+		return 0;
+	return us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+}
+
+static unsigned histIndex(uint32_t us)
+{
+	int exp;
+
+	if (us < (1 << HIST_SUB_BITS))
+		return us;
+	exp = 31 - __builtin_clz(us);
+	return ((exp - HIST_SUB_BITS + 1) << HIST_SUB_BITS) + ((us >> (exp - HIST_SUB_BITS)) & ((1 << HIST_SUB_BITS) - 1));
+}
+
+/* Largest value that falls in a bucket */
+static uint64_t histBucketMax(unsigned index)
+{
+	unsigned exp, mantissa;
+
+	if (index < (1 << HIST_SUB_BITS))
+		return index;
+	exp      = (index >> HIST_SUB_BITS) + HIST_SUB_BITS - 1;
+	mantissa = index & ((1 << HIST_SUB_BITS) - 1);
+	return ((uint64_t)((1 << HIST_SUB_BITS) + mantissa + 1) << (exp - HIST_SUB_BITS)) - 1;
+}
+
+//Must be called with out_mutex held
+static void histAdd(struct histogram *hist, uint32_t us)
+{
+	hist->buckets[histIndex(us)]++;
+	hist->count++;
+	hist->sum += us;
+	if (us > hist->max)
+		hist->max = us;
+}
+
+static uint64_t histPercentile(const struct histogram *hist, unsigned percent)
+{
+	uint64_t target = (hist->count * percent + 99) / 100;
+	uint64_t total  = 0;
+
+	if (!hist->count)
+		return 0;
+	for (unsigned i = 0; i < HIST_BUCKETS; i++)
+	{
+		total += hist->buckets[i];
+		if (total >= target)
+			return histBucketMax(i) < hist->max ? histBucketMax(i) : hist->max;
+	}
+	return hist->max;
+}
+
 static struct inst_priv *getInstFromAddr(uint16_t shaddr)
 {
 	for (int i = 0; i < numInsts; i++)
@@ -148,6 +279,7 @@ static size_t addExpected(struct inst_priv *target, struct inst_priv *source, ui
 	target->mExpectedStatus[*index] = 0;
 	target->mExpectedData[*index]   = payload;
 	target->mExpectedSource[*index] = source;
+	target->mExpectedLength[*index] = 0;
 
 	return *index;
 }
@@ -167,7 +299,7 @@ static uint8_t processConfirmed(struct inst_priv *target, size_t id)
 	return 1;
 }
 
-static void processReceived(struct inst_priv *target, uint32_t payload)
+static void processReceived(struct inst_priv *target, uint32_t payload, const struct timespec *now)
 {
 	for (size_t i = 0; i < HISTORY_LENGTH; i++)
 	{
@@ -177,6 +309,15 @@ static void processReceived(struct inst_priv *target, uint32_t payload)
 			{
 				target->mRepeats++;
 			}
+			else if (target->mExpectedLength[i] && target->mExpectedSource[i] != NULL)
+			{
+				bool indirect = target->mExpectedStatus[i] & STATUS_INDIRECT;
+
+				histAdd(&sLatency[indirect ? LATENCY_INDICATION_INDIRECT : LATENCY_INDICATION_DIRECT],
+				        elapsedUs(&target->mExpectedTime[i], now));
+				target->mExpectedSource[i]->mDelivered++;
+				target->mExpectedSource[i]->mDeliveredBytes += target->mExpectedLength[i];
+			}
 			target->mExpectedStatus[i] |= STATUS_RECEIVED;
 			return;
 		}
@@ -202,12 +343,12 @@ static ca_error driverErrorCallback(ca_error error, struct ca821x_dev *pDeviceRe
 	pthread_mutex_t  *confirm_mutex = &(priv->confirm_mutex);
 	pthread_cond_t   *confirm_cond  = &(priv->confirm_cond);
 
-	printf(COLOR_SET(RED, "DRIVER FAILED FOR %x WITH ERROR %d") "\n\r", priv->mAddress, (int)error);
-	printf(COLOR_SET(BLUE, "Attempting restart...") "\n\r");
+	fprintf(statusOut(), COLOR_SET(RED, "DRIVER FAILED FOR %x WITH ERROR %d") "\n\r", priv->mAddress, (int)error);
+	fprintf(statusOut(), COLOR_SET(BLUE, "Attempting restart...") "\n\r");
 
 	initInst(priv);
 
-	printf(COLOR_SET(GREEN, "Restart successful!") "\n\r");
+	fprintf(statusOut(), COLOR_SET(GREEN, "Restart successful!") "\n\r");
 
 	pthread_mutex_lock(&out_mutex);
 	priv->mRestarts++;
@@ -230,18 +371,21 @@ static ca_error handleEvbmeMessage(struct EVBME_Message *params, struct ca821x_d
 static ca_error handleDataIndication(struct MCPS_DATA_indication_pset *params, struct ca821x_dev *pDeviceRef) //Async
 {
 	struct inst_priv *other, *priv = pDeviceRef->context;
+	struct timespec   now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
 	pthread_mutex_lock(&out_mutex);
 	priv->mRx++;
 
 #if CASCODA_CA_VER >= 8212
 	// MSDU located after Header IEs and Payload IEs.
 	uint8_t msdu_shift = params->HeaderIELength + params->PayloadIELength;
-	processReceived(priv, GETLE32(params->Data + msdu_shift));
+	processReceived(priv, GETLE32(params->Data + msdu_shift), &now);
 
 	if (params->Data[params->MsduLength + msdu_shift] != 0)
 		fprintf(stderr, "Unexpected security level!");
 #else
-	processReceived(priv, GETLE32(params->Msdu));
+	processReceived(priv, GETLE32(params->Msdu), &now);
 
 	if (params->Msdu[params->MsduLength] != 0)
 		fprintf(stderr, "Unexpected security level!");
@@ -309,6 +453,9 @@ static ca_error handleDataConfirm(struct MCPS_DATA_confirm_pset *params, struct
 	pthread_mutex_t  *confirm_mutex = &(priv->confirm_mutex);
 	pthread_cond_t   *confirm_cond  = &(priv->confirm_cond);
 	uint16_t          dstAddr;
+	struct timespec   now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
 
 	//Catch expiring junk
 	if (params->MsduHandle < INDIRECTJUNK)
@@ -317,6 +464,17 @@ static ca_error handleDataConfirm(struct MCPS_DATA_confirm_pset *params, struct
 		return CA_ERROR_SUCCESS;
 	}
 
+	pthread_mutex_lock(&out_mutex);
+	if (priv->mRequestTime[params->MsduHandle].tv_sec || priv->mRequestTime[params->MsduHandle].tv_nsec)
+	{
+		if (params->Status == MAC_SUCCESS)
+			histAdd(&sLatency[priv->mRequestIndirect[params->MsduHandle] ? LATENCY_CONFIRM_INDIRECT
+			                                                              : LATENCY_CONFIRM_DIRECT],
+			        elapsedUs(&priv->mRequestTime[params->MsduHandle], &now));
+		priv->mRequestTime[params->MsduHandle] = (struct timespec){0, 0};
+	}
+	pthread_mutex_unlock(&out_mutex);
+
 	pthread_mutex_lock(confirm_mutex);
 	dstAddr = priv->lastAddress;
 	pthread_mutex_unlock(confirm_mutex);
@@ -369,7 +527,7 @@ static ca_error handleDataConfirm(struct MCPS_DATA_confirm_pset *params, struct
 		pthread_mutex_unlock(&out_mutex);
 		break;
 	case MAC_SYSTEM_ERROR:
-		printf("SystemError");
+		fprintf(statusOut(), "SystemError");
 		//Fall through
 	default:
 		pthread_mutex_lock(&out_mutex);
@@ -428,6 +586,7 @@ static void *inst_worker(void *arg)
 	struct inst_priv  *priv       = arg;
 	struct ca821x_dev *pDeviceRef = &(priv->pDeviceRef);
 	uint32_t           payload;
+	size_t             expectedId;
 
 	pthread_mutex_t *confirm_mutex = &(priv->confirm_mutex);
 	pthread_cond_t  *confirm_cond  = &(priv->confirm_cond);
@@ -444,7 +603,7 @@ static void *inst_worker(void *arg)
 		if (ACKREQ)
 			txOpts |= 0x01;
 
-		if (INDIRECT && !i && getRand(0, 5))
+		if (sIndirectPercent && !i && getRand(1, 100) <= sIndirectPercent)
 			txOpts |= 0x04;
 
 		if (USELONGADDR)
@@ -471,7 +630,8 @@ static void *inst_worker(void *arg)
 
 		pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
 
-		nanosleep(&TX_PERIOD, NULL);
+		struct timespec period = getTxPeriod();
+		nanosleep(&period, NULL);
 
 		if (INSERT_SYNC)
 		{
@@ -487,7 +647,7 @@ static void *inst_worker(void *arg)
 				continue;
 		}
 
-		if (INDIRECT && i)
+		if (sIndirectPercent && i)
 		{
 			struct FullAddr fa = {0};
 			PUTLE16(M_PANID, fa.PANId);
@@ -505,9 +665,14 @@ static void *inst_worker(void *arg)
 			continue;
 		}
 
+		//At the end of a benchmark, only the polls carry on, to collect the indirect frames
+		if (sDraining)
+			continue;
+
 		pthread_mutex_lock(&out_mutex);
 		priv->mMsduHandles[priv->idIndex]   = priv->lastHandle;
-		priv->prevExpectedId[priv->idIndex] = addExpected(&(insts[i]), priv, payload);
+		expectedId                          = addExpected(&(insts[i]), priv, payload);
+		priv->prevExpectedId[priv->idIndex] = expectedId;
 		priv->idIndex                       = (priv->idIndex + 1) % MSDU_HISTORY;
 		if (priv->mBackoff)
 		{
@@ -530,6 +695,18 @@ static void *inst_worker(void *arg)
 		pthread_mutex_unlock(confirm_mutex);
 		PUTLE32(payload, priv->msdu);
 
+		uint8_t msduLength = getMsduLength();
+
+		pthread_mutex_lock(&out_mutex);
+		clock_gettime(CLOCK_MONOTONIC, &priv->mRequestTime[priv->lastHandle]);
+		priv->mRequestIndirect[priv->lastHandle] = (txOpts & 0x04) != 0;
+		priv->mRequested++;
+		insts[i].mExpectedTime[expectedId]   = priv->mRequestTime[priv->lastHandle];
+		insts[i].mExpectedLength[expectedId] = msduLength;
+		if (txOpts & 0x04)
+			insts[i].mExpectedStatus[expectedId] |= STATUS_INDIRECT;
+		pthread_mutex_unlock(&out_mutex);
+
 #if CASCODA_CA_VER >= 8212
 		uint8_t tx_op[2] = {0x00, 0x00};
 		tx_op[0]         = txOpts;
@@ -537,7 +714,7 @@ static void *inst_worker(void *arg)
 		                  dest,             /* DstAddr */
 		                  0,                /* HeaderIELength */
 		                  0,                /* PayloadIELength */
-		                  M_MSDU_LENGTH,    /* MsduLength */
+		                  msduLength,       /* MsduLength */
 		                  priv->msdu,       /* pMsdu */
 		                  priv->lastHandle, /* MsduHandle */
 		                  tx_op,            /* pTxOptions */
@@ -549,8 +726,7 @@ static void *inst_worker(void *arg)
 		                  &sSecSpec,        /* pSecurity */
 		                  pDeviceRef);      /* pDeviceRef */
 #else
-		MCPS_DATA_request(
-		    curAddrMode, dest, M_MSDU_LENGTH, priv->msdu, priv->lastHandle, txOpts, &sSecSpec, pDeviceRef);
+		MCPS_DATA_request(curAddrMode, dest, msduLength, priv->msdu, priv->lastHandle, txOpts, &sSecSpec, pDeviceRef);
 #endif // CASCODA_CA_VER >= 8212
 
 		fillIndirectJunk(priv);
@@ -643,6 +819,119 @@ void drawTableRow(unsigned int time)
 	printf("\n");
 }
 
+static void printLatencyJson(FILE *out, const struct histogram *hist)
+{
+	fprintf(out,
+	        "{\"count\": %llu, \"mean\": %llu, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu}",
+	        (unsigned long long)hist->count,
+	        (unsigned long long)(hist->count ? hist->sum / hist->count : 0),
+	        (unsigned long long)histPercentile(hist, 50),
+	        (unsigned long long)histPercentile(hist, 90),
+	        (unsigned long long)histPercentile(hist, 99),
+	        (unsigned long long)hist->max);
+}
+
+static double getLoss(unsigned int requested, unsigned int delivered)
+{
+	if (!requested)
+		return 0;
+	return 1.0 - (double)delivered / requested;
+}
+
+/* Summary of a benchmark. The goodput counts the MSDU bytes that arrived once, over the time data was sent. */
+static void printBenchJson(FILE *out, double seconds)
+{
+	unsigned int requested = 0, delivered = 0;
+	uint64_t     deliveredBytes = 0;
+
+	pthread_mutex_lock(&out_mutex);
+	fprintf(out, "{\n");
+	fprintf(out,
+	        "  \"config\": {\"nodes\": %d, \"duration_s\": %d, \"tx_period_us\": %ld, \"msdu_length\": %d, "
+	        "\"indirect_percent\": %d},\n",
+	        numInsts,
+	        sBenchSeconds,
+	        sTxPeriodNs / 1000,
+	        sMsduLength,
+	        sIndirectPercent);
+
+	fprintf(out, "  \"nodes\": [\n");
+	for (int i = 0; i < numInsts; i++)
+	{
+		struct inst_priv *inst = &insts[i];
+
+		fprintf(out,
+		        "    {\"address\": %u, \"requested\": %u, \"delivered\": %u, \"goodput_bps\": %.0f, \"loss\": %.4f, "
+		        "\"received\": %u, \"repeats\": %u, \"unexpected\": %u, \"errors\": %u, "
+		        "\"channel_access_failures\": %u, \"no_acks\": %u, \"transaction_overflows\": %u, "
+		        "\"confirms_lost\": %u, \"restarts\": %u}%s\n",
+		        inst->mAddress,
+		        inst->mRequested,
+		        inst->mDelivered,
+		        inst->mDeliveredBytes * 8 / seconds,
+		        getLoss(inst->mRequested, inst->mDelivered),
+		        inst->mRx,
+		        inst->mRepeats,
+		        inst->mUnexpected,
+		        inst->mErr,
+		        inst->mCAF,
+		        inst->mNack,
+		        inst->mTO,
+		        inst->mConfirmLost,
+		        inst->mRestarts,
+		        (i + 1 < numInsts) ? "," : "");
+		requested += inst->mRequested;
+		delivered += inst->mDelivered;
+		deliveredBytes += inst->mDeliveredBytes;
+	}
+	fprintf(out, "  ],\n");
+
+	fprintf(out,
+	        "  \"total\": {\"requested\": %u, \"delivered\": %u, \"goodput_bps\": %.0f, \"loss\": %.4f},\n",
+	        requested,
+	        delivered,
+	        deliveredBytes * 8 / seconds,
+	        getLoss(requested, delivered));
+
+	fprintf(out, "  \"latency_us\": {\n");
+	for (int type = 0; type < LATENCY_TYPES; type++)
+	{
+		fprintf(out, "    \"%s\": ", sLatencyNames[type]);
+		printLatencyJson(out, &sLatency[type]);
+		fprintf(out, "%s\n", (type + 1 < LATENCY_TYPES) ? "," : "");
+	}
+	fprintf(out, "  }\n}\n");
+	pthread_mutex_unlock(&out_mutex);
+}
+
+static void runBenchmark(void)
+{
+	struct timespec start, end;
+	FILE           *out = stdout;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int time = 0; time < sBenchSeconds; time++)
+	{
+		sleep(1);
+		fprintf(stderr, "\rBenchmark: %d/%d s", time + 1, sBenchSeconds);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	//Stop sending data, and give the frames in flight and the indirect frames time to arrive
+	sDraining = true;
+	fprintf(stderr, "\nWaiting %d s for the frames in flight...\n", DRAIN_SECONDS);
+	sleep(DRAIN_SECONDS);
+
+	if (sJsonPath && (out = fopen(sJsonPath, "w")) == NULL)
+	{
+		perror(sJsonPath);
+		out = stdout;
+	}
+	printBenchJson(out, elapsedUs(&start, &end) / 1e6);
+	if (out != stdout)
+		fclose(out);
+}
+
 void initInst(struct inst_priv *cur)
 {
 	struct ca821x_dev *pDeviceRef = &(cur->pDeviceRef);
@@ -696,18 +985,73 @@ void initInst(struct inst_priv *cur)
 	    pDeviceRef);
 }
 
+static void usage(const char *exec_name)
+{
+	fprintf(stderr,
+	        "Usage: %s [-b SECONDS [-o FILE]] [-r RATE] [-l LENGTH] [-i PERCENT] ADDRESS ADDRESS...\n",
+	        exec_name);
+	fprintf(stderr, "\tGenerate IEEE 802.15.4 traffic between devices, which use the ADDRESSes as short addresses.\n\n");
+	fprintf(stderr, "\t-b SECONDS  Benchmark for SECONDS, then print a JSON summary instead of the live table\n");
+	fprintf(stderr, "\t-o FILE     Write the JSON summary to FILE\n");
+	fprintf(stderr,
+	        "\t-r RATE     Requests sent by each device per second, data or polls (default about %d)\n",
+	        BENCH_DEFAULT_RATE);
+	fprintf(stderr, "\t-l LENGTH   MSDU length, 4-%d bytes (default %d)\n", MAX_BENCH_MSDU_LEN, MAX_MSDU_LEN);
+	fprintf(stderr, "\t-i PERCENT  Percentage of the frames to the first device that are sent indirect (default %d)\n",
+	        sIndirectPercent);
+	fprintf(stderr, "\t            The other devices poll each other instead of exchanging data, unless PERCENT is 0\n");
+}
+
 int main(int argc, char *argv[])
 {
-	if (argc <= 2)
+	int opt;
+
+	while ((opt = getopt(argc, argv, "b:o:r:l:i:h")) != -1)
+	{
+		switch (opt)
+		{
+		case 'b':
+			sBenchSeconds = atoi(optarg);
+			break;
+		case 'o':
+			sJsonPath = optarg;
+			break;
+		case 'r':
+			sTxPeriodNs = atoi(optarg) > 0 ? 1000000000L / atoi(optarg) : -1;
+			break;
+		case 'l':
+			sMsduLength = atoi(optarg);
+			break;
+		case 'i':
+			sIndirectPercent = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : -1;
+		}
+	}
+	if (argc - optind < 2 || sBenchSeconds < 0 || sTxPeriodNs < 0 || sMsduLength < 0 ||
+	    (sMsduLength && (sMsduLength < 4 || sMsduLength > MAX_BENCH_MSDU_LEN)) || sIndirectPercent < 0 ||
+	    sIndirectPercent > 100)
+	{
+		usage(argv[0]);
 		return -1;
-	numInsts = argc - 1;
+	}
+	argv += optind - 1;
+	numInsts = argc - optind;
+
+	//A benchmark offers a fixed load, so that its results can be compared
+	if (sBenchSeconds && !sTxPeriodNs)
+		sTxPeriodNs = 1000000000L / BENCH_DEFAULT_RATE;
+	if (sBenchSeconds && !sMsduLength)
+		sMsduLength = MAX_MSDU_LEN;
 
 	time_t t;
 	srand((unsigned)time(&t));
 
 	if (numInsts > MAX_INSTANCES)
 	{
-		printf("Please increase MAX_INSTANCES in main.c");
+		fprintf(statusOut(), "Please increase MAX_INSTANCES in main.c");
 		return -1;
 	}
 
@@ -743,7 +1087,7 @@ int main(int argc, char *argv[])
 		ca821x_util_start_upstream_dispatch_worker();
 
 		initInst(cur);
-		printf("Initialised. %d\r\n", i);
+		fprintf(statusOut(), "Initialised. %d\r\n", i);
 	}
 
 	for (int i = 0; i < numInsts; i++)
@@ -753,6 +1097,12 @@ int main(int argc, char *argv[])
 
 	signal(SIGINT, quit);
 
+	if (sBenchSeconds)
+	{
+		runBenchmark();
+		quit(0);
+	}
+
 	//Draw the table onscreen every second
 	unsigned int time = 0;
 	while (1)
@@ -84,6 +84,11 @@ int main(int argc, char *argv[])
 	 *     posixPlatformGetTimeout(aInstance, &timeout);
 	 *     posixPlatformSleep(aInstance, &timeout); //Must run very soon after posixPlatformProcessGetTimeout
 	 * }
+	 *
+	 * Application file descriptors (sockets, timerfds...) can be added to the loop with posixPlatformRegisterFd, so
+	 * that posixPlatformSleep wakes up and calls their callback as soon as they are ready:
+	 *
+	 * posixPlatformRegisterFd(sockFd, POLLIN, &handleSocket, NULL);
 	 */
 
 	return 0;
@@ -30,10 +30,16 @@
 #define _DEFAULT_SOURCE 1
 #define _POSIX_SOURCE 1
 
+#include <poll.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/timerfd.h>
+#endif
 
 #include "ca821x-posix-thread/posix-platform.h"
 #include "openthread/platform/alarm-milli.h"
@@ -41,10 +47,104 @@
 static bool            s_is_running = false;
 static uint32_t        s_alarm      = 0;
 static struct timespec s_start;
+#ifdef __linux__
+static int s_timer_fd = -1;
+#endif
+
+//Milliseconds elapsed between s_start and aNow, without wrapping
+static uint64_t alarm_elapsed_ms(const struct timespec *aNow)
+{
+	struct timespec tv;
+
+	tv.tv_sec  = aNow->tv_sec - s_start.tv_sec;
+	tv.tv_nsec = aNow->tv_nsec - s_start.tv_nsec;
+
+	if (tv.tv_nsec < 0)
+	{
+		--tv.tv_sec;
+		tv.tv_nsec += 1000000000;
+	}
+
+	return ((uint64_t)tv.tv_sec * 1000) + (tv.tv_nsec / 1000000);
+}
+
+static bool alarm_has_timer(void)
+{
+#ifdef __linux__
+	return s_timer_fd >= 0;
+#else
+	return false;
+#endif
+}
+
+#ifdef __linux__
+static void alarm_timer_callback(int aFd, short aEvents, void *aContext)
+{
+	uint64_t expirations;
+
+	(void)aEvents;
+	(void)aContext;
+
+	//Only clears the readiness, the alarm fires from posixPlatformAlarmProcess
+	read(aFd, &expirations, sizeof(expirations));
+}
+#endif
+
+//Arms the timerfd at the exact time otPlatAlarmMilliGetNow reaches s_alarm, or disarms it
+static void alarm_timer_update(void)
+{
+#ifdef __linux__
+	struct itimerspec spec = {0};
+	struct timespec   now;
+	uint64_t          elapsed;
+	int32_t           remaining;
+
+	if (s_timer_fd < 0)
+		return;
+
+	if (s_is_running)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		elapsed   = alarm_elapsed_ms(&now);
+		remaining = (int32_t)(s_alarm - (uint32_t)elapsed);
+
+		if (remaining < 0)
+			remaining = 0;
+		elapsed += (uint32_t)remaining;
+
+		spec.it_value.tv_sec  = s_start.tv_sec + (time_t)(elapsed / 1000);
+		spec.it_value.tv_nsec = s_start.tv_nsec + (long)(elapsed % 1000) * 1000000;
+		if (spec.it_value.tv_nsec >= 1000000000)
+		{
+			++spec.it_value.tv_sec;
+			spec.it_value.tv_nsec -= 1000000000;
+		}
+	}
+
+	timerfd_settime(s_timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+#endif
+}
 
 void posixPlatformAlarmInit(void)
 {
 	clock_gettime(CLOCK_MONOTONIC, &s_start);
+
+#ifdef __linux__
+	if (s_timer_fd >= 0)
+		return;
+
+	s_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (s_timer_fd < 0)
+	{
+		perror("timerfd_create");
+	}
+	else if (posixPlatformRegisterFd(s_timer_fd, POLLIN, &alarm_timer_callback, NULL) < 0)
+	{
+		perror("timerfd");
+		close(s_timer_fd);
+		s_timer_fd = -1;
+	}
+#endif
 }
 
 uint32_t otPlatAlarmMilliGetNow(void)
@@ -53,16 +153,7 @@ uint32_t otPlatAlarmMilliGetNow(void)
 
 	clock_gettime(CLOCK_MONOTONIC, &tv);
 
-	tv.tv_sec  = tv.tv_sec - s_start.tv_sec;
-	tv.tv_nsec = tv.tv_nsec - s_start.tv_nsec;
-
-	if (tv.tv_nsec < 0)
-	{
-		--tv.tv_sec;
-		tv.tv_nsec += 1000000000;
-	}
-
-	return (uint32_t)((tv.tv_sec * 1000) + (tv.tv_nsec / 1000000));
+	return (uint32_t)alarm_elapsed_ms(&tv);
 }
 
 void otPlatAlarmMilliStartAt(otInstance *aInstance, uint32_t t0, uint32_t dt)
@@ -70,12 +161,14 @@ void otPlatAlarmMilliStartAt(otInstance *aInstance, uint32_t t0, uint32_t dt)
 	(void)aInstance;
 	s_alarm      = t0 + dt;
 	s_is_running = true;
+	alarm_timer_update();
 }
 
 void otPlatAlarmMilliStop(otInstance *aInstance)
 {
 	(void)aInstance;
 	s_is_running = false;
+	alarm_timer_update();
 }
 
 void posixPlatformAlarmUpdateTimeout(struct timeval *aTimeout)
@@ -87,7 +180,7 @@ void posixPlatformAlarmUpdateTimeout(struct timeval *aTimeout)
 		return;
 	}
 
-	if (s_is_running)
+	if (s_is_running && !alarm_has_timer())
 	{
 		remaining = (int32_t)(s_alarm - otPlatAlarmMilliGetNow());
 
@@ -35,6 +35,7 @@
 #ifndef POSIX_PLATFORM_H_
 #define POSIX_PLATFORM_H_
 
+#include <poll.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -60,6 +61,25 @@ extern uint32_t NODE_ID;
  */
 extern uint32_t WELLKNOWN_NODE_ID;
 
+/**
+ * Maximum number of file descriptors that can be registered with posixPlatformRegisterFd, including the ones used by
+ * the platform itself.
+ */
+#ifndef POSIX_PLATFORM_MAX_FDS
+#define POSIX_PLATFORM_MAX_FDS 16
+#endif
+
+/**
+ * Callback for a file descriptor registered with posixPlatformRegisterFd. Called from posixPlatformSleep, on the
+ * thread running the OpenThread stack.
+ *
+ * @param[in]  aFd       The file descriptor.
+ * @param[in]  aEvents   The events that occurred, as the revents of poll() (POLLIN, POLLOUT, POLLERR, POLLHUP).
+ * @param[in]  aContext  The context given to posixPlatformRegisterFd.
+ *
+ */
+typedef void (*posixPlatformFdCallback)(int aFd, short aEvents, void *aContext);
+
 /**
  * This method performs all platform-specific initialization.
  *
@@ -93,6 +113,7 @@ void posixPlatformProcessDriversQuick(otInstance *aInstance);
 
 /**
  * This method gets the timeout for the sleep function, and places it in the timeout struct.
+ * The file descriptors registered with posixPlatformRegisterFd wake up the sleep function before the timeout.
  */
 void posixPlatformGetTimeout(otInstance *aInstance, struct timeval *timeout);
 
@@ -102,6 +123,48 @@ void posixPlatformGetTimeout(otInstance *aInstance, struct timeval *timeout);
  */
 void posixPlatformSleep(otInstance *aInstance, struct timeval *timeout);
 
+/**
+ * This method adds a file descriptor to the platform loop, so that posixPlatformSleep wakes up and calls the callback
+ * when it becomes ready. The registration persists until posixPlatformUnregisterFd is called, which must happen
+ * before the file descriptor is closed. On Linux, the loop is based on epoll and the events are level-triggered.
+ *
+ * This method must be called from the thread running the OpenThread stack.
+ *
+ * @param[in]  aFd        The file descriptor, which should be non-blocking.
+ * @param[in]  aEvents    The events to wait for, as the events of poll() (POLLIN, POLLOUT). Can be 0.
+ * @param[in]  aCallback  The callback to call when an event occurs, or NULL to only wake up the loop.
+ * @param[in]  aContext   Context passed to the callback.
+ *
+ * @retval 0   The file descriptor has been registered.
+ * @retval -1  Failure, errno is EEXIST if already registered, or ENOMEM if POSIX_PLATFORM_MAX_FDS are registered.
+ *
+ */
+int posixPlatformRegisterFd(int aFd, short aEvents, posixPlatformFdCallback aCallback, void *aContext);
+
+/**
+ * This method changes the events waited for on a registered file descriptor, eg. to only wait for POLLOUT while
+ * there is data to write.
+ *
+ * @param[in]  aFd      The registered file descriptor.
+ * @param[in]  aEvents  The events to wait for, as the events of poll(). Can be 0.
+ *
+ * @retval 0   The events have been changed.
+ * @retval -1  Failure, errno is ENOENT if the file descriptor is not registered.
+ *
+ */
+int posixPlatformModifyFd(int aFd, short aEvents);
+
+/**
+ * This method removes a file descriptor from the platform loop.
+ *
+ * @param[in]  aFd  The registered file descriptor.
+ *
+ * @retval 0   The file descriptor has been unregistered, its callback will not be called anymore.
+ * @retval -1  Failure, errno is ENOENT if the file descriptor is not registered.
+ *
+ */
+int posixPlatformUnregisterFd(int aFd);
+
 /**
  * This method initializes the alarm service used by OpenThread.
  *
@@ -109,7 +172,8 @@ void posixPlatformSleep(otInstance *aInstance, struct timeval *timeout);
 void posixPlatformAlarmInit(void);
 
 /**
- * This method retrieves the time remaining until the alarm fires.
+ * This method retrieves the time remaining until the alarm fires. On Linux, the alarm is tracked by a timerfd which
+ * wakes up posixPlatformSleep itself, so the idle timeout of 10 seconds is always returned.
  *
  * @param[out]  tv  A pointer to the timeval struct.
  *
@@ -160,16 +224,6 @@ void posixPlatformRestoreTerminal(void);
  */
 void posixPlatformRandomInit(void);
 
-/**
- * This method updates the file descriptor sets with file descriptors used by the serial driver.
- *
- * @param[inout]  aReadFdSet   A pointer to the read file descriptors.
- * @param[inout]  aWriteFdSet  A pointer to the write file descriptors.
- * @param[inout]  aMaxFd       A pointer to the max file descriptor.
- *
- */
-void platformUartUpdateFdSet(fd_set *aReadFdSet, fd_set *aWriteFdSet, int *aMaxFd);
-
 /**
  * This method performs radio driver processing.
  *
@@ -35,20 +35,39 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
 #include "ca821x-posix-thread/posix-platform.h"
 #include "openthread/platform/alarm-milli.h"
 #include "openthread/tasklet.h"
 #include "selfpipe.h"
 
-static fd_set read_fds;
-static fd_set write_fds;
-static int    max_fd = -1;
+/** A file descriptor registered with posixPlatformRegisterFd */
+struct platform_fd
+{
+	int                     fd;          //!< File descriptor, -1 if the entry is free
+	short                   events;      //!< Events of interest, as for poll()
+	bool                    alwaysReady; //!< File that epoll cannot wait on, such as a regular file
+	posixPlatformFdCallback callback;    //!< Called when an event occurs, can be NULL
+	void                   *context;     //!< Passed to the callback
+};
+
+static struct platform_fd s_fds[POSIX_PLATFORM_MAX_FDS];
+static bool               s_fds_initialised = false;
+#ifdef __linux__
+static int s_epoll_fd = -1;
+#endif
 
 int    gArgumentsCount = 0;
 char **gArguments      = NULL;
@@ -56,6 +75,233 @@ char **gArguments      = NULL;
 // Used to distinguish between different instances of Thread when booting from persistent storage
 uint32_t NODE_ID = 1;
 
+static void fds_init(void)
+{
+	if (s_fds_initialised)
+		return;
+
+	for (int i = 0; i < POSIX_PLATFORM_MAX_FDS; i++) s_fds[i].fd = -1;
+
+#ifdef __linux__
+	s_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (s_epoll_fd < 0)
+		perror("epoll_create1");
+#endif
+	s_fds_initialised = true;
+}
+
+static struct platform_fd *fds_find(int aFd)
+{
+	for (int i = 0; i < POSIX_PLATFORM_MAX_FDS; i++)
+	{
+		if (s_fds[i].fd == aFd)
+			return &s_fds[i];
+	}
+	return NULL;
+}
+
+#ifdef __linux__
+static uint32_t events_to_epoll(short aEvents)
+{
+	uint32_t events = 0;
+
+	if (aEvents & POLLIN)
+		events |= EPOLLIN;
+	if (aEvents & POLLPRI)
+		events |= EPOLLPRI;
+	if (aEvents & POLLOUT)
+		events |= EPOLLOUT;
+	return events;
+}
+
+static short events_from_epoll(uint32_t aEvents)
+{
+	short events = 0;
+
+	if (aEvents & EPOLLIN)
+		events |= POLLIN;
+	if (aEvents & EPOLLPRI)
+		events |= POLLPRI;
+	if (aEvents & EPOLLOUT)
+		events |= POLLOUT;
+	if (aEvents & EPOLLERR)
+		events |= POLLERR;
+	if (aEvents & EPOLLHUP)
+		events |= POLLHUP;
+	return events;
+}
+#endif
+
+static void fds_dispatch(struct platform_fd *aEntry, int aFd, short aEvents)
+{
+	// The entry may have been unregistered by an earlier callback of the same wait
+	if (aEntry->fd != aFd || !aEntry->callback || !aEvents)
+		return;
+
+	aEntry->callback(aFd, aEvents, aEntry->context);
+}
+
+static void fds_wait(int aTimeoutMs)
+{
+	struct platform_fd *entries[POSIX_PLATFORM_MAX_FDS];
+	int                 fds[POSIX_PLATFORM_MAX_FDS];
+	short               revents[POSIX_PLATFORM_MAX_FDS];
+	int                 nready = 0;
+	int                 rval;
+
+	fds_init();
+
+	for (int i = 0; i < POSIX_PLATFORM_MAX_FDS; i++)
+	{
+		if (s_fds[i].alwaysReady && s_fds[i].events)
+			aTimeoutMs = 0;
+	}
+
+#ifdef __linux__
+	struct epoll_event events[POSIX_PLATFORM_MAX_FDS];
+
+	rval = epoll_wait(s_epoll_fd, events, POSIX_PLATFORM_MAX_FDS, aTimeoutMs);
+	for (int i = 0; i < rval; i++)
+	{
+		entries[nready] = events[i].data.ptr;
+		fds[nready]     = entries[nready]->fd;
+		revents[nready] = events_from_epoll(events[i].events);
+		nready++;
+	}
+	for (int i = 0; i < POSIX_PLATFORM_MAX_FDS; i++)
+	{
+		if (s_fds[i].alwaysReady && s_fds[i].events)
+		{
+			entries[nready] = &s_fds[i];
+			fds[nready]     = s_fds[i].fd;
+			revents[nready] = s_fds[i].events & (POLLIN | POLLOUT);
+			nready++;
+		}
+	}
+#else
+	struct pollfd pollfds[POSIX_PLATFORM_MAX_FDS];
+	int           npoll = 0;
+
+	for (int i = 0; i < POSIX_PLATFORM_MAX_FDS; i++)
+	{
+		if (s_fds[i].fd < 0 || !s_fds[i].events)
+			continue;
+		entries[npoll]         = &s_fds[i];
+		pollfds[npoll].fd      = s_fds[i].fd;
+		pollfds[npoll].events  = s_fds[i].events;
+		pollfds[npoll].revents = 0;
+		npoll++;
+	}
+
+	rval = poll(pollfds, npoll, aTimeoutMs);
+	if (rval > 0)
+	{
+		for (int i = 0; i < npoll; i++)
+		{
+			if (!pollfds[i].revents)
+				continue;
+			entries[nready] = entries[i];
+			fds[nready]     = pollfds[i].fd;
+			revents[nready] = pollfds[i].revents;
+			nready++;
+		}
+	}
+#endif
+
+	if (rval < 0 && errno != EINTR)
+		perror("posixPlatformSleep");
+
+	for (int i = 0; i < nready; i++) fds_dispatch(entries[i], fds[i], revents[i]);
+}
+
+int posixPlatformRegisterFd(int aFd, short aEvents, posixPlatformFdCallback aCallback, void *aContext)
+{
+	struct platform_fd *entry;
+
+	fds_init();
+
+	if (aFd < 0)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	if (fds_find(aFd))
+	{
+		errno = EEXIST;
+		return -1;
+	}
+	entry = fds_find(-1);
+	if (!entry)
+	{
+		errno = ENOMEM;
+		return -1;
+	}
+
+	entry->alwaysReady = false;
+#ifdef __linux__
+	struct epoll_event event = {.events = events_to_epoll(aEvents), .data.ptr = entry};
+
+	if (epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, aFd, &event) < 0)
+	{
+		// Regular files are always readable and writable, like with select()
+		if (errno != EPERM)
+			return -1;
+		entry->alwaysReady = true;
+	}
+#endif
+
+	entry->fd       = aFd;
+	entry->events   = aEvents;
+	entry->callback = aCallback;
+	entry->context  = aContext;
+	return 0;
+}
+
+int posixPlatformModifyFd(int aFd, short aEvents)
+{
+	struct platform_fd *entry = (aFd < 0) ? NULL : fds_find(aFd);
+
+	if (!entry)
+	{
+		errno = ENOENT;
+		return -1;
+	}
+	if (entry->events == aEvents)
+		return 0;
+
+#ifdef __linux__
+	struct epoll_event event = {.events = events_to_epoll(aEvents), .data.ptr = entry};
+
+	if (!entry->alwaysReady && epoll_ctl(s_epoll_fd, EPOLL_CTL_MOD, aFd, &event) < 0)
+		return -1;
+#endif
+
+	entry->events = aEvents;
+	return 0;
+}
+
+int posixPlatformUnregisterFd(int aFd)
+{
+	struct platform_fd *entry = (aFd < 0) ? NULL : fds_find(aFd);
+
+	if (!entry)
+	{
+		errno = ENOENT;
+		return -1;
+	}
+
+#ifdef __linux__
+	if (!entry->alwaysReady)
+		epoll_ctl(s_epoll_fd, EPOLL_CTL_DEL, aFd, NULL);
+#endif
+
+	entry->fd       = -1;
+	entry->events   = 0;
+	entry->callback = NULL;
+	entry->context  = NULL;
+	return 0;
+}
+
 void posixPlatformSetOrigArgs(int argc, char *argv[])
 {
 	gArgumentsCount = argc;
@@ -81,23 +327,28 @@ void otTaskletsSignalPending(otInstance *aInstance)
 
 void posixPlatformGetTimeout(otInstance *aInstance, struct timeval *timeout)
 {
-	FD_ZERO(&read_fds);
-	FD_ZERO(&write_fds);
-
-	platformUartUpdateFdSet(&read_fds, &write_fds, &max_fd);
-	selfpipe_UpdateFdSet(&read_fds, &write_fds, &max_fd);
 	posixPlatformAlarmUpdateTimeout(timeout);
 }
 
 void posixPlatformSleep(otInstance *aInstance, struct timeval *timeout)
 {
-	int rval;
+	int timeoutMs = -1;
 
-	if (!otTaskletsArePending(aInstance))
+	if (otTaskletsArePending(aInstance))
 	{
-		rval = select(max_fd + 1, &read_fds, &write_fds, NULL, timeout);
-		selfpipe_pop();
+		// Still service the ready file descriptors, so that a busy stack does not starve them
+		timeoutMs = 0;
 	}
+	else if (timeout != NULL)
+	{
+		// Rounded up, so that the loop does not wake up before the alarm is due
+		if (timeout->tv_sec >= INT_MAX / 1000 - 1)
+			timeoutMs = INT_MAX;
+		else
+			timeoutMs = (int)(timeout->tv_sec * 1000 + (timeout->tv_usec + 999) / 1000);
+	}
+
+	fds_wait(timeoutMs);
 }
 
 void posixPlatformProcessDriversQuick(otInstance *aInstance)
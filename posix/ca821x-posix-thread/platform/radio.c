@@ -37,7 +37,6 @@
 #include <assert.h>
 #include <fcntl.h>
 #include <math.h>
-#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -61,24 +60,63 @@
 
 #define ARRAY_LENGTH(array) (sizeof((array)) / sizeof((array)[0]))
 
-//BARRIER
+//EVENT QUEUE
 /*
- * The following functions create a thread safe system for allowing the worker
- * thread to access openthread functions safely. The main thread always has
- * priority and must explicitly give control to the worker thread while locking
- * itself. This has ONLY been designed to work with ONE worker and ONE main, in
- * a way that causes the worker thread to run one operation per poll cycle as
- * openthread was designed for.
+ * The MAC indications and confirms are received on the upstream dispatch worker
+ * thread, but openthread must only be called from the main thread. The worker
+ * copies each of them into a slot of a bounded queue, without locking and
+ * without waiting for the main thread. The main thread is woken up through the
+ * self-pipe, and passes all the queued events to openthread in one batch.
+ *
+ * This has ONLY been designed to work with ONE worker (producer) and ONE main
+ * (consumer). Indications may only fill the queue up to
+ * RADIO_EVENT_CONFIRM_RESERVE free slots, so that the confirms of outstanding
+ * requests are not dropped. Indications that don't fit are dropped, as if they
+ * had not been received.
  */
-static pthread_mutex_t barrier_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t  barrier_cond  = PTHREAD_COND_INITIALIZER;
+#define RADIO_EVENT_QUEUE_SIZE 128     //!< Number of slots of the event queue, must be a power of 2
+#define RADIO_EVENT_CONFIRM_RESERVE 16 //!< Number of slots that only confirms can use
+
+enum radio_event_type
+{
+	RADIO_EVENT_DATA_INDICATION,
+	RADIO_EVENT_POLL_INDICATION,
+	RADIO_EVENT_COMM_STATUS_INDICATION,
+	RADIO_EVENT_BEACON_NOTIFY,
+	RADIO_EVENT_DATA_CONFIRM,
+	RADIO_EVENT_POLL_CONFIRM,
+	RADIO_EVENT_SCAN_CONFIRM,
+};
 
-static enum barrier_waiting { NOT_WAITING, WAITING, GREENLIGHT, DONE } mbarrier_waiting;
+struct radio_event
+{
+	uint8_t type; //!< enum radio_event_type
+	union
+	{
+		otDataIndication       dataInd;
+		otPollIndication       pollInd;
+		otCommStatusIndication commInd;
+		otBeaconNotify         beaconNotify;
+		otScanConfirm          scanConfirm;
+		struct
+		{
+			uint8_t msduHandle;
+			otError error;
+		} dataConfirm;
+		otError pollError;
+	} data;
+};
+
+static struct radio_event sEventQueue[RADIO_EVENT_QUEUE_SIZE];
+static unsigned           sEventHead;        //!< Next slot to write, only written by the worker
+static unsigned           sEventTail;        //!< Next slot to read, only written by the main thread
+static unsigned           sEventsDropped;    //!< Events dropped since the queue was last processed
+static bool               sEventWakePending; //!< The main thread was woken up, and has not read the queue yet
 
-static inline void barrier_main_letWorkerWork(void);
-static inline void barrier_worker_waitForMain(void);
-static inline void barrier_worker_endWork(void);
-//END BARRIER
+static struct radio_event *event_queue_alloc(bool aIsConfirm);
+static void                event_queue_commit(void);
+static void                event_queue_process(void);
+//END EVENT QUEUE
 
 static const char IeeeEuiFile[] = "otEui";
 static uint8_t    sIeeeEui64[8];
@@ -410,19 +448,26 @@ otError otPlatMcpsPurge(otInstance *aInstance, uint8_t aMsduHandle)
 
 static ca_error handleDataIndication(struct MCPS_DATA_indication_pset *params, struct ca821x_dev *pDeviceRef)
 {
-	int16_t rssi;
-	//TODO: Move this off the stack
-	otDataIndication dataInd = {0};
+	struct radio_event *event = event_queue_alloc(false);
+	otDataIndication   *dataInd;
+	int16_t             rssi;
+
+	if (!event)
+		return CA_ERROR_SUCCESS;
+
+	event->type = RADIO_EVENT_DATA_INDICATION;
+	dataInd     = &event->data.dataInd;
+	memset(dataInd, 0, sizeof(*dataInd));
 
-	dataInd.mSrc             = *((struct otFullAddr *)&(params->Src));
-	dataInd.mDst             = *((struct otFullAddr *)&(params->Dst));
-	dataInd.mMsduLength      = params->MsduLength;
-	rssi                     = ((int16_t)params->MpduLinkQuality - 256) / 2; //convert to rssi
-	dataInd.mMpduLinkQuality = rssi;
-	dataInd.mDSN             = params->DSN;
+	dataInd->mSrc             = *((struct otFullAddr *)&(params->Src));
+	dataInd->mDst             = *((struct otFullAddr *)&(params->Dst));
+	dataInd->mMsduLength      = params->MsduLength;
+	rssi                      = ((int16_t)params->MpduLinkQuality - 256) / 2; //convert to rssi
+	dataInd->mMpduLinkQuality = rssi;
+	dataInd->mDSN             = params->DSN;
 #if CASCODA_CA_VER >= 8212
-	dataInd.mHeaderIELength  = params->HeaderIELength;
-	dataInd.mPayloadIELength = params->PayloadIELength;
+	dataInd->mHeaderIELength  = params->HeaderIELength;
+	dataInd->mPayloadIELength = params->PayloadIELength;
 
 	union DataIndVariable
 	{
@@ -435,59 +480,62 @@ static ca_error handleDataIndication(struct MCPS_DATA_indication_pset *params, s
 
 	data.ptr = params->Data;
 
-	memcpy(dataInd.mHeaderIEList, data.pHieList, dataInd.mHeaderIELength);
-	data.ptr += dataInd.mHeaderIELength;
+	memcpy(dataInd->mHeaderIEList, data.pHieList, dataInd->mHeaderIELength);
+	data.ptr += dataInd->mHeaderIELength;
 
-	memcpy(dataInd.mPayloadIELength, data.pPieList, dataInd.mPayloadIELength);
-	data.ptr += dataInd.mPayloadIELength;
+	memcpy(dataInd->mPayloadIELength, data.pPieList, dataInd->mPayloadIELength);
+	data.ptr += dataInd->mPayloadIELength;
 
-	memcpy(dataInd.mMsdu, data.pMsdu, dataInd.mMsduLength);
-	data.ptr += dataInd.mMsduLength;
+	memcpy(dataInd->mMsdu, data.pMsdu, dataInd->mMsduLength);
+	data.ptr += dataInd->mMsduLength;
 
-	memcpy(&(dataInd.mSecurity), data.pSec, sizeof(dataInd.mSecurity));
+	memcpy(&(dataInd->mSecurity), data.pSec, sizeof(dataInd->mSecurity));
 #else
-	memcpy(dataInd.mMsdu, params->Msdu, dataInd.mMsduLength);
-	memcpy(&(dataInd.mSecurity), params->Msdu + params->MsduLength, sizeof(dataInd.mSecurity));
+	memcpy(dataInd->mMsdu, params->Msdu, dataInd->mMsduLength);
+	memcpy(&(dataInd->mSecurity), params->Msdu + params->MsduLength, sizeof(dataInd->mSecurity));
 #endif // CASCODA_CA_VER >= 8212
 
 #if CASCODA_CA_VER >= 8211
-	dataInd.mIsFramePending = params->FramePending;
+	dataInd->mIsFramePending = params->FramePending;
 #endif // CASCODA_CA_VER >= 8211
 
-	if (dataInd.mSecurity.mSecurityLevel == 0)
+	if (dataInd->mSecurity.mSecurityLevel == 0)
 	{
-		memset(&(dataInd.mSecurity), 0, sizeof(dataInd.mSecurity));
+		memset(&(dataInd->mSecurity), 0, sizeof(dataInd->mSecurity));
 	}
 
-	barrier_worker_waitForMain();
-	otPlatMcpsDataIndication(OT_INSTANCE, &dataInd);
-	barrier_worker_endWork();
+	event_queue_commit();
 
 	return CA_ERROR_SUCCESS;
 }
 
 static ca_error handlePollIndication(struct MLME_POLL_indication_pset *params, struct ca821x_dev *pDeviceRef)
 {
-	//TODO: Move this off the stack
-	otPollIndication pollInd = {0};
+	struct radio_event *event = event_queue_alloc(false);
+	otPollIndication   *pollInd;
 
-	pollInd.mSrc = *((struct otFullAddr *)&(params->Src));
-	pollInd.mDst = *((struct otFullAddr *)&(params->Dst));
-	pollInd.mLQI = params->LQI;
-	pollInd.mDSN = params->DSN;
+	if (!event)
+		return CA_ERROR_SUCCESS;
+
+	event->type = RADIO_EVENT_POLL_INDICATION;
+	pollInd     = &event->data.pollInd;
+	memset(pollInd, 0, sizeof(*pollInd));
+
+	pollInd->mSrc = *((struct otFullAddr *)&(params->Src));
+	pollInd->mDst = *((struct otFullAddr *)&(params->Dst));
+	pollInd->mLQI = params->LQI;
+	pollInd->mDSN = params->DSN;
 #if CASCODA_CA_VER >= 8212
-	memset(&(pollInd.Timestamp), params->Timestamp, sizeof(pollInd.Timestamp));
+	memset(&(pollInd->Timestamp), params->Timestamp, sizeof(pollInd->Timestamp));
 #endif // CASCODA_CA_VER >= 8212
-	memcpy(&(pollInd.mSecurity), &(params->Security), sizeof(pollInd.mSecurity));
+	memcpy(&(pollInd->mSecurity), &(params->Security), sizeof(pollInd->mSecurity));
 
-	if (pollInd.mSecurity.mSecurityLevel == 0)
+	if (pollInd->mSecurity.mSecurityLevel == 0)
 	{
-		memset(&(pollInd.mSecurity), 0, sizeof(pollInd.mSecurity));
+		memset(&(pollInd->mSecurity), 0, sizeof(pollInd->mSecurity));
 	}
 
-	barrier_worker_waitForMain();
-	otPlatMlmePollIndication(OT_INSTANCE, &pollInd);
-	barrier_worker_endWork();
+	event_queue_commit();
 
 	return CA_ERROR_SUCCESS;
 }
@@ -495,9 +543,14 @@ static ca_error handlePollIndication(struct MLME_POLL_indication_pset *params, s
 #if CASCODA_CA_VER >= 8212
 static ca_error handlePollConfirm(struct MLME_POLL_confirm_pset *params, struct ca821x_dev *pDeviceRef)
 {
-	otError error = ConvertErrorMacToOt((ca_mac_status)params->Status);
+	struct radio_event *event = event_queue_alloc(true);
+
+	if (!event)
+		return CA_ERROR_SUCCESS;
 
-	otPlatMlmePollConfirm(OT_INSTANCE, error);
+	event->type           = RADIO_EVENT_POLL_CONFIRM;
+	event->data.pollError = ConvertErrorMacToOt((ca_mac_status)params->Status);
+	event_queue_commit();
 
 	return CA_ERROR_SUCCESS;
 }
@@ -506,39 +559,48 @@ static ca_error handlePollConfirm(struct MLME_POLL_confirm_pset *params, struct
 static ca_error handleCommStatusIndication(struct MLME_COMM_STATUS_indication_pset *params,
                                            struct ca821x_dev                       *pDeviceRef)
 {
-	//TODO: Move this off the stack
-	otCommStatusIndication commInd = {0};
+	struct radio_event     *event = event_queue_alloc(false);
+	otCommStatusIndication *commInd;
+
+	if (!event)
+		return CA_ERROR_SUCCESS;
+
+	event->type = RADIO_EVENT_COMM_STATUS_INDICATION;
+	commInd     = &event->data.commInd;
+	memset(commInd, 0, sizeof(*commInd));
 
-	memcpy(commInd.mPanId, params->PANId, sizeof(commInd.mPanId));
-	commInd.mDstAddrMode = params->DstAddrMode;
-	commInd.mSrcAddrMode = params->SrcAddrMode;
-	memcpy(commInd.mDstAddr, params->DstAddr, sizeof(commInd.mDstAddr));
-	memcpy(commInd.mSrcAddr, params->SrcAddr, sizeof(commInd.mSrcAddr));
-	memcpy(&commInd.mSecurity, &params->Security, sizeof(commInd.mSecurity));
+	memcpy(commInd->mPanId, params->PANId, sizeof(commInd->mPanId));
+	commInd->mDstAddrMode = params->DstAddrMode;
+	commInd->mSrcAddrMode = params->SrcAddrMode;
+	memcpy(commInd->mDstAddr, params->DstAddr, sizeof(commInd->mDstAddr));
+	memcpy(commInd->mSrcAddr, params->SrcAddr, sizeof(commInd->mSrcAddr));
+	memcpy(&commInd->mSecurity, &params->Security, sizeof(commInd->mSecurity));
 
-	commInd.mStatus = params->Status;
+	commInd->mStatus = params->Status;
 
-	if (commInd.mSecurity.mSecurityLevel == 0)
+	if (commInd->mSecurity.mSecurityLevel == 0)
 	{
-		memset(&(commInd.mSecurity), 0, sizeof(commInd.mSecurity));
+		memset(&(commInd->mSecurity), 0, sizeof(commInd->mSecurity));
 	}
 
-	barrier_worker_waitForMain();
-	otPlatMlmeCommStatusIndication(OT_INSTANCE, &commInd);
-	barrier_worker_endWork();
+	event_queue_commit();
 
 	return CA_ERROR_SUCCESS;
 }
 
 static ca_error handleDataConfirm(struct MCPS_DATA_confirm_pset *params, struct ca821x_dev *pDeviceRef) //Async
 {
-	otError error = ConvertErrorMacToOt((ca_mac_status)params->Status);
+	struct radio_event *event = event_queue_alloc(true);
 
 	ca_log_debg("Data Confirm handle %x, status %x", params->MsduHandle, params->Status);
 
-	barrier_worker_waitForMain();
-	otPlatMcpsDataConfirm(OT_INSTANCE, params->MsduHandle, error);
-	barrier_worker_endWork();
+	if (!event)
+		return CA_ERROR_SUCCESS;
+
+	event->type                        = RADIO_EVENT_DATA_CONFIRM;
+	event->data.dataConfirm.msduHandle = params->MsduHandle;
+	event->data.dataConfirm.error      = ConvertErrorMacToOt((ca_mac_status)params->Status);
+	event_queue_commit();
 
 	return CA_ERROR_SUCCESS;
 }
@@ -546,9 +608,16 @@ static ca_error handleDataConfirm(struct MCPS_DATA_confirm_pset *params, struct
 static ca_error handleBeaconNotify(struct MLME_BEACON_NOTIFY_indication_pset *params,
                                    struct ca821x_dev                         *pDeviceRef) //Async
 {
-	//TODO: Move this off the stack
-	otBeaconNotify beaconNotify = {0};
-	uint8_t        sduLenOffset;
+	struct radio_event *event = event_queue_alloc(false);
+	otBeaconNotify     *beaconNotify;
+	uint8_t             sduLenOffset;
+
+	if (!event)
+		return CA_ERROR_SUCCESS;
+
+	event->type  = RADIO_EVENT_BEACON_NOTIFY;
+	beaconNotify = &event->data.beaconNotify;
+	memset(beaconNotify, 0, sizeof(*beaconNotify));
 
 	{
 		uint8_t addrField  = ((uint8_t *)params)[23];
@@ -557,23 +626,26 @@ static ca_error handleBeaconNotify(struct MLME_BEACON_NOTIFY_indication_pset *pa
 		sduLenOffset       = (24 + (2 * shortaddrs) + (8 * extaddrs));
 	}
 
-	beaconNotify.BSN            = params->BSN;
-	beaconNotify.mPanDescriptor = *((struct otPanDescriptor *)&(params->PanDescriptor));
-	beaconNotify.mSduLength     = ((uint8_t *)params)[sduLenOffset];
-	memcpy(beaconNotify.mSdu, &(((uint8_t *)params)[sduLenOffset + 1]), beaconNotify.mSduLength);
+	beaconNotify->BSN            = params->BSN;
+	beaconNotify->mPanDescriptor = *((struct otPanDescriptor *)&(params->PanDescriptor));
+	beaconNotify->mSduLength     = ((uint8_t *)params)[sduLenOffset];
+	memcpy(beaconNotify->mSdu, &(((uint8_t *)params)[sduLenOffset + 1]), beaconNotify->mSduLength);
 
-	barrier_worker_waitForMain();
-	otPlatMlmeBeaconNotifyIndication(OT_INSTANCE, &beaconNotify);
-	barrier_worker_endWork();
+	event_queue_commit();
 
 	return CA_ERROR_SUCCESS;
 }
 
 static ca_error handleScanConfirm(struct MLME_SCAN_confirm_pset *params, struct ca821x_dev *pDeviceRef) //Async
 {
-	barrier_worker_waitForMain();
-	otPlatMlmeScanConfirm(OT_INSTANCE, (otScanConfirm *)params);
-	barrier_worker_endWork();
+	struct radio_event *event = event_queue_alloc(true);
+
+	if (!event)
+		return CA_ERROR_SUCCESS;
+
+	event->type = RADIO_EVENT_SCAN_CONFIRM;
+	memcpy(&event->data.scanConfirm, params, sizeof(event->data.scanConfirm));
+	event_queue_commit();
 
 	return CA_ERROR_SUCCESS;
 }
@@ -743,7 +815,7 @@ bool otPlatRadioIsEnabled(otInstance *aInstance)
 
 int PlatformRadioProcess(void)
 {
-	barrier_main_letWorkerWork();
+	event_queue_process();
 	return 0;
 }
 
@@ -763,51 +835,85 @@ otError otPlatRadioSetCcaEnergyDetectThreshold(otInstance *aInstance, int8_t aTh
 	return OT_ERROR_NOT_IMPLEMENTED;
 }
 
-//Lets the worker thread work synchronously if there is synchronous work to do
-static inline void barrier_main_letWorkerWork()
+//Gets the next free slot of the queue, or NULL if it is full. Worker thread only.
+static struct radio_event *event_queue_alloc(bool aIsConfirm)
 {
-	pthread_mutex_lock(&barrier_mutex);
+	unsigned head  = __atomic_load_n(&sEventHead, __ATOMIC_RELAXED);
+	unsigned tail  = __atomic_load_n(&sEventTail, __ATOMIC_ACQUIRE);
+	unsigned limit = aIsConfirm ? RADIO_EVENT_QUEUE_SIZE : RADIO_EVENT_QUEUE_SIZE - RADIO_EVENT_CONFIRM_RESERVE;
 
-	if (mbarrier_waiting == WAITING)
+	if (head - tail >= limit)
 	{
-		mbarrier_waiting = GREENLIGHT;
-		pthread_cond_broadcast(&barrier_cond);
-
-		while (mbarrier_waiting != DONE)
-		{
-			pthread_cond_wait(&barrier_cond, &barrier_mutex); //The worker thread does work now
-		}
+		__atomic_fetch_add(&sEventsDropped, 1, __ATOMIC_RELAXED);
+		return NULL;
 	}
 
-	mbarrier_waiting = NOT_WAITING;
-	pthread_cond_broadcast(&barrier_cond);
-	pthread_mutex_unlock(&barrier_mutex);
+	return &sEventQueue[head % RADIO_EVENT_QUEUE_SIZE];
 }
 
-static inline void barrier_worker_waitForMain()
+//Publishes the slot returned by event_queue_alloc, and wakes up the main thread. Worker thread only.
+static void event_queue_commit(void)
 {
-	pthread_mutex_lock(&barrier_mutex);
+	unsigned head = __atomic_load_n(&sEventHead, __ATOMIC_RELAXED);
 
-	while (mbarrier_waiting != NOT_WAITING)
-	{
-		pthread_cond_wait(&barrier_cond, &barrier_mutex);
-	}
+	__atomic_store_n(&sEventHead, head + 1, __ATOMIC_SEQ_CST);
+
+	//Only write to the self-pipe once until the main thread reads the queue
+	if (!__atomic_exchange_n(&sEventWakePending, true, __ATOMIC_SEQ_CST))
+		selfpipe_push();
+}
+
+//Passes all the queued events to openthread. Main thread only.
+static void event_queue_process(void)
+{
+	unsigned tail = __atomic_load_n(&sEventTail, __ATOMIC_RELAXED);
+	unsigned head;
+	unsigned dropped;
 
-	selfpipe_push();
-	mbarrier_waiting = WAITING;
-	pthread_cond_broadcast(&barrier_cond);
+	//Cleared before reading the head, so that the events queued from now on wake up the main thread again
+	__atomic_store_n(&sEventWakePending, false, __ATOMIC_SEQ_CST);
+	head = __atomic_load_n(&sEventHead, __ATOMIC_SEQ_CST);
 
-	while (mbarrier_waiting != GREENLIGHT)
+	for (; tail != head; tail++)
 	{
-		pthread_cond_wait(&barrier_cond, &barrier_mutex); //wait for the main thread to signal worker to run
+		struct radio_event *event = &sEventQueue[tail % RADIO_EVENT_QUEUE_SIZE];
+
+		switch (event->type)
+		{
+		case RADIO_EVENT_DATA_INDICATION:
+			otPlatMcpsDataIndication(OT_INSTANCE, &event->data.dataInd);
+			break;
+		case RADIO_EVENT_POLL_INDICATION:
+			otPlatMlmePollIndication(OT_INSTANCE, &event->data.pollInd);
+			break;
+		case RADIO_EVENT_COMM_STATUS_INDICATION:
+			otPlatMlmeCommStatusIndication(OT_INSTANCE, &event->data.commInd);
+			break;
+		case RADIO_EVENT_BEACON_NOTIFY:
+			otPlatMlmeBeaconNotifyIndication(OT_INSTANCE, &event->data.beaconNotify);
+			break;
+		case RADIO_EVENT_DATA_CONFIRM:
+			otPlatMcpsDataConfirm(OT_INSTANCE, event->data.dataConfirm.msduHandle, event->data.dataConfirm.error);
+			break;
+#if CASCODA_CA_VER >= 8212
+		case RADIO_EVENT_POLL_CONFIRM:
+			otPlatMlmePollConfirm(OT_INSTANCE, event->data.pollError);
+			break;
+#endif // CASCODA_CA_VER >= 8212
+		case RADIO_EVENT_SCAN_CONFIRM:
+			otPlatMlmeScanConfirm(OT_INSTANCE, &event->data.scanConfirm);
+			break;
+		default:
+			break;
+		}
+
+		//Hand the slot back to the worker as soon as it has been processed
+		__atomic_store_n(&sEventTail, tail + 1, __ATOMIC_RELEASE);
 	}
-}
 
-static inline void barrier_worker_endWork()
-{
-	mbarrier_waiting = DONE;
-	pthread_cond_broadcast(&barrier_cond);
-	pthread_mutex_unlock(&barrier_mutex);
+	dropped = __atomic_exchange_n(&sEventsDropped, 0, __ATOMIC_RELAXED);
+	if (dropped)
+		ca_log_warn("Radio event queue full, dropped %u events", dropped);
 }
 
 // SOF Cascoda low level cli access
@@ -25,44 +25,79 @@
  *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
  *  POSSIBILITY OF SUCH DAMAGE.
  */
+/*
+ * Wakes up posixPlatformSleep from other threads, eg. when the radio worker queues an event or a tasklet is posted.
+ * An eventfd is used on Linux, which is a single file descriptor and coalesces any number of wake-ups into one
+ * read, and a non-blocking pipe elsewhere.
+ */
+
 #define _GNU_SOURCE
 
 #include <fcntl.h>
+#include <poll.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+#include "ca821x-posix-thread/posix-platform.h"
 #include "selfpipe.h"
 
-static int fd[2];
+static int fd[2] = {-1, -1};
+
+static void selfpipe_callback(int aFd, short aEvents, void *aContext)
+{
+	(void)aFd;
+	(void)aEvents;
+	(void)aContext;
+
+	selfpipe_pop();
+}
 
 void selfpipe_init(void)
 {
+	if (fd[0] >= 0)
+		return;
+
+#ifdef __linux__
+	fd[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	fd[1] = fd[0];
+#else
 	pipe(fd);
 	fcntl(fd[0], F_SETFL, O_NONBLOCK);
 	fcntl(fd[1], F_SETFL, O_NONBLOCK);
+#endif
+
+	if (fd[0] < 0)
+		perror("selfpipe");
+	else
+		posixPlatformRegisterFd(fd[0], POLLIN, &selfpipe_callback, NULL);
 }
 
 void selfpipe_push(void)
 {
+#ifdef __linux__
+	uint64_t count = 1;
+
+	write(fd[1], &count, sizeof(count));
+#else
 	write(fd[1], "a", 1);
+#endif
 }
 
 void selfpipe_pop(void)
 {
-	uint8_t junkBuf;
-	read(fd[0], &junkBuf, 1);
-}
+#ifdef __linux__
+	uint64_t count;
 
-void selfpipe_UpdateFdSet(fd_set *aReadFdSet, fd_set *aWriteFdSet, int *aMaxFd)
-{
-	if (aReadFdSet != NULL)
-	{
-		FD_SET(fd[0], aReadFdSet);
+	read(fd[0], &count, sizeof(count));
+#else
+	uint8_t junkBuf[16];
 
-		if (aMaxFd != NULL && *aMaxFd < fd[0])
-		{
-			*aMaxFd = fd[0];
-		}
-	}
+	while (read(fd[0], junkBuf, sizeof(junkBuf)) > 0)
+		;
+#endif
 }
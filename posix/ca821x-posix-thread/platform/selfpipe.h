@@ -29,19 +29,18 @@
 #ifndef PLATFORM_SELFPIPE_H_
 #define PLATFORM_SELFPIPE_H_
 
-#include <sys/select.h>
-
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** Create the wake-up file descriptor and register it with the platform loop. Can be called more than once. */
 void selfpipe_init(void);
 
+/** Wake up posixPlatformSleep. Can be called from any thread. */
 void selfpipe_push(void);
+/** Clear all the pending wake-ups. */
 void selfpipe_pop(void);
 
-void selfpipe_UpdateFdSet(fd_set *aReadFdSet, fd_set *aWriteFdSet, int *aMaxFd);
-
 #ifdef __cplusplus
 }
 #endif
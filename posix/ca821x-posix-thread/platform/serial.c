@@ -170,7 +170,12 @@ otError otPlatUartEnable(void)
 	}
 
 	if (error == OT_ERROR_NONE)
+	{
+		//Only wake up the loop, the data is handled by platformUartProcess
+		posixPlatformRegisterFd(s_in_fd, POLLIN, NULL, NULL);
+		posixPlatformRegisterFd(s_out_fd, 0, NULL, NULL);
 		s_enabled = true;
+	}
 	return error;
 
 exit:
@@ -185,6 +190,8 @@ otError otPlatUartDisable(void)
 {
 	otError error = OT_ERROR_NONE;
 
+	posixPlatformUnregisterFd(s_in_fd);
+	posixPlatformUnregisterFd(s_out_fd);
 	close(s_in_fd);
 	close(s_out_fd);
 
@@ -200,6 +207,7 @@ otError otPlatUartSend(const uint8_t *aBuf, uint16_t aBufLength)
 
 	s_write_buffer = aBuf;
 	s_write_length = aBufLength;
+	posixPlatformModifyFd(s_out_fd, POLLOUT);
 
 exit:
 	return error;
@@ -210,32 +218,6 @@ otError otPlatUartFlush(void)
 	return OT_ERROR_NOT_IMPLEMENTED;
 }
 
-void platformUartUpdateFdSet(fd_set *aReadFdSet, fd_set *aWriteFdSet, int *aMaxFd)
-{
-	if (!s_enabled)
-		return;
-
-	if (aReadFdSet != NULL)
-	{
-		FD_SET(s_in_fd, aReadFdSet);
-
-		if (aMaxFd != NULL && *aMaxFd < s_in_fd)
-		{
-			*aMaxFd = s_in_fd;
-		}
-	}
-
-	if ((aWriteFdSet != NULL) && (s_write_length > 0))
-	{
-		FD_SET(s_out_fd, aWriteFdSet);
-
-		if (aMaxFd != NULL && *aMaxFd < s_out_fd)
-		{
-			*aMaxFd = s_out_fd;
-		}
-	}
-}
-
 void platformUartProcess(void)
 {
 	ssize_t       rval;
@@ -300,6 +282,7 @@ void platformUartProcess(void)
 
 			if (s_write_length == 0)
 			{
+				posixPlatformModifyFd(s_out_fd, 0);
 				otPlatUartSendDone();
 			}
 		}
@@ -371,6 +371,35 @@ ca_error EVBME_CheckVersion(const char *aMinVerString, struct ca821x_dev *pDevic
 	return status;
 }
 
+/**
+ * Pass each line of a message indication to the callback separately. The device coalesces several lines into one
+ * frame, separated by '\n', so that a burst of prints takes fewer transfers.
+ */
+static ca_error dispatch_message_lines(struct EVBME_Message  *rxMsg,
+                                       EVBME_Message_callback callback,
+                                       struct ca821x_dev     *pDeviceRef)
+{
+	const char           *message = rxMsg->EVBME.MESSAGE_indication.mMessage;
+	size_t                start   = 0;
+	ca_error              error   = CA_ERROR_SUCCESS;
+	uint8_t               lineBuf[2 + UINT8_MAX];
+	struct EVBME_Message *line = (struct EVBME_Message *)lineBuf;
+
+	line->mCmdId = rxMsg->mCmdId;
+	for (size_t i = 0; i <= rxMsg->mLen; i++)
+	{
+		if (i < rxMsg->mLen && message[i] != '\n')
+			continue;
+
+		line->mLen = i - start;
+		memcpy(line->EVBME.MESSAGE_indication.mMessage, message + start, line->mLen);
+		error = callback(line, pDeviceRef);
+		start = i + 1;
+	}
+
+	return error;
+}
+
 ca_error ca821x_evbme_dispatch(uint8_t *aBuf, size_t aBufLen, struct ca821x_dev *pDeviceRef)
 {
 	struct ca821x_exchange_base *base     = pDeviceRef->exchange_context;
@@ -394,7 +423,10 @@ ca_error ca821x_evbme_dispatch(uint8_t *aBuf, size_t aBufLen, struct ca821x_dev
 		break;
 	}
 
-	if (callback)
+	if (callback && rxMsg->mCmdId == EVBME_MESSAGE_INDICATION &&
+	    memchr(rxMsg->EVBME.MESSAGE_indication.mMessage, '\n', rxMsg->mLen))
+		error = dispatch_message_lines(rxMsg, callback, pDeviceRef);
+	else if (callback)
 		error = callback(rxMsg, pDeviceRef);
 
 	return error;
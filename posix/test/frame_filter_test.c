@@ -0,0 +1,106 @@
+/*
+ *  Copyright (c) 2020, Cascoda Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file
+ * @brief  Unit tests for the frame filter of the sniffer
+ */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+//cmocka must be after system headers
+#include <cmocka.h>
+
+#include "frame-filter.h"
+
+static ca_error add(const char *expr)
+{
+	struct frame_filter filter;
+
+	memset(&filter, 0, sizeof(filter));
+	return frame_filter_add(&filter, expr);
+}
+
+/* Addresses have no order, so only = and != can be used on them */
+static void address_operators(void **state)
+{
+	(void)state;
+
+	assert_int_equal(add("src=1234"), CA_ERROR_SUCCESS);
+	assert_int_equal(add("dst==0x1234"), CA_ERROR_SUCCESS);
+	assert_int_equal(add("addr!=00:12:4b:00:01:02:03:04"), CA_ERROR_SUCCESS);
+
+	assert_int_equal(add("src<1234"), CA_ERROR_INVALID_ARGS);
+	assert_int_equal(add("src<=1234"), CA_ERROR_INVALID_ARGS);
+	assert_int_equal(add("dst>1234"), CA_ERROR_INVALID_ARGS);
+	assert_int_equal(add("dst>=1234"), CA_ERROR_INVALID_ARGS);
+	assert_int_equal(add("addr<00:12:4b:00:01:02:03:04"), CA_ERROR_INVALID_ARGS);
+	assert_int_equal(add("type=data,addr>=1234"), CA_ERROR_INVALID_ARGS);
+
+	// Other fields are still ordered
+	assert_int_equal(add("len<20"), CA_ERROR_SUCCESS);
+	assert_int_equal(add("rssi>=-70,pan<=0xface"), CA_ERROR_SUCCESS);
+}
+
+static void address_match(void **state)
+{
+	struct frame_filter filter;
+	struct frame_info   info;
+
+	(void)state;
+	memset(&info, 0, sizeof(info));
+	info.valid    = true;
+	info.src_mode = FRAME_ADDR_SHORT;
+	info.src_addr = 0x1234;
+	info.dst_mode = FRAME_ADDR_SHORT;
+	info.dst_addr = 0xffff;
+
+	memset(&filter, 0, sizeof(filter));
+	assert_int_equal(frame_filter_add(&filter, "src=1234"), CA_ERROR_SUCCESS);
+	assert_true(frame_filter_match(&filter, &info));
+	info.src_addr = 0x1235;
+	assert_false(frame_filter_match(&filter, &info));
+
+	memset(&filter, 0, sizeof(filter));
+	assert_int_equal(frame_filter_add(&filter, "addr!=1234"), CA_ERROR_SUCCESS);
+	assert_true(frame_filter_match(&filter, &info));
+	info.dst_addr = 0x1234;
+	assert_false(frame_filter_match(&filter, &info));
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+	    cmocka_unit_test(address_operators),
+	    cmocka_unit_test(address_match),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}